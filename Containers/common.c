@@ -5,6 +5,7 @@
  */
 
 #include "common.h"
+#include "../utility.h"
 #include <stdint.h>
 
 /* These structs really aren't used at all, they're just present to emit compiler warnings if assigning one container type to another.
@@ -288,6 +289,78 @@ void binary_destroy(Binary *b) {
     }
 }
 
+struct BinaryBufferStruct {
+    Atomic refs;
+    size_t length;
+    char *data;
+    void (*release)(char *data, size_t length);
+};
+
+BinaryBuffer binary_buffer_adopt(char *data, size_t length, void (*release)(char *data, size_t length)) {
+    BinaryBuffer buffer = MALLOC(sizeof(*buffer));
+    if (buffer == NULL)
+        return NULL;
+
+    buffer->refs = 1;
+    buffer->length = length;
+    buffer->data = data;
+    buffer->release = release;
+
+    return buffer;
+}
+
+BinaryBuffer binary_buffer_ref(BinaryBuffer buffer) {
+    atomic_add(&buffer->refs, 1);
+
+    return buffer;
+}
+
+void binary_buffer_release(BinaryBuffer buffer) {
+    if (buffer == NULL || atomic_sub(&buffer->refs, 1) != 1)
+        return;
+
+    if (buffer->release)
+        buffer->release(buffer->data, buffer->length);
+    else
+        FREE(buffer->data);
+
+    FREE(buffer);
+}
+
+char *binary_buffer_data(BinaryBuffer buffer) {
+    return buffer->data;
+}
+
+size_t binary_buffer_size(BinaryBuffer buffer) {
+    return buffer->length;
+}
+
+BinarySlice *binary_slice_alloc(BinaryBuffer buffer, size_t offset, size_t length) {
+    if (offset > buffer->length)
+        return NULL;
+
+    BinarySlice *slice = MALLOC(sizeof(*slice));
+    if (slice == NULL)
+        return NULL;
+
+    slice->length = MIN(length, buffer->length - offset);
+    slice->data = buffer->data + offset;
+    slice->buffer = binary_buffer_ref(buffer);
+
+    return slice;
+}
+
+BinarySlice *binary_slice_copy(const BinarySlice *other) {
+    return binary_slice_alloc(other->buffer, other->data - other->buffer->data, other->length);
+}
+
+void binary_slice_destroy(BinarySlice *slice) {
+    if (slice) {
+        binary_buffer_release(slice->buffer);
+        FREE(slice);
+    }
+}
+
 void *generic_pod_copy_alloc(const void *p, size_t bytes) {
     if (p == NULL)
         return NULL;
@@ -301,6 +374,30 @@ void *generic_pod_copy_alloc(const void *p, size_t bytes) {
     return new_p;
 }
 
+size_t generic_hash_bytes(const void *p, size_t bytes) {
+    const unsigned char *cptr = p;
+    uint64_t hash = UINT64_C(0x9e3779b97f4a7c15) ^ bytes;
+
+    /* Mix in a word at a time */
+    for (; bytes >= 8; bytes -= 8, cptr += 8) {
+        uint64_t word;
+
+        memcpy(&word, cptr, 8);
+        hash = (hash ^ word) * UINT64_C(0xff51afd7ed558ccd);
+        hash ^= hash >> 32;
+    }
+
+    if (bytes) {
+        uint64_t word = 0;
+
+        memcpy(&word, cptr, bytes);
+        hash = (hash ^ word) * UINT64_C(0xc4ceb9fe1a85ec53);
+        hash ^= hash >> 29;
+    }
+
+    return (size_t) (hash ^ (hash >> 32));
+}
+
 void *generic_identitycopy(const void *p) {
     return (void *) p;
 }
@@ -30,6 +30,7 @@ struct BinarySetStruct;
 struct GenericMapStruct;
 struct StringMapStruct;
 struct GenericLinkedListStruct;
+struct ConcurrentMapStruct;
 
 typedef struct VariantStruct *Variant; /* Simple variant type that can hold integers, floating point values, strings, or other containers. Simple conversions can be performed */
 typedef struct GenericListStruct *GenericList; /* Simple list of generic pointers */
@@ -39,6 +40,7 @@ typedef struct GenericSetStruct *GenericSet; /* Simple exclusive set of generic
 typedef struct StringSetStruct *StringSet; /* Simple exclusive set of NUL-terminated strings, each element only appears once. Elements are in ascending order */
 typedef struct GenericMapStruct *GenericMap; /* Ordered map of items, containing generic pointers. Elements are in ascending order */
 typedef struct StringMapStruct *StringMap; /* Simple exclusive map of NUL-terminated string keys with values, each element only appears once. Elements are NUL-terminated strings. Elements are in ascending order */
+typedef struct ConcurrentMapStruct *ConcurrentMap; /* Unordered hash map that can be read and written by many threads at once. Reads do not take locks */
 
 struct CommonContainerBaseStruct;
 
@@ -55,6 +57,43 @@ Binary *binary_copy(const Binary *other);
 int binary_compare(const Binary *a, const Binary *b);
 void binary_destroy(Binary *b);
 
+typedef struct BinaryBufferStruct *BinaryBuffer; /* Reference-counted block of data that BinarySlice objects can refer to */
+
+/* A Binary object that refers to a range of a BinaryBuffer instead of owning a copy of its data.
+ * A `BinarySlice *` can be used wherever a `const Binary *` is expected, but the data is not NUL-terminated */
+typedef struct BinarySliceStruct {
+    size_t length;
+    char *data;
+    BinaryBuffer buffer;
+} BinarySlice;
+
+/** @brief Creates a reference-counted buffer that takes ownership of existing data
+ *
+ * The buffer of a dynamic IO device can be adopted with `binary_buffer_adopt(io_take_underlying_buffer(io), io_underlying_buffer_size(io), NULL)`.
+ *
+ * @param data The data to adopt. This must stay valid and unmodified until @p release is called.
+ * @param length The length of @p data in bytes.
+ * @param release The function to call with @p data and @p length when the last reference is released, or NULL to free @p data with FREE().
+ *        For example, a function that calls munmap() can be provided for memory-mapped data.
+ * @return A new buffer with one reference, or NULL if allocation failed. @p data is not released on failure.
+ */
+BinaryBuffer binary_buffer_adopt(char *data, size_t length, void (*release)(char *data, size_t length));
+BinaryBuffer binary_buffer_ref(BinaryBuffer buffer); /* Adds a reference to the buffer and returns it */
+void binary_buffer_release(BinaryBuffer buffer); /* Removes a reference from the buffer, and frees it if no references remain */
+char *binary_buffer_data(BinaryBuffer buffer);
+size_t binary_buffer_size(BinaryBuffer buffer);
+
+/** @brief Allocates a slice that refers to part of a buffer, without copying the data
+ *
+ * @param buffer The buffer to refer to. The slice holds its own reference to the buffer.
+ * @param offset The offset of the slice in @p buffer.
+ * @param length The length of the slice. The slice is truncated if it would extend past the end of @p buffer.
+ * @return A new slice, or NULL if allocation failed or @p offset is past the end of @p buffer.
+ */
+BinarySlice *binary_slice_alloc(BinaryBuffer buffer, size_t offset, size_t length);
+BinarySlice *binary_slice_copy(const BinarySlice *other); /* Copies the slice, but not the data it refers to */
+void binary_slice_destroy(BinarySlice *slice);
+
 typedef struct CommonContainerBaseStruct CommonContainerBase;
 
 /** @brief Structure containing the identity of a Parser function. See `Parser` for details. */
@@ -221,6 +260,13 @@ typedef enum {
  */
 typedef int (*Compare)(const void *a, const void *b);
 
+/** Hashes an item
+ *
+ * Any two items that compare equal with the Compare function of the same container base must hash to the same value.
+ * Hashed containers mix the result further, so the hash does not need to be well distributed, only consistent with the Compare function.
+ */
+typedef size_t (*Hasher)(const void *p);
+
 /** Creates a collection. The collection is later destroyed with the Deleter function
  *
  * @return Returns a handle to the collection, or NULL if an error occurred.
@@ -341,6 +387,7 @@ struct CommonContainerBaseStruct {
     Deleter deleter;
     Parser parse;
     Serializer serialize;
+    Hasher hash; /* Used by hashed containers, if NULL, the type cannot be used as a key of a hashed container */
     union {
         CollectionCreateList list;
         CollectionCreateKeyValue key_value;
@@ -444,6 +491,12 @@ int generic_types_compatible_compare(const CommonContainerBase *lhs, const Commo
  */
 void *generic_pod_copy_alloc(const void *p, size_t bytes);
 
+/** @brief A utility hash function that hashes a block of memory and returns the hash
+ *
+ * This function cannot be used as a Hasher parameter.
+ */
+size_t generic_hash_bytes(const void *p, size_t bytes);
+
 /** @brief A copier function that simply returns its argument
  *
  * Use this function as a copier when you want generic containers to treat objects as atomic values
@@ -0,0 +1,732 @@
+/** @file
+ *
+ *  @author Oliver Adams
+ *  @copyright Copyright (C) 2020
+ */
+
+#include "concurrentmap.h"
+#include "../utility.h"
+
+#include <string.h>
+
+/* Sharded hash map with separately chained buckets.
+ *
+ * Writers lock the shard that owns the key, and never change anything readers look at in a reachable node, except for its `next` link.
+ * A node is linked in only after it is fully initialized, so readers can walk the chains without locks.
+ * Replaced values, removed nodes, and bucket arrays left behind by a resize are retired instead of freed.
+ *
+ * Retired memory is reclaimed with grace periods. Readers register in a counter for the current epoch parity while they read.
+ * A grace period starts when a writer advances the epoch, so new readers register in the other counter, and completes once the counters
+ * of the previous parity have drained. Memory retired before a grace period started can be freed once it completes.
+ * Writers retire memory in batches and only check whether a grace period has completed when a batch fills, so they don't wait for readers,
+ * unless readers hold up so many batches that memory use must be bounded.
+ */
+
+/* POD keys and values up to this size are stored inline in the node, larger ones are stored as pointers */
+#ifndef CONCURRENTMAP_MAX_INLINE_SIZE
+#define CONCURRENTMAP_MAX_INLINE_SIZE 64
+#endif
+
+#ifndef CONCURRENTMAP_DEFAULT_SHARDS
+#define CONCURRENTMAP_DEFAULT_SHARDS 16
+#endif
+
+/* Number of reader counters. Readers pick one by thread, so more slots means less contention between readers on the counters */
+#ifndef CONCURRENTMAP_READER_SLOTS
+#define CONCURRENTMAP_READER_SLOTS 16
+#endif
+
+/* Number of retired nodes a shard collects in a batch before trying to reclaim them */
+#ifndef CONCURRENTMAP_RECLAIM_THRESHOLD
+#define CONCURRENTMAP_RECLAIM_THRESHOLD 64
+#endif
+
+/* Number of retired nodes a shard can hold waiting for readers before writers to the shard wait for a grace period to complete */
+#ifndef CONCURRENTMAP_MAX_PENDING
+#define CONCURRENTMAP_MAX_PENDING (CONCURRENTMAP_RECLAIM_THRESHOLD * 64)
+#endif
+
+#define CONCURRENTMAP_CACHE_LINE 64
+#define CONCURRENTMAP_MIN_BUCKETS 8
+
+#define CONCURRENTMAP_OWNS_KEY 1
+#define CONCURRENTMAP_OWNS_VALUE 2
+
+typedef struct ConcurrentMapNode {
+    struct ConcurrentMapNode *volatile next;
+    struct ConcurrentMapNode *retired; /* Only used by writers, once the node is no longer reachable from the buckets */
+    size_t hash;
+    int owns; /* Which elements are destroyed with the node, since replaced and resized nodes hand their elements to a new node */
+    /* Followed by key storage at `key_offset` and value storage at `value_offset`, see ConcurrentMapStruct */
+} ConcurrentMapNode;
+
+typedef struct ConcurrentMapBuckets {
+    size_t mask; /* Number of buckets minus one */
+    struct ConcurrentMapBuckets *retired;
+    ConcurrentMapNode *volatile heads[];
+} ConcurrentMapBuckets;
+
+/* Memory retired by a shard, linked through the `retired` fields */
+typedef struct ConcurrentMapBatch {
+    ConcurrentMapNode *nodes;
+    ConcurrentMapBuckets *buckets;
+    size_t count; /* Number of nodes */
+    size_t grace_period; /* The batch can be freed when this grace period completes */
+} ConcurrentMapBatch;
+
+typedef struct ConcurrentMapShard {
+    Mutex lock;
+    ConcurrentMapBuckets *volatile buckets;
+    size_t size;
+
+    ConcurrentMapBatch retired; /* Not yet waiting for a grace period */
+    /* Waiting for a grace period. Batches only ever wait for the current or next grace period, so two are enough */
+    ConcurrentMapBatch pending[2];
+} ConcurrentMapShard;
+
+/* Each slot has its own cache line, so readers on different threads don't contend on the same counters */
+typedef struct ConcurrentMapReaderSlot {
+    volatile Atomic readers[2];
+    unsigned char padding[CONCURRENTMAP_CACHE_LINE - 2 * sizeof(Atomic)];
+} ConcurrentMapReaderSlot;
+
+struct ConcurrentMapStruct {
+    ConcurrentMapReaderSlot slots[CONCURRENTMAP_READER_SLOTS];
+    volatile Atomic epoch;
+    Mutex reclaim_lock; /* Always taken after a shard lock, never before */
+    size_t grace_started, grace_completed; /* Protected by `reclaim_lock` */
+
+    CommonContainerBase *key_base, *value_base;
+    size_t key_offset, value_offset, node_size; /* Layout of a node */
+
+    size_t shard_count, shard_stride;
+    unsigned char *shards;
+    void *shard_allocation;
+};
+
+static int concurrentmap_element_inline(const CommonContainerBase *base) {
+    return base->size && base->size <= CONCURRENTMAP_MAX_INLINE_SIZE;
+}
+
+static size_t concurrentmap_element_size(const CommonContainerBase *base) {
+    return concurrentmap_element_inline(base)? base->size: sizeof(void*);
+}
+
+/* Returns the alignment of an element in a node, the largest power of two (up to 16) that divides its size */
+static size_t concurrentmap_element_alignment(const CommonContainerBase *base) {
+    const size_t size = concurrentmap_element_size(base);
+    size_t alignment = 1;
+
+    while (alignment < 16 && size % (alignment * 2) == 0)
+        alignment *= 2;
+
+    return alignment;
+}
+
+static size_t concurrentmap_align(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+/* Computes the hash of a key, mixed so that both the shard and bucket indexes are well distributed */
+static size_t concurrentmap_hash(const ConcurrentMap map, const void *key) {
+    uint64_t hash = map->key_base->hash(key);
+
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xff51afd7ed558ccd);
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xc4ceb9fe1a85ec53);
+    hash ^= hash >> 33;
+
+    return (size_t) hash;
+}
+
+static ConcurrentMapShard *concurrentmap_shard(const ConcurrentMap map, size_t hash) {
+    return (ConcurrentMapShard *) (map->shards + (hash % map->shard_count) * map->shard_stride);
+}
+
+/* The shard index uses the low part of the hash, so buckets within a shard are chosen from the rest */
+static ConcurrentMapNode *volatile *concurrentmap_bucket(const ConcurrentMap map, ConcurrentMapBuckets *buckets, size_t hash) {
+    return &buckets->heads[(hash / map->shard_count) & buckets->mask];
+}
+
+/* Links that readers can follow are published with atomicp_set(), so they are read with an acquire load.
+ * Unlike atomicp_load(), it doesn't write to the link, so readers never contend on the cache lines they walk through */
+static ConcurrentMapNode *concurrentmap_load(ConcurrentMapNode *volatile *link) {
+    return atomicp_load_acquire((volatile const AtomicPointer *) link);
+}
+
+static ConcurrentMapBuckets *concurrentmap_load_buckets(ConcurrentMapShard *shard) {
+    return atomicp_load_acquire((volatile const AtomicPointer *) &shard->buckets);
+}
+
+static unsigned char *concurrentmap_key_storage(const ConcurrentMap map, ConcurrentMapNode *node) {
+    return (unsigned char *) node + map->key_offset;
+}
+
+static unsigned char *concurrentmap_value_storage(const ConcurrentMap map, ConcurrentMapNode *node) {
+    return (unsigned char *) node + map->value_offset;
+}
+
+static const void *concurrentmap_key(const ConcurrentMap map, ConcurrentMapNode *node) {
+    unsigned char *storage = concurrentmap_key_storage(map, node);
+
+    return concurrentmap_element_inline(map->key_base)? storage: *((void **) storage);
+}
+
+static const void *concurrentmap_value(const ConcurrentMap map, ConcurrentMapNode *node) {
+    unsigned char *storage = concurrentmap_value_storage(map, node);
+
+    return concurrentmap_element_inline(map->value_base)? storage: *((void **) storage);
+}
+
+/* Moves an element into node storage. Inline elements are copied and the original freed, as with GenericList */
+static void concurrentmap_store_move(const CommonContainerBase *base, void *storage, void *item) {
+    if (concurrentmap_element_inline(base)) {
+        if (item == NULL)
+            memset(storage, 0, base->size);
+        else {
+            memcpy(storage, item, base->size);
+            FREE(item);
+        }
+    } else {
+        *((void **) storage) = item;
+    }
+}
+
+/* Copies an element into node storage. Returns an error if the element could not be copied */
+static int concurrentmap_store_copy(const CommonContainerBase *base, void *storage, const void *item) {
+    if (concurrentmap_element_inline(base)) {
+        if (item == NULL)
+            memset(storage, 0, base->size);
+        else
+            memcpy(storage, item, base->size);
+
+        return 0;
+    }
+
+    void *duplicate = NULL;
+    if (item != NULL) {
+        if (base->copier == NULL)
+            return CC_ENOTSUP;
+
+        duplicate = base->copier(item);
+        if (duplicate == NULL)
+            return CC_ENOMEM;
+    }
+
+    *((void **) storage) = duplicate;
+    return 0;
+}
+
+static void concurrentmap_destroy_element(const CommonContainerBase *base, void *storage) {
+    if (!concurrentmap_element_inline(base) && base->deleter)
+        base->deleter(*((void **) storage));
+}
+
+/* Destroys an element that was going to be moved into the map, but wasn't needed */
+static void concurrentmap_discard_moved(const CommonContainerBase *base, void *item) {
+    if (concurrentmap_element_inline(base))
+        FREE(item);
+    else if (base->deleter)
+        base->deleter(item);
+}
+
+static void concurrentmap_free_node(const ConcurrentMap map, ConcurrentMapNode *node) {
+    if (node->owns & CONCURRENTMAP_OWNS_KEY)
+        concurrentmap_destroy_element(map->key_base, concurrentmap_key_storage(map, node));
+    if (node->owns & CONCURRENTMAP_OWNS_VALUE)
+        concurrentmap_destroy_element(map->value_base, concurrentmap_value_storage(map, node));
+
+    FREE(node);
+}
+
+static ConcurrentMapBuckets *concurrentmap_alloc_buckets(size_t count) {
+    ConcurrentMapBuckets *buckets = CALLOC(1, sizeof(*buckets) + count * sizeof(*buckets->heads));
+    if (buckets == NULL)
+        return NULL;
+
+    buckets->mask = count - 1;
+    return buckets;
+}
+
+/* Returns a token that must be passed to concurrentmap_read_unlock() */
+static size_t concurrentmap_read_lock(ConcurrentMap map) {
+    /* Threads have separate stacks, so the address of a local picks a slot that differs between threads, without thread-local storage */
+    char marker;
+    const size_t slot = (size_t) ((((uintptr_t) &marker >> 12) * 2654435761u) >> 16) % CONCURRENTMAP_READER_SLOTS;
+
+    while (1) {
+        const size_t parity = map->epoch & 1;
+
+        /* If the epoch advanced before the counter was incremented, the reclaiming writer may not have seen this reader, so try again */
+        atomic_add(&map->slots[slot].readers[parity], 1);
+        if ((map->epoch & 1) == parity)
+            return slot * 2 + parity;
+
+        atomic_sub(&map->slots[slot].readers[parity], 1);
+    }
+}
+
+static void concurrentmap_read_unlock(ConcurrentMap map, size_t token) {
+    atomic_sub(&map->slots[token / 2].readers[token & 1], 1);
+}
+
+static int concurrentmap_readers_drained(ConcurrentMap map, size_t parity) {
+    for (size_t i = 0; i < CONCURRENTMAP_READER_SLOTS; ++i) {
+        if (atomic_load(&map->slots[i].readers[parity]) != 0)
+            return 0;
+    }
+
+    return 1;
+}
+
+/* Completes the current grace period if its readers have left, then starts grace period `needed` if it hasn't started yet.
+ * The reclaim lock must be held */
+static void concurrentmap_advance(ConcurrentMap map, size_t needed) {
+    /* Readers that registered before the epoch advanced used the parity of the previous epoch */
+    if (map->grace_completed != map->grace_started && concurrentmap_readers_drained(map, (map->grace_started - 1) & 1))
+        map->grace_completed = map->grace_started;
+
+    if (map->grace_completed == map->grace_started && needed > map->grace_started) {
+        atomic_add(&map->epoch, 1);
+        ++map->grace_started;
+    }
+}
+
+static void concurrentmap_free_batch(ConcurrentMap map, ConcurrentMapBatch *batch) {
+    while (batch->nodes) {
+        ConcurrentMapNode *next = batch->nodes->retired;
+        concurrentmap_free_node(map, batch->nodes);
+        batch->nodes = next;
+    }
+
+    while (batch->buckets) {
+        ConcurrentMapBuckets *next = batch->buckets->retired;
+        FREE(batch->buckets);
+        batch->buckets = next;
+    }
+
+    batch->count = 0;
+}
+
+static void concurrentmap_merge_batch(ConcurrentMapBatch *dst, ConcurrentMapBatch *src) {
+    while (src->nodes) {
+        ConcurrentMapNode *next = src->nodes->retired;
+        src->nodes->retired = dst->nodes;
+        dst->nodes = src->nodes;
+        src->nodes = next;
+    }
+
+    while (src->buckets) {
+        ConcurrentMapBuckets *next = src->buckets->retired;
+        src->buckets->retired = dst->buckets;
+        dst->buckets = src->buckets;
+        src->buckets = next;
+    }
+
+    dst->count += src->count;
+    src->count = 0;
+}
+
+static int concurrentmap_batch_empty(const ConcurrentMapBatch *batch) {
+    return batch->nodes == NULL && batch->buckets == NULL;
+}
+
+/* Moves the shard's retired batch to wait for a grace period that starts after it was retired,
+ * and frees batches whose grace period has completed. Returns the number of nodes still waiting. The shard must be locked */
+static size_t concurrentmap_reclaim(ConcurrentMap map, ConcurrentMapShard *shard) {
+    ConcurrentMapBatch completed[2] = {{0}, {0}};
+    size_t needed = 0, waiting = 0;
+
+    mutex_lock(map->reclaim_lock);
+
+    for (size_t i = 0; i < 2; ++i) {
+        if (!concurrentmap_batch_empty(&shard->pending[i]) && shard->pending[i].grace_period > needed)
+            needed = shard->pending[i].grace_period;
+    }
+
+    /* Readers might still see the retired batch unless they registered after the next epoch change */
+    if (!concurrentmap_batch_empty(&shard->retired))
+        needed = shard->retired.grace_period = map->grace_started + 1;
+
+    concurrentmap_advance(map, needed);
+
+    for (size_t i = 0; i < 2; ++i) {
+        if (!concurrentmap_batch_empty(&shard->pending[i]) && shard->pending[i].grace_period <= map->grace_completed) {
+            completed[i] = shard->pending[i];
+            shard->pending[i] = (ConcurrentMapBatch) {0};
+        }
+    }
+
+    mutex_unlock(map->reclaim_lock);
+
+    if (!concurrentmap_batch_empty(&shard->retired)) {
+        ConcurrentMapBatch *pending = &shard->pending[0];
+
+        if (!concurrentmap_batch_empty(pending) && pending->grace_period != shard->retired.grace_period)
+            pending = &shard->pending[1];
+
+        pending->grace_period = shard->retired.grace_period;
+        concurrentmap_merge_batch(pending, &shard->retired);
+    }
+
+    for (size_t i = 0; i < 2; ++i) {
+        concurrentmap_free_batch(map, &completed[i]);
+        waiting += shard->pending[i].count;
+    }
+
+    return waiting;
+}
+
+/* Retires a node that has been unlinked. The shard must be locked */
+static void concurrentmap_retire(ConcurrentMap map, ConcurrentMapShard *shard, ConcurrentMapNode *node) {
+    node->retired = shard->retired.nodes;
+    shard->retired.nodes = node;
+
+    if (++shard->retired.count >= CONCURRENTMAP_RECLAIM_THRESHOLD) {
+        /* Bound memory use if readers keep grace periods from completing */
+        while (concurrentmap_reclaim(map, shard) > CONCURRENTMAP_MAX_PENDING)
+            thread_yield();
+    }
+}
+
+/* Doubles the number of buckets in a shard. The shard must be locked.
+ *
+ * Readers may be walking the old chains, so nodes can't be relinked. Instead every node is copied into the new chains,
+ * and the old nodes and bucket array are retired. Element pointers are shared between the copies, and owned by the new nodes.
+ * If out of memory, the shard is left as it is, which only makes chains longer */
+static void concurrentmap_grow(ConcurrentMap map, ConcurrentMapShard *shard) {
+    ConcurrentMapBuckets *old_buckets = concurrentmap_load_buckets(shard);
+    ConcurrentMapBuckets *buckets = concurrentmap_alloc_buckets((old_buckets->mask + 1) * 2);
+    if (buckets == NULL)
+        return;
+
+    /* Allocate all copies before changing anything, so failure doesn't need to be undone */
+    ConcurrentMapNode *copies = NULL;
+    for (size_t i = 0; i < shard->size; ++i) {
+        ConcurrentMapNode *copy = MALLOC(map->node_size);
+        if (copy == NULL) {
+            while (copies) {
+                ConcurrentMapNode *next = copies->next;
+                FREE(copies);
+                copies = next;
+            }
+
+            FREE(buckets);
+            return;
+        }
+
+        copy->next = copies;
+        copies = copy;
+    }
+
+    for (size_t i = 0; i <= old_buckets->mask; ++i) {
+        for (ConcurrentMapNode *node = concurrentmap_load(&old_buckets->heads[i]); node; node = concurrentmap_load(&node->next)) {
+            ConcurrentMapNode *copy = copies;
+            copies = copies->next;
+
+            memcpy(copy, node, map->node_size);
+            node->owns = 0;
+
+            ConcurrentMapNode *volatile *bucket = concurrentmap_bucket(map, buckets, copy->hash);
+            copy->next = *bucket;
+            *bucket = copy;
+        }
+    }
+
+    /* Nothing in the new array is visible to readers until it is published */
+    atomicp_set((volatile AtomicPointer *) &shard->buckets, buckets);
+
+    for (size_t i = 0; i <= old_buckets->mask; ++i) {
+        for (ConcurrentMapNode *node = concurrentmap_load(&old_buckets->heads[i]); node; node = concurrentmap_load(&node->next)) {
+            node->retired = shard->retired.nodes;
+            shard->retired.nodes = node;
+        }
+    }
+
+    old_buckets->retired = shard->retired.buckets;
+    shard->retired.buckets = old_buckets;
+    shard->retired.count += shard->size;
+
+    /* A whole shard was just retired, so don't wait for the batch to fill */
+    concurrentmap_reclaim(map, shard);
+}
+
+ConcurrentMap concurrentmap_create(const CommonContainerBase *key_base, const CommonContainerBase *value_base, size_t shards) {
+    if (key_base == NULL || value_base == NULL || key_base->compare == NULL || key_base->hash == NULL)
+        return NULL;
+
+    if (shards == 0)
+        shards = CONCURRENTMAP_DEFAULT_SHARDS;
+
+    ConcurrentMap map = CALLOC(1, sizeof(*map));
+    if (map == NULL)
+        return NULL;
+
+    map->key_base = container_base_copy_if_dynamic(key_base);
+    map->value_base = container_base_copy_if_dynamic(value_base);
+    map->reclaim_lock = mutex_create();
+    map->shard_count = shards;
+    map->shard_stride = concurrentmap_align(sizeof(ConcurrentMapShard), CONCURRENTMAP_CACHE_LINE);
+
+    if (map->key_base == NULL || map->value_base == NULL || map->reclaim_lock == NULL)
+        goto cleanup;
+
+    const size_t value_alignment = concurrentmap_element_alignment(value_base);
+    map->key_offset = concurrentmap_align(sizeof(ConcurrentMapNode), concurrentmap_element_alignment(key_base));
+    map->value_offset = concurrentmap_align(map->key_offset + concurrentmap_element_size(key_base), value_alignment);
+    map->node_size = concurrentmap_align(map->value_offset + concurrentmap_element_size(value_base), sizeof(void*));
+
+    if (shards > (SIZE_MAX - CONCURRENTMAP_CACHE_LINE) / map->shard_stride)
+        goto cleanup;
+
+    /* Shards are aligned to cache lines so writers on different shards don't contend */
+    map->shard_allocation = CALLOC(1, shards * map->shard_stride + CONCURRENTMAP_CACHE_LINE);
+    if (map->shard_allocation == NULL)
+        goto cleanup;
+
+    map->shards = (unsigned char *) concurrentmap_align((uintptr_t) map->shard_allocation, CONCURRENTMAP_CACHE_LINE);
+
+    for (size_t i = 0; i < shards; ++i) {
+        ConcurrentMapShard *shard = (ConcurrentMapShard *) (map->shards + i * map->shard_stride);
+
+        shard->lock = mutex_create();
+        shard->buckets = concurrentmap_alloc_buckets(CONCURRENTMAP_MIN_BUCKETS);
+
+        if (shard->lock == NULL || shard->buckets == NULL)
+            goto cleanup;
+    }
+
+    return map;
+
+cleanup:
+    concurrentmap_destroy(map);
+    return NULL;
+}
+
+void concurrentmap_destroy(ConcurrentMap map) {
+    if (map == NULL)
+        return;
+
+    for (size_t i = 0; map->shards && i < map->shard_count; ++i) {
+        ConcurrentMapShard *shard = (ConcurrentMapShard *) (map->shards + i * map->shard_stride);
+
+        if (shard->buckets) {
+            for (size_t j = 0; j <= shard->buckets->mask; ++j) {
+                ConcurrentMapNode *node = shard->buckets->heads[j];
+
+                while (node) {
+                    ConcurrentMapNode *next = node->next;
+                    concurrentmap_free_node(map, node);
+                    node = next;
+                }
+            }
+
+            FREE(shard->buckets);
+        }
+
+        /* No readers remain, so retired memory can be freed without waiting */
+        concurrentmap_free_batch(map, &shard->retired);
+        concurrentmap_free_batch(map, &shard->pending[0]);
+        concurrentmap_free_batch(map, &shard->pending[1]);
+
+        if (shard->lock)
+            mutex_destroy(shard->lock);
+    }
+
+    if (map->reclaim_lock)
+        mutex_destroy(map->reclaim_lock);
+
+    container_base_destroy_if_dynamic(map->key_base);
+    container_base_destroy_if_dynamic(map->value_base);
+    FREE(map->shard_allocation);
+    FREE(map);
+}
+
+/* Returns the link that points to the node containing `key`, and stores that node in `found`, or NULL if not found.
+ * Must be called with the shard locked or while registered as a reader.
+ * Readers must use `found` rather than loading the link again, since a writer may have relinked it since */
+static ConcurrentMapNode *volatile *concurrentmap_find_link(ConcurrentMap map, ConcurrentMapShard *shard, const void *key, size_t hash, ConcurrentMapNode **found) {
+    ConcurrentMapNode *volatile *link = concurrentmap_bucket(map, concurrentmap_load_buckets(shard), hash);
+    ConcurrentMapNode *node;
+
+    for (; (node = concurrentmap_load(link)) != NULL; link = &node->next) {
+        if (node->hash == hash && map->key_base->compare(concurrentmap_key(map, node), key) == 0)
+            break;
+    }
+
+    *found = node;
+    return link;
+}
+
+/* Returns the node containing `key`, or NULL if not found. Must be called while registered as a reader */
+static ConcurrentMapNode *concurrentmap_find(ConcurrentMap map, ConcurrentMapShard *shard, const void *key, size_t hash) {
+    ConcurrentMapNode *node;
+
+    concurrentmap_find_link(map, shard, key, hash, &node);
+    return node;
+}
+
+/* Inserts or replaces the value of a key. `copy_value` specifies whether `value` is copied or moved.
+ * A moved value is destroyed if an error is returned */
+static int concurrentmap_insert_helper(ConcurrentMap map, const void *key, void *value, int copy_value) {
+    const size_t hash = concurrentmap_hash(map, key);
+    ConcurrentMapShard *shard = concurrentmap_shard(map, hash);
+    int err = 0;
+
+    /* The new node is prepared before locking, so copiers don't run while writers of the shard wait */
+    ConcurrentMapNode *node = MALLOC(map->node_size);
+    if (node == NULL) {
+        err = CC_ENOMEM;
+        goto cleanup;
+    }
+
+    if (copy_value)
+        err = concurrentmap_store_copy(map->value_base, concurrentmap_value_storage(map, node), value);
+    else
+        concurrentmap_store_move(map->value_base, concurrentmap_value_storage(map, node), value);
+
+    if (err)
+        goto cleanup;
+
+    node->hash = hash;
+    node->retired = NULL;
+    node->owns = CONCURRENTMAP_OWNS_VALUE;
+
+    mutex_lock(shard->lock);
+
+    ConcurrentMapNode *existing;
+    ConcurrentMapNode *volatile *link = concurrentmap_find_link(map, shard, key, hash, &existing);
+
+    if (existing) {
+        /* Readers may be reading the old value, so the key is handed to the new node and the old node keeps the value until it is reclaimed */
+        memcpy(concurrentmap_key_storage(map, node), concurrentmap_key_storage(map, existing), concurrentmap_element_size(map->key_base));
+        node->owns |= CONCURRENTMAP_OWNS_KEY;
+        node->next = concurrentmap_load(&existing->next);
+
+        existing->owns &= ~CONCURRENTMAP_OWNS_KEY;
+        atomicp_set((volatile AtomicPointer *) link, node);
+        concurrentmap_retire(map, shard, existing);
+    } else {
+        err = concurrentmap_store_copy(map->key_base, concurrentmap_key_storage(map, node), key);
+        if (err) {
+            mutex_unlock(shard->lock);
+            concurrentmap_destroy_element(map->value_base, concurrentmap_value_storage(map, node));
+            FREE(node);
+            return err;
+        }
+
+        node->owns |= CONCURRENTMAP_OWNS_KEY;
+        node->next = NULL;
+        atomicp_set((volatile AtomicPointer *) link, node);
+
+        if (++shard->size > concurrentmap_load_buckets(shard)->mask + 1)
+            concurrentmap_grow(map, shard);
+    }
+
+    mutex_unlock(shard->lock);
+    return 0;
+
+cleanup:
+    if (!copy_value)
+        concurrentmap_discard_moved(map->value_base, value);
+
+    FREE(node);
+    return err;
+}
+
+int concurrentmap_insert(ConcurrentMap map, const void *key, const void *item) {
+    return concurrentmap_insert_helper(map, key, (void *) item, 1);
+}
+
+int concurrentmap_insert_move(ConcurrentMap map, const void *key, void *item) {
+    return concurrentmap_insert_helper(map, key, item, 0);
+}
+
+int concurrentmap_remove(ConcurrentMap map, const void *key) {
+    const size_t hash = concurrentmap_hash(map, key);
+    ConcurrentMapShard *shard = concurrentmap_shard(map, hash);
+
+    mutex_lock(shard->lock);
+
+    ConcurrentMapNode *node;
+    ConcurrentMapNode *volatile *link = concurrentmap_find_link(map, shard, key, hash, &node);
+    if (node) {
+        /* The removed node keeps its `next` link, so readers currently on it can continue down the chain */
+        atomicp_set((volatile AtomicPointer *) link, concurrentmap_load(&node->next));
+        --shard->size;
+        concurrentmap_retire(map, shard, node);
+    }
+
+    mutex_unlock(shard->lock);
+
+    return node != NULL;
+}
+
+int concurrentmap_contains(ConcurrentMap map, const void *key) {
+    const size_t hash = concurrentmap_hash(map, key);
+    ConcurrentMapShard *shard = concurrentmap_shard(map, hash);
+    const size_t token = concurrentmap_read_lock(map);
+
+    const int found = concurrentmap_find(map, shard, key, hash) != NULL;
+
+    concurrentmap_read_unlock(map, token);
+    return found;
+}
+
+int concurrentmap_get_copy(ConcurrentMap map, const void *key, void *item) {
+    const size_t hash = concurrentmap_hash(map, key);
+    ConcurrentMapShard *shard = concurrentmap_shard(map, hash);
+    const size_t token = concurrentmap_read_lock(map);
+    int err = CC_ENOENT;
+
+    ConcurrentMapNode *node = concurrentmap_find(map, shard, key, hash);
+    if (node) {
+        const void *value = concurrentmap_value(map, node);
+
+        /* POD values are copied directly, even if too large to be stored inline */
+        if (map->value_base->size) {
+            memcpy(item, value, map->value_base->size);
+            err = 0;
+        } else
+            err = concurrentmap_store_copy(map->value_base, item, value);
+    }
+
+    concurrentmap_read_unlock(map, token);
+    return err;
+}
+
+int concurrentmap_read(ConcurrentMap map, const void *key, void (*reader)(const void *item, void *userdata), void *userdata) {
+    const size_t hash = concurrentmap_hash(map, key);
+    ConcurrentMapShard *shard = concurrentmap_shard(map, hash);
+    const size_t token = concurrentmap_read_lock(map);
+
+    ConcurrentMapNode *node = concurrentmap_find(map, shard, key, hash);
+    if (node)
+        reader(concurrentmap_value(map, node), userdata);
+
+    concurrentmap_read_unlock(map, token);
+    return node != NULL;
+}
+
+size_t concurrentmap_size(ConcurrentMap map) {
+    size_t size = 0;
+
+    for (size_t i = 0; i < map->shard_count; ++i) {
+        ConcurrentMapShard *shard = (ConcurrentMapShard *) (map->shards + i * map->shard_stride);
+
+        mutex_lock(shard->lock);
+        size += shard->size;
+        mutex_unlock(shard->lock);
+    }
+
+    return size;
+}
+
+const CommonContainerBase *concurrentmap_get_key_container_base(ConcurrentMap map) {
+    return map->key_base;
+}
+
+const CommonContainerBase *concurrentmap_get_value_container_base(ConcurrentMap map) {
+    return map->value_base;
+}
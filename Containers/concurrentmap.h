@@ -0,0 +1,58 @@
+/** @file
+ *
+ *  @author Oliver Adams
+ *  @copyright Copyright (C) 2020
+ */
+
+#ifndef CONCURRENTMAP_H
+#define CONCURRENTMAP_H
+
+#include "common.h"
+
+/* A ConcurrentMap is split into shards by key hash, and each shard has its own lock that is only taken by writers.
+ * Readers never lock or write to shared nodes. Nodes that are removed or replaced are freed once every reader that could still see them has finished,
+ * so values read from the map are copied out or only accessed inside a callback, instead of being returned as iterators.
+ *
+ * Keys and values are owned by the map and copied or destroyed with their container bases, as with the other containers.
+ */
+
+/** @brief Creates a concurrent map.
+ *
+ * The key container base must provide both a `compare` and a `hash` function, otherwise NULL is returned.
+ *
+ * @param key_base The container base of the keys.
+ * @param value_base The container base of the values.
+ * @param shards The number of independently locked shards, or 0 to use a default. More shards reduce contention between writers.
+ * @return A new, empty map, or NULL if out of memory.
+ */
+ConcurrentMap concurrentmap_create(const CommonContainerBase *key_base, const CommonContainerBase *value_base, size_t shards);
+/* Must not be called while any other thread is using the map */
+void concurrentmap_destroy(ConcurrentMap map);
+/* The key and value are both copied into the map, replacing any existing value. Returns 0 on success or an error if they could not be copied */
+int concurrentmap_insert(ConcurrentMap map, const void *key, const void *item);
+/* The key is copied and the value is moved into the map, replacing any existing value. The value is destroyed if an error is returned */
+int concurrentmap_insert_move(ConcurrentMap map, const void *key, void *item);
+/* Returns non-zero if the key was removed, or 0 if it was not in the map */
+int concurrentmap_remove(ConcurrentMap map, const void *key);
+int concurrentmap_contains(ConcurrentMap map, const void *key);
+/** @brief Copies the value of a key out of the map.
+ *
+ * POD values are copied into @p item. For other values, a copy made with the value container base's copier is stored in `*(void **) item`,
+ * and must be destroyed by the caller.
+ *
+ * @return 0 on success, CC_ENOENT if the key is not in the map, or another error if the value could not be copied.
+ */
+int concurrentmap_get_copy(ConcurrentMap map, const void *key, void *item);
+/** @brief Calls @p reader with the value of a key, without copying it.
+ *
+ * The value is only valid until @p reader returns, and must not be modified, since other threads may be reading it.
+ * @p reader must not modify the map.
+ *
+ * @return Non-zero if the key was found and @p reader was called, 0 otherwise.
+ */
+int concurrentmap_read(ConcurrentMap map, const void *key, void (*reader)(const void *item, void *userdata), void *userdata);
+size_t concurrentmap_size(ConcurrentMap map);
+const CommonContainerBase *concurrentmap_get_key_container_base(ConcurrentMap map);
+const CommonContainerBase *concurrentmap_get_value_container_base(ConcurrentMap map);
+
+#endif // CONCURRENTMAP_H
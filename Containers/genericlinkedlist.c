@@ -6,17 +6,264 @@
 #include "variant.h"
 #include "genericmap.h"
 
+/* Nodes are allocated from slabs owned by the list and recycled through a free list, so growing and shrinking a list rarely calls the allocator.
+ *
+ * Normally every node holds a single element. Unrolled lists hold several elements per node, and every node is a power of two in size and aligned to its size,
+ * so the node containing an element is found by masking off the low bits of the element's address.
+ * Iterators point to an element inside its node. POD elements are stored inline, non-POD elements are stored as pointers.
+ */
+#define GENERICLINKEDLIST_HEADER_SIZE ((sizeof(struct GenericLinkedListNode) + 15) & ~(size_t) 15)
+
+/* Minimum size of a node of an unrolled list. Nodes are made larger if fewer than GENERICLINKEDLIST_MIN_UNROLLED_ELEMENTS would fit */
+#define GENERICLINKEDLIST_UNROLLED_NODE_SIZE 256
+#define GENERICLINKEDLIST_MIN_UNROLLED_ELEMENTS 4
+
+/* Slabs start small so small lists stay small, and double in size up to the maximum */
+#define GENERICLINKEDLIST_MIN_SLAB_NODES 4
+#define GENERICLINKEDLIST_MAX_SLAB_NODES 1024
+
+/* POD elements up to this size are buffered on the stack when inserting, larger ones use the heap */
+#define GENERICLINKEDLIST_ELEMENT_BUFFER_SIZE 64
+
 struct GenericLinkedListNode {
-    struct GenericLinkedListNode *next;
-    unsigned char data[];
+    struct GenericLinkedListNode *next; /* Free nodes are linked through `next` as well */
+    size_t count; /* Number of elements in the node */
+    /* Followed by the elements at GENERICLINKEDLIST_HEADER_SIZE */
 };
 
+struct GenericLinkedListSlab {
+    struct GenericLinkedListSlab *next;
+};
+
+/* Nodes in a slab start at this offset, so they are suitably aligned for any inline element */
+#define GENERICLINKEDLIST_SLAB_HEADER_SIZE ((sizeof(struct GenericLinkedListSlab) + 15) & ~(size_t) 15)
+
 struct GenericLinkedListStruct {
     CommonContainerBase *base;
     struct GenericLinkedListNode *head, *tail;
     size_t size;
+
+    /* Layout of the nodes, fixed when the list is created */
+    size_t element_size; /* Size in bytes of an element as stored in a node */
+    size_t node_size; /* Size in bytes of every node */
+    size_t node_capacity; /* Maximum number of elements in a node, 1 unless the list is unrolled */
+
+    struct GenericLinkedListSlab *slabs; /* All nodes are allocated from these slabs, and are only freed when the list is cleared or destroyed */
+    unsigned char *slab_next; /* Next unused node in the most recent slab */
+    size_t slab_remaining; /* Number of unused nodes at `slab_next` */
+    size_t slab_nodes; /* Number of nodes to allocate in the next slab */
+    struct GenericLinkedListNode *free_nodes;
 };
 
+static unsigned char *genericlinkedlist_slot(GenericLinkedList list, struct GenericLinkedListNode *node, size_t index) {
+    return (unsigned char *) node + GENERICLINKEDLIST_HEADER_SIZE + index * list->element_size;
+}
+
+static struct GenericLinkedListNode *genericlinkedlist_node_of(GenericLinkedList list, Iterator it) {
+    if (list->node_capacity == 1)
+        return (struct GenericLinkedListNode *) ((unsigned char *) it - GENERICLINKEDLIST_HEADER_SIZE);
+
+    return (struct GenericLinkedListNode *) ((uintptr_t) it & ~(uintptr_t) (list->node_size - 1));
+}
+
+static size_t genericlinkedlist_index_of(GenericLinkedList list, struct GenericLinkedListNode *node, Iterator it) {
+    return ((unsigned char *) it - genericlinkedlist_slot(list, node, 0)) / list->element_size;
+}
+
+/* Returns an iterator to the last element of the list, or NULL if the list is empty */
+static Iterator genericlinkedlist_last(GenericLinkedList list) {
+    return list->tail? genericlinkedlist_slot(list, list->tail, list->tail->count - 1): NULL;
+}
+
+static struct GenericLinkedListNode *genericlinkedlist_node_alloc(GenericLinkedList list) {
+    struct GenericLinkedListNode *node = list->free_nodes;
+
+    if (node != NULL) {
+        list->free_nodes = node->next;
+    } else {
+        if (list->slab_remaining == 0) {
+            /* Unrolled nodes are aligned to their size, so one extra node is allocated to make room for the alignment */
+            const size_t alignment = list->node_capacity == 1? 0: list->node_size;
+            struct GenericLinkedListSlab *slab = MALLOC(GENERICLINKEDLIST_SLAB_HEADER_SIZE + (list->slab_nodes + !!alignment) * list->node_size);
+            if (slab == NULL)
+                return NULL;
+
+            slab->next = list->slabs;
+            list->slabs = slab;
+            list->slab_next = (unsigned char *) slab + GENERICLINKEDLIST_SLAB_HEADER_SIZE;
+            list->slab_remaining = list->slab_nodes;
+
+            if (alignment)
+                list->slab_next = (unsigned char *) (((uintptr_t) list->slab_next + alignment - 1) & ~(uintptr_t) (alignment - 1));
+
+            if (list->slab_nodes < GENERICLINKEDLIST_MAX_SLAB_NODES)
+                list->slab_nodes *= 2;
+        }
+
+        node = (struct GenericLinkedListNode *) list->slab_next;
+        list->slab_next += list->node_size;
+        list->slab_remaining -= 1;
+    }
+
+    node->next = NULL;
+    node->count = 0;
+
+    return node;
+}
+
+/* Returns a node to the free list of the list, the elements must already have been destroyed or moved */
+static void genericlinkedlist_node_free(GenericLinkedList list, struct GenericLinkedListNode *node) {
+    node->next = list->free_nodes;
+    list->free_nodes = node;
+}
+
+/* Ensures that the next `count` node allocations will succeed */
+static int genericlinkedlist_reserve_nodes(GenericLinkedList list, size_t count) {
+    struct GenericLinkedListNode *reserved = NULL;
+    size_t i;
+
+    for (i = 0; i < count; ++i) {
+        struct GenericLinkedListNode *node = genericlinkedlist_node_alloc(list);
+        if (node == NULL)
+            break;
+
+        node->next = reserved;
+        reserved = node;
+    }
+
+    while (reserved) {
+        struct GenericLinkedListNode *next = reserved->next;
+        genericlinkedlist_node_free(list, reserved);
+        reserved = next;
+    }
+
+    return i == count? 0: CC_ENOMEM;
+}
+
+static void genericlinkedlist_destroy_element(GenericLinkedList list, unsigned char *slot) {
+    if (!list->base->size && list->base->deleter)
+        list->base->deleter(*((void **) slot));
+}
+
+/* Destroys all elements in the list and frees all slabs at once */
+static void genericlinkedlist_destroy_nodes(GenericLinkedList list) {
+    if (!list->base->size && list->base->deleter) {
+        for (struct GenericLinkedListNode *node = list->head; node; node = node->next)
+            for (size_t i = 0; i < node->count; ++i)
+                genericlinkedlist_destroy_element(list, genericlinkedlist_slot(list, node, i));
+    }
+
+    while (list->slabs) {
+        struct GenericLinkedListSlab *next = list->slabs->next;
+        FREE(list->slabs);
+        list->slabs = next;
+    }
+
+    list->head = list->tail = NULL;
+    list->size = 0;
+    list->slab_next = NULL;
+    list->slab_remaining = 0;
+    list->slab_nodes = GENERICLINKEDLIST_MIN_SLAB_NODES;
+    list->free_nodes = NULL;
+}
+
+/* Makes room for a new element after `after_it`, or at the start of the list if `after_it` is NULL, and returns the uninitialized slot for it.
+ * Returns NULL and leaves the list unchanged if a node could not be allocated */
+static unsigned char *genericlinkedlist_make_room(GenericLinkedList list, Iterator after_it) {
+    struct GenericLinkedListNode *node = after_it? genericlinkedlist_node_of(list, after_it): list->head;
+    size_t index = after_it? genericlinkedlist_index_of(list, node, after_it) + 1: 0;
+    const size_t element_size = list->element_size;
+
+    if (node != NULL && node->count == list->node_capacity) {
+        if (index == node->count && node->next && node->next->count < list->node_capacity) {
+            /* Appending to a full node, but the following node has room at its start */
+            node = node->next;
+            index = 0;
+        } else {
+            struct GenericLinkedListNode *new_node = genericlinkedlist_node_alloc(list);
+            if (new_node == NULL)
+                return NULL;
+
+            if (after_it == NULL) { /* Full head, so add a new head in front of it */
+                new_node->next = list->head;
+                list->head = new_node;
+                node = new_node;
+            } else {
+                new_node->next = node->next;
+                node->next = new_node;
+
+                if (list->tail == node)
+                    list->tail = new_node;
+
+                if (index == node->count) { /* Appending to a full node, so start the new node with the new element */
+                    node = new_node;
+                    index = 0;
+                } else { /* Inserting into the middle of a full node, so split it in half */
+                    const size_t kept = node->count - node->count / 2;
+
+                    memcpy(genericlinkedlist_slot(list, new_node, 0), genericlinkedlist_slot(list, node, kept), (node->count - kept) * element_size);
+                    new_node->count = node->count - kept;
+                    node->count = kept;
+
+                    if (index > kept) {
+                        node = new_node;
+                        index -= kept;
+                    }
+                }
+            }
+        }
+    } else if (node == NULL) { /* Empty list */
+        node = genericlinkedlist_node_alloc(list);
+        if (node == NULL)
+            return NULL;
+
+        list->head = list->tail = node;
+    }
+
+    unsigned char *slot = genericlinkedlist_slot(list, node, index);
+
+    memmove(slot + element_size, slot, (node->count - index) * element_size);
+    ++node->count;
+    ++list->size;
+
+    return slot;
+}
+
+static GenericLinkedList genericlinkedlist_create_helper(const CommonContainerBase *base, int unrolled) {
+    if (base == NULL)
+        return NULL;
+
+    struct GenericLinkedListStruct *list = CALLOC(1, sizeof(*list));
+    CommonContainerBase *new_base = container_base_copy_if_dynamic(base);
+    if (list == NULL || new_base == NULL) {
+        FREE(list);
+        container_base_destroy_if_dynamic(new_base);
+        return NULL;
+    }
+
+    list->base = new_base;
+    list->element_size = base->size? base->size: sizeof(void*);
+    list->slab_nodes = GENERICLINKEDLIST_MIN_SLAB_NODES;
+
+    if (unrolled) {
+        list->node_size = GENERICLINKEDLIST_UNROLLED_NODE_SIZE;
+        while ((list->node_size - GENERICLINKEDLIST_HEADER_SIZE) / list->element_size < GENERICLINKEDLIST_MIN_UNROLLED_ELEMENTS)
+            list->node_size *= 2;
+
+        list->node_capacity = (list->node_size - GENERICLINKEDLIST_HEADER_SIZE) / list->element_size;
+    } else {
+        list->node_size = (GENERICLINKEDLIST_HEADER_SIZE + list->element_size + 15) & ~(size_t) 15;
+        list->node_capacity = 1;
+    }
+
+    return list;
+}
+
+/* Creates an empty list with the same container base and mode as `other` */
+static GenericLinkedList genericlinkedlist_create_like(GenericLinkedList other) {
+    return genericlinkedlist_create_helper(other->base, other->node_capacity > 1);
+}
+
 Variant variant_from_genericlinkedlist(GenericLinkedList list) {
     return variant_create_custom_adopt(list, genericlinkedlist_build_recipe(list));
 }
@@ -41,21 +288,19 @@ int variant_set_genericlinkedlist(Variant var, const GenericLinkedList list) {
 }
 
 GenericLinkedList genericlinkedlist_create(const CommonContainerBase *base) {
-    struct GenericLinkedListStruct *list = CALLOC(1, sizeof(*list));
-    CommonContainerBase *new_base = container_base_copy_if_dynamic(base);
-    if (list == NULL || new_base == NULL) {
-        FREE(list);
-        container_base_destroy_if_dynamic(new_base);
-        return NULL;
-    }
+    return genericlinkedlist_create_helper(base, 0);
+}
 
-    list->base = new_base;
+GenericLinkedList genericlinkedlist_create_unrolled(const CommonContainerBase *base) {
+    return genericlinkedlist_create_helper(base, 1);
+}
 
-    return list;
+int genericlinkedlist_is_unrolled(GenericLinkedList list) {
+    return list->node_capacity > 1;
 }
 
 GenericLinkedList genericlinkedlist_copy(GenericLinkedList other) {
-    GenericLinkedList list = genericlinkedlist_create(genericlinkedlist_get_container_base(other));
+    GenericLinkedList list = genericlinkedlist_create_like(other);
     if (list == NULL)
         return NULL;
 
@@ -73,7 +318,7 @@ GenericLinkedList genericlinkedlist_concatenate(GenericLinkedList left, GenericL
     if (generic_types_compatible_compare(genericlinkedlist_get_container_base(left), genericlinkedlist_get_container_base(right)) != 0)
         return NULL;
 
-    GenericLinkedList list = genericlinkedlist_create(genericlinkedlist_get_container_base(left));
+    GenericLinkedList list = genericlinkedlist_create_like(left);
     if (list == NULL)
         return NULL;
 
@@ -135,11 +380,12 @@ GenericLinkedList genericlinkedlist_from_array_n(const void **items, size_t coun
 
 int genericlinkedlist_append_list(GenericLinkedList list, GenericLinkedList other) {
     int err = 0;
-    size_t list_size = genericlinkedlist_size(list);
-    struct GenericLinkedListNode *original_tail = list->tail;
+    /* The size is saved because if `list` and `other` are the same list, the size will change when items are added */
+    size_t other_size = genericlinkedlist_size(other);
+    Iterator original_last = genericlinkedlist_last(list);
 
     Iterator it = genericlinkedlist_begin(other);
-    for (size_t i = 0; i < list_size; ++i, it = genericlinkedlist_next(other, it)) {
+    for (size_t i = 0; i < other_size; ++i, it = genericlinkedlist_next(other, it)) {
         err = genericlinkedlist_append(list, genericlinkedlist_value_of(other, it));
         if (err)
             goto cleanup;
@@ -148,18 +394,18 @@ int genericlinkedlist_append_list(GenericLinkedList list, GenericLinkedList othe
     return 0;
 
 cleanup:
-    while (genericlinkedlist_remove_after(list, original_tail))
+    while (genericlinkedlist_remove_after(list, original_last))
         ;
 
     return err;
 }
 
 int genericlinkedlist_append(GenericLinkedList list, const void *item) {
-    return genericlinkedlist_insert(list, item, list->tail);
+    return genericlinkedlist_insert(list, item, genericlinkedlist_last(list));
 }
 
 int genericlinkedlist_append_move(GenericLinkedList list, void *item) {
-    return genericlinkedlist_insert_move(list, item, list->tail);
+    return genericlinkedlist_insert_move(list, item, genericlinkedlist_last(list));
 }
 
 int genericlinkedlist_prepend(GenericLinkedList list, const void *item) {
@@ -172,29 +418,26 @@ int genericlinkedlist_prepend_move(GenericLinkedList list, void *item) {
 
 int genericlinkedlist_insert(GenericLinkedList list, const void *item, Iterator after_it) {
     if (list->base->size) { /* POD type */
-        struct GenericLinkedListNode *new_node = CALLOC(1, sizeof(*new_node) + list->base->size), *prev_node = after_it;
-        if (new_node == NULL)
+        unsigned char temp_buffer[GENERICLINKEDLIST_ELEMENT_BUFFER_SIZE]; /* Saves the item, in case it's a reference to an element in this list
+                                                                             that will be moved when making room for the new element. */
+        const size_t element_size = list->base->size;
+        unsigned char *temp = element_size > sizeof(temp_buffer)? MALLOC(element_size): temp_buffer;
+        if (temp == NULL)
             return CC_ENOMEM;
 
         if (item != NULL)
-            memcpy(new_node->data, item, list->base->size);
-
-        if (prev_node) { /* Inserting after a node */
-            new_node->next = prev_node->next;
-            prev_node->next = new_node;
+            memcpy(temp, item, element_size);
+        else
+            memset(temp, 0, element_size);
 
-            if (prev_node == list->tail) /* May have to update the tail if inserting after it */
-                list->tail = new_node;
-        } else { /* Insert at start of list */
-            if (list->head) /* If there is an element, link to it */
-                new_node->next = list->head->next;
-            else /* If list is empty, tail should be set too */
-                list->tail = new_node;
+        unsigned char *slot = genericlinkedlist_make_room(list, after_it);
+        if (slot != NULL)
+            memcpy(slot, temp, element_size);
 
-            list->head = new_node;
-        }
+        if (temp != temp_buffer)
+            FREE(temp);
 
-        ++list->size;
+        return slot? 0: CC_ENOMEM;
     } else { /* Non-POD type */
         if (list->base->copier == NULL)
             return CC_ENOTSUP;
@@ -206,9 +449,9 @@ int genericlinkedlist_insert(GenericLinkedList list, const void *item, Iterator
         int err = genericlinkedlist_insert_move(list, duplicate, after_it);
         if (err && list->base->deleter)
             list->base->deleter(duplicate);
-    }
 
-    return 0;
+        return err;
+    }
 }
 
 int genericlinkedlist_insert_move(GenericLinkedList list, void *item, Iterator after_it) {
@@ -219,28 +462,11 @@ int genericlinkedlist_insert_move(GenericLinkedList list, void *item, Iterator a
 
         FREE(item);
     } else { /* Non-POD type */
-        struct GenericLinkedListNode *new_node = MALLOC(sizeof(*new_node)), *prev_node = after_it;
-        if (new_node == NULL)
+        unsigned char *slot = genericlinkedlist_make_room(list, after_it);
+        if (slot == NULL)
             return CC_ENOMEM;
 
-        *((void **) new_node->data) = item;
-
-        if (prev_node) { /* Inserting after a node */
-            new_node->next = prev_node->next;
-            prev_node->next = new_node;
-
-            if (prev_node == list->tail) /* May have to update the tail if inserting after it */
-                list->tail = new_node;
-        } else { /* Insert at start of list */
-            if (list->head) /* If there is an element, link to it */
-                new_node->next = list->head->next;
-            else /* If list is empty, tail should be set too */
-                list->tail = new_node;
-
-            list->head = new_node;
-        }
-
-        ++list->size;
+        *((void **) slot) = item;
     }
 
     return 0;
@@ -248,12 +474,10 @@ int genericlinkedlist_insert_move(GenericLinkedList list, void *item, Iterator a
 
 int genericlinkedlist_replace_at(GenericLinkedList list, Iterator it, const void *item) {
     if (list->base->size) { /* POD type */
-        struct GenericLinkedListNode *node = it;
-
         if (item == NULL)
-            memset(node->data, 0, list->base->size);
+            memset(it, 0, list->base->size);
         else
-            memmove(node->data, item, list->base->size);
+            memmove(it, item, list->base->size);
     } else { /* Non-POD type */
         if (list->base->copier == NULL)
             return CC_ENOTSUP;
@@ -265,6 +489,8 @@ int genericlinkedlist_replace_at(GenericLinkedList list, Iterator it, const void
         int err = genericlinkedlist_replace_move_at(list, it, duplicate);
         if (err && list->base->deleter)
             list->base->deleter(duplicate);
+
+        return err;
     }
 
     return 0;
@@ -278,12 +504,9 @@ int genericlinkedlist_replace_move_at(GenericLinkedList list, Iterator it, void
 
         FREE(item);
     } else { /* Non-POD type */
-        struct GenericLinkedListNode *node = it;
-
-        if (list->base->deleter)
-            list->base->deleter(node->data);
+        genericlinkedlist_destroy_element(list, it);
 
-        *((void **) node->data) = item;
+        *((void **) it) = item;
     }
 
     return 0;
@@ -293,34 +516,44 @@ size_t genericlinkedlist_remove_after(GenericLinkedList list, Iterator it) {
     if (list->head == NULL)
         return 0;
 
-    struct GenericLinkedListNode *node = NULL;
+    struct GenericLinkedListNode *node = NULL, *prev = NULL;
+    size_t index = 0;
 
     if (it == NULL) { /* Remove head of list */
         node = list->head;
-
-        if (list->tail == list->head)
-            list->head = list->tail = NULL;
-        else
-            list->head = list->head->next;
     } else {
-        struct GenericLinkedListNode *prev = it;
-        node = prev->next;
+        node = genericlinkedlist_node_of(list, it);
+        index = genericlinkedlist_index_of(list, node, it) + 1;
 
-        if (node == NULL) /* Trying to delete after tail */
-            return 0;
-
-        if (list->tail == node)
-            list->tail = prev;
+        if (index == node->count) { /* The following element is at the start of the next node */
+            prev = node;
+            node = node->next;
+            index = 0;
 
-        prev->next = node->next;
+            if (node == NULL) /* Trying to delete after tail */
+                return 0;
+        }
     }
 
-    if (!list->base->size && list->base->deleter)
-        list->base->deleter(node->data);
+    unsigned char *slot = genericlinkedlist_slot(list, node, index);
 
-    FREE(node);
+    genericlinkedlist_destroy_element(list, slot);
+    memmove(slot, slot + list->element_size, (node->count - index - 1) * list->element_size);
+    --node->count;
     --list->size;
 
+    if (node->count == 0) {
+        if (prev)
+            prev->next = node->next;
+        else
+            list->head = node->next;
+
+        if (list->tail == node)
+            list->tail = prev;
+
+        genericlinkedlist_node_free(list, node);
+    }
+
     return 1;
 }
 
@@ -429,57 +662,141 @@ int genericlinkedlist_sort(GenericLinkedList list, int descending) {
     return genericlinkedlist_stable_sort(list, descending);
 }
 
-/* Both left and right lists are guaranteed to have at least one element */
+/* Sorts the elements within a single node of an unrolled list with an insertion sort. `temp` must have room for one element */
+static void genericlinkedlist_sort_node(GenericLinkedList list, struct GenericLinkedListNode *node, unsigned char *temp, int descending, int *err) {
+    const size_t element_size = list->element_size;
+
+    for (size_t i = 1; i < node->count; ++i) {
+        size_t j = i;
+
+        memcpy(temp, genericlinkedlist_slot(list, node, i), element_size);
+
+        for (; j > 0; --j) {
+            int cmp = list->base->compare(genericlinkedlist_value_of(list, genericlinkedlist_slot(list, node, j-1)),
+                                          genericlinkedlist_value_of(list, temp));
+            if (cmp == CompareUnordered)
+                *err = CC_ENOTSUP;
+
+            if (cmp * descending <= 0)
+                break;
+
+            memcpy(genericlinkedlist_slot(list, node, j), genericlinkedlist_slot(list, node, j-1), element_size);
+        }
+
+        memcpy(genericlinkedlist_slot(list, node, j), temp, element_size);
+    }
+}
+
+/* Merges the sorted runs `left` and `right` of an unrolled list, which are NULL-terminated chains of nodes, and returns the merged run.
+ * Equal elements are taken from `left` first.
+ *
+ * Nodes are refilled as elements are merged, and input nodes are recycled for the output as soon as they are used up.
+ * The output never gets more than two nodes ahead of the recycled input nodes, so the caller must make sure at least two nodes are free */
+static struct GenericLinkedListNode *genericlinkedlist_merge_runs(GenericLinkedList list,
+                                                                  struct GenericLinkedListNode *left,
+                                                                  struct GenericLinkedListNode *right,
+                                                                  int descending, int *err) {
+    const Compare compare = list->base->compare;
+    const int pod = list->base->size != 0;
+    const size_t element_size = list->element_size;
+    struct GenericLinkedListNode *head = NULL, *tail = NULL;
+    size_t left_index = 0, right_index = 0;
+
+    /* The remainder of the last partially used input node is copied too, so every input node that was read from gets recycled */
+    while ((left && right) || (left && left_index) || (right && right_index)) {
+        struct GenericLinkedListNode **source = &left;
+        size_t *source_index = &left_index;
+
+        if (left == NULL) {
+            source = &right;
+            source_index = &right_index;
+        } else if (right != NULL) {
+            unsigned char *left_slot = genericlinkedlist_slot(list, left, left_index), *right_slot = genericlinkedlist_slot(list, right, right_index);
+            int cmp = compare(pod? left_slot: *((void **) left_slot), pod? right_slot: *((void **) right_slot));
+            if (cmp == CompareUnordered)
+                *err = CC_ENOTSUP;
+
+            if (cmp * descending > 0) {
+                source = &right;
+                source_index = &right_index;
+            }
+        }
+
+        if (tail == NULL || tail->count == list->node_capacity) {
+            struct GenericLinkedListNode *node = genericlinkedlist_node_alloc(list); /* Cannot fail, since enough nodes are free */
+
+            if (tail)
+                tail->next = node;
+            else
+                head = node;
+
+            tail = node;
+        }
+
+        memcpy(genericlinkedlist_slot(list, tail, tail->count++), genericlinkedlist_slot(list, *source, *source_index), element_size);
+
+        if (++*source_index == (*source)->count) {
+            struct GenericLinkedListNode *next = (*source)->next;
+
+            genericlinkedlist_node_free(list, *source);
+            *source = next;
+            *source_index = 0;
+        }
+    }
+
+    /* Whole nodes left over in one of the runs are linked as they are */
+    struct GenericLinkedListNode *rest = left? left: right;
+
+    if (tail)
+        tail->next = rest;
+    else
+        head = rest;
+
+    return head;
+}
+
+/* Merges two sorted chains of single-element nodes by relinking them. Both chains are guaranteed to have at least one node */
 static struct GenericLinkedListNode *genericlinkedlist_merge_sort_helper(GenericLinkedList list,
                                                                          struct GenericLinkedListNode *left,
                                                                          struct GenericLinkedListNode *right,
                                                                          Compare compare, int descending,
                                                                          struct GenericLinkedListNode **tailptr,
                                                                          int *err) {
-    struct GenericLinkedListNode *head = NULL, *tail = NULL;
+    const int pod = list->base->size != 0;
+    struct GenericLinkedListNode *head = NULL, *tail = NULL, **link = &head;
 
     while (left && right) {
-        struct GenericLinkedListNode *temp = NULL;
-        int cmp = compare(genericlinkedlist_value_of(list, left),
-                          genericlinkedlist_value_of(list, right));
-        if (cmp == CompareUnordered && err)
+        unsigned char *left_slot = genericlinkedlist_slot(list, left, 0), *right_slot = genericlinkedlist_slot(list, right, 0);
+        int cmp = compare(pod? left_slot: *((void **) left_slot), pod? right_slot: *((void **) right_slot));
+        if (cmp == CompareUnordered)
             *err = CC_ENOTSUP;
 
-        cmp *= descending;
-
-        if (cmp <= 0) {
-            temp = left;
+        if (cmp * descending <= 0) {
+            tail = left;
             left = left->next;
         } else {
-            temp = right;
+            tail = right;
             right = right->next;
         }
 
-        if (head == NULL) {
-            head = tail = temp;
-        } else {
-            tail->next = temp;
-            tail = temp;
-        }
+        *link = tail;
+        link = &tail->next;
     }
 
     /* Tail is guaranteed to not be NULL because both lists have at least one element and the previous loop will have added something to `head` */
-    for (; left; left = left->next) {
-        tail->next = left;
-        tail = left;
-    }
+    tail->next = left? left: right;
 
-    for (; right; right = right->next) {
-        tail->next = right;
-        tail = right;
-    }
+    if (tailptr) {
+        while (tail->next)
+            tail = tail->next;
 
-    if (tailptr)
         *tailptr = tail;
+    }
 
     return head;
 }
 
+/* Top-down merge sort for lists that are not unrolled. Splitting by length keeps the merges balanced, and relinking avoids copying elements */
 static struct GenericLinkedListNode *genericlinkedlist_merge_sort(GenericLinkedList list,
                                                                   struct GenericLinkedListNode *left,
                                                                   size_t length,
@@ -511,48 +828,113 @@ static struct GenericLinkedListNode *genericlinkedlist_merge_sort(GenericLinkedL
     return genericlinkedlist_merge_sort_helper(list, left, right, compare, descending, tailptr, err);
 }
 
+/* Enough pending runs for any list that fits in memory, since the run at level `i` has 2^i nodes */
+#define GENERICLINKEDLIST_SORT_LEVELS (sizeof(size_t) * CHAR_BIT)
+
 int genericlinkedlist_stable_sort(GenericLinkedList list, int descending) {
     if (list->base->compare == NULL)
         return CC_ENOTSUP;
+    else if (list->size < 2)
+        return 0;
+
+    int err = 0;
+
+    if (list->node_capacity == 1) {
+        list->head = genericlinkedlist_merge_sort(list, list->head, list->size, list->base->compare, descending? -1: 1, &list->tail, &err);
+        return err;
+    }
+
+    unsigned char temp_buffer[GENERICLINKEDLIST_ELEMENT_BUFFER_SIZE];
+    unsigned char *temp = list->element_size > sizeof(temp_buffer)? MALLOC(list->element_size): temp_buffer;
+
+    if (temp == NULL || genericlinkedlist_reserve_nodes(list, 2)) {
+        if (temp != temp_buffer)
+            FREE(temp);
+
+        return CC_ENOMEM;
+    }
 
-    int result = 0;
-    list->head = genericlinkedlist_merge_sort(list, list->head, list->size, list->base->compare, descending? -1: 1, &list->tail, &result);
+    /* Unrolled lists use a bottom-up merge sort. Every node is sorted to become a run, and `runs[i]` holds a pending run of 2^i nodes.
+     * Runs at higher levels always hold earlier elements, so merging them on the left keeps the sort stable */
+    struct GenericLinkedListNode *runs[GENERICLINKEDLIST_SORT_LEVELS] = {NULL};
+    struct GenericLinkedListNode *node = list->head, *result = NULL;
+
+    descending = descending? -1: 1;
+
+    while (node) {
+        struct GenericLinkedListNode *run = node;
+        size_t level = 0;
+
+        node = node->next;
+        run->next = NULL;
+
+        genericlinkedlist_sort_node(list, run, temp, descending, &err);
+
+        for (; runs[level]; ++level) {
+            run = genericlinkedlist_merge_runs(list, runs[level], run, descending, &err);
+            runs[level] = NULL;
+
+            if (level == GENERICLINKEDLIST_SORT_LEVELS - 1)
+                break;
+        }
+
+        runs[level] = run;
+    }
+
+    for (size_t level = 0; level < GENERICLINKEDLIST_SORT_LEVELS; ++level) {
+        if (runs[level])
+            result = result? genericlinkedlist_merge_runs(list, runs[level], result, descending, &err): runs[level];
+    }
+
+    list->head = list->tail = result;
+    while (list->tail->next)
+        list->tail = list->tail->next;
+
+    if (temp != temp_buffer)
+        FREE(temp);
 
-    return result;
+    return err;
 }
 
 Iterator genericlinkedlist_begin(GenericLinkedList list) {
-    return list->head;
+    return list->head? genericlinkedlist_slot(list, list->head, 0): NULL;
 }
 
 Iterator genericlinkedlist_next(GenericLinkedList list, Iterator it) {
-    UNUSED(list)
+    if (it == NULL)
+        return NULL;
+
+    struct GenericLinkedListNode *node = genericlinkedlist_node_of(list, it);
 
-    return it? ((struct GenericLinkedListNode *) it)->next: NULL;
+    if (genericlinkedlist_index_of(list, node, it) + 1 < node->count)
+        return (unsigned char *) it + list->element_size;
+
+    return node->next? genericlinkedlist_slot(list, node->next, 0): NULL;
 }
 
 Iterator genericlinkedlist_previous(GenericLinkedList list, Iterator it) {
     if (it == NULL)
-        return list->tail;
+        return genericlinkedlist_last(list);
 
-    Iterator last = NULL;
-    for (Iterator t = list->head; t; ) {
-        Iterator temp = t;
-        if ((t = genericlinkedlist_next(list, t)) == it)
-            break;
-        last = temp;
-    }
+    struct GenericLinkedListNode *node = genericlinkedlist_node_of(list, it);
+
+    if (genericlinkedlist_index_of(list, node, it) > 0)
+        return (unsigned char *) it - list->element_size;
+    else if (node == list->head)
+        return NULL;
 
-    return last;
+    struct GenericLinkedListNode *prev = list->head;
+    while (prev->next != node)
+        prev = prev->next;
+
+    return genericlinkedlist_slot(list, prev, prev->count - 1);
 }
 
 void *genericlinkedlist_value_of(GenericLinkedList list, Iterator it) {
-    struct GenericLinkedListNode *node = it;
-
     if (list->base->size)
-        return node->data;
+        return it;
     else
-        return *((void **) node->data);
+        return *((void **) it);
 }
 
 size_t genericlinkedlist_size(GenericLinkedList list) {
@@ -560,33 +942,12 @@ size_t genericlinkedlist_size(GenericLinkedList list) {
 }
 
 void genericlinkedlist_clear(GenericLinkedList list) {
-    struct GenericLinkedListNode *node = list->head, *temp;
-    while (node) {
-        temp = node;
-        node = node->next;
-
-        if (!list->base->size && list->base->deleter)
-            list->base->deleter(temp->data);
-
-        FREE(temp);
-    }
-
-    list->size = 0;
-    list->head = list->tail = NULL;
+    genericlinkedlist_destroy_nodes(list);
 }
 
 void genericlinkedlist_destroy(GenericLinkedList list) {
     if (list != NULL) {
-        struct GenericLinkedListNode *node = list->head, *temp;
-        while (node) {
-            temp = node;
-            node = node->next;
-
-            if (!list->base->size && list->base->deleter)
-                list->base->deleter(temp->data);
-
-            FREE(temp);
-        }
+        genericlinkedlist_destroy_nodes(list);
 
         container_base_destroy_if_dynamic(list->base);
         FREE(list);
@@ -16,6 +16,16 @@ GenericLinkedList variant_get_genericlinkedlist(Variant var);
 int variant_set_genericlinkedlist(Variant var, const GenericLinkedList list);
 int variant_set_genericlinkedlist_move(Variant var, GenericLinkedList list);
 GenericLinkedList genericlinkedlist_create(const CommonContainerBase *base);
+/** @brief Creates an unrolled linked list, which stores several elements in each node.
+ *
+ *  Unrolled lists need far fewer nodes and are much faster to iterate and sort, at the cost of weaker iterator guarantees:
+ *  inserting or removing an element invalidates iterators to the elements following it in the same node, and inserting may move elements to a new node.
+ *  Iterators to other elements stay valid, as with a normal list.
+ *
+ *  Copies of an unrolled list are unrolled as well.
+ */
+GenericLinkedList genericlinkedlist_create_unrolled(const CommonContainerBase *base);
+int genericlinkedlist_is_unrolled(GenericLinkedList list);
 GenericLinkedList genericlinkedlist_copy(GenericLinkedList other);
 GenericLinkedList genericlinkedlist_concatenate(GenericLinkedList left, GenericLinkedList right);
 GenericLinkedList genericlinkedlist_from_genericmap_values(GenericMap other);
@@ -51,13 +61,22 @@ int genericlinkedlist_compare(GenericLinkedList list, GenericLinkedList other);
 GenericLinkedList genericlinkedlist_sorted(GenericLinkedList list, int descending);
 GenericLinkedList genericlinkedlist_stable_sorted(GenericLinkedList list, int descending);
 int genericlinkedlist_sort(GenericLinkedList list, int descending);
+/** @brief Stably sorts the list in place with a merge sort that reuses the existing nodes.
+ *
+ *  Classic lists (one element per node) use a top-down merge sort that relinks the nodes. Unrolled lists use a bottom-up merge sort
+ *  that refills the nodes, since their elements are stored in blocks rather than one per node.
+ *
+ *  All iterators to the list are invalidated.
+ *
+ *  @return 0 on success, CC_ENOTSUP if the list has no comparison function or some elements were unordered, or CC_ENOMEM if an unrolled list could not reserve nodes to sort with.
+ */
 int genericlinkedlist_stable_sort(GenericLinkedList list, int descending);
 Iterator genericlinkedlist_begin(GenericLinkedList list);
 Iterator genericlinkedlist_next(GenericLinkedList list, Iterator it);
 /** @brief Gets the preceding element of the linked list
  *
  *  WARNING! Since GenericLinkedList is singly-linked, this function runs in O(n) time and can be very, very slow!
- *  Use only if absolutely necessary.
+ *  Use only if absolutely necessary. In unrolled lists, it only has to search when @p it is the first element of its node.
  *
  *  Calling with @p it == NULL returns an iterator pointing to the last element in the list.
  */
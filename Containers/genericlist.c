@@ -14,30 +14,107 @@
 
 #define MERGE_SORT_INSERTION_SORT_CUTOFF 8
 
+/* POD elements up to this size are buffered on the stack when inserting or sorting, larger ones use the heap */
+#define GENERICLIST_ELEMENT_BUFFER_SIZE 64
+
+/* Size in bytes of the small buffer allocated along with every list, enough for 8 pointers plus the terminating element.
+ * Lists whose elements fit in the small buffer need no separate array allocation until they grow past it */
+#define GENERICLIST_SMALL_BUFFER_SIZE (9 * sizeof(void*))
+
+/* Elements of packed lists are allocated back to back in blocks, starting at the minimum size and doubling up to the maximum size */
+#define GENERICLIST_ARENA_MIN_BLOCK_SIZE 4096
+#define GENERICLIST_ARENA_MAX_BLOCK_SIZE (64ul * 1024 * 1024)
+
+typedef struct GenericListArenaBlock {
+    struct GenericListArenaBlock *next; /* The previously filled block */
+    size_t size; /* Size in bytes of data */
+    size_t used; /* Number of bytes of data allocated so far */
+    unsigned char data[];
+} GenericListArenaBlock;
+
 struct GenericListStruct {
     CommonContainerBase *base;
     size_t array_size; /* Number of elements in array (not bytes) */
     size_t array_capacity; /* Capacity in elements of array (not bytes) */
-    void *array;
+    size_t small_capacity; /* Capacity in elements of small_buffer (not bytes), or 0 if there isn't room for more than the terminator */
+    void *array; /* Points to small_buffer or a heap allocation */
+    GenericListArenaBlock *arena; /* Most recent arena block of a packed list, or NULL if no elements have been allocated from it */
+    int packed; /* Whether elements may be allocated from the arena */
+    union {
+        void *p;
+        long long ll;
+        long double ld;
+    } small_buffer[]; /* Allocated with the list itself */
 };
 
 static inline size_t genericlist_stored_element_size(const CommonContainerBase *base) {
-    return base->size? MIN(base->size, sizeof(void*)): sizeof(void*);
+    return base->size? base->size: sizeof(void*);
+}
+
+/* Returns whether `item` was allocated from the list's arena, in which case it must not be destroyed individually */
+static int genericlist_arena_owns(GenericList list, const void *item) {
+    const uintptr_t address = (uintptr_t) item;
+
+    for (GenericListArenaBlock *block = list->arena; block; block = block->next) {
+        if (address >= (uintptr_t) block->data && address < (uintptr_t) block->data + block->used)
+            return 1;
+    }
+
+    return 0;
+}
+
+static void genericlist_arena_destroy(GenericList list) {
+    while (list->arena) {
+        GenericListArenaBlock *next = list->arena->next;
+
+        FREE(list->arena);
+        list->arena = next;
+    }
+}
+
+/* Destroys an element of a non-POD list, unless it lives in the list's arena */
+static void genericlist_destroy_element(GenericList list, void *item) {
+    if (list->base->deleter && (list->arena == NULL || !genericlist_arena_owns(list, item)))
+        list->base->deleter(item);
+}
+
+static inline int genericlist_is_small(GenericList list) {
+    return list->array == (void *) list->small_buffer;
+}
+
+/* Moves the array to a heap allocation with room for `capacity` elements */
+static int genericlist_reallocate(GenericList list, size_t capacity) {
+    const size_t element_size = genericlist_stored_element_size(list->base);
+    const size_t new_size = safe_multiply(capacity, element_size);
+    if (!new_size)
+        return CC_ENOMEM;
+
+    void *new_array;
+
+    if (genericlist_is_small(list)) {
+        new_array = MALLOC(new_size);
+        if (new_array)
+            memcpy(new_array, list->array, (list->array_size + 1) * element_size);
+    } else {
+        new_array = REALLOC(list->array, new_size);
+    }
+
+    if (!new_array)
+        return CC_ENOMEM;
+
+    list->array_capacity = capacity;
+    list->array = new_array;
+
+    return 0;
 }
 
 static int genericlist_grow(GenericList list, size_t added) {
     if (list->array_size+added >= list->array_capacity) {
         size_t new_capacity = MAX(list->array_capacity + (list->array_capacity / 2), list->array_size + added) + 1;
-        size_t new_size = safe_multiply(new_capacity, genericlist_stored_element_size(list->base));
-        if (!new_size || new_capacity < list->array_capacity)
-            return CC_ENOMEM;
-
-        void **new_array = REALLOC(list->array, new_size);
-        if (!new_array)
+        if (new_capacity < list->array_capacity)
             return CC_ENOMEM;
 
-        list->array_capacity = new_capacity;
-        list->array = new_array;
+        return genericlist_reallocate(list, new_capacity);
     }
 
     return 0;
@@ -78,12 +155,25 @@ GenericList genericlist_create_reserve(size_t reserve, const CommonContainerBase
     if (base == NULL)
         return NULL;
 
-    GenericList list = CALLOC(1, sizeof(*list));
+    const size_t element_size = genericlist_stored_element_size(base);
+    const size_t small_capacity = GENERICLIST_SMALL_BUFFER_SIZE / element_size;
+    const size_t small_size = small_capacity > 1? small_capacity * element_size: 0;
+
+    GenericList list = CALLOC(1, sizeof(*list) + small_size);
     CommonContainerBase *new_base = container_base_copy_if_dynamic(base);
     if (!list || !new_base)
         goto cleanup;
 
-    const size_t element_size = genericlist_stored_element_size(base);
+    list->base = new_base;
+    list->small_capacity = small_size? small_capacity: 0;
+
+    if (reserve < list->small_capacity) {
+        list->array_capacity = list->small_capacity;
+        list->array = list->small_buffer;
+
+        return list;
+    }
+
     const size_t minimum_size = 8;
 
     list->array_capacity = MAX(minimum_size, reserve);
@@ -103,7 +193,6 @@ GenericList genericlist_create_reserve(size_t reserve, const CommonContainerBase
         }
 
         memset(list->array, 0, element_size);
-        list->base = new_base;
 
         return list;
     }
@@ -114,6 +203,51 @@ cleanup:
     return NULL;
 }
 
+GenericList genericlist_create_packed(size_t reserve, const CommonContainerBase *base) {
+    if (base == NULL || base->size != 0)
+        return NULL;
+
+    GenericList list = genericlist_create_reserve(reserve, base);
+    if (list)
+        list->packed = 1;
+
+    return list;
+}
+
+int genericlist_is_packed(GenericList list) {
+    return list->packed;
+}
+
+void *genericlist_packed_alloc(GenericList list, size_t size) {
+    if (!list->packed)
+        return NULL;
+
+    GenericListArenaBlock *block = list->arena;
+
+    if (block == NULL || block->size - block->used < size) {
+        size_t block_size = block? MIN(block->size * 2, GENERICLIST_ARENA_MAX_BLOCK_SIZE): GENERICLIST_ARENA_MIN_BLOCK_SIZE;
+        if (block_size < size)
+            block_size = size;
+
+        if (block_size > SIZE_MAX - sizeof(*block))
+            return NULL;
+
+        block = MALLOC(sizeof(*block) + block_size);
+        if (block == NULL)
+            return NULL;
+
+        block->next = list->arena;
+        block->size = block_size;
+        block->used = 0;
+        list->arena = block;
+    }
+
+    void *result = block->data + block->used;
+    block->used += size;
+
+    return result;
+}
+
 GenericList genericlist_copy(GenericList other) {
     GenericList list = genericlist_create_reserve(other->array_size, other->base);
     if (!list)
@@ -212,7 +346,7 @@ GenericList genericlist_copy_slice(GenericList other, size_t begin_index, size_t
     if (list == NULL)
         return NULL;
 
-    if (list->base->size && list->base->size <= sizeof(void*)) {
+    if (list->base->size) {
         if (genericlist_grow(list, length)) {
             genericlist_destroy(list);
             return NULL;
@@ -242,23 +376,12 @@ int genericlist_fill(GenericList list, const void *item, size_t size) {
     if (error)
         return error;
 
-    if (list->base->size > sizeof(void*)) { /* Large POD */
-        const size_t element_size = list->base->size;
-        void **array = (void **) list->array;
-
-        for (size_t i = 0; i < fill_size; ++i) {
-            void *duplicate = generic_pod_copy_alloc(item, element_size);
-            if (duplicate == NULL && item != NULL)
-                return CC_ENOMEM;
-
-            FREE(array[i]);
-
-            array[i] = duplicate;
-        }
-    } else if (list->base->size) { /* Small POD type */
+    if (list->base->size) { /* POD type */
         const size_t element_size = list->base->size;
 
-        if (element_size == 1) {
+        if (item == NULL) {
+            memset(list->array, 0, fill_size * element_size);
+        } else if (element_size == 1) {
             memset(list->array, *((unsigned char *) item), size);
         } else {
             for (size_t i = 0; i < fill_size; ++i) {
@@ -276,8 +399,7 @@ int genericlist_fill(GenericList list, const void *item, size_t size) {
             if (duplicate == NULL && item != NULL)
                 return CC_ENOMEM;
 
-            if (list->base->deleter)
-                list->base->deleter(array[i]);
+            genericlist_destroy_element(list, array[i]);
 
             array[i] = duplicate;
         }
@@ -294,26 +416,13 @@ int genericlist_resize(GenericList list, size_t size, const void *empty_item) {
         return error;
 
     if (size > original_size) {
-        if (list->base->size > sizeof(void*)) { /* Large POD */
+        if (list->base->size) { /* POD type */
             const size_t element_size = list->base->size;
-            void **array = (void **) list->array;
 
-            for (size_t i = original_size; i < size; ++i) {
-                void *duplicate = generic_pod_copy_alloc(empty_item, element_size);
-                if (duplicate == NULL && empty_item != NULL) {
-                    list->array_size = i;
-                    goto cleanup;
-                }
-
-                array[i] = duplicate;
-            }
-
-            array[size] = NULL;
-        } else if (list->base->size) { /* Small POD type */
-            const size_t element_size = list->base->size;
-
-            if (element_size == 1) {
-                memset((char *) list->array + original_size, *((unsigned char *) empty_item), element_size);
+            if (empty_item == NULL) {
+                memset((char *) list->array + (original_size * element_size), 0, (size - original_size) * element_size);
+            } else if (element_size == 1) {
+                memset((char *) list->array + original_size, *((unsigned char *) empty_item), size - original_size);
             } else {
                 for (size_t i = original_size; i < size; ++i) {
                     memcpy((char *) list->array + (i * element_size), empty_item, element_size);
@@ -340,20 +449,15 @@ int genericlist_resize(GenericList list, size_t size, const void *empty_item) {
             array[size] = NULL;
         }
     } else if (size < original_size) {
-        if (list->base->size && list->base->size <= sizeof(void*)) { /* Small POD type */
+        if (list->base->size) { /* POD type */
             const size_t element_size = list->base->size;
 
             memset((char *) list->array + (size * element_size), 0, element_size);
-        } else { /* Large POD or non-POD type */
+        } else { /* Non-POD type */
             void **array = (void **) list->array;
-            Deleter d = list->base->size?
-                                          FREE: /* Large POD */
-                                          list->base->deleter; /* Non-POD */
 
-            if (d) {
-                for (size_t i = size; i < original_size; ++i) {
-                    d(array[i]);
-                }
+            for (size_t i = size; i < original_size; ++i) {
+                genericlist_destroy_element(list, array[i]);
             }
 
             array[size] = NULL;
@@ -409,7 +513,7 @@ int genericlist_insert_list(GenericList list, GenericList other, size_t before_i
     if (err)
         return err;
 
-    if (list->base->size && list->base->size <= sizeof(void*)) {
+    if (list->base->size) {
         const size_t element_size = list->base->size;
 
         /* One is added at the end of the move so the trailing 0-element will be moved as well */
@@ -473,8 +577,10 @@ int genericlist_insert_list(GenericList list, GenericList other, size_t before_i
 
         list->array_size += other_size;
 
+        return 0;
+
 non_pod_cleanup: ;
-        Deleter d = list->base->size? FREE: list->base->deleter;
+        Deleter d = list->base->deleter;
 
         if (d) {
             for (size_t i = before_index; i < rollback_location; ++i) {
@@ -492,25 +598,7 @@ non_pod_cleanup: ;
 }
 
 int genericlist_insert_move(GenericList list, void *item, size_t before_index) {
-    if (list->base->size > sizeof(void*)) { /* Large POD type */
-        int owns_item = 0;
-        const size_t element_size = list->base->size;
-
-        if (item == NULL) {
-            owns_item = 1;
-            item = CALLOC(1, element_size);
-            if (item == NULL)
-                return CC_ENOMEM;
-        }
-
-        int error = genericlist_grow(list, 1);
-        if (error) {
-            if (owns_item) FREE(item);
-            return error;
-        }
-
-        /* Fallthrough to non-POD type code below */
-    } else if (list->base->size) { /* Small POD type */
+    if (list->base->size) { /* POD type */
         int err = genericlist_insert(list, item, before_index);
         if (err)
             return err;
@@ -522,9 +610,7 @@ int genericlist_insert_move(GenericList list, void *item, size_t before_index) {
         int error = genericlist_grow(list, 1);
         if (error)
             return error;
-    }
 
-    { /* Non-POD type or verified large-POD type */
         if (before_index >= genericlist_size(list))
             before_index = genericlist_size(list);
 
@@ -541,36 +627,29 @@ int genericlist_insert_move(GenericList list, void *item, size_t before_index) {
 }
 
 int genericlist_insert(GenericList list, const void *item, size_t before_index) {
-    if (list->base->size > sizeof(void*)) { /* Large POD type */
+    if (list->base->size) { /* POD type */
+        unsigned char temp_buffer[GENERICLIST_ELEMENT_BUFFER_SIZE]; /* Allows us to save the data of the specified item,
+                                                                       in case it's a reference to an element in this list
+                                                                       that will possibly get invalidated if we grow it. */
         const size_t element_size = list->base->size;
-
-        void *duplicate = CALLOC(1, element_size);
-        if (duplicate == NULL)
+        void *temp = element_size > sizeof(temp_buffer)? MALLOC(element_size): temp_buffer;
+        if (temp == NULL)
             return CC_ENOMEM;
 
-        if (item != NULL)
-            memcpy(duplicate, item, element_size);
-
-        int err = genericlist_insert_move(list, duplicate, before_index);
-        if (err)
-            FREE(duplicate);
-
-        return err;
-    } else if (list->base->size) { /* Small POD type */
-        unsigned char temp_buffer[sizeof(void*)] = {0}; /* Allows us to save the data of the specified item,
-                                                           in case it's a reference to an element in this list
-                                                           that will possibly get invalidated if we grow it. */
-        const size_t element_size = list->base->size;
-
         if (before_index >= genericlist_size(list))
             before_index = genericlist_size(list);
 
         if (item != NULL)
-            memcpy(temp_buffer, item, element_size);
+            memcpy(temp, item, element_size);
+        else
+            memset(temp, 0, element_size);
 
         int error = genericlist_grow(list, 1);
-        if (error)
+        if (error) {
+            if (temp != temp_buffer)
+                FREE(temp);
             return error;
+        }
 
         /* Make space in list */
         memmove((char *) list->array + ((before_index+1) * element_size),
@@ -578,12 +657,15 @@ int genericlist_insert(GenericList list, const void *item, size_t before_index)
                 (genericlist_size(list) - before_index)  * element_size);
 
         /* Insert into list */
-        memcpy((char *) list->array + (before_index * element_size), temp_buffer, element_size);
+        memcpy((char *) list->array + (before_index * element_size), temp, element_size);
         ++list->array_size;
 
         /* Terminate list */
         memset((char *) list->array + (list->array_size * element_size), 0, element_size);
 
+        if (temp != temp_buffer)
+            FREE(temp);
+
         return 0;
     } else {
         if (list->base->copier == NULL)
@@ -610,19 +692,7 @@ int genericlist_insert_copy_iterator(GenericList list, const void *item, Iterato
 }
 
 int genericlist_replace_move_at(GenericList list, size_t index, void *item) {
-    if (list->base->size > sizeof(void*)) { /* Large POD type */
-        void **array = (void **) list->array;
-
-        if (item == NULL) {
-            const size_t element_size = list->base->size;
-
-            memset(array[index], 0, element_size);
-        } else {
-            FREE(array[index]);
-
-            array[index] = item;
-        }
-    } else if (list->base->size) { /* Small POD type */
+    if (list->base->size) { /* POD type */
         const size_t element_size = list->base->size;
 
         if (item == NULL)
@@ -634,8 +704,7 @@ int genericlist_replace_move_at(GenericList list, size_t index, void *item) {
     } else { /* Non-POD type */
         void **array = (void **) list->array;
 
-        if (list->base->deleter)
-            list->base->deleter(array[index]);
+        genericlist_destroy_element(list, array[index]);
 
         array[index] = item;
     }
@@ -644,12 +713,7 @@ int genericlist_replace_move_at(GenericList list, size_t index, void *item) {
 }
 
 int genericlist_replace_at(GenericList list, size_t index, const void *item) {
-    if (list->base->size > sizeof(void*)) { /* Large POD type */
-        const size_t element_size = list->base->size;
-        void **array = (void **) list->array;
-
-        memmove(array[index], item, element_size);
-    } else if (list->base->size) { /* Small POD type */
+    if (list->base->size) { /* POD type */
         const size_t element_size = list->base->size;
 
         if (item == NULL)
@@ -719,14 +783,13 @@ size_t genericlist_erase(GenericList list, size_t begin_index, size_t end_index)
         end_index = genericlist_size(list);
 
     const size_t element_size = genericlist_stored_element_size(list->base);
-    Deleter deleter = list->base->size? list->base->size <= sizeof(void*)? NULL: FREE: list->base->deleter;
 
     size_t length = end_index - begin_index;
-    if (deleter) {
+    if (list->base->size == 0) {
         void **array = (void **) list->array;
 
         for (size_t i = begin_index; i < end_index; ++i) {
-            deleter(array[i]);
+            genericlist_destroy_element(list, array[i]);
         }
     }
 
@@ -737,6 +800,10 @@ size_t genericlist_erase(GenericList list, size_t begin_index, size_t end_index)
     list->array_size -= length;
     memset((char *) list->array + (list->array_size * element_size), 0, element_size);
 
+    /* Nothing refers to the arena anymore, so it can be reused from scratch */
+    if (list->array_size == 0)
+        genericlist_arena_destroy(list);
+
     return length;
 }
 
@@ -756,7 +823,7 @@ size_t genericlist_bsearch(GenericList list, const void *item) {
     size_t hi = highest;
     size_t lo = 0;
 
-    if (list->base->size && list->base->size <= sizeof(void*)) {
+    if (list->base->size) {
         const size_t element_size = list->base->size;
 
         while (lo <= hi) {
@@ -1028,22 +1095,28 @@ static void genericlist_ptr_heap_sort(void **base, size_t num, int descending, C
     }
 }
 
-/* descending must be -1 (descending) or 1 (ascending) */
-static void genericlist_pod_merge_helper(void *result, void *base, size_t begin, size_t pivot, size_t end, size_t element_size, int descending, Compare compar) {
-    size_t left = begin, right = pivot;
-
-    for (size_t i = begin; i < end; ++i) {
-        char * left_element = (char *) base +  left * element_size;
-        char *right_element = (char *) base + right * element_size;
+/* Merges the sorted runs `left` and `right` into `result`, taking from `left` first if elements are equal.
+ * descending must be -1 (descending) or 1 (ascending) */
+static void genericlist_pod_merge_helper(void *result, const void *left, size_t left_count, const void *right, size_t right_count, size_t element_size, int descending, Compare compar) {
+    char *out = result;
+    const char *left_element = left, *right_element = right;
 
-        if (left < pivot && (right >= end || compar(left_element, right_element) * descending <= 0)) {
-            memcpy((char *) result + i * element_size, left_element, element_size);
-            ++left;
+    while (left_count && right_count) {
+        if (compar(left_element, right_element) * descending <= 0) {
+            memcpy(out, left_element, element_size);
+            left_element += element_size;
+            --left_count;
         } else {
-            memcpy((char *) result + i * element_size, right_element, element_size);
-            ++right;
+            memcpy(out, right_element, element_size);
+            right_element += element_size;
+            --right_count;
         }
+
+        out += element_size;
     }
+
+    memcpy(out, left_element, left_count * element_size);
+    memcpy(out + left_count * element_size, right_element, right_count * element_size);
 }
 
 static void genericlist_pod_merge_sort(void *result, void *base, size_t begin, size_t end, size_t element_size, int descending, Compare compar) {
@@ -1056,19 +1129,26 @@ static void genericlist_pod_merge_sort(void *result, void *base, size_t begin, s
 
     genericlist_pod_merge_sort(base, result, begin, pivot, element_size, descending, compar);
     genericlist_pod_merge_sort(base, result, pivot, end, element_size, descending, compar);
-    genericlist_pod_merge_helper(base, result, begin, pivot, end, element_size, descending, compar);
-}
-
-/* descending must be -1 (descending) or 1 (ascending) */
-static void genericlist_ptr_merge_helper(void **result, void **base, size_t begin, size_t pivot, size_t end, int descending, Compare compar) {
-    size_t left = begin, right = pivot;
-
-    for (size_t i = begin; i < end; ++i) {
-        if (left < pivot && (right >= end || compar(base[left], base[right]) * descending <= 0))
-            result[i] = base[left++];
-        else
-            result[i] = base[right++];
+    genericlist_pod_merge_helper((char *) base + begin * element_size,
+                                 (char *) result + begin * element_size, pivot - begin,
+                                 (char *) result + pivot * element_size, end - pivot, element_size, descending, compar);
+}
+
+/* Merges the sorted runs `left` and `right` into `result`, taking from `left` first if elements are equal.
+ * descending must be -1 (descending) or 1 (ascending) */
+static void genericlist_ptr_merge_helper(void **result, void * const *left, size_t left_count, void * const *right, size_t right_count, int descending, Compare compar) {
+    while (left_count && right_count) {
+        if (compar(*left, *right) * descending <= 0) {
+            *result++ = *left++;
+            --left_count;
+        } else {
+            *result++ = *right++;
+            --right_count;
+        }
     }
+
+    memcpy(result, left, left_count * sizeof(*left));
+    memcpy(result + left_count, right, right_count * sizeof(*right));
 }
 
 static void genericlist_ptr_merge_sort(void **result, void **base, size_t begin, size_t end, int descending, Compare compar) {
@@ -1081,7 +1161,556 @@ static void genericlist_ptr_merge_sort(void **result, void **base, size_t begin,
 
     genericlist_ptr_merge_sort(base, result, begin, pivot, descending, compar);
     genericlist_ptr_merge_sort(base, result, pivot, end, descending, compar);
-    genericlist_ptr_merge_helper(base, result, begin, pivot, end, descending, compar);
+    genericlist_ptr_merge_helper(base + begin, result + begin, pivot - begin, result + pivot, end - pivot, descending, compar);
+}
+
+/* Unstable sorting uses pattern-defeating quicksort, falling back to heap sort if too many partitions are unbalanced.
+ * Pointer arrays are sorted as arrays of elements the size of a pointer, comparing the elements they point to */
+#define PDQSORT_INSERTION_SORT_CUTOFF 24
+#define PDQSORT_NINTHER_CUTOFF 128
+#define PDQSORT_PARTIAL_INSERTION_SORT_LIMIT 8
+
+typedef struct {
+    Compare compare;
+    size_t size; /* Size in bytes of each array element */
+    int descending; /* Must be -1 (descending) or 1 (ascending) */
+    int indirect; /* Non-zero if the array elements are pointers to the values to compare */
+    unsigned char *pivot, *temp; /* Scratch space for one element each */
+} GenericListSorter;
+
+/* Returns whether the element at `a` sorts before the element at `b` */
+static int genericlist_sort_less(const GenericListSorter *sorter, const unsigned char *a, const unsigned char *b) {
+    if (sorter->indirect)
+        return sorter->compare(*((void * const *) a), *((void * const *) b)) * sorter->descending < 0;
+
+    return sorter->compare(a, b) * sorter->descending < 0;
+}
+
+/* Copies one element. Common sizes are handled separately so the copy is inlined */
+static void genericlist_sort_copy(const GenericListSorter *sorter, unsigned char *dst, const unsigned char *src) {
+    switch (sorter->size) {
+        case 1: memcpy(dst, src, 1); break;
+        case 2: memcpy(dst, src, 2); break;
+        case 4: memcpy(dst, src, 4); break;
+        case 8: memcpy(dst, src, 8); break;
+        default: memcpy(dst, src, sorter->size); break;
+    }
+}
+
+static void genericlist_sort_swap(const GenericListSorter *sorter, unsigned char *a, unsigned char *b) {
+    genericlist_sort_copy(sorter, sorter->temp, a);
+    genericlist_sort_copy(sorter, a, b);
+    genericlist_sort_copy(sorter, b, sorter->temp);
+}
+
+static void genericlist_sort2(const GenericListSorter *sorter, unsigned char *a, unsigned char *b) {
+    if (genericlist_sort_less(sorter, b, a))
+        genericlist_sort_swap(sorter, a, b);
+}
+
+static void genericlist_sort3(const GenericListSorter *sorter, unsigned char *a, unsigned char *b, unsigned char *c) {
+    genericlist_sort2(sorter, a, b);
+    genericlist_sort2(sorter, b, c);
+    genericlist_sort2(sorter, a, b);
+}
+
+/* Insertion sort of [begin, end). If `unguarded` is set, the element before `begin` must not sort after any element in the range */
+static void genericlist_pdq_insertion_sort(const GenericListSorter *sorter, unsigned char *begin, unsigned char *end, int unguarded) {
+    const size_t size = sorter->size;
+
+    if (begin == end)
+        return;
+
+    for (unsigned char *current = begin + size; current != end; current += size) {
+        unsigned char *sift = current;
+
+        if (!genericlist_sort_less(sorter, sift, sift - size))
+            continue;
+
+        genericlist_sort_copy(sorter, sorter->pivot, sift);
+        do {
+            genericlist_sort_copy(sorter, sift, sift - size);
+            sift -= size;
+        } while ((unguarded || sift != begin) && genericlist_sort_less(sorter, sorter->pivot, sift - size));
+
+        genericlist_sort_copy(sorter, sift, sorter->pivot);
+    }
+}
+
+/* Attempts an insertion sort of [begin, end), but gives up and returns 0 if more than a few elements need to be moved */
+static int genericlist_pdq_partial_insertion_sort(const GenericListSorter *sorter, unsigned char *begin, unsigned char *end) {
+    const size_t size = sorter->size;
+    size_t moved = 0;
+
+    if (begin == end)
+        return 1;
+
+    for (unsigned char *current = begin + size; current != end; current += size) {
+        unsigned char *sift = current;
+
+        if (!genericlist_sort_less(sorter, sift, sift - size))
+            continue;
+
+        genericlist_sort_copy(sorter, sorter->pivot, sift);
+        do {
+            genericlist_sort_copy(sorter, sift, sift - size);
+            sift -= size;
+        } while (sift != begin && genericlist_sort_less(sorter, sorter->pivot, sift - size));
+
+        genericlist_sort_copy(sorter, sift, sorter->pivot);
+
+        moved += (current - sift) / size;
+        if (moved > PDQSORT_PARTIAL_INSERTION_SORT_LIMIT)
+            return 0;
+    }
+
+    return 1;
+}
+
+/* Partitions [begin, end) around the pivot at `begin`, putting elements equal to the pivot on the right.
+ * Returns the final position of the pivot, and sets `*already_partitioned` if no elements needed to be swapped */
+static unsigned char *genericlist_pdq_partition_right(const GenericListSorter *sorter, unsigned char *begin, unsigned char *end, int *already_partitioned) {
+    const size_t size = sorter->size;
+    unsigned char *first = begin, *last = end;
+
+    genericlist_sort_copy(sorter, sorter->pivot, begin);
+
+    /* The median-of-three pivot selection guarantees that these loops stop within the range */
+    do
+        first += size;
+    while (genericlist_sort_less(sorter, first, sorter->pivot));
+
+    if (first - size == begin) {
+        while (first < last) {
+            last -= size;
+            if (genericlist_sort_less(sorter, last, sorter->pivot))
+                break;
+        }
+    } else {
+        do
+            last -= size;
+        while (!genericlist_sort_less(sorter, last, sorter->pivot));
+    }
+
+    *already_partitioned = first >= last;
+
+    while (first < last) {
+        genericlist_sort_swap(sorter, first, last);
+
+        do
+            first += size;
+        while (genericlist_sort_less(sorter, first, sorter->pivot));
+
+        do
+            last -= size;
+        while (!genericlist_sort_less(sorter, last, sorter->pivot));
+    }
+
+    unsigned char *pivot_position = first - size;
+    genericlist_sort_copy(sorter, begin, pivot_position);
+    genericlist_sort_copy(sorter, pivot_position, sorter->pivot);
+
+    return pivot_position;
+}
+
+/* Partitions [begin, end) around the pivot at `begin`, putting elements equal to the pivot on the left.
+ * Used when the pivot is equal to the element before the range, so all of the equal elements are done in one pass */
+static unsigned char *genericlist_pdq_partition_left(const GenericListSorter *sorter, unsigned char *begin, unsigned char *end) {
+    const size_t size = sorter->size;
+    unsigned char *first = begin, *last = end;
+
+    genericlist_sort_copy(sorter, sorter->pivot, begin);
+
+    do
+        last -= size;
+    while (genericlist_sort_less(sorter, sorter->pivot, last));
+
+    if (last + size == end) {
+        while (first < last) {
+            first += size;
+            if (genericlist_sort_less(sorter, sorter->pivot, first))
+                break;
+        }
+    } else {
+        do
+            first += size;
+        while (!genericlist_sort_less(sorter, sorter->pivot, first));
+    }
+
+    while (first < last) {
+        genericlist_sort_swap(sorter, first, last);
+
+        do
+            last -= size;
+        while (genericlist_sort_less(sorter, sorter->pivot, last));
+
+        do
+            first += size;
+        while (!genericlist_sort_less(sorter, sorter->pivot, first));
+    }
+
+    genericlist_sort_copy(sorter, begin, last);
+    genericlist_sort_copy(sorter, last, sorter->pivot);
+
+    return last;
+}
+
+static void genericlist_pdq_heap_sort(const GenericListSorter *sorter, unsigned char *begin, unsigned char *end) {
+    const size_t count = (end - begin) / sorter->size;
+
+    if (sorter->indirect)
+        genericlist_ptr_heap_sort((void **) begin, count, sorter->descending, sorter->compare);
+    else
+        genericlist_pod_heap_sort(begin, count, sorter->size, sorter->descending, sorter->compare);
+}
+
+/* Sorts [begin, end). `bad_allowed` is the number of unbalanced partitions allowed before switching to heap sort,
+ * and `leftmost` is zero if the element before `begin` is known not to sort after any element in the range */
+static void genericlist_pdq_sort_loop(const GenericListSorter *sorter, unsigned char *begin, unsigned char *end, int bad_allowed, int leftmost) {
+    const size_t size = sorter->size;
+
+    while (1) {
+        const size_t count = (end - begin) / size;
+
+        if (count < PDQSORT_INSERTION_SORT_CUTOFF) {
+            genericlist_pdq_insertion_sort(sorter, begin, end, !leftmost);
+            return;
+        }
+
+        /* Choose the pivot as the median of three elements, or the pseudomedian of nine for larger ranges, and move it to `begin` */
+        const size_t half = count / 2;
+        if (count > PDQSORT_NINTHER_CUTOFF) {
+            genericlist_sort3(sorter, begin, begin + half * size, end - size);
+            genericlist_sort3(sorter, begin + size, begin + (half - 1) * size, end - 2 * size);
+            genericlist_sort3(sorter, begin + 2 * size, begin + (half + 1) * size, end - 3 * size);
+            genericlist_sort3(sorter, begin + (half - 1) * size, begin + half * size, begin + (half + 1) * size);
+            genericlist_sort_swap(sorter, begin, begin + half * size);
+        } else {
+            genericlist_sort3(sorter, begin + half * size, begin, end - size);
+        }
+
+        /* If the pivot is equal to the element before the range, it is the smallest element here, so skip over all elements equal to it */
+        if (!leftmost && !genericlist_sort_less(sorter, begin - size, begin)) {
+            begin = genericlist_pdq_partition_left(sorter, begin, end) + size;
+            continue;
+        }
+
+        int already_partitioned;
+        unsigned char *pivot = genericlist_pdq_partition_right(sorter, begin, end, &already_partitioned);
+
+        const size_t left_count = (pivot - begin) / size;
+        const size_t right_count = (end - pivot) / size - 1;
+
+        if (left_count < count / 8 || right_count < count / 8) {
+            if (--bad_allowed == 0) {
+                genericlist_pdq_heap_sort(sorter, begin, end);
+                return;
+            }
+
+            /* Break up patterns that may be causing the unbalanced partitions */
+            if (left_count >= PDQSORT_INSERTION_SORT_CUTOFF) {
+                genericlist_sort_swap(sorter, begin, begin + (left_count / 4) * size);
+                genericlist_sort_swap(sorter, pivot - size, pivot - (left_count / 4) * size);
+
+                if (left_count > PDQSORT_NINTHER_CUTOFF) {
+                    genericlist_sort_swap(sorter, begin + size, begin + (left_count / 4 + 1) * size);
+                    genericlist_sort_swap(sorter, begin + 2 * size, begin + (left_count / 4 + 2) * size);
+                    genericlist_sort_swap(sorter, pivot - 2 * size, pivot - (left_count / 4 + 1) * size);
+                    genericlist_sort_swap(sorter, pivot - 3 * size, pivot - (left_count / 4 + 2) * size);
+                }
+            }
+
+            if (right_count >= PDQSORT_INSERTION_SORT_CUTOFF) {
+                genericlist_sort_swap(sorter, pivot + size, pivot + (1 + right_count / 4) * size);
+                genericlist_sort_swap(sorter, end - size, end - (right_count / 4) * size);
+
+                if (right_count > PDQSORT_NINTHER_CUTOFF) {
+                    genericlist_sort_swap(sorter, pivot + 2 * size, pivot + (2 + right_count / 4) * size);
+                    genericlist_sort_swap(sorter, pivot + 3 * size, pivot + (3 + right_count / 4) * size);
+                    genericlist_sort_swap(sorter, end - 2 * size, end - (1 + right_count / 4) * size);
+                    genericlist_sort_swap(sorter, end - 3 * size, end - (2 + right_count / 4) * size);
+                }
+            }
+        } else if (already_partitioned &&
+                   genericlist_pdq_partial_insertion_sort(sorter, begin, pivot) &&
+                   genericlist_pdq_partial_insertion_sort(sorter, pivot + size, end)) {
+            /* The range was probably already sorted, and now it is */
+            return;
+        }
+
+        /* Recurse into the left partition and loop on the right one */
+        genericlist_pdq_sort_loop(sorter, begin, pivot, bad_allowed, leftmost);
+        begin = pivot + size;
+        leftmost = 0;
+    }
+}
+
+/* descending must be -1 (descending) or 1 (ascending)
+ * Returns CC_ENOMEM if the elements are too large for the stack buffer and no scratch space could be allocated */
+static int genericlist_pdq_sort(void *base, size_t num, size_t element_size, int indirect, int descending, Compare compar) {
+    unsigned char scratch_buffer[2 * GENERICLIST_ELEMENT_BUFFER_SIZE];
+    unsigned char *scratch = element_size > GENERICLIST_ELEMENT_BUFFER_SIZE? MALLOC(2 * element_size): scratch_buffer;
+    GenericListSorter sorter;
+    int bad_allowed = 0;
+
+    if (scratch == NULL)
+        return CC_ENOMEM;
+
+    sorter.compare = compar;
+    sorter.size = element_size;
+    sorter.descending = descending;
+    sorter.indirect = indirect;
+    sorter.pivot = scratch;
+    sorter.temp = scratch + element_size;
+
+    for (size_t n = num; n > 1; n /= 2)
+        ++bad_allowed;
+
+    genericlist_pdq_sort_loop(&sorter, base, (unsigned char *) base + num * element_size, bad_allowed, 1);
+
+    if (scratch != scratch_buffer)
+        FREE(scratch);
+
+    return 0;
+}
+
+/* Radix sorting is used for lists of built-in numbers and strings, since it needs no comparisons at all */
+#define RADIX_SORT_CUTOFF 256
+
+enum GenericListRadixKind {
+    RADIX_NONE,
+    RADIX_UNSIGNED,
+    RADIX_SIGNED,
+    RADIX_FLOAT
+};
+
+/* The compare function identifies the element type, but a custom recipe can reuse it with a different size, so both must match */
+#define GENERICLIST_RADIX_IS(base, recipe, type) ((base)->compare == recipe()->compare && (base)->size == sizeof(type))
+
+/* Returns how the elements of a list with this container base can be radix sorted, based on its comparison function and element size */
+static enum GenericListRadixKind genericlist_radix_kind(const CommonContainerBase *base) {
+    if (base->size == 0 || base->size > sizeof(uint64_t))
+        return RADIX_NONE;
+
+    if (GENERICLIST_RADIX_IS(base, container_base_char_recipe, char))
+        return CHAR_MIN < 0? RADIX_SIGNED: RADIX_UNSIGNED;
+    else if (GENERICLIST_RADIX_IS(base, container_base_short_recipe, short) ||
+             GENERICLIST_RADIX_IS(base, container_base_int_recipe, int) ||
+             GENERICLIST_RADIX_IS(base, container_base_long_recipe, long) ||
+             GENERICLIST_RADIX_IS(base, container_base_long_long_recipe, long long))
+        return RADIX_SIGNED;
+    else if (GENERICLIST_RADIX_IS(base, container_base_uchar_recipe, unsigned char) ||
+             GENERICLIST_RADIX_IS(base, container_base_ushort_recipe, unsigned short) ||
+             GENERICLIST_RADIX_IS(base, container_base_uint_recipe, unsigned int) ||
+             GENERICLIST_RADIX_IS(base, container_base_ulong_recipe, unsigned long) ||
+             GENERICLIST_RADIX_IS(base, container_base_ulong_long_recipe, unsigned long long) ||
+             GENERICLIST_RADIX_IS(base, container_base_size_t_recipe, size_t))
+        return RADIX_UNSIGNED;
+    else if ((GENERICLIST_RADIX_IS(base, container_base_float_recipe, float) && sizeof(float) == sizeof(uint32_t)) ||
+             (GENERICLIST_RADIX_IS(base, container_base_double_recipe, double) && sizeof(double) == sizeof(uint64_t)))
+        return RADIX_FLOAT;
+
+    return RADIX_NONE;
+}
+
+static uint64_t genericlist_radix_load(const unsigned char *element, size_t size) {
+    switch (size) {
+        case 1: {uint8_t v; memcpy(&v, element, 1); return v;}
+        case 2: {uint16_t v; memcpy(&v, element, 2); return v;}
+        case 4: {uint32_t v; memcpy(&v, element, 4); return v;}
+        default: {uint64_t v; memcpy(&v, element, 8); return v;}
+    }
+}
+
+static void genericlist_radix_store(unsigned char *element, uint64_t value, size_t size) {
+    switch (size) {
+        case 1: {uint8_t v = (uint8_t) value; memcpy(element, &v, 1); break;}
+        case 2: {uint16_t v = (uint16_t) value; memcpy(element, &v, 2); break;}
+        case 4: {uint32_t v = (uint32_t) value; memcpy(element, &v, 4); break;}
+        default: memcpy(element, &value, 8); break;
+    }
+}
+
+/* Converts every element in place to (or back from) an unsigned integer that sorts in the desired order */
+static void genericlist_radix_transform(unsigned char *base, size_t num, size_t size, enum GenericListRadixKind kind, int descending, int inverse) {
+    const uint64_t mask = size == 8? UINT64_MAX: ((uint64_t) 1 << (size * CHAR_BIT)) - 1;
+    const uint64_t sign = (uint64_t) 1 << (size * CHAR_BIT - 1);
+
+    for (size_t i = 0; i < num; ++i) {
+        uint64_t v = genericlist_radix_load(base + i * size, size);
+
+        if (inverse && descending)
+            v = ~v & mask;
+
+        switch (kind) {
+            default: break;
+            case RADIX_SIGNED: v ^= sign; break;
+            case RADIX_FLOAT:
+                /* Negative numbers have all bits flipped so they sort in reverse, positive numbers just have the sign bit set */
+                if (inverse)
+                    v = (v & sign)? v ^ sign: ~v & mask;
+                else
+                    v = (v & sign)? ~v & mask: v | sign;
+                break;
+        }
+
+        if (!inverse && descending)
+            v = ~v & mask;
+
+        genericlist_radix_store(base + i * size, v, size);
+    }
+}
+
+/* Distributes elements by the byte at `offset`. Called with constant sizes so the copy is inlined */
+static void genericlist_radix_scatter(unsigned char *dst, const unsigned char *src, size_t num, size_t size, size_t offset, size_t *positions) {
+    for (size_t i = 0; i < num; ++i) {
+        const unsigned char *element = src + i * size;
+        memcpy(dst + positions[element[offset]]++ * size, element, size);
+    }
+}
+
+/* Least-significant-digit radix sort of unsigned integers stored in native byte order.
+ * `temp` must have room for `num` elements, and `counts` must have room for `size` histograms.
+ * Bytes that are the same in every element are skipped entirely */
+static void genericlist_radix_sort_unsigned(unsigned char *base, unsigned char *temp, size_t (*counts)[256], size_t num, size_t size) {
+    const uint16_t endian_test = 1;
+    const int little_endian = *((const unsigned char *) &endian_test);
+    unsigned char *src = base, *dst = temp;
+
+    for (size_t i = 0; i < num; ++i)
+        for (size_t byte = 0; byte < size; ++byte)
+            counts[byte][base[i * size + byte]]++;
+
+    for (size_t digit = 0; digit < size; ++digit) {
+        const size_t offset = little_endian? digit: size - 1 - digit;
+        size_t positions[256], total = 0;
+
+        if (counts[offset][src[offset]] == num)
+            continue;
+
+        for (size_t i = 0; i < 256; ++i) {
+            positions[i] = total;
+            total += counts[offset][i];
+        }
+
+        switch (size) {
+            case 1: genericlist_radix_scatter(dst, src, num, 1, offset, positions); break;
+            case 2: genericlist_radix_scatter(dst, src, num, 2, offset, positions); break;
+            case 4: genericlist_radix_scatter(dst, src, num, 4, offset, positions); break;
+            default: genericlist_radix_scatter(dst, src, num, 8, offset, positions); break;
+        }
+
+        unsigned char *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != base)
+        memcpy(base, src, num * size);
+}
+
+/* Sorts a list of built-in numbers with a radix sort. Returns non-zero if the list could not be radix sorted */
+static int genericlist_radix_sort(void *base, size_t num, size_t element_size, enum GenericListRadixKind kind, int descending) {
+    if (num < RADIX_SORT_CUTOFF || (element_size != 1 && element_size != 2 && element_size != 4 && element_size != 8))
+        return CC_ENOTSUP;
+
+    unsigned char *temp = MALLOC(num * element_size);
+    size_t (*counts)[256] = CALLOC(element_size, sizeof(*counts));
+    if (temp == NULL || counts == NULL) {
+        FREE(temp);
+        FREE(counts);
+        return CC_ENOMEM;
+    }
+
+    genericlist_radix_transform(base, num, element_size, kind, descending, 0);
+    genericlist_radix_sort_unsigned(base, temp, counts, num, element_size);
+    genericlist_radix_transform(base, num, element_size, kind, descending, 1);
+
+    FREE(temp);
+    FREE(counts);
+
+    return 0;
+}
+
+/* Finishes sorting strings that share their first `depth` characters */
+static void genericlist_cstring_insertion_sort(char **base, size_t num, size_t depth) {
+    for (size_t i = 1; i < num; ++i) {
+        char *item = base[i];
+        size_t j = i;
+
+        for (; j > 0 && strcmp(item + depth, base[j-1] + depth) < 0; --j)
+            base[j] = base[j-1];
+
+        base[j] = item;
+    }
+}
+
+/* Most-significant-digit radix sort of strings that share their first `depth` characters. `temp` must have room for `num` pointers.
+ * The largest bucket is handled by looping instead of recursing, so the recursion depth is logarithmic in `num` */
+static void genericlist_cstring_radix_sort(char **base, char **temp, size_t num, size_t depth) {
+    while (num > MERGE_SORT_INSERTION_SORT_CUTOFF) {
+        size_t counts[256] = {0}, starts[256], total = 0, largest = 0;
+
+        for (size_t i = 0; i < num; ++i)
+            counts[(unsigned char) base[i][depth]]++;
+
+        for (size_t i = 0; i < 256; ++i) {
+            starts[i] = total;
+            total += counts[i];
+
+            if (counts[i] > counts[largest])
+                largest = i;
+        }
+
+        if (counts[largest] != num) {
+            size_t positions[256];
+            memcpy(positions, starts, sizeof(positions));
+
+            for (size_t i = 0; i < num; ++i)
+                temp[positions[(unsigned char) base[i][depth]]++] = base[i];
+
+            memcpy(base, temp, num * sizeof(*base));
+        }
+
+        /* Strings in bucket 0 have ended, so they are all equal and already in place */
+        for (size_t i = 1; i < 256; ++i) {
+            if (i != largest && counts[i] > 1)
+                genericlist_cstring_radix_sort(base + starts[i], temp, counts[i], depth + 1);
+        }
+
+        if (largest == 0)
+            return;
+
+        base += starts[largest];
+        num = counts[largest];
+        depth += 1;
+    }
+
+    genericlist_cstring_insertion_sort(base, num, depth);
+}
+
+/* Sorts a list of strings with a radix sort. Returns non-zero if the list could not be radix sorted */
+static int genericlist_cstring_sort(char **base, size_t num, int descending) {
+    if (num < RADIX_SORT_CUTOFF)
+        return CC_ENOTSUP;
+
+    char **temp = MALLOC(num * sizeof(*temp));
+    if (temp == NULL)
+        return CC_ENOMEM;
+
+    genericlist_cstring_radix_sort(base, temp, num, 0);
+
+    if (descending) {
+        for (size_t i = 0; i < num / 2; ++i) {
+            char *swap = base[i];
+            base[i] = base[num - 1 - i];
+            base[num - 1 - i] = swap;
+        }
+    }
+
+    FREE(temp);
+
+    return 0;
 }
 
 GenericList genericlist_sorted(GenericList list, int descending) {
@@ -1104,39 +1733,248 @@ GenericList genericlist_stable_sorted(GenericList list, int descending) {
     return copy;
 }
 
+/* Sorts `count` elements of a list with container base `base` stored at `array` */
+static int genericlist_sort_array(const CommonContainerBase *base, void *array, size_t count, int descending) {
+    if (base->size) {
+        const enum GenericListRadixKind kind = genericlist_radix_kind(base);
+
+        if (kind == RADIX_NONE || genericlist_radix_sort(array, count, base->size, kind, descending))
+            return genericlist_pdq_sort(array, count, base->size, 0, descending? -1: 1, base->compare);
+    } else if (base->compare != container_base_cstring_recipe()->compare ||
+               genericlist_cstring_sort(array, count, descending)) {
+        return genericlist_pdq_sort(array, count, sizeof(void*), 1, descending? -1: 1, base->compare);
+    }
+
+    return 0;
+}
+
+/* Stably sorts `count` elements of a list with container base `base` stored at `array`. `temp` must have room for `count` elements */
+static void genericlist_stable_sort_array(const CommonContainerBase *base, void *array, void *temp, size_t count, int descending) {
+    const size_t element_size = genericlist_stored_element_size(base);
+
+    memcpy(temp, array, count * element_size);
+    if (base->size)
+        genericlist_pod_merge_sort(temp, array, 0, count, element_size, descending? -1: 1, base->compare);
+    else
+        genericlist_ptr_merge_sort(temp, array, 0, count, descending? -1: 1, base->compare);
+}
+
 int genericlist_sort(GenericList list, int descending) {
     if (list->base->compare == NULL)
         return CC_ENOTSUP;
 
-    if (list->base->size && list->base->size <= sizeof(void*))
-        /* Could (technically) also use builtin qsort here, but it would require possibly worse than O(n log n) complexity and wouldn't allow compare reversal */
-        genericlist_pod_heap_sort(list->array, genericlist_size(list), list->base->size, descending? -1: 1, list->base->compare);
-    else
-        genericlist_ptr_heap_sort(list->array, genericlist_size(list), descending? -1: 1, list->base->compare);
-
-    return 0;
+    return genericlist_sort_array(list->base, list->array, genericlist_size(list), descending);
 }
 
 int genericlist_stable_sort(GenericList list, int descending) {
     if (list->base->compare == NULL)
         return CC_ENOTSUP;
+    else if (genericlist_size(list) == 0)
+        return 0;
 
-    const size_t element_size = genericlist_stored_element_size(list->base);
-    void **temp = genericlist_size(list)? MALLOC(genericlist_size(list) * element_size): NULL;
+    void *temp = MALLOC(genericlist_size(list) * genericlist_stored_element_size(list->base));
     if (temp == NULL)
         return CC_ENOMEM;
 
-    memcpy(temp, list->array, genericlist_size(list) * element_size);
-    if (list->base->size && list->base->size <= sizeof(void*))
-        genericlist_pod_merge_sort(temp, list->array, 0, genericlist_size(list), element_size, descending? -1: 1, list->base->compare);
+    genericlist_stable_sort_array(list->base, list->array, temp, genericlist_size(list), descending);
+
+    FREE(temp);
+
+    return 0;
+}
+
+/* Lists smaller than this per thread are not worth sorting in parallel */
+#define PARALLEL_SORT_MIN_CHUNK 16384
+
+/* One unit of work for a parallel sort, either sorting a chunk of the list or merging parts of two sorted runs */
+typedef struct {
+    const CommonContainerBase *base;
+    int descending;
+    int stable;
+
+    /* For sorting, the chunk is at `left` with `left_count` elements, and `out` is scratch space of the same size */
+    /* For merging, `left` and `right` are merged into `out` */
+    void *left, *right, *out;
+    size_t left_count, right_count;
+} GenericListSortTask;
+
+static int genericlist_parallel_sort_chunk(void *args) {
+    GenericListSortTask *task = args;
+
+    /* If an unstable sort cannot get scratch space, the chunk's share of the output can be used for a stable sort instead */
+    if (task->stable || genericlist_sort_array(task->base, task->left, task->left_count, task->descending))
+        genericlist_stable_sort_array(task->base, task->left, task->out, task->left_count, task->descending);
+
+    return 0;
+}
+
+static int genericlist_parallel_merge_chunk(void *args) {
+    GenericListSortTask *task = args;
+    const CommonContainerBase *base = task->base;
+    const int descending = task->descending? -1: 1;
+
+    if (base->size)
+        genericlist_pod_merge_helper(task->out, task->left, task->left_count, task->right, task->right_count, base->size, descending, base->compare);
     else
-        genericlist_ptr_merge_sort(temp, list->array, 0, genericlist_size(list), descending? -1: 1, list->base->compare);
+        genericlist_ptr_merge_helper(task->out, task->left, task->left_count, task->right, task->right_count, descending, base->compare);
+
+    return 0;
+}
 
+/* Runs every task, each on its own thread except the first, which runs on the calling thread.
+ * If a thread cannot be created, its task is run on the calling thread instead */
+static void genericlist_run_tasks(ThreadStartFn fn, GenericListSortTask *tasks, Thread *threads, size_t count) {
+    for (size_t i = 1; i < count; ++i)
+        threads[i] = thread_create(fn, &tasks[i]);
+
+    fn(&tasks[0]);
+
+    for (size_t i = 1; i < count; ++i) {
+        if (threads[i] == NULL)
+            fn(&tasks[i]);
+        else
+            thread_join(threads[i], NULL);
+    }
+}
+
+/* Returns how many of the first `diagonal` elements of the merge of `left` and `right` come from `left` (the merge path split).
+ * Ties are taken from `left` first, as in the merge helpers, so parallel merges are stable */
+static size_t genericlist_merge_path_split(const CommonContainerBase *base, const void *left, size_t left_count, const void *right, size_t right_count, size_t diagonal, int descending) {
+    const size_t element_size = genericlist_stored_element_size(base);
+    const int pod = base->size != 0;
+    size_t lo = diagonal > right_count? diagonal - right_count: 0;
+    size_t hi = MIN(diagonal, left_count);
+
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        const void *left_element = (const char *) left + mid * element_size;
+        const void *right_element = (const char *) right + (diagonal - mid - 1) * element_size;
+        int cmp;
+
+        if (pod)
+            cmp = base->compare(left_element, right_element);
+        else
+            cmp = base->compare(*((void * const *) left_element), *((void * const *) right_element));
+
+        if (cmp * descending <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+static int genericlist_parallel_sort_helper(GenericList list, int descending, size_t threads, int stable) {
+    if (list->base->compare == NULL)
+        return CC_ENOTSUP;
+
+    const size_t size = genericlist_size(list);
+    const size_t element_size = genericlist_stored_element_size(list->base);
+    const size_t chunks = MIN(threads, size / PARALLEL_SORT_MIN_CHUNK);
+
+    if (chunks <= 1)
+        return stable? genericlist_stable_sort(list, descending): genericlist_sort(list, descending);
+
+    threads = chunks;
+
+    /* Every merge round has at most `threads` tasks, plus one more per pair of runs for rounding */
+    size_t *bounds = MALLOC((chunks + 1) * sizeof(*bounds));
+    GenericListSortTask *tasks = MALLOC((threads + chunks) * sizeof(*tasks));
+    Thread *handles = MALLOC((threads + chunks) * sizeof(*handles));
+    unsigned char *temp = MALLOC(size * element_size);
+    if (bounds == NULL || tasks == NULL || handles == NULL || temp == NULL) {
+        FREE(bounds);
+        FREE(tasks);
+        FREE(handles);
+        FREE(temp);
+        return stable? CC_ENOMEM: genericlist_sort(list, descending);
+    }
+
+    unsigned char *src = list->array, *dst = temp;
+    size_t runs = chunks;
+
+    /* Sort each chunk independently */
+    for (size_t i = 0; i <= chunks; ++i)
+        bounds[i] = size / chunks * i + MIN(i, size % chunks);
+
+    for (size_t i = 0; i < chunks; ++i) {
+        GenericListSortTask *task = &tasks[i];
+
+        task->base = list->base;
+        task->descending = descending;
+        task->stable = stable;
+        task->left = src + bounds[i] * element_size;
+        task->left_count = bounds[i+1] - bounds[i];
+        task->out = temp + bounds[i] * element_size;
+    }
+
+    genericlist_run_tasks(genericlist_parallel_sort_chunk, tasks, handles, chunks);
+
+    /* Merge pairs of runs until only one is left, splitting each merge between threads along the merge path */
+    while (runs > 1) {
+        const size_t pairs = (runs + 1) / 2;
+        const size_t parts = MAX(threads / pairs, 1);
+        size_t task_count = 0;
+
+        for (size_t pair = 0; pair < pairs; ++pair) {
+            const size_t begin = bounds[2*pair];
+            const size_t pivot = bounds[2*pair+1];
+            const size_t end = 2*pair+2 <= runs? bounds[2*pair+2]: pivot;
+            const unsigned char *left = src + begin * element_size, *right = src + pivot * element_size;
+            const size_t left_count = pivot - begin, right_count = end - pivot;
+            size_t previous_diagonal = 0, previous_split = 0;
+
+            for (size_t part = 1; part <= parts; ++part) {
+                const size_t diagonal = (end - begin) / parts * part + MIN(part, (end - begin) % parts);
+                const size_t split = genericlist_merge_path_split(list->base, left, left_count, right, right_count, diagonal, descending? -1: 1);
+                GenericListSortTask *task = &tasks[task_count++];
+
+                task->base = list->base;
+                task->descending = descending;
+                task->stable = stable;
+                task->left = (unsigned char *) left + previous_split * element_size;
+                task->left_count = split - previous_split;
+                task->right = (unsigned char *) right + (previous_diagonal - previous_split) * element_size;
+                task->right_count = (diagonal - split) - (previous_diagonal - previous_split);
+                task->out = dst + (begin + previous_diagonal) * element_size;
+
+                previous_diagonal = diagonal;
+                previous_split = split;
+            }
+
+            bounds[pair] = begin;
+        }
+
+        bounds[pairs] = size;
+        runs = pairs;
+
+        genericlist_run_tasks(genericlist_parallel_merge_chunk, tasks, handles, task_count);
+
+        unsigned char *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != list->array)
+        memcpy(list->array, src, size * element_size);
+
+    FREE(bounds);
+    FREE(tasks);
+    FREE(handles);
     FREE(temp);
 
     return 0;
 }
 
+int genericlist_parallel_sort(GenericList list, int descending, size_t threads) {
+    return genericlist_parallel_sort_helper(list, descending, threads, 0);
+}
+
+int genericlist_parallel_stable_sort(GenericList list, int descending, size_t threads) {
+    return genericlist_parallel_sort_helper(list, descending, threads, 1);
+}
+
 void genericlist_reserve(GenericList list, size_t size) {
     if (size <= genericlist_size(list))
         return;
@@ -1144,6 +1982,25 @@ void genericlist_reserve(GenericList list, size_t size) {
     genericlist_grow(list, size - genericlist_size(list));
 }
 
+int genericlist_shrink_to_fit(GenericList list) {
+    const size_t element_size = genericlist_stored_element_size(list->base);
+
+    if (genericlist_is_small(list) || list->array_capacity == list->array_size + 1)
+        return 0;
+    else if (list->array_size < list->small_capacity) {
+        /* Move back into the small buffer, including the terminating element */
+        memcpy(list->small_buffer, list->array, (list->array_size + 1) * element_size);
+        FREE(list->array);
+
+        list->array = list->small_buffer;
+        list->array_capacity = list->small_capacity;
+
+        return 0;
+    }
+
+    return genericlist_reallocate(list, list->array_size + 1);
+}
+
 Iterator genericlist_begin(GenericList list) {
     return list->array_size == 0? NULL: list->array;
 }
@@ -1152,7 +2009,7 @@ Iterator genericlist_next(GenericList list, Iterator it) {
     if (it == NULL || genericlist_size(list) == 0)
         return NULL;
 
-    if (list->base->size && list->base->size <= sizeof(void*)) {
+    if (list->base->size) {
         const size_t element_size = list->base->size;
 
         if ((char *) it == (char *) list->array + ((list->array_size-1) * element_size))
@@ -1173,7 +2030,7 @@ Iterator genericlist_next(GenericList list, Iterator it) {
 size_t genericlist_index_of(GenericList list, Iterator it) {
     if (it == NULL)
         return list->array_size;
-    else if (list->base->size && list->base->size <= sizeof(void*)) {
+    else if (list->base->size) {
         const char *ptr_offset = list->array;
         size_t size_left = list->array_size;
         size_t index_offset = 0;
@@ -1199,14 +2056,14 @@ size_t genericlist_index_of(GenericList list, Iterator it) {
 }
 
 void *genericlist_value_of(GenericList list, Iterator it) {
-    if (list->base->size && list->base->size <= sizeof(void*))
+    if (list->base->size)
         return it;
     else
         return *((void **) it);
 }
 
 void *genericlist_value_at(GenericList list, size_t index) {
-    if (list->base->size && list->base->size <= sizeof(void*)) {
+    if (list->base->size) {
         const size_t element_size = list->base->size;
 
         return (char *) list->array + (index * element_size);
@@ -1302,17 +2159,17 @@ void genericlist_clear(GenericList list) {
 
 void genericlist_destroy(GenericList list) {
     if (list) {
-        Deleter deleter = list->base->size? list->base->size <= sizeof(void*)? NULL: FREE: list->base->deleter;
-
-        if (deleter) {
+        if (list->base->size == 0) {
             void **array = (void **) list->array;
 
             for (size_t i = 0; i < genericlist_size(list); ++i)
-                deleter(array[i]);
+                genericlist_destroy_element(list, array[i]);
         }
 
+        genericlist_arena_destroy(list);
         container_base_destroy_if_dynamic(list->base);
-        FREE(list->array);
+        if (!genericlist_is_small(list))
+            FREE(list->array);
         FREE(list);
     }
 }
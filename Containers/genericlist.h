@@ -17,6 +17,24 @@ int variant_set_genericlist(Variant var, const GenericList list);
 int variant_set_genericlist_move(Variant var, GenericList list);
 GenericList genericlist_create(const CommonContainerBase *base);
 GenericList genericlist_create_reserve(size_t reserve, const CommonContainerBase *base);
+/** @brief Creates a packed list of non-POD elements.
+ *
+ * A packed list can allocate storage for its elements from an arena owned by the list, using genericlist_packed_alloc(), instead of allocating each one separately.
+ * Elements from the arena are never destroyed individually. Replacing or removing one just leaves its storage unused until the list is emptied or destroyed.
+ * Elements added with the copying functions are still allocated with the list's copier, so mutating a packed list falls back to copying each changed element.
+ *
+ * @return A new, empty, packed list, or NULL if `base` is a POD type or allocation failed.
+ */
+GenericList genericlist_create_packed(size_t reserve, const CommonContainerBase *base);
+int genericlist_is_packed(GenericList list);
+/** @brief Allocates `size` unaligned bytes from the arena of a packed list.
+ *
+ * The result must be moved into the list with one of the move functions, such as genericlist_append_move().
+ * If moving it in fails, it must not be freed; it is released along with the arena.
+ *
+ * @return The new storage, or NULL if the list is not packed or allocation failed.
+ */
+void *genericlist_packed_alloc(GenericList list, size_t size);
 GenericList genericlist_copy(GenericList other);
 GenericList genericlist_concatenate(GenericList left, GenericList right);
 GenericList genericlist_from_genericmap_values(GenericMap other);
@@ -53,7 +71,25 @@ GenericList genericlist_sorted(GenericList list, int descending);
 GenericList genericlist_stable_sorted(GenericList list, int descending);
 int genericlist_sort(GenericList list, int descending);
 int genericlist_stable_sort(GenericList list, int descending);
+/** @brief Sorts a list using up to @p threads threads, including the calling thread.
+ *
+ * The list is split into chunks that are sorted concurrently, then the sorted chunks are merged in parallel.
+ * Small lists, or a @p threads value of 0 or 1, are sorted on the calling thread as with genericlist_sort().
+ * genericlist_parallel_stable_sort() keeps equal elements in their original order, as with genericlist_stable_sort().
+ *
+ * @return 0 on success, or an error if the list could not be sorted.
+ */
+int genericlist_parallel_sort(GenericList list, int descending, size_t threads);
+int genericlist_parallel_stable_sort(GenericList list, int descending, size_t threads);
 void genericlist_reserve(GenericList list, size_t size);
+/** @brief Releases unused capacity of a list.
+ *
+ * Small lists are stored in a buffer allocated along with the list itself, and only move to a separate allocation when they outgrow it.
+ * If the list fits in that buffer again, it is moved back there, otherwise its separate allocation is shrunk to fit its elements.
+ *
+ * @return 0 on success, or an error if the list could not be reallocated. The list is unchanged on error.
+ */
+int genericlist_shrink_to_fit(GenericList list);
 Iterator genericlist_begin(GenericList list);
 Iterator genericlist_next(GenericList list, Iterator it);
 size_t genericlist_index_of(GenericList list, Iterator it);
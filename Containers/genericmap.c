@@ -6,6 +6,8 @@
 
 #include "genericmap.h"
 #include "impl/avl.h"
+#include "impl/btree.h"
+#include "impl/hashtable.h"
 #include "recipes.h"
 
 /* For conversions */
@@ -14,6 +16,8 @@
 /* See common.c for reasoning behind this empty struct */
 struct GenericMapStruct {char dummy;};
 
+/* A GenericMap is a `struct AVLTree`, a `struct HashTable`, or a `struct BTree`, see impl/backend.h */
+
 Variant variant_from_genericmap(GenericMap map) {
     return variant_create_custom_adopt(map, genericmap_build_recipe(map));
 }
@@ -45,98 +49,172 @@ GenericMap genericmap_create(const CommonContainerBase *key_base, const CommonCo
     return (GenericMap) avltree_create(key_base, value_base);
 }
 
+GenericMap genericmap_create_hashed(const CommonContainerBase *key_base, const CommonContainerBase *value_base) {
+    return (GenericMap) hashtable_create(key_base, value_base);
+}
+
+GenericMap genericmap_create_btree(const CommonContainerBase *key_base, const CommonContainerBase *value_base) {
+    return (GenericMap) btree_create(key_base, value_base);
+}
+
+GenericMap genericmap_from_sorted(const void **keys, const void **values, size_t count, const CommonContainerBase *key_base, const CommonContainerBase *value_base) {
+    struct AVLTree *tree = avltree_create(key_base, value_base);
+    if (tree == NULL || avltree_build_sorted(tree, keys, values, count)) {
+        avltree_destroy(tree);
+        return NULL;
+    }
+
+    return (GenericMap) tree;
+}
+
 GenericMap genericmap_copy(GenericMap other) {
-    return (GenericMap) avltree_copy((struct AVLTree *) other);
+    switch (CONTAINER_BACKEND_OF(other)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return (GenericMap) avltree_copy((struct AVLTree *) other);
+        case CONTAINER_BACKEND_HASH: return (GenericMap) hashtable_copy((struct HashTable *) other);
+        case CONTAINER_BACKEND_BTREE: return (GenericMap) btree_copy((struct BTree *) other);
+    }
+}
+
+int genericmap_is_ordered(GenericMap map) {
+    return CONTAINER_BACKEND_OF(map) != CONTAINER_BACKEND_HASH;
 }
 
 int genericmap_insert_move_key(GenericMap map, void *key, void *item) {
-    if (avltree_insert_move_key((struct AVLTree *) map, key, item) == NULL)
+    Iterator it;
+
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: it = avltree_insert_move_key((struct AVLTree *) map, key, item); break;
+        case CONTAINER_BACKEND_HASH: it = hashtable_insert_move_key((struct HashTable *) map, key, item); break;
+        case CONTAINER_BACKEND_BTREE: it = btree_insert_move_key((struct BTree *) map, key, item); break;
+    }
+
+    if (it == NULL)
         return CC_ENOMEM;
 
     return 0;
 }
 
 int genericmap_insert_move(GenericMap map, const void *key, void *item) {
-    if (avltree_insert_copy_key((struct AVLTree *) map, key, item) == NULL)
+    Iterator it;
+
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: it = avltree_insert_copy_key((struct AVLTree *) map, key, item); break;
+        case CONTAINER_BACKEND_HASH: it = hashtable_insert_copy_key((struct HashTable *) map, key, item); break;
+        case CONTAINER_BACKEND_BTREE: it = btree_insert_copy_key((struct BTree *) map, key, item); break;
+    }
+
+    if (it == NULL)
         return CC_ENOMEM;
 
     return 0;
 }
 
 int genericmap_insert(GenericMap map, const void *key, const void *item) {
-    if (avltree_get_value_copier_fn((struct AVLTree *) map) == NULL)
+    Iterator it;
+
+    /* Backends only report failure as a NULL iterator, so a value that can't be copied is rejected here */
+    if (genericmap_get_value_copier_fn(map) == NULL)
         return CC_ENOTSUP;
 
-    void *duplicate = avltree_get_value_copier_fn((struct AVLTree *) map)(item);
-    if (duplicate == NULL && item != NULL)
-        return CC_ENOMEM;
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: it = avltree_insert_copy((struct AVLTree *) map, key, item); break;
+        case CONTAINER_BACKEND_HASH: it = hashtable_insert_copy((struct HashTable *) map, key, item); break;
+        case CONTAINER_BACKEND_BTREE: it = btree_insert_copy((struct BTree *) map, key, item); break;
+    }
 
-    int err = genericmap_insert_move(map, key, duplicate);
-    if (err)
-        avltree_get_value_deleter_fn((struct AVLTree *) map)(duplicate);
+    if (it == NULL)
+        return CC_ENOMEM;
 
-    return err;
+    return 0;
 }
 
 int genericmap_replace_move(GenericMap map, Iterator it, void *item) {
-    struct AVLNode *node = it;
-
-    avltree_get_value_deleter_fn((struct AVLTree *) map)(*avlnode_value(node));
-    *avlnode_value(node) = item;
-    return 0;
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_replace_move((struct AVLTree *) map, (struct AVLNode *) it, item);
+        case CONTAINER_BACKEND_HASH: return hashtable_replace_move((struct HashTable *) map, it, item);
+        case CONTAINER_BACKEND_BTREE: return btree_replace_move((struct BTree *) map, it, item);
+    }
 }
 
 int genericmap_replace(GenericMap map, Iterator it, const void *item) {
-    if (avltree_get_value_copier_fn((struct AVLTree *) map) == NULL)
-        return CC_ENOTSUP;
-
-    void *duplicate = avltree_get_value_copier_fn((struct AVLTree *) map)(item);
-    if (duplicate == NULL && item != NULL)
-        return CC_ENOMEM;
-
-    int err = genericmap_replace_move(map, it, duplicate);
-    if (err)
-        avltree_get_value_deleter_fn((struct AVLTree *) map)(duplicate);
-
-    return err;
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_replace((struct AVLTree *) map, (struct AVLNode *) it, item);
+        case CONTAINER_BACKEND_HASH: return hashtable_replace((struct HashTable *) map, it, item);
+        case CONTAINER_BACKEND_BTREE: return btree_replace((struct BTree *) map, it, item);
+    }
 }
 
 int genericmap_contains(GenericMap map, const void *key) {
-    return avltree_find((struct AVLTree *) map, key) != NULL;
+    return genericmap_find(map, key) != NULL;
 }
 
 Iterator genericmap_find(GenericMap map, const void *key) {
-    return avltree_find((struct AVLTree *) map, key);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_find((struct AVLTree *) map, key);
+        case CONTAINER_BACKEND_HASH: return hashtable_find((struct HashTable *) map, key);
+        case CONTAINER_BACKEND_BTREE: return btree_find((struct BTree *) map, key);
+    }
 }
 
 void genericmap_remove(GenericMap map, const void *key) {
-    avltree_delete((struct AVLTree *) map, key);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: avltree_delete((struct AVLTree *) map, key); break;
+        case CONTAINER_BACKEND_HASH: hashtable_delete((struct HashTable *) map, key); break;
+        case CONTAINER_BACKEND_BTREE: btree_delete((struct BTree *) map, key); break;
+    }
 }
 
 Iterator genericmap_erase(GenericMap map, Iterator it) {
-    return avltree_delete_node((struct AVLTree *) map, (struct AVLNode *) it);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_delete_node((struct AVLTree *) map, (struct AVLNode *) it);
+        case CONTAINER_BACKEND_HASH: return hashtable_delete_slot((struct HashTable *) map, it);
+        case CONTAINER_BACKEND_BTREE: return btree_delete_at((struct BTree *) map, it);
+    }
 }
 
 Iterator genericmap_begin(GenericMap map) {
-    return avltree_min_node((struct AVLTree *) map);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_min_node((struct AVLTree *) map);
+        case CONTAINER_BACKEND_HASH: return hashtable_begin((struct HashTable *) map);
+        case CONTAINER_BACKEND_BTREE: return btree_begin((struct BTree *) map);
+    }
 }
 
 Iterator genericmap_next(GenericMap map, Iterator it) {
-    UNUSED(map)
-
-    return avltree_inorder_next((struct AVLNode *) it);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_inorder_next((struct AVLNode *) it);
+        case CONTAINER_BACKEND_HASH: return hashtable_next((struct HashTable *) map, it);
+        case CONTAINER_BACKEND_BTREE: return btree_next((struct BTree *) map, it);
+    }
 }
 
 const void *genericmap_key_of(GenericMap map, Iterator it) {
-    UNUSED(map)
-
-    return avlnode_key((struct AVLNode *) it);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avlnode_key((struct AVLTree *) map, (struct AVLNode *) it);
+        case CONTAINER_BACKEND_HASH: return hashtable_key_of((struct HashTable *) map, it);
+        case CONTAINER_BACKEND_BTREE: return btree_key_of((struct BTree *) map, it);
+    }
 }
 
 void *genericmap_value_of(GenericMap map, Iterator it) {
-    UNUSED(map)
-
-    return *avlnode_value((struct AVLNode *) it);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avlnode_value((struct AVLTree *) map, (struct AVLNode *) it);
+        case CONTAINER_BACKEND_HASH: return hashtable_value_of((struct HashTable *) map, it);
+        case CONTAINER_BACKEND_BTREE: return btree_value_of((struct BTree *) map, it);
+    }
 }
 
 void *genericmap_value_of_key(GenericMap map, const void *key) {
@@ -147,28 +225,131 @@ void *genericmap_value_of_key(GenericMap map, const void *key) {
     return genericmap_value_of(map, it);
 }
 
+/* Compares maps without relying on iteration order. Maps of equal size compare equal if every key of `lhs` is present in `rhs` with an equal value */
+static int genericmap_unordered_compare(GenericMap lhs, GenericMap rhs) {
+    const CommonContainerBase *key_base = genericmap_get_key_container_base(lhs);
+    const CommonContainerBase *value_base = genericmap_get_value_container_base(lhs);
+
+    int cmp = generic_types_compatible_compare(key_base, genericmap_get_key_container_base(rhs));
+    if (cmp)
+        return cmp;
+
+    cmp = generic_types_compatible_compare(value_base, genericmap_get_value_container_base(rhs));
+    if (cmp)
+        return cmp;
+
+    if (genericmap_size(lhs) != genericmap_size(rhs))
+        return genericmap_size(lhs) < genericmap_size(rhs)? -1: 1;
+
+    for (Iterator it = genericmap_begin(lhs); it; it = genericmap_next(lhs, it)) {
+        Iterator found = genericmap_find(rhs, genericmap_key_of(lhs, it));
+        if (found == NULL)
+            return CompareUnordered;
+
+        if (value_base->compare) {
+            cmp = value_base->compare(genericmap_value_of(lhs, it), genericmap_value_of(rhs, found));
+            if (cmp)
+                return cmp;
+        }
+    }
+
+    return 0;
+}
+
+/* Compares maps that both iterate in key order, element by element */
+static int genericmap_ordered_compare(GenericMap lhs, GenericMap rhs) {
+    const CommonContainerBase *key_base = genericmap_get_key_container_base(lhs);
+    const CommonContainerBase *value_base = genericmap_get_value_container_base(lhs);
+
+    int cmp = generic_types_compatible_compare(key_base, genericmap_get_key_container_base(rhs));
+    if (cmp)
+        return cmp;
+
+    cmp = generic_types_compatible_compare(value_base, genericmap_get_value_container_base(rhs));
+    if (cmp)
+        return cmp;
+
+    Iterator lhs_it = genericmap_begin(lhs);
+    Iterator rhs_it = genericmap_begin(rhs);
+
+    while (lhs_it && rhs_it) {
+        cmp = key_base->compare(genericmap_key_of(lhs, lhs_it), genericmap_key_of(rhs, rhs_it));
+        if (cmp)
+            return cmp;
+
+        if (value_base->compare) {
+            cmp = value_base->compare(genericmap_value_of(lhs, lhs_it), genericmap_value_of(rhs, rhs_it));
+            if (cmp)
+                return cmp;
+        }
+
+        lhs_it = genericmap_next(lhs, lhs_it);
+        rhs_it = genericmap_next(rhs, rhs_it);
+    }
+
+    if (lhs_it)
+        return 1;
+    else if (rhs_it)
+        return -1;
+    else
+        return 0;
+}
+
 int genericmap_compare(GenericMap lhs, GenericMap rhs) {
-    return avltree_compare((struct AVLTree *) lhs, (struct AVLTree *) rhs);
+    if (!genericmap_is_ordered(lhs) || !genericmap_is_ordered(rhs))
+        return genericmap_unordered_compare(lhs, rhs);
+    else if (CONTAINER_BACKEND_OF(lhs) == CONTAINER_BACKEND_AVL && CONTAINER_BACKEND_OF(rhs) == CONTAINER_BACKEND_AVL)
+        return avltree_compare((struct AVLTree *) lhs, (struct AVLTree *) rhs);
+
+    return genericmap_ordered_compare(lhs, rhs);
 }
 
 size_t genericmap_size(GenericMap map) {
-    return avltree_size((struct AVLTree *) map);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_size((struct AVLTree *) map);
+        case CONTAINER_BACKEND_HASH: return hashtable_size((struct HashTable *) map);
+        case CONTAINER_BACKEND_BTREE: return btree_size((struct BTree *) map);
+    }
 }
 
 void genericmap_clear(GenericMap map) {
-    avltree_clear((struct AVLTree *) map);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: avltree_clear((struct AVLTree *) map); break;
+        case CONTAINER_BACKEND_HASH: hashtable_clear((struct HashTable *) map); break;
+        case CONTAINER_BACKEND_BTREE: btree_clear((struct BTree *) map); break;
+    }
 }
 
 void genericmap_destroy(GenericMap map) {
-    avltree_destroy((struct AVLTree *) map);
+    if (map == NULL)
+        return;
+
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: avltree_destroy((struct AVLTree *) map); break;
+        case CONTAINER_BACKEND_HASH: hashtable_destroy((struct HashTable *) map); break;
+        case CONTAINER_BACKEND_BTREE: btree_destroy((struct BTree *) map); break;
+    }
 }
 
 const CommonContainerBase *genericmap_get_key_container_base(GenericMap map) {
-    return avltree_get_key_container_base((struct AVLTree *) map);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_key_container_base((struct AVLTree *) map);
+        case CONTAINER_BACKEND_HASH: return hashtable_get_key_container_base((struct HashTable *) map);
+        case CONTAINER_BACKEND_BTREE: return btree_get_key_container_base((struct BTree *) map);
+    }
 }
 
 const CommonContainerBase *genericmap_get_value_container_base(GenericMap map) {
-    return avltree_get_value_container_base((struct AVLTree *) map);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_value_container_base((struct AVLTree *) map);
+        case CONTAINER_BACKEND_HASH: return hashtable_get_value_container_base((struct HashTable *) map);
+        case CONTAINER_BACKEND_BTREE: return btree_get_value_container_base((struct BTree *) map);
+    }
 }
 
 CommonContainerBase *genericmap_build_recipe(GenericMap map) {
@@ -178,81 +359,192 @@ CommonContainerBase *genericmap_build_recipe(GenericMap map) {
 }
 
 Compare genericmap_get_key_compare_fn(GenericMap map) {
-    return avltree_get_key_compare_fn((struct AVLTree *) map);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_key_compare_fn((struct AVLTree *) map);
+        case CONTAINER_BACKEND_HASH: return hashtable_get_key_compare_fn((struct HashTable *) map);
+        case CONTAINER_BACKEND_BTREE: return btree_get_key_compare_fn((struct BTree *) map);
+    }
 }
 
 int genericmap_set_key_compare_fn(GenericMap map, Compare compare) {
-    return avltree_set_key_compare_fn((struct AVLTree *) map, compare);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_set_key_compare_fn((struct AVLTree *) map, compare);
+        case CONTAINER_BACKEND_HASH: return hashtable_set_key_compare_fn((struct HashTable *) map, compare);
+        case CONTAINER_BACKEND_BTREE: return btree_set_key_compare_fn((struct BTree *) map, compare);
+    }
 }
 
 Compare genericmap_get_value_compare_fn(GenericMap map) {
-    return avltree_get_value_compare_fn((struct AVLTree *) map);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_value_compare_fn((struct AVLTree *) map);
+        case CONTAINER_BACKEND_HASH: return hashtable_get_value_compare_fn((struct HashTable *) map);
+        case CONTAINER_BACKEND_BTREE: return btree_get_value_compare_fn((struct BTree *) map);
+    }
 }
 
 int genericmap_set_value_compare_fn(GenericMap map, Compare compare) {
-    return avltree_set_value_compare_fn((struct AVLTree *) map, compare);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_set_value_compare_fn((struct AVLTree *) map, compare);
+        case CONTAINER_BACKEND_HASH: return hashtable_set_value_compare_fn((struct HashTable *) map, compare);
+        case CONTAINER_BACKEND_BTREE: return btree_set_value_compare_fn((struct BTree *) map, compare);
+    }
 }
 
 Copier genericmap_get_key_copier_fn(GenericMap map) {
-    return avltree_get_key_copier_fn((struct AVLTree *) map);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_key_copier_fn((struct AVLTree *) map);
+        case CONTAINER_BACKEND_HASH: return hashtable_get_key_copier_fn((struct HashTable *) map);
+        case CONTAINER_BACKEND_BTREE: return btree_get_key_copier_fn((struct BTree *) map);
+    }
 }
 
 int genericmap_set_key_copier_fn(GenericMap map, Copier copier) {
-    return avltree_set_key_copier_fn((struct AVLTree *) map, copier);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_set_key_copier_fn((struct AVLTree *) map, copier);
+        case CONTAINER_BACKEND_HASH: return hashtable_set_key_copier_fn((struct HashTable *) map, copier);
+        case CONTAINER_BACKEND_BTREE: return btree_set_key_copier_fn((struct BTree *) map, copier);
+    }
 }
 
 Copier genericmap_get_value_copier_fn(GenericMap map) {
-    return avltree_get_value_copier_fn((struct AVLTree *) map);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_value_copier_fn((struct AVLTree *) map);
+        case CONTAINER_BACKEND_HASH: return hashtable_get_value_copier_fn((struct HashTable *) map);
+        case CONTAINER_BACKEND_BTREE: return btree_get_value_copier_fn((struct BTree *) map);
+    }
 }
 
 int genericmap_set_value_copier_fn(GenericMap map, Copier copier) {
-    return avltree_set_value_copier_fn((struct AVLTree *) map, copier);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_set_value_copier_fn((struct AVLTree *) map, copier);
+        case CONTAINER_BACKEND_HASH: return hashtable_set_value_copier_fn((struct HashTable *) map, copier);
+        case CONTAINER_BACKEND_BTREE: return btree_set_value_copier_fn((struct BTree *) map, copier);
+    }
 }
 
 Deleter genericmap_get_key_deleter_fn(GenericMap map) {
-    return avltree_get_key_deleter_fn((struct AVLTree *) map);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_key_deleter_fn((struct AVLTree *) map);
+        case CONTAINER_BACKEND_HASH: return hashtable_get_key_deleter_fn((struct HashTable *) map);
+        case CONTAINER_BACKEND_BTREE: return btree_get_key_deleter_fn((struct BTree *) map);
+    }
 }
 
 int genericmap_set_key_deleter_fn(GenericMap map, Deleter deleter) {
-    return avltree_set_key_deleter_fn((struct AVLTree *) map, deleter);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_set_key_deleter_fn((struct AVLTree *) map, deleter);
+        case CONTAINER_BACKEND_HASH: return hashtable_set_key_deleter_fn((struct HashTable *) map, deleter);
+        case CONTAINER_BACKEND_BTREE: return btree_set_key_deleter_fn((struct BTree *) map, deleter);
+    }
 }
 
 Deleter genericmap_get_value_deleter_fn(GenericMap map) {
-    return avltree_get_value_deleter_fn((struct AVLTree *) map);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_value_deleter_fn((struct AVLTree *) map);
+        case CONTAINER_BACKEND_HASH: return hashtable_get_value_deleter_fn((struct HashTable *) map);
+        case CONTAINER_BACKEND_BTREE: return btree_get_value_deleter_fn((struct BTree *) map);
+    }
 }
 
 int genericmap_set_value_deleter_fn(GenericMap map, Deleter deleter) {
-    return avltree_set_value_deleter_fn((struct AVLTree *) map, deleter);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_set_value_deleter_fn((struct AVLTree *) map, deleter);
+        case CONTAINER_BACKEND_HASH: return hashtable_set_value_deleter_fn((struct HashTable *) map, deleter);
+        case CONTAINER_BACKEND_BTREE: return btree_set_value_deleter_fn((struct BTree *) map, deleter);
+    }
 }
 
 Parser genericmap_get_key_parser_fn(GenericMap map) {
-    return avltree_get_key_parser_fn((struct AVLTree *) map);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_key_parser_fn((struct AVLTree *) map);
+        case CONTAINER_BACKEND_HASH: return hashtable_get_key_parser_fn((struct HashTable *) map);
+        case CONTAINER_BACKEND_BTREE: return btree_get_key_parser_fn((struct BTree *) map);
+    }
 }
 
 int genericmap_set_key_parser_fn(GenericMap map, Parser parser) {
-    return avltree_set_key_parser_fn((struct AVLTree *) map, parser);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_set_key_parser_fn((struct AVLTree *) map, parser);
+        case CONTAINER_BACKEND_HASH: return hashtable_set_key_parser_fn((struct HashTable *) map, parser);
+        case CONTAINER_BACKEND_BTREE: return btree_set_key_parser_fn((struct BTree *) map, parser);
+    }
 }
 
 Parser genericmap_get_value_parser_fn(GenericMap map) {
-    return avltree_get_value_parser_fn((struct AVLTree *) map);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_value_parser_fn((struct AVLTree *) map);
+        case CONTAINER_BACKEND_HASH: return hashtable_get_value_parser_fn((struct HashTable *) map);
+        case CONTAINER_BACKEND_BTREE: return btree_get_value_parser_fn((struct BTree *) map);
+    }
 }
 
 int genericmap_set_value_parser_fn(GenericMap map, Parser parser) {
-    return avltree_set_value_parser_fn((struct AVLTree *) map, parser);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_set_value_parser_fn((struct AVLTree *) map, parser);
+        case CONTAINER_BACKEND_HASH: return hashtable_set_value_parser_fn((struct HashTable *) map, parser);
+        case CONTAINER_BACKEND_BTREE: return btree_set_value_parser_fn((struct BTree *) map, parser);
+    }
 }
 
 Serializer genericmap_get_key_serializer_fn(GenericMap map) {
-    return avltree_get_key_serializer_fn((struct AVLTree *) map);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_key_serializer_fn((struct AVLTree *) map);
+        case CONTAINER_BACKEND_HASH: return hashtable_get_key_serializer_fn((struct HashTable *) map);
+        case CONTAINER_BACKEND_BTREE: return btree_get_key_serializer_fn((struct BTree *) map);
+    }
 }
 
 int genericmap_set_key_serializer_fn(GenericMap map, Serializer serializer) {
-    return avltree_set_key_serializer_fn((struct AVLTree *) map, serializer);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_set_key_serializer_fn((struct AVLTree *) map, serializer);
+        case CONTAINER_BACKEND_HASH: return hashtable_set_key_serializer_fn((struct HashTable *) map, serializer);
+        case CONTAINER_BACKEND_BTREE: return btree_set_key_serializer_fn((struct BTree *) map, serializer);
+    }
 }
 
 Serializer genericmap_get_value_serializer_fn(GenericMap map) {
-    return avltree_get_value_serializer_fn((struct AVLTree *) map);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_value_serializer_fn((struct AVLTree *) map);
+        case CONTAINER_BACKEND_HASH: return hashtable_get_value_serializer_fn((struct HashTable *) map);
+        case CONTAINER_BACKEND_BTREE: return btree_get_value_serializer_fn((struct BTree *) map);
+    }
 }
 
 int genericmap_set_value_serializer_fn(GenericMap map, Serializer serializer) {
-    return avltree_set_value_serializer_fn((struct AVLTree *) map, serializer);
+    switch (CONTAINER_BACKEND_OF(map)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_set_value_serializer_fn((struct AVLTree *) map, serializer);
+        case CONTAINER_BACKEND_HASH: return hashtable_set_value_serializer_fn((struct HashTable *) map, serializer);
+        case CONTAINER_BACKEND_BTREE: return btree_set_value_serializer_fn((struct BTree *) map, serializer);
+    }
+}
+
+Hasher genericmap_get_key_hash_fn(GenericMap map) {
+    return genericmap_get_key_container_base(map)->hash;
+}
+
+int genericmap_set_key_hash_fn(GenericMap map, Hasher hash) {
+    if (CONTAINER_BACKEND_OF(map) != CONTAINER_BACKEND_HASH)
+        return CC_ENOTSUP;
+
+    return hashtable_set_key_hash_fn((struct HashTable *) map, hash);
 }
@@ -16,7 +16,28 @@ GenericMap variant_get_genericmap(Variant var);
 int variant_set_genericmap(Variant var, const GenericMap map);
 int variant_set_genericmap_move(Variant var, GenericMap map);
 GenericMap genericmap_create(const CommonContainerBase *key_base, const CommonContainerBase *value_base);
+/** @brief Creates a map backed by an open-addressing hash table instead of a balanced tree.
+ *
+ * The key container base must provide both a `compare` and a `hash` function, otherwise NULL is returned.
+ * POD keys and values are stored inline in the table. Iteration order is unspecified, and iterators are invalidated by any insertion.
+ */
+GenericMap genericmap_create_hashed(const CommonContainerBase *key_base, const CommonContainerBase *value_base);
+/** @brief Creates a map backed by a B+tree instead of an AVL tree.
+ *
+ * Small POD keys and values are stored inline in wide, linked leaves, which makes iteration and range scans much more cache-friendly.
+ * Iteration is in key order, as with genericmap_create(). Iterators are invalidated by any insertion or removal,
+ * except that genericmap_erase() returns a valid iterator to the next element.
+ */
+GenericMap genericmap_create_btree(const CommonContainerBase *key_base, const CommonContainerBase *value_base);
+/** @brief Creates a map from `count` keys that are already sorted in ascending order with no duplicates, and their corresponding values.
+ *
+ * The map is built in linear time without comparing any keys, so the behavior is undefined if the keys are not sorted and unique.
+ * All keys and values are copied into the map. If @p values is NULL, every value is empty.
+ */
+GenericMap genericmap_from_sorted(const void **keys, const void **values, size_t count, const CommonContainerBase *key_base, const CommonContainerBase *value_base);
 GenericMap genericmap_copy(GenericMap other);
+/** @brief Returns non-zero if iterating @p map visits keys in sorted order. */
+int genericmap_is_ordered(GenericMap map);
 int genericmap_insert_move_key(GenericMap map, void *key, void *item);
 int genericmap_insert_move(GenericMap map, const void *key, void *item);
 int genericmap_insert(GenericMap map, const void *key, const void *item);
@@ -49,6 +70,7 @@ Parser genericmap_get_key_parser_fn(GenericMap map);
 Parser genericmap_get_value_parser_fn(GenericMap map);
 Serializer genericmap_get_key_serializer_fn(GenericMap map);
 Serializer genericmap_get_value_serializer_fn(GenericMap map);
+Hasher genericmap_get_key_hash_fn(GenericMap map);
 int genericmap_set_key_compare_fn(GenericMap map, Compare compare);
 int genericmap_set_value_compare_fn(GenericMap map, Compare compare);
 int genericmap_set_key_copier_fn(GenericMap map, Copier copier);
@@ -59,5 +81,7 @@ int genericmap_set_key_parser_fn(GenericMap map, Parser parser);
 int genericmap_set_value_parser_fn(GenericMap map, Parser parser);
 int genericmap_set_key_serializer_fn(GenericMap map, Serializer serializer);
 int genericmap_set_value_serializer_fn(GenericMap map, Serializer serializer);
+/* Only supported by hashed maps, and only while the map is empty */
+int genericmap_set_key_hash_fn(GenericMap map, Hasher hash);
 
 #endif // GENERICMAP_H
@@ -6,14 +6,20 @@
 
 #include "genericset.h"
 #include "impl/avl.h"
+#include "impl/btree.h"
 #include "recipes.h"
 
+#include <string.h>
+
 /* For conversions */
 #include "variant.h"
+#include "genericlist.h"
 
 /* See common.c for reasoning behind this empty struct */
 struct GenericSetStruct {char dummy;};
 
+/* A GenericSet is either a `struct AVLTree` or a `struct BTree` with no values, see impl/backend.h */
+
 Variant variant_from_genericset(GenericSet set) {
     return variant_create_custom_adopt(set, genericset_build_recipe(set));
 }
@@ -45,212 +51,260 @@ GenericSet genericset_create(const CommonContainerBase *base) {
     return (GenericSet) avltree_create(base, container_base_empty_recipe());
 }
 
+GenericSet genericset_create_btree(const CommonContainerBase *base) {
+    return (GenericSet) btree_create(base, container_base_empty_recipe());
+}
+
+/* Creates an empty set with the same backend as `set`, for the results of set operations */
+static GenericSet genericset_create_like(GenericSet set, const CommonContainerBase *base) {
+    if (CONTAINER_BACKEND_OF(set) == CONTAINER_BACKEND_BTREE)
+        return genericset_create_btree(base);
+
+    return genericset_create(base);
+}
+
 GenericSet genericset_copy(GenericSet other) {
-    return (GenericSet) avltree_copy((struct AVLTree *) other);
+    switch (CONTAINER_BACKEND_OF(other)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return (GenericSet) avltree_copy((struct AVLTree *) other);
+        case CONTAINER_BACKEND_BTREE: return (GenericSet) btree_copy((struct BTree *) other);
+    }
 }
 
-GenericSet genericset_union(GenericSet a, GenericSet b) {
-    if (generic_types_compatible_compare(avltree_get_key_container_base((struct AVLTree *) a), avltree_get_key_container_base((struct AVLTree *) b)) != 0)
-        return NULL;
+/* Fills an empty set with `count` items that are sorted in ascending order with no duplicates, without comparing them */
+static int genericset_build_sorted(GenericSet set, const void **items, size_t count) {
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_build_sorted((struct AVLTree *) set, items, NULL, count);
+        case CONTAINER_BACKEND_BTREE: return btree_build_sorted((struct BTree *) set, items, NULL, count);
+    }
+}
 
-    const CommonContainerBase *base = avltree_get_key_container_base((struct AVLTree *) a);
-    GenericSet result = genericset_create(base);
-    if (result == NULL)
-        return NULL;
+/* Sorts an array of item pointers with a merge sort. `temp` must have room for at least `count / 2` pointers.
+ * Runs that are already in order are not merged, so sorted input only takes a linear number of comparisons */
+static void genericset_sort_items(const void **items, const void **temp, size_t count, Compare compare) {
+    if (count < 2)
+        return;
 
-    Iterator lhs = genericset_begin(a);
-    Iterator rhs = genericset_begin(b);
-    while (lhs && rhs) {
-        const void *lhs_value = genericset_value_of(a, lhs);
-        const void *rhs_value = genericset_value_of(b, rhs);
-        int cmp = base->compare(lhs_value, rhs_value);
-        int err = 0;
+    const size_t pivot = count / 2;
 
-        if (cmp < 0) {
-            err = genericset_add(result, lhs_value);
-            lhs = genericset_next(a, lhs);
-        } else if (cmp > 0) {
-            err = genericset_add(result, rhs_value);
-            rhs = genericset_next(b, rhs);
-        } else {
-            err = genericset_add(result, lhs_value);
-            lhs = genericset_next(a, lhs);
-            rhs = genericset_next(b, rhs);
-        }
+    genericset_sort_items(items, temp, pivot, compare);
+    genericset_sort_items(items + pivot, temp, count - pivot, compare);
 
-        if (err) {
-            genericset_destroy(result);
-            return NULL;
-        }
-    }
+    if (compare(items[pivot-1], items[pivot]) <= 0)
+        return;
 
-    while (lhs) {
-        if (genericset_add(result, genericset_value_of(a, lhs))) {
-            genericset_destroy(result);
-            return NULL;
-        }
+    memcpy(temp, items, pivot * sizeof(*items));
 
-        lhs = genericset_next(a, lhs);
-    }
+    size_t left = 0, right = pivot, out = 0;
+    while (left < pivot && right < count)
+        items[out++] = compare(items[right], temp[left]) < 0? items[right++]: temp[left++];
 
-    while (rhs) {
-        if (genericset_add(result, genericset_value_of(b, rhs))) {
-            genericset_destroy(result);
-            return NULL;
-        }
+    while (left < pivot)
+        items[out++] = temp[left++];
+}
 
-        rhs = genericset_next(b, rhs);
+/* Sorts `items` in place and builds a set from them. Duplicates keep the first occurrence, as if added one at a time */
+static GenericSet genericset_from_unsorted(const void **items, size_t count, const CommonContainerBase *base) {
+    if (base->compare == NULL)
+        return NULL;
+
+    const void **temp = count > 1? MALLOC((count / 2) * sizeof(*temp)): NULL;
+    if (count > 1 && temp == NULL)
+        return NULL;
+
+    genericset_sort_items(items, temp, count, base->compare);
+    FREE(temp);
+
+    size_t unique = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (unique == 0 || base->compare(items[unique-1], items[i]) != 0)
+            items[unique++] = items[i];
     }
 
-    return result;
+    return genericset_from_sorted(items, unique, base);
 }
 
-GenericSet genericset_intersection(GenericSet a, GenericSet b) {
-    if (generic_types_compatible_compare(avltree_get_key_container_base((struct AVLTree *) a), avltree_get_key_container_base((struct AVLTree *) b)) != 0)
+GenericSet genericset_from_sorted(const void **items, size_t count, const CommonContainerBase *base) {
+    GenericSet set = genericset_create(base);
+    if (set == NULL || genericset_build_sorted(set, items, count)) {
+        genericset_destroy(set);
         return NULL;
+    }
 
-    const CommonContainerBase *base = avltree_get_key_container_base((struct AVLTree *) a);
-    GenericSet result = genericset_create(base);
-    if (result == NULL)
+    return set;
+}
+
+GenericSet genericset_from_array_n(const void **items, size_t count, const CommonContainerBase *base) {
+    const void **copy = count? MALLOC(count * sizeof(*copy)): NULL;
+    if (count && copy == NULL)
         return NULL;
 
-    Iterator lhs = genericset_begin(a);
-    Iterator rhs = genericset_begin(b);
-    while (lhs && rhs) {
-        const void *lhs_value = genericset_value_of(a, lhs);
-        const void *rhs_value = genericset_value_of(b, rhs);
-        int cmp = base->compare(lhs_value, rhs_value);
+    if (count)
+        memcpy(copy, items, count * sizeof(*copy));
 
-        if (cmp < 0) {
-            lhs = genericset_next(a, lhs);
-        } else if (cmp > 0) {
-            rhs = genericset_next(b, rhs);
-        } else {
-            if (genericset_add(result, lhs_value)) {
-                genericset_destroy(result);
-                return NULL;
-            }
-            lhs = genericset_next(a, lhs);
-            rhs = genericset_next(b, rhs);
-        }
-    }
+    GenericSet set = genericset_from_unsorted(copy, count, base);
+    FREE(copy);
 
-    return result;
+    return set;
 }
 
-GenericSet genericset_subtract(GenericSet from, GenericSet set_to_subtract) {
-    if (generic_types_compatible_compare(avltree_get_key_container_base((struct AVLTree *) from), avltree_get_key_container_base((struct AVLTree *) set_to_subtract)) != 0)
+GenericSet genericset_from_genericlist(GenericList list) {
+    const size_t count = genericlist_size(list);
+    const void **items = count? MALLOC(count * sizeof(*items)): NULL;
+    if (count && items == NULL)
         return NULL;
 
-    const CommonContainerBase *base = avltree_get_key_container_base((struct AVLTree *) from);
-    GenericSet result = genericset_create(base);
+    size_t index = 0;
+    for (Iterator it = genericlist_begin(list); it; it = genericlist_next(list, it))
+        items[index++] = genericlist_value_of(list, it);
+
+    GenericSet set = genericset_from_unsorted(items, count, genericlist_get_container_base(list));
+    FREE(items);
+
+    return set;
+}
+
+/* Like genericset_merge(), but for sets that are not ordered the same way, so neither can be walked in the order of the other.
+ * Each element is looked up in the other set and inserted into the result one at a time */
+static GenericSet genericset_merge_unordered(GenericSet a, GenericSet b, int keep_a_only, int keep_both, int keep_b_only) {
+    GenericSet result = genericset_create_like(a, genericset_get_container_base(a));
     if (result == NULL)
         return NULL;
 
-    Iterator lhs = genericset_begin(from);
-    Iterator rhs = genericset_begin(set_to_subtract);
-    while (lhs && rhs) {
-        const void *lhs_value = genericset_value_of(from, lhs);
-        const void *rhs_value = genericset_value_of(set_to_subtract, rhs);
-        int cmp = base->compare(lhs_value, rhs_value);
+    if (keep_a_only || keep_both) {
+        for (Iterator it = genericset_begin(a); it; it = genericset_next(a, it)) {
+            const void *value = genericset_value_of(a, it);
+            const int keep = genericset_contains(b, value)? keep_both: keep_a_only;
 
-        if (cmp < 0) {
-            if (genericset_add(result, lhs_value)) {
+            if (keep && genericset_add(result, value)) {
                 genericset_destroy(result);
                 return NULL;
             }
-            lhs = genericset_next(from, lhs);
-        } else if (cmp > 0) {
-            rhs = genericset_next(set_to_subtract, rhs);
-        } else {
-            lhs = genericset_next(from, lhs);
-            rhs = genericset_next(set_to_subtract, rhs);
         }
     }
 
-    while (lhs) {
-        if (genericset_add(result, genericset_value_of(from, lhs))) {
-            genericset_destroy(result);
-            return NULL;
-        }
+    if (keep_b_only) {
+        for (Iterator it = genericset_begin(b); it; it = genericset_next(b, it)) {
+            const void *value = genericset_value_of(b, it);
 
-        lhs = genericset_next(from, lhs);
+            if (!genericset_contains(a, value) && genericset_add(result, value)) {
+                genericset_destroy(result);
+                return NULL;
+            }
+        }
     }
 
     return result;
 }
 
-GenericSet genericset_difference(GenericSet a, GenericSet b) {
-    if (generic_types_compatible_compare(avltree_get_key_container_base((struct AVLTree *) a), avltree_get_key_container_base((struct AVLTree *) b)) != 0)
+/* Walks both sets in order, keeping the elements only in `a`, in both sets, or only in `b` as requested.
+ * The result has the same backend as `a`, and is built in one pass once all of its elements are known */
+static GenericSet genericset_merge(GenericSet a, GenericSet b, int keep_a_only, int keep_both, int keep_b_only) {
+    if (generic_types_compatible_compare(genericset_get_container_base(a), genericset_get_container_base(b)) != 0)
         return NULL;
+    else if (genericset_get_compare_fn(a) != genericset_get_compare_fn(b))
+        return genericset_merge_unordered(a, b, keep_a_only, keep_both, keep_b_only);
 
-    const CommonContainerBase *base = avltree_get_key_container_base((struct AVLTree *) a);
-    GenericSet result = genericset_create(base);
-    if (result == NULL)
+    const CommonContainerBase *base = genericset_get_container_base(a);
+    const size_t capacity = (keep_a_only || keep_both? genericset_size(a): 0) + (keep_b_only? genericset_size(b): 0);
+    const void **items = capacity? MALLOC(capacity * sizeof(*items)): NULL;
+    if (capacity && items == NULL)
         return NULL;
 
+    size_t count = 0;
     Iterator lhs = genericset_begin(a);
     Iterator rhs = genericset_begin(b);
     while (lhs && rhs) {
         const void *lhs_value = genericset_value_of(a, lhs);
         const void *rhs_value = genericset_value_of(b, rhs);
         int cmp = base->compare(lhs_value, rhs_value);
-        int err = 0;
 
         if (cmp < 0) {
-            err = genericset_add(result, lhs_value);
+            if (keep_a_only)
+                items[count++] = lhs_value;
             lhs = genericset_next(a, lhs);
         } else if (cmp > 0) {
-            err = genericset_add(result, rhs_value);
+            if (keep_b_only)
+                items[count++] = rhs_value;
             rhs = genericset_next(b, rhs);
         } else {
+            if (keep_both)
+                items[count++] = lhs_value;
             lhs = genericset_next(a, lhs);
             rhs = genericset_next(b, rhs);
         }
-
-        if (err) {
-            genericset_destroy(result);
-            return NULL;
-        }
     }
 
-    while (lhs) {
-        if (genericset_add(result, genericset_value_of(a, lhs))) {
-            genericset_destroy(result);
-            return NULL;
-        }
-
-        lhs = genericset_next(a, lhs);
-    }
+    for (; lhs && keep_a_only; lhs = genericset_next(a, lhs))
+        items[count++] = genericset_value_of(a, lhs);
 
-    while (rhs) {
-        if (genericset_add(result, genericset_value_of(b, rhs))) {
-            genericset_destroy(result);
-            return NULL;
-        }
+    for (; rhs && keep_b_only; rhs = genericset_next(b, rhs))
+        items[count++] = genericset_value_of(b, rhs);
 
-        rhs = genericset_next(b, rhs);
+    GenericSet result = genericset_create_like(a, base);
+    if (result != NULL && genericset_build_sorted(result, items, count)) {
+        genericset_destroy(result);
+        result = NULL;
     }
 
+    FREE(items);
+
     return result;
 }
 
+GenericSet genericset_union(GenericSet a, GenericSet b) {
+    return genericset_merge(a, b, 1, 1, 1);
+}
+
+GenericSet genericset_intersection(GenericSet a, GenericSet b) {
+    return genericset_merge(a, b, 0, 1, 0);
+}
+
+GenericSet genericset_subtract(GenericSet from, GenericSet set_to_subtract) {
+    return genericset_merge(from, set_to_subtract, 1, 0, 0);
+}
+
+GenericSet genericset_difference(GenericSet a, GenericSet b) {
+    return genericset_merge(a, b, 1, 0, 1);
+}
+
 int genericset_add(GenericSet set, const void *item) {
-    if (avltree_insert_copy_key((struct AVLTree *) set, item, NULL) == NULL)
+    Iterator it;
+
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: it = avltree_insert_copy_key((struct AVLTree *) set, item, NULL); break;
+        case CONTAINER_BACKEND_BTREE: it = btree_insert_copy_key((struct BTree *) set, item, NULL); break;
+    }
+
+    if (it == NULL)
         return CC_ENOMEM;
 
     return 0;
 }
 
 int genericset_add_move(GenericSet set, void *item) {
-    if (avltree_insert_move_key((struct AVLTree *) set, item, NULL) == NULL)
+    Iterator it;
+
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: it = avltree_insert_move_key((struct AVLTree *) set, item, NULL); break;
+        case CONTAINER_BACKEND_BTREE: it = btree_insert_move_key((struct BTree *) set, item, NULL); break;
+    }
+
+    if (it == NULL)
         return CC_ENOMEM;
 
     return 0;
 }
 
 Iterator genericset_find(GenericSet set, const void *item) {
-    return avltree_find((struct AVLTree *) set, item);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_find((struct AVLTree *) set, item);
+        case CONTAINER_BACKEND_BTREE: return btree_find((struct BTree *) set, item);
+    }
 }
 
 int genericset_contains(GenericSet set, const void *item) {
@@ -258,50 +312,110 @@ int genericset_contains(GenericSet set, const void *item) {
 }
 
 void genericset_remove(GenericSet set, const void *item) {
-    avltree_delete((struct AVLTree *) set, item);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: avltree_delete((struct AVLTree *) set, item); break;
+        case CONTAINER_BACKEND_BTREE: btree_delete((struct BTree *) set, item); break;
+    }
 }
 
 Iterator genericset_erase(GenericSet set, Iterator it) {
-    return avltree_delete_node((struct AVLTree *) set, (struct AVLNode *) it);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_delete_node((struct AVLTree *) set, (struct AVLNode *) it);
+        case CONTAINER_BACKEND_BTREE: return btree_delete_at((struct BTree *) set, it);
+    }
 }
 
 Iterator genericset_begin(GenericSet set) {
-    return avltree_min_node((struct AVLTree *) set);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_min_node((struct AVLTree *) set);
+        case CONTAINER_BACKEND_BTREE: return btree_begin((struct BTree *) set);
+    }
 }
 
 Iterator genericset_next(GenericSet set, Iterator it) {
-    UNUSED(set)
-
     if (it == NULL)
         return NULL;
 
-    return avltree_inorder_next((struct AVLNode *) it);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_inorder_next((struct AVLNode *) it);
+        case CONTAINER_BACKEND_BTREE: return btree_next((struct BTree *) set, it);
+    }
 }
 
 const void *genericset_value_of(GenericSet set, Iterator it) {
-    UNUSED(set)
-
-    return avlnode_key((struct AVLNode *) it);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avlnode_key((struct AVLTree *) set, (struct AVLNode *) it);
+        case CONTAINER_BACKEND_BTREE: return btree_key_of((struct BTree *) set, it);
+    }
 }
 
 size_t genericset_size(GenericSet set) {
-    return avltree_size((struct AVLTree *) set);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_size((struct AVLTree *) set);
+        case CONTAINER_BACKEND_BTREE: return btree_size((struct BTree *) set);
+    }
 }
 
 int genericset_compare(GenericSet lhs, GenericSet rhs) {
-    return avltree_compare((struct AVLTree *) lhs, (struct AVLTree *) rhs);
+    if (CONTAINER_BACKEND_OF(lhs) == CONTAINER_BACKEND_AVL && CONTAINER_BACKEND_OF(rhs) == CONTAINER_BACKEND_AVL)
+        return avltree_compare((struct AVLTree *) lhs, (struct AVLTree *) rhs);
+
+    const CommonContainerBase *base = genericset_get_container_base(lhs);
+    int cmp = generic_types_compatible_compare(base, genericset_get_container_base(rhs));
+    if (cmp)
+        return cmp;
+
+    Iterator lhs_it = genericset_begin(lhs);
+    Iterator rhs_it = genericset_begin(rhs);
+
+    while (lhs_it && rhs_it) {
+        cmp = base->compare(genericset_value_of(lhs, lhs_it), genericset_value_of(rhs, rhs_it));
+        if (cmp)
+            return cmp;
+
+        lhs_it = genericset_next(lhs, lhs_it);
+        rhs_it = genericset_next(rhs, rhs_it);
+    }
+
+    if (lhs_it)
+        return 1;
+    else if (rhs_it)
+        return -1;
+    else
+        return 0;
 }
 
 void genericset_clear(GenericSet set) {
-    avltree_clear((struct AVLTree *) set);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: avltree_clear((struct AVLTree *) set); break;
+        case CONTAINER_BACKEND_BTREE: btree_clear((struct BTree *) set); break;
+    }
 }
 
 void genericset_destroy(GenericSet set) {
-    avltree_destroy((struct AVLTree *) set);
+    if (set == NULL)
+        return;
+
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: avltree_destroy((struct AVLTree *) set); break;
+        case CONTAINER_BACKEND_BTREE: btree_destroy((struct BTree *) set); break;
+    }
 }
 
 const CommonContainerBase *genericset_get_container_base(GenericSet set) {
-    return avltree_get_key_container_base((struct AVLTree *) set);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_key_container_base((struct AVLTree *) set);
+        case CONTAINER_BACKEND_BTREE: return btree_get_key_container_base((struct BTree *) set);
+    }
 }
 
 CommonContainerBase *genericset_build_recipe(GenericSet set) {
@@ -309,41 +423,81 @@ CommonContainerBase *genericset_build_recipe(GenericSet set) {
 }
 
 Compare genericset_get_compare_fn(GenericSet set) {
-    return avltree_get_key_compare_fn((struct AVLTree *) set);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_key_compare_fn((struct AVLTree *) set);
+        case CONTAINER_BACKEND_BTREE: return btree_get_key_compare_fn((struct BTree *) set);
+    }
 }
 
 int genericset_set_compare_fn(GenericSet set, Compare compare) {
-    return avltree_set_key_compare_fn((struct AVLTree *) set, compare);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_set_key_compare_fn((struct AVLTree *) set, compare);
+        case CONTAINER_BACKEND_BTREE: return btree_set_key_compare_fn((struct BTree *) set, compare);
+    }
 }
 
 Copier genericset_get_copier_fn(GenericSet set) {
-    return avltree_get_key_copier_fn((struct AVLTree *) set);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_key_copier_fn((struct AVLTree *) set);
+        case CONTAINER_BACKEND_BTREE: return btree_get_key_copier_fn((struct BTree *) set);
+    }
 }
 
 int genericset_set_copier_fn(GenericSet set, Copier copier) {
-    return avltree_set_key_copier_fn((struct AVLTree *) set, copier);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_set_key_copier_fn((struct AVLTree *) set, copier);
+        case CONTAINER_BACKEND_BTREE: return btree_set_key_copier_fn((struct BTree *) set, copier);
+    }
 }
 
 Deleter genericset_get_deleter_fn(GenericSet set) {
-    return avltree_get_key_deleter_fn((struct AVLTree *) set);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_key_deleter_fn((struct AVLTree *) set);
+        case CONTAINER_BACKEND_BTREE: return btree_get_key_deleter_fn((struct BTree *) set);
+    }
 }
 
 int genericset_set_deleter_fn(GenericSet set, Deleter deleter) {
-    return avltree_set_key_deleter_fn((struct AVLTree *) set, deleter);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_set_key_deleter_fn((struct AVLTree *) set, deleter);
+        case CONTAINER_BACKEND_BTREE: return btree_set_key_deleter_fn((struct BTree *) set, deleter);
+    }
 }
 
 Parser genericset_get_parser_fn(GenericSet set) {
-    return avltree_get_key_parser_fn((struct AVLTree *) set);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_key_parser_fn((struct AVLTree *) set);
+        case CONTAINER_BACKEND_BTREE: return btree_get_key_parser_fn((struct BTree *) set);
+    }
 }
 
 int genericset_set_parser_fn(GenericSet set, Parser parser) {
-    return avltree_set_key_parser_fn((struct AVLTree *) set, parser);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_set_key_parser_fn((struct AVLTree *) set, parser);
+        case CONTAINER_BACKEND_BTREE: return btree_set_key_parser_fn((struct BTree *) set, parser);
+    }
 }
 
 Serializer genericset_get_serializer_fn(GenericSet set) {
-    return avltree_get_key_serializer_fn((struct AVLTree *) set);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_get_key_serializer_fn((struct AVLTree *) set);
+        case CONTAINER_BACKEND_BTREE: return btree_get_key_serializer_fn((struct BTree *) set);
+    }
 }
 
 int genericset_set_serializer_fn(GenericSet set, Serializer serializer) {
-    return avltree_set_key_serializer_fn((struct AVLTree *) set, serializer);
+    switch (CONTAINER_BACKEND_OF(set)) {
+        default:
+        case CONTAINER_BACKEND_AVL: return avltree_set_key_serializer_fn((struct AVLTree *) set, serializer);
+        case CONTAINER_BACKEND_BTREE: return btree_set_key_serializer_fn((struct BTree *) set, serializer);
+    }
 }
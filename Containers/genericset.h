@@ -16,7 +16,25 @@ GenericSet variant_get_genericset(Variant var);
 int variant_set_genericset(Variant var, const GenericSet set);
 int variant_set_genericset_move(Variant var, GenericSet set);
 GenericSet genericset_create(const CommonContainerBase *base);
+/** @brief Creates a set backed by a B+tree instead of an AVL tree.
+ *
+ * Small POD elements are stored inline in wide, linked leaves, which makes iteration and range scans much more cache-friendly.
+ * Iterators are invalidated by any insertion or removal, except that genericset_erase() returns a valid iterator to the next element.
+ */
+GenericSet genericset_create_btree(const CommonContainerBase *base);
+/** @brief Creates a set from a list, sorting the list elements and then building the set in a single pass.
+ *
+ * Duplicate elements are only added once. The list is not modified.
+ */
 GenericSet genericset_from_genericlist(GenericList list);
+/** @brief Creates a set from an array of `count` items in any order, as genericset_from_genericlist() does. */
+GenericSet genericset_from_array_n(const void **items, size_t count, const CommonContainerBase *base);
+/** @brief Creates a set from an array of `count` items that are already sorted in ascending order with no duplicates.
+ *
+ * The set is built in linear time without comparing any items, so the behavior is undefined if the items are not sorted and unique.
+ * All items are copied into the set.
+ */
+GenericSet genericset_from_sorted(const void **items, size_t count, const CommonContainerBase *base);
 GenericSet genericset_copy(GenericSet other);
 GenericSet genericset_union(GenericSet a, GenericSet b);
 GenericSet genericset_intersection(GenericSet a, GenericSet b);
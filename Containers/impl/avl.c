@@ -6,17 +6,43 @@
 
 #include "avl.h"
 
+#include <string.h>
+
+/* POD keys and values up to this size are stored inline in the node, larger ones are stored as pointers */
+#ifndef AVLTREE_MAX_INLINE_SIZE
+#define AVLTREE_MAX_INLINE_SIZE 64
+#endif
+
+/* Slabs start small so small trees stay small, and double in size up to the maximum */
+#define AVLTREE_MIN_SLAB_NODES 8
+#define AVLTREE_MAX_SLAB_NODES 4096
+
+/* Nodes in a slab start at this offset, so they are suitably aligned for any inline element */
+#define AVLTREE_SLAB_HEADER_SIZE ((sizeof(AVLSlab) + 15) & ~(size_t) 15)
+
 typedef struct AVLNode {
     struct AVLNode *left, *right, *parent;
-    void *key;
-    void *value;
     int balance;
+    /* Followed by key storage at `key_offset` and value storage at `value_offset`, see AVLTree */
 } AVLNode;
 
+typedef struct AVLSlab {
+    struct AVLSlab *next;
+} AVLSlab;
+
 typedef struct AVLTree {
+    enum ContainerBackend backend; /* Always CONTAINER_BACKEND_AVL */
     CommonContainerBase *key_base, *value_base;
     struct AVLNode *root;
     size_t size;
+
+    size_t key_offset, value_offset, node_size; /* Layout of a node, fixed when the tree is created */
+
+    struct AVLSlab *slabs; /* All nodes are allocated from these slabs, and are only freed when the tree is cleared or destroyed */
+    unsigned char *slab_next; /* Next unused node in the most recent slab */
+    size_t slab_remaining; /* Number of unused nodes at `slab_next` */
+    size_t slab_nodes; /* Number of nodes to allocate in the next slab */
+    struct AVLNode *free_nodes; /* Nodes that were deleted, linked through `parent` */
 } AVLTree;
 
 void *avltree_non_copier(const void *p) {
@@ -28,18 +54,187 @@ void avltree_non_deleter(void *p) {
     UNUSED(p)
 }
 
-static void avltree_nodedestroy(const AVLTree *tree, AVLNode *node) {
-    if (tree->key_base->deleter) tree->key_base->deleter(node->key);
-    if (tree->value_base->deleter) tree->value_base->deleter(node->value);
-    FREE(node);
+static int avltree_element_inline(const CommonContainerBase *base) {
+    return base->size && base->size <= AVLTREE_MAX_INLINE_SIZE;
+}
+
+static size_t avltree_element_size(const CommonContainerBase *base) {
+    return avltree_element_inline(base)? base->size: sizeof(void*);
+}
+
+/* Returns the alignment of an element in a node, the largest power of two (up to 16) that divides its size */
+static size_t avltree_element_alignment(const CommonContainerBase *base) {
+    const size_t size = avltree_element_size(base);
+    size_t alignment = 1;
+
+    while (alignment < 16 && size % (alignment * 2) == 0)
+        alignment *= 2;
+
+    return alignment;
+}
+
+static size_t avltree_align(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+static unsigned char *avlnode_key_storage(const AVLTree *tree, AVLNode *node) {
+    return (unsigned char *) node + tree->key_offset;
+}
+
+static unsigned char *avlnode_value_storage(const AVLTree *tree, AVLNode *node) {
+    return (unsigned char *) node + tree->value_offset;
+}
+
+/* Moves an element into node storage. Inline elements are copied and the original freed, as with GenericList */
+static void avltree_store_move(const CommonContainerBase *base, void *storage, void *item) {
+    if (avltree_element_inline(base)) {
+        if (item == NULL)
+            memset(storage, 0, base->size);
+        else {
+            memmove(storage, item, base->size);
+            FREE(item);
+        }
+    } else {
+        *((void **) storage) = item;
+    }
+}
+
+/* Copies an element into node storage. Returns an error if the element could not be copied */
+static int avltree_store_copy(const CommonContainerBase *base, void *storage, const void *item) {
+    if (avltree_element_inline(base)) {
+        if (item == NULL)
+            memset(storage, 0, base->size);
+        else
+            memmove(storage, item, base->size);
+
+        return 0;
+    }
+
+    void *duplicate = NULL;
+    if (item != NULL) {
+        if (base->copier == NULL)
+            return CC_ENOTSUP;
+
+        duplicate = base->copier(item);
+        if (duplicate == NULL)
+            return CC_ENOMEM;
+    }
+
+    *((void **) storage) = duplicate;
+    return 0;
+}
+
+/* Returns whether elements of this type must be destroyed individually */
+static int avltree_element_needs_delete(const CommonContainerBase *base) {
+    return !avltree_element_inline(base) && base->deleter;
 }
 
-const void *avlnode_key(AVLNode *node) {
-    return node->key;
+static void avltree_destroy_element(const CommonContainerBase *base, void *storage) {
+    if (avltree_element_needs_delete(base))
+        base->deleter(*((void **) storage));
 }
 
-void **avlnode_value(AVLNode *node) {
-    return &node->value;
+/* Destroys an element that was going to be moved into the tree, but wasn't needed */
+static void avltree_discard_moved(const CommonContainerBase *base, void *item) {
+    if (avltree_element_inline(base))
+        FREE(item);
+    else if (base->deleter)
+        base->deleter(item);
+}
+
+static AVLNode *avltree_node_alloc(AVLTree *tree) {
+    AVLNode *node = tree->free_nodes;
+
+    if (node != NULL) {
+        tree->free_nodes = node->parent;
+    } else {
+        if (tree->slab_remaining == 0) {
+            AVLSlab *slab = MALLOC(AVLTREE_SLAB_HEADER_SIZE + tree->slab_nodes * tree->node_size);
+            if (slab == NULL)
+                return NULL;
+
+            slab->next = tree->slabs;
+            tree->slabs = slab;
+            tree->slab_next = (unsigned char *) slab + AVLTREE_SLAB_HEADER_SIZE;
+            tree->slab_remaining = tree->slab_nodes;
+
+            if (tree->slab_nodes < AVLTREE_MAX_SLAB_NODES)
+                tree->slab_nodes *= 2;
+        }
+
+        node = (AVLNode *) tree->slab_next;
+        tree->slab_next += tree->node_size;
+        tree->slab_remaining -= 1;
+    }
+
+    node->left = node->right = node->parent = NULL;
+    node->balance = 0;
+
+    return node;
+}
+
+/* Sizes the next slab to hold `count` nodes at once, for building a whole tree */
+static void avltree_begin_bulk_slab(AVLTree *tree, size_t count) {
+    tree->slab_nodes = MAX(count, AVLTREE_MIN_SLAB_NODES);
+}
+
+/* Returns to normal slab growth after a bulk slab, so the next insert doesn't allocate another slab the size of the tree */
+static void avltree_end_bulk_slab(AVLTree *tree, size_t count) {
+    tree->slab_nodes = MIN(MAX(count, AVLTREE_MIN_SLAB_NODES), AVLTREE_MAX_SLAB_NODES);
+}
+
+/* Returns a node to the free list of the tree, the elements must already have been destroyed */
+static void avltree_node_free(AVLTree *tree, AVLNode *node) {
+    node->parent = tree->free_nodes;
+    tree->free_nodes = node;
+}
+
+static void avltree_nodedestroy(AVLTree *tree, AVLNode *node) {
+    avltree_destroy_element(tree->key_base, avlnode_key_storage(tree, node));
+    avltree_destroy_element(tree->value_base, avlnode_value_storage(tree, node));
+    avltree_node_free(tree, node);
+}
+
+/* Destroys the elements of every node in the subtree, but does not free the nodes */
+static void avltree_destroy_elements(const AVLTree *tree, AVLNode *node) {
+    if (node == NULL)
+        return;
+
+    avltree_destroy_elements(tree, node->left);
+    avltree_destroy_elements(tree, node->right);
+    avltree_destroy_element(tree->key_base, avlnode_key_storage(tree, node));
+    avltree_destroy_element(tree->value_base, avlnode_value_storage(tree, node));
+}
+
+/* Destroys all elements in the tree and frees all slabs at once */
+static void avltree_destroy_nodes(AVLTree *tree) {
+    if (avltree_element_needs_delete(tree->key_base) || avltree_element_needs_delete(tree->value_base))
+        avltree_destroy_elements(tree, tree->root);
+
+    while (tree->slabs) {
+        AVLSlab *next = tree->slabs->next;
+        FREE(tree->slabs);
+        tree->slabs = next;
+    }
+
+    tree->root = NULL;
+    tree->size = 0;
+    tree->slab_next = NULL;
+    tree->slab_remaining = 0;
+    tree->slab_nodes = AVLTREE_MIN_SLAB_NODES;
+    tree->free_nodes = NULL;
+}
+
+const void *avlnode_key(const AVLTree *tree, AVLNode *node) {
+    unsigned char *storage = avlnode_key_storage(tree, node);
+
+    return avltree_element_inline(tree->key_base)? storage: *((void **) storage);
+}
+
+void *avlnode_value(const AVLTree *tree, AVLNode *node) {
+    unsigned char *storage = avlnode_value_storage(tree, node);
+
+    return avltree_element_inline(tree->value_base)? storage: *((void **) storage);
 }
 
 Compare avltree_get_key_compare_fn(AVLTree *tree) {
@@ -203,6 +398,8 @@ AVLTree *avltree_create(const CommonContainerBase *key_base, const CommonContain
     if (tree == NULL)
         goto cleanup;
 
+    tree->backend = CONTAINER_BACKEND_AVL;
+
     tree->key_base = container_base_copy_if_dynamic((CommonContainerBase *) key_base);
     if (tree->key_base == NULL)
         goto cleanup;
@@ -211,6 +408,15 @@ AVLTree *avltree_create(const CommonContainerBase *key_base, const CommonContain
     if (tree->value_base == NULL)
         goto cleanup;
 
+    const size_t key_alignment = avltree_element_alignment(key_base);
+    const size_t value_alignment = avltree_element_alignment(value_base);
+    const size_t node_alignment = MAX(sizeof(void*), MAX(key_alignment, value_alignment));
+
+    tree->key_offset = avltree_align(sizeof(AVLNode), key_alignment);
+    tree->value_offset = avltree_align(tree->key_offset + avltree_element_size(key_base), value_alignment);
+    tree->node_size = avltree_align(tree->value_offset + avltree_element_size(value_base), node_alignment);
+    tree->slab_nodes = AVLTREE_MIN_SLAB_NODES;
+
     return tree;
 
 cleanup:
@@ -223,18 +429,9 @@ cleanup:
     return NULL;
 }
 
-void avltree_destroy_helper(const AVLTree *tree, AVLNode *node) {
-    if (node == NULL)
-        return;
-
-    avltree_destroy_helper(tree, node->left);
-    avltree_destroy_helper(tree, node->right);
-    avltree_nodedestroy(tree, node);
-}
-
 void avltree_destroy(AVLTree *tree) {
     if (tree != NULL) {
-        avltree_destroy_helper(tree, tree->root);
+        avltree_destroy_nodes(tree);
 
         container_base_destroy_if_dynamic(tree->key_base);
         container_base_destroy_if_dynamic(tree->value_base);
@@ -243,43 +440,54 @@ void avltree_destroy(AVLTree *tree) {
     FREE(tree);
 }
 
-static AVLNode *avltree_copy_helper(const AVLTree *tree, AVLNode *node, AVLNode *parent) {
-    if (node == NULL)
+/* Copies the subtree at `node` of `other` into `tree`.
+ * If a copy fails, `*err` is set, but the returned subtree only ever contains fully copied nodes so it can still be destroyed */
+static AVLNode *avltree_copy_helper(AVLTree *tree, const AVLTree *other, AVLNode *node, AVLNode *parent, int *err) {
+    if (node == NULL || *err)
         return NULL;
 
-    AVLNode *new_node = CALLOC(1, sizeof(*new_node));
-    if (new_node == NULL)
+    AVLNode *new_node = avltree_node_alloc(tree);
+    if (new_node == NULL) {
+        *err = CC_ENOMEM;
         return NULL;
+    }
 
-    new_node->parent = parent;
-    new_node->key = tree->key_base->copier(node->key);
-    new_node->value = tree->value_base->copier(node->value);
-    new_node->left = avltree_copy_helper(tree, node->left, new_node);
-    new_node->right = avltree_copy_helper(tree, node->right, new_node);
-
-    if ((new_node->key == NULL && node->key != NULL) ||
-        (new_node->value == NULL && node->value != NULL) ||
-        (new_node->left == NULL && node->left != NULL) ||
-        (new_node->right == NULL && node->right != NULL)) {
-        avltree_destroy_helper(tree, new_node);
+    if ((*err = avltree_store_copy(tree->key_base, avlnode_key_storage(tree, new_node), avlnode_key(other, node))) != 0) {
+        avltree_node_free(tree, new_node);
         return NULL;
     }
 
+    if ((*err = avltree_store_copy(tree->value_base, avlnode_value_storage(tree, new_node), avlnode_value(other, node))) != 0) {
+        avltree_destroy_element(tree->key_base, avlnode_key_storage(tree, new_node));
+        avltree_node_free(tree, new_node);
+        return NULL;
+    }
+
+    new_node->parent = parent;
+    new_node->balance = node->balance;
+    new_node->left = avltree_copy_helper(tree, other, node->left, new_node, err);
+    new_node->right = avltree_copy_helper(tree, other, node->right, new_node, err);
+
     return new_node;
 }
 
 AVLTree *avltree_copy(AVLTree *other) {
-    if (other == NULL || other->key_base->copier == NULL || other->value_base->copier == NULL)
+    if (other == NULL)
         return NULL;
 
     AVLTree *tree = avltree_create(other->key_base, other->value_base);
     if (tree == NULL)
         return NULL;
 
+    int err = 0;
+
+    /* Allocate the first slab large enough to hold the entire tree */
+    avltree_begin_bulk_slab(tree, other->size);
+    tree->root = avltree_copy_helper(tree, other, other->root, NULL, &err);
     tree->size = other->size;
-    tree->root = avltree_copy_helper(other, other->root, NULL);
+    avltree_end_bulk_slab(tree, other->size);
 
-    if (tree->root == NULL && other->root != NULL) {
+    if (err) {
         avltree_destroy(tree);
         return NULL;
     }
@@ -287,6 +495,79 @@ AVLTree *avltree_copy(AVLTree *other) {
     return tree;
 }
 
+/* Builds a perfectly balanced subtree from `count` sorted keys and values, and sets `*height` to the height of the subtree.
+ * Nodes are allocated in order, so iterating the finished tree walks through memory sequentially.
+ * Returns NULL and sets `*err` if anything fails, after destroying every element that was already copied */
+static AVLNode *avltree_build_helper(AVLTree *tree, const void **keys, const void **values, size_t count, int *height, int *err) {
+    *height = 0;
+    if (count == 0)
+        return NULL;
+
+    const size_t mid = count / 2;
+    int left_height, right_height;
+
+    AVLNode *left = avltree_build_helper(tree, keys, values, mid, &left_height, err);
+    if (*err)
+        return NULL;
+
+    AVLNode *node = avltree_node_alloc(tree);
+    if (node == NULL)
+        *err = CC_ENOMEM;
+    else if ((*err = avltree_store_copy(tree->key_base, avlnode_key_storage(tree, node), keys[mid])) != 0)
+        avltree_node_free(tree, node);
+    else if ((*err = avltree_store_copy(tree->value_base, avlnode_value_storage(tree, node), values? values[mid]: NULL)) != 0) {
+        avltree_destroy_element(tree->key_base, avlnode_key_storage(tree, node));
+        avltree_node_free(tree, node);
+    }
+
+    if (*err) {
+        avltree_destroy_elements(tree, left);
+        return NULL;
+    }
+
+    AVLNode *right = avltree_build_helper(tree, keys + mid + 1, values? values + mid + 1: NULL, count - mid - 1, &right_height, err);
+    if (*err) {
+        avltree_destroy_elements(tree, left);
+        avltree_nodedestroy(tree, node);
+        return NULL;
+    }
+
+    node->left = left;
+    node->right = right;
+    node->balance = right_height - left_height;
+
+    if (left)
+        left->parent = node;
+    if (right)
+        right->parent = node;
+
+    *height = MAX(left_height, right_height) + 1;
+
+    return node;
+}
+
+int avltree_build_sorted(AVLTree *tree, const void **keys, const void **values, size_t count) {
+    if (tree->size)
+        return CC_EINVAL;
+
+    int err = 0, height;
+
+    /* Allocate the first slab large enough to hold the entire tree */
+    avltree_clear(tree);
+    avltree_begin_bulk_slab(tree, count);
+    tree->root = avltree_build_helper(tree, keys, values, count, &height, &err);
+    avltree_end_bulk_slab(tree, count);
+
+    if (err) {
+        avltree_clear(tree);
+        return err;
+    }
+
+    tree->size = count;
+
+    return 0;
+}
+
 static AVLNode **avltree_find_helper(const AVLTree *tree, AVLNode **node, AVLNode **parent, const void *item_key) {
     *parent = NULL;
 
@@ -294,7 +575,7 @@ static AVLNode **avltree_find_helper(const AVLTree *tree, AVLNode **node, AVLNod
         if (*node == NULL)
             return node;
 
-        int cmp = tree->key_base->compare(item_key, (*node)->key);
+        int cmp = tree->key_base->compare(item_key, avlnode_key(tree, *node));
 
         if (cmp == 0)
             return node;
@@ -489,27 +770,12 @@ static AVLNode *avltree_rotate_leftright(AVLNode *parent, AVLNode *child) {
     return grandchild;
 }
 
-AVLNode *avltree_insert_move_key(AVLTree *tree, void *key, void *value) {
-    AVLNode *parent, *node, *inserted;
-    AVLNode **nodeptr = avltree_find_helper(tree, &tree->root, &parent, key);
-
-    if (*nodeptr != NULL) { /* Key already exists in tree */
-        if (tree->value_base->deleter)
-            tree->value_base->deleter((*nodeptr)->value);
-
-        (*nodeptr)->value = value;
-        return *nodeptr;
-    }
-
-    /* Key does not exist in tree yet */
-
-    inserted = node = *nodeptr = CALLOC(1, sizeof(*node));
-    if (node == NULL)
-        return NULL;
+/* Links a new node into the tree at `nodeptr` and rebalances the tree */
+static AVLNode *avltree_insert_node(AVLTree *tree, AVLNode **nodeptr, AVLNode *parent, AVLNode *node) {
+    AVLNode *inserted = node;
 
+    *nodeptr = node;
     tree->size += 1;
-    node->key = key;
-    node->value = value;
     node->parent = parent;
 
     for (; parent != NULL; parent = node->parent) {
@@ -568,15 +834,90 @@ AVLNode *avltree_insert_move_key(AVLTree *tree, void *key, void *value) {
     return inserted;
 }
 
-AVLNode *avltree_insert_copy_key(AVLTree *tree, const void *key, void *value) {
-    if (tree->key_base->copier == NULL)
+AVLNode *avltree_insert_move_key(AVLTree *tree, void *key, void *value) {
+    AVLNode *parent;
+    AVLNode **nodeptr = avltree_find_helper(tree, &tree->root, &parent, key);
+
+    if (*nodeptr != NULL) { /* Key already exists in tree */
+        avltree_discard_moved(tree->key_base, key);
+        avltree_destroy_element(tree->value_base, avlnode_value_storage(tree, *nodeptr));
+        avltree_store_move(tree->value_base, avlnode_value_storage(tree, *nodeptr), value);
+        return *nodeptr;
+    }
+
+    /* Key does not exist in tree yet */
+
+    AVLNode *node = avltree_node_alloc(tree);
+    if (node == NULL)
         return NULL;
 
-    void *new_key = tree->key_base->copier(key);
-    if (new_key == NULL)
+    avltree_store_move(tree->key_base, avlnode_key_storage(tree, node), key);
+    avltree_store_move(tree->value_base, avlnode_value_storage(tree, node), value);
+
+    return avltree_insert_node(tree, nodeptr, parent, node);
+}
+
+/* Copies the key and stores the value in a new or existing node. `copy_value` specifies whether `value` is copied or moved */
+static AVLNode *avltree_insert_helper(AVLTree *tree, const void *key, void *value, int copy_value) {
+    AVLNode *parent;
+    AVLNode **nodeptr = avltree_find_helper(tree, &tree->root, &parent, key);
+
+    if (*nodeptr != NULL) { /* Key already exists in tree */
+        if (copy_value)
+            return avltree_replace(tree, *nodeptr, value)? NULL: *nodeptr;
+
+        avltree_replace_move(tree, *nodeptr, value);
+        return *nodeptr;
+    }
+
+    /* Key does not exist in tree yet */
+
+    AVLNode *node = avltree_node_alloc(tree);
+    if (node == NULL)
         return NULL;
 
-    return avltree_insert_move_key(tree, new_key, value);
+    if (avltree_store_copy(tree->key_base, avlnode_key_storage(tree, node), key)) {
+        avltree_node_free(tree, node);
+        return NULL;
+    }
+
+    if (!copy_value)
+        avltree_store_move(tree->value_base, avlnode_value_storage(tree, node), value);
+    else if (avltree_store_copy(tree->value_base, avlnode_value_storage(tree, node), value)) {
+        avltree_destroy_element(tree->key_base, avlnode_key_storage(tree, node));
+        avltree_node_free(tree, node);
+        return NULL;
+    }
+
+    return avltree_insert_node(tree, nodeptr, parent, node);
+}
+
+AVLNode *avltree_insert_copy_key(AVLTree *tree, const void *key, void *value) {
+    return avltree_insert_helper(tree, key, value, 0);
+}
+
+AVLNode *avltree_insert_copy(AVLTree *tree, const void *key, const void *value) {
+    return avltree_insert_helper(tree, key, (void *) value, 1);
+}
+
+int avltree_replace_move(AVLTree *tree, AVLNode *node, void *value) {
+    avltree_destroy_element(tree->value_base, avlnode_value_storage(tree, node));
+    avltree_store_move(tree->value_base, avlnode_value_storage(tree, node), value);
+
+    return 0;
+}
+
+int avltree_replace(AVLTree *tree, AVLNode *node, const void *value) {
+    if (avltree_element_inline(tree->value_base))
+        return avltree_store_copy(tree->value_base, avlnode_value_storage(tree, node), value);
+
+    /* Copy before destroying the old value, in case `value` refers to it */
+    void *duplicate;
+    int err = avltree_store_copy(tree->value_base, &duplicate, value);
+    if (err)
+        return err;
+
+    return avltree_replace_move(tree, node, duplicate);
 }
 
 /* Returns node after deleted node, or NULL if the node to be deleted has no successor */
@@ -604,18 +945,25 @@ static AVLNode *avltree_delete_node_helper(AVLTree *tree, AVLNode **node) {
         node_replacement = left;
     } else { /* Both children present, successor will never be parent of node */
         /* This routine just swaps out the successor (which must have at most one child) with the node to be deleted
-         * and queues the successor to be deleted instead */
-        (*node)->value = successor->value;
-        (*node)->key = successor->key;
-        successor->value = save.value;
-        successor->key = save.key;
+         * and queues the successor to be deleted instead. The node to be deleted then holds the successor's elements,
+         * so it is the node after the deleted node */
+        AVLNode *next = *node;
+        unsigned char *lhs = avlnode_key_storage(tree, next), *rhs = avlnode_key_storage(tree, successor);
+
+        for (size_t i = tree->key_offset; i < tree->node_size; ++i, ++lhs, ++rhs) {
+            unsigned char temp = *lhs;
+            *lhs = *rhs;
+            *rhs = temp;
+        }
 
         if (successor == successor->parent->left)
             node = &successor->parent->left;
         else
             node = &successor->parent->right;
 
-        return avltree_delete_node_helper(tree, node);
+        avltree_delete_node_helper(tree, node);
+
+        return next;
     }
 
     AVLNode *n = *node, *parent = save.parent, *sibling = NULL, *grandparent = NULL, *left = NULL;
@@ -762,12 +1110,12 @@ int avltree_compare(AVLTree *left, AVLTree *right) {
     AVLNode *rhs = avltree_min_node(right);
 
     while (lhs && rhs) {
-        cmp = left->key_base->compare(lhs->key, rhs->key);
+        cmp = left->key_base->compare(avlnode_key(left, lhs), avlnode_key(right, rhs));
         if (cmp)
             return cmp;
 
         if (left->value_base->compare) {
-            cmp = left->value_base->compare(lhs->value, rhs->value);
+            cmp = left->value_base->compare(avlnode_value(left, lhs), avlnode_value(right, rhs));
             if (cmp)
                 return cmp;
         }
@@ -785,9 +1133,7 @@ int avltree_compare(AVLTree *left, AVLTree *right) {
 }
 
 void avltree_clear(AVLTree *tree) {
-    avltree_destroy_helper(tree, tree->root);
-    tree->root = NULL;
-    tree->size = 0;
+    avltree_destroy_nodes(tree);
 }
 
 size_t avltree_size(AVLTree *tree) {
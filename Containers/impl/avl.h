@@ -8,6 +8,7 @@
 #define AVL_H
 
 #include "../common.h"
+#include "backend.h"
 
 struct AVLNode;
 struct AVLTree;
@@ -15,8 +16,9 @@ struct AVLTree;
 void *avltree_copier(const void *p);
 void avltree_deleter(void *p);
 
-const void *avlnode_key(struct AVLNode *node);
-void **avlnode_value(struct AVLNode *node);
+/* POD keys and values are stored inline in the node, so these return pointers into the node */
+const void *avlnode_key(const struct AVLTree *tree, struct AVLNode *node);
+void *avlnode_value(const struct AVLTree *tree, struct AVLNode *node);
 
 Compare avltree_get_key_compare_fn(struct AVLTree *tree);
 Compare avltree_get_value_compare_fn(struct AVLTree *tree);
@@ -40,9 +42,11 @@ int avltree_set_key_serializer_fn(struct AVLTree *tree, Serializer serializer);
 int avltree_set_value_serializer_fn(struct AVLTree *tree, Serializer serializer);
 
 struct AVLTree *avltree_create(const CommonContainerBase *key_base, const CommonContainerBase *value_base);
-void avltree_destroy_helper(const struct AVLTree *tree, struct AVLNode *node);
 void avltree_destroy(struct AVLTree *tree);
 struct AVLTree *avltree_copy(struct AVLTree *other);
+/* Fills an empty tree with `count` keys and values in linear time, without comparing them.
+ * The keys must be sorted in ascending order with no duplicates. All keys and values are copied, and `values` may be NULL */
+int avltree_build_sorted(struct AVLTree *tree, const void **keys, const void **values, size_t count);
 struct AVLNode *avltree_min_node(struct AVLTree *tree);
 struct AVLNode *avltree_max_node(struct AVLTree *tree);
 struct AVLNode *avltree_inorder_previous(struct AVLNode *node);
@@ -50,6 +54,9 @@ struct AVLNode *avltree_inorder_next(struct AVLNode *node);
 struct AVLNode *avltree_find(struct AVLTree *tree, const void *key);
 struct AVLNode *avltree_insert_move_key(struct AVLTree *tree, void *key, void *value);
 struct AVLNode *avltree_insert_copy_key(struct AVLTree *tree, const void *key, void *value);
+struct AVLNode *avltree_insert_copy(struct AVLTree *tree, const void *key, const void *value);
+int avltree_replace_move(struct AVLTree *tree, struct AVLNode *node, void *value);
+int avltree_replace(struct AVLTree *tree, struct AVLNode *node, const void *value);
 /* Returns node after deleted node, or NULL if the node to be deleted has no successor */
 struct AVLNode *avltree_delete_node(struct AVLTree *tree, struct AVLNode *node);
 struct AVLNode *avltree_delete(struct AVLTree *tree, const void *key);
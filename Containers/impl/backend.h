@@ -0,0 +1,23 @@
+/** @file
+ *
+ *  @author Oliver Adams
+ *  @copyright Copyright (C) 2020
+ */
+
+#ifndef BACKEND_H
+#define BACKEND_H
+
+/* Identifies the implementation behind a generic container handle.
+ *
+ * Every implementation struct that can back the same public handle type (e.g. GenericMap) begins with this field,
+ * so the public functions can dispatch to the correct implementation without a separate wrapper allocation.
+ */
+enum ContainerBackend {
+    CONTAINER_BACKEND_AVL,
+    CONTAINER_BACKEND_HASH,
+    CONTAINER_BACKEND_BTREE
+};
+
+#define CONTAINER_BACKEND_OF(container) (*((const enum ContainerBackend *) (container)))
+
+#endif /* BACKEND_H */
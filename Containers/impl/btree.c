@@ -0,0 +1,1270 @@
+/** @file
+ *
+ *  @author Oliver Adams
+ *  @copyright Copyright (C) 2020
+ */
+
+#include "btree.h"
+#include "../recipes.h"
+#include "../../utility.h"
+
+#include <string.h>
+
+/* B+tree with all elements stored in linked leaves, and copies of keys used as separators in the internal nodes.
+ *
+ * Every node is BTREE_NODE_SIZE bytes and aligned to BTREE_NODE_SIZE, so nodes span a small fixed number of cache lines.
+ * Iterators point to a key in a leaf, and the leaf containing the key is found by masking off the low bits of the iterator.
+ */
+#define BTREE_NODE_SIZE 512
+
+/* POD keys and values up to this size are stored inline in the leaves, larger ones are stored as pointers */
+#ifndef BTREE_MAX_INLINE_SIZE
+#define BTREE_MAX_INLINE_SIZE 32
+#endif
+
+/* Large enough to hold any element as stored in a node */
+#define BTREE_ELEMENT_BUFFER_SIZE (BTREE_MAX_INLINE_SIZE < 16? 16: BTREE_MAX_INLINE_SIZE)
+
+/* Slabs start small so small trees stay small, and double in size up to the maximum */
+#define BTREE_MIN_SLAB_NODES 2
+#define BTREE_MAX_SLAB_NODES 64
+
+/* Internal nodes hold at least 2 keys, so this is plenty for any tree that fits in memory */
+#define BTREE_MAX_DEPTH 48
+
+#define BTREE_HEADER_SIZE ((sizeof(BTreeNode) + 15) & ~(size_t) 15)
+
+typedef struct BTreeNode {
+    struct BTreeNode *next, *prev; /* Leaves are linked in key order. Free nodes are linked through `next` */
+    unsigned count; /* Number of keys in the node, internal nodes have `count + 1` children */
+    unsigned leaf;
+    /* Followed by the keys at BTREE_HEADER_SIZE. Leaves then have the values at `leaf_value_offset`, internal nodes have the children at `internal_child_offset` */
+} BTreeNode;
+
+typedef struct BTreeSlab {
+    struct BTreeSlab *next;
+} BTreeSlab;
+
+typedef struct BTree {
+    enum ContainerBackend backend; /* Always CONTAINER_BACKEND_BTREE */
+    CommonContainerBase *key_base, *value_base;
+    struct BTreeNode *root;
+    size_t size;
+
+    /* Layout of the nodes, fixed when the tree is created. `value_size` is zero if values are not stored at all, as in sets */
+    size_t key_size, value_size;
+    size_t leaf_value_offset, internal_child_offset;
+    unsigned leaf_capacity, internal_capacity;
+
+    struct BTreeSlab *slabs; /* All nodes are allocated from these slabs, and are only freed when the tree is cleared or destroyed */
+    unsigned char *slab_next; /* Next unused node in the most recent slab */
+    size_t slab_remaining; /* Number of unused nodes at `slab_next` */
+    size_t slab_nodes; /* Number of nodes to allocate in the next slab */
+    struct BTreeNode *free_nodes;
+} BTree;
+
+static int btree_element_inline(const CommonContainerBase *base) {
+    return base->size && base->size <= BTREE_MAX_INLINE_SIZE;
+}
+
+static size_t btree_element_size(const CommonContainerBase *base) {
+    return btree_element_inline(base)? base->size: sizeof(void*);
+}
+
+/* Returns the alignment of an element in a node, the largest power of two (up to 16) that divides its size */
+static size_t btree_element_alignment(const CommonContainerBase *base) {
+    const size_t size = btree_element_size(base);
+    size_t alignment = 1;
+
+    while (alignment < 16 && size % (alignment * 2) == 0)
+        alignment *= 2;
+
+    return alignment;
+}
+
+static size_t btree_align(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+/* Returns the element in storage, either the storage itself or the pointer it contains */
+static void *btree_element(const CommonContainerBase *base, unsigned char *storage) {
+    return btree_element_inline(base)? storage: *((void **) storage);
+}
+
+/* Copies an element into storage. Returns an error if the element could not be copied */
+static int btree_store_copy(const CommonContainerBase *base, void *storage, const void *item) {
+    if (btree_element_inline(base)) {
+        if (item == NULL)
+            memset(storage, 0, base->size);
+        else
+            memmove(storage, item, base->size);
+
+        return 0;
+    }
+
+    void *duplicate = NULL;
+    if (item != NULL) {
+        if (base->copier == NULL)
+            return CC_ENOTSUP;
+
+        duplicate = base->copier(item);
+        if (duplicate == NULL)
+            return CC_ENOMEM;
+    }
+
+    *((void **) storage) = duplicate;
+    return 0;
+}
+
+/* Puts an element that is being moved into storage, without taking ownership yet. See btree_release_moved() */
+static void btree_stage_move(const CommonContainerBase *base, void *storage, void *item) {
+    if (btree_element_inline(base)) {
+        if (item == NULL)
+            memset(storage, 0, base->size);
+        else
+            memmove(storage, item, base->size);
+    } else {
+        *((void **) storage) = item;
+    }
+}
+
+/* Takes ownership of an element that was staged with btree_stage_move(). Inline elements are freed, as with GenericList */
+static void btree_release_moved(const CommonContainerBase *base, void *item) {
+    if (btree_element_inline(base))
+        FREE(item);
+}
+
+/* Returns whether elements of this type must be destroyed individually */
+static int btree_element_needs_delete(const CommonContainerBase *base) {
+    return !btree_element_inline(base) && base->deleter;
+}
+
+static void btree_destroy_element(const CommonContainerBase *base, void *storage) {
+    if (btree_element_needs_delete(base))
+        base->deleter(*((void **) storage));
+}
+
+/* Destroys an element that was going to be moved into the tree, but wasn't needed */
+static void btree_discard_moved(const CommonContainerBase *base, void *item) {
+    if (btree_element_inline(base))
+        FREE(item);
+    else if (base->deleter)
+        base->deleter(item);
+}
+
+static unsigned char *btree_key_slot(const BTree *tree, BTreeNode *node, size_t index) {
+    return (unsigned char *) node + BTREE_HEADER_SIZE + index * tree->key_size;
+}
+
+static unsigned char *btree_value_slot(const BTree *tree, BTreeNode *node, size_t index) {
+    return (unsigned char *) node + tree->leaf_value_offset + index * tree->value_size;
+}
+
+static BTreeNode **btree_children(const BTree *tree, BTreeNode *node) {
+    return (BTreeNode **) ((unsigned char *) node + tree->internal_child_offset);
+}
+
+static const void *btree_key_at(const BTree *tree, BTreeNode *node, size_t index) {
+    return btree_element(tree->key_base, btree_key_slot(tree, node, index));
+}
+
+static BTreeNode *btree_leaf_of(Iterator it) {
+    return (BTreeNode *) ((uintptr_t) it & ~(uintptr_t) (BTREE_NODE_SIZE - 1));
+}
+
+static unsigned btree_index_of(const BTree *tree, BTreeNode *leaf, Iterator it) {
+    return (unsigned) (((unsigned char *) it - btree_key_slot(tree, leaf, 0)) / tree->key_size);
+}
+
+static unsigned btree_leaf_minimum(const BTree *tree) {
+    return tree->leaf_capacity / 2;
+}
+
+static unsigned btree_internal_minimum(const BTree *tree) {
+    return tree->internal_capacity / 2;
+}
+
+static BTreeNode *btree_node_alloc(BTree *tree) {
+    BTreeNode *node = tree->free_nodes;
+
+    if (node != NULL) {
+        tree->free_nodes = node->next;
+    } else {
+        if (tree->slab_remaining == 0) {
+            /* One extra node is allocated so the nodes can be aligned to BTREE_NODE_SIZE */
+            BTreeSlab *slab = MALLOC(sizeof(*slab) + (tree->slab_nodes + 1) * BTREE_NODE_SIZE);
+            if (slab == NULL)
+                return NULL;
+
+            slab->next = tree->slabs;
+            tree->slabs = slab;
+            tree->slab_next = (unsigned char *) btree_align((uintptr_t) (slab + 1), BTREE_NODE_SIZE);
+            tree->slab_remaining = tree->slab_nodes;
+
+            if (tree->slab_nodes < BTREE_MAX_SLAB_NODES)
+                tree->slab_nodes *= 2;
+        }
+
+        node = (BTreeNode *) tree->slab_next;
+        tree->slab_next += BTREE_NODE_SIZE;
+        tree->slab_remaining -= 1;
+    }
+
+    node->next = node->prev = NULL;
+    node->count = 0;
+    node->leaf = 0;
+
+    return node;
+}
+
+/* Returns a node to the free list of the tree, the elements must already have been destroyed */
+static void btree_node_free(BTree *tree, BTreeNode *node) {
+    node->next = tree->free_nodes;
+    tree->free_nodes = node;
+}
+
+/* Ensures that the next `count` node allocations will succeed */
+static int btree_reserve_nodes(BTree *tree, size_t count) {
+    BTreeNode *reserved = NULL;
+    size_t i;
+
+    for (i = 0; i < count; ++i) {
+        BTreeNode *node = btree_node_alloc(tree);
+        if (node == NULL)
+            break;
+
+        node->next = reserved;
+        reserved = node;
+    }
+
+    while (reserved) {
+        BTreeNode *next = reserved->next;
+        btree_node_free(tree, reserved);
+        reserved = next;
+    }
+
+    return i == count? 0: CC_ENOMEM;
+}
+
+/* Destroys the elements of every node in the subtree, but does not free the nodes */
+static void btree_destroy_elements(const BTree *tree, BTreeNode *node) {
+    if (node == NULL)
+        return;
+
+    if (btree_element_needs_delete(tree->key_base))
+        for (size_t i = 0; i < node->count; ++i)
+            btree_destroy_element(tree->key_base, btree_key_slot(tree, node, i));
+
+    if (node->leaf) {
+        if (tree->value_size && btree_element_needs_delete(tree->value_base))
+            for (size_t i = 0; i < node->count; ++i)
+                btree_destroy_element(tree->value_base, btree_value_slot(tree, node, i));
+    } else {
+        for (size_t i = 0; i <= node->count; ++i)
+            btree_destroy_elements(tree, btree_children(tree, node)[i]);
+    }
+}
+
+/* Destroys all elements in the tree and frees all slabs at once */
+static void btree_destroy_nodes(BTree *tree) {
+    if (btree_element_needs_delete(tree->key_base) || (tree->value_size && btree_element_needs_delete(tree->value_base)))
+        btree_destroy_elements(tree, tree->root);
+
+    while (tree->slabs) {
+        BTreeSlab *next = tree->slabs->next;
+        FREE(tree->slabs);
+        tree->slabs = next;
+    }
+
+    tree->root = NULL;
+    tree->size = 0;
+    tree->slab_next = NULL;
+    tree->slab_remaining = 0;
+    tree->slab_nodes = BTREE_MIN_SLAB_NODES;
+    tree->free_nodes = NULL;
+}
+
+/* Returns the index of the first key in the leaf not less than `key`, and sets `*found` if that key is equal to `key` */
+static unsigned btree_leaf_search(const BTree *tree, BTreeNode *leaf, const void *key, int *found) {
+    unsigned lo = 0, hi = leaf->count;
+
+    *found = 0;
+    while (lo < hi) {
+        const unsigned mid = lo + (hi - lo) / 2;
+        const int cmp = tree->key_base->compare(key, btree_key_at(tree, leaf, mid));
+
+        if (cmp == 0) {
+            *found = 1;
+            return mid;
+        } else if (cmp < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    return lo;
+}
+
+/* Returns the index of the child of an internal node that may contain `key` */
+static unsigned btree_internal_search(const BTree *tree, BTreeNode *node, const void *key) {
+    unsigned lo = 0, hi = node->count;
+
+    while (lo < hi) {
+        const unsigned mid = lo + (hi - lo) / 2;
+
+        if (tree->key_base->compare(key, btree_key_at(tree, node, mid)) < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    return lo;
+}
+
+/* Finds the leaf that may contain `key`, recording the path from the root in `path` and `path_index`.
+ * Returns the index in the leaf where the key is or would be, and sets `*found` if the key exists */
+static unsigned btree_find_path(const BTree *tree, const void *key, BTreeNode **path, unsigned *path_index, size_t *depth, BTreeNode **leaf, int *found) {
+    BTreeNode *node = tree->root;
+
+    *depth = 0;
+    while (!node->leaf) {
+        const unsigned index = btree_internal_search(tree, node, key);
+
+        path[*depth] = node;
+        path_index[*depth] = index;
+        *depth += 1;
+
+        node = btree_children(tree, node)[index];
+    }
+
+    *leaf = node;
+    return btree_leaf_search(tree, node, key, found);
+}
+
+/* Moves `count` keys and values from one position in a leaf to another, possibly in the same leaf */
+static void btree_leaf_move(const BTree *tree, BTreeNode *to, unsigned to_index, BTreeNode *from, unsigned from_index, unsigned count) {
+    memmove(btree_key_slot(tree, to, to_index), btree_key_slot(tree, from, from_index), count * tree->key_size);
+    memmove(btree_value_slot(tree, to, to_index), btree_value_slot(tree, from, from_index), count * tree->value_size);
+}
+
+/* Moves `count` keys from one position in an internal node to another, possibly in the same node */
+static void btree_internal_move_keys(const BTree *tree, BTreeNode *to, unsigned to_index, BTreeNode *from, unsigned from_index, unsigned count) {
+    memmove(btree_key_slot(tree, to, to_index), btree_key_slot(tree, from, from_index), count * tree->key_size);
+}
+
+/* Moves `count` children from one position in an internal node to another, possibly in the same node */
+static void btree_internal_move_children(const BTree *tree, BTreeNode *to, unsigned to_index, BTreeNode *from, unsigned from_index, unsigned count) {
+    memmove(btree_children(tree, to) + to_index, btree_children(tree, from) + from_index, count * sizeof(BTreeNode *));
+}
+
+/* Inserts a key and the child to its right at `index` of an internal node that is not full */
+static void btree_internal_insert(const BTree *tree, BTreeNode *node, unsigned index, const unsigned char *key, BTreeNode *child) {
+    btree_internal_move_keys(tree, node, index + 1, node, index, node->count - index);
+    btree_internal_move_children(tree, node, index + 2, node, index + 1, node->count - index);
+    memcpy(btree_key_slot(tree, node, index), key, tree->key_size);
+    btree_children(tree, node)[index + 1] = child;
+    node->count += 1;
+}
+
+/* Removes the key at `index` of an internal node and the child to its right. The key is not destroyed */
+static void btree_internal_remove(const BTree *tree, BTreeNode *node, unsigned index) {
+    btree_internal_move_keys(tree, node, index, node, index + 1, node->count - index - 1);
+    btree_internal_move_children(tree, node, index + 1, node, index + 2, node->count - index - 1);
+    node->count -= 1;
+}
+
+/* Inserts `separator` and the node to its right into the ancestors of a node that was just split.
+ * Enough nodes must have been reserved to split every full ancestor, and to add a new root */
+static void btree_insert_separator(BTree *tree, BTreeNode **path, const unsigned *path_index, size_t depth, unsigned char *separator, BTreeNode *right) {
+    const unsigned capacity = tree->internal_capacity;
+    const unsigned split = (capacity + 1) / 2; /* Index of the key that moves up when a node is split */
+
+    for (; depth > 0; --depth) {
+        BTreeNode *node = path[depth-1];
+        const unsigned index = path_index[depth-1];
+
+        if (node->count < capacity) {
+            btree_internal_insert(tree, node, index, separator, right);
+            return;
+        }
+
+        /* Split the node as if the separator had been inserted, then move the middle key up to the parent */
+        unsigned char promoted[BTREE_ELEMENT_BUFFER_SIZE];
+        BTreeNode *sibling = btree_node_alloc(tree);
+
+        if (index < split) {
+            memcpy(promoted, btree_key_slot(tree, node, split - 1), tree->key_size);
+            btree_internal_move_keys(tree, sibling, 0, node, split, capacity - split);
+            btree_internal_move_children(tree, sibling, 0, node, split, capacity - split + 1);
+            sibling->count = capacity - split;
+            node->count = split - 1;
+            btree_internal_insert(tree, node, index, separator, right);
+        } else if (index == split) {
+            memcpy(promoted, separator, tree->key_size);
+            btree_internal_move_keys(tree, sibling, 0, node, split, capacity - split);
+            btree_internal_move_children(tree, sibling, 1, node, split + 1, capacity - split);
+            btree_children(tree, sibling)[0] = right;
+            sibling->count = capacity - split;
+            node->count = split;
+        } else {
+            memcpy(promoted, btree_key_slot(tree, node, split), tree->key_size);
+            btree_internal_move_keys(tree, sibling, 0, node, split + 1, capacity - split - 1);
+            btree_internal_move_children(tree, sibling, 0, node, split + 1, capacity - split);
+            sibling->count = capacity - split - 1;
+            node->count = split;
+            btree_internal_insert(tree, sibling, index - split - 1, separator, right);
+        }
+
+        memcpy(separator, promoted, tree->key_size);
+        right = sibling;
+    }
+
+    /* The root was split, so the tree grows by one level */
+    BTreeNode *root = btree_node_alloc(tree);
+
+    memcpy(btree_key_slot(tree, root, 0), separator, tree->key_size);
+    btree_children(tree, root)[0] = tree->root;
+    btree_children(tree, root)[1] = right;
+    root->count = 1;
+    tree->root = root;
+}
+
+/* Inserts a new element at `index` of `leaf`, splitting nodes up to the root as needed.
+ * `key` and `value` point to the element as it will be stored in the leaf.
+ * Returns the slot of the new key, or NULL if out of memory, in which case the tree is unchanged */
+static unsigned char *btree_insert_at(BTree *tree, BTreeNode **path, const unsigned *path_index, size_t depth,
+                                      BTreeNode *leaf, unsigned index, const unsigned char *key, const unsigned char *value) {
+    BTreeNode *target = leaf;
+    unsigned target_index = index;
+
+    if (leaf->count == tree->leaf_capacity) {
+        const unsigned capacity = tree->leaf_capacity;
+        const unsigned split = (capacity + 1) / 2; /* Number of elements that stay in the left leaf */
+
+        /* Every full ancestor is split as well, and a full root gets a new parent */
+        size_t needed = 1, level = depth;
+        while (level > 0 && path[level-1]->count == tree->internal_capacity) {
+            ++needed;
+            --level;
+        }
+        if (level == 0)
+            ++needed;
+
+        if (btree_reserve_nodes(tree, needed))
+            return NULL;
+
+        /* The first key of the new right leaf is copied to the parent */
+        unsigned char separator[BTREE_ELEMENT_BUFFER_SIZE];
+        const void *separator_key = index == split? btree_element(tree->key_base, (unsigned char *) key):
+                                                    btree_key_at(tree, leaf, index < split? split - 1: split);
+
+        if (btree_store_copy(tree->key_base, separator, separator_key))
+            return NULL;
+
+        BTreeNode *right = btree_node_alloc(tree);
+        right->leaf = 1;
+        right->prev = leaf;
+        right->next = leaf->next;
+        if (leaf->next)
+            leaf->next->prev = right;
+        leaf->next = right;
+
+        if (index < split) {
+            btree_leaf_move(tree, right, 0, leaf, split - 1, capacity - split + 1);
+            right->count = capacity - split + 1;
+            leaf->count = split - 1;
+        } else {
+            btree_leaf_move(tree, right, 0, leaf, split, capacity - split);
+            right->count = capacity - split;
+            leaf->count = split;
+            target = right;
+            target_index = index - split;
+        }
+
+        btree_insert_separator(tree, path, path_index, depth, separator, right);
+    }
+
+    btree_leaf_move(tree, target, target_index + 1, target, target_index, target->count - target_index);
+    memcpy(btree_key_slot(tree, target, target_index), key, tree->key_size);
+    memcpy(btree_value_slot(tree, target, target_index), value, tree->value_size);
+    target->count += 1;
+    tree->size += 1;
+
+    return btree_key_slot(tree, target, target_index);
+}
+
+static void btree_leaf_unlink(BTreeNode *leaf) {
+    if (leaf->prev)
+        leaf->prev->next = leaf->next;
+    if (leaf->next)
+        leaf->next->prev = leaf->prev;
+}
+
+/* Replaces the separator at `index` of an internal node with a new, already copied, key */
+static void btree_replace_separator(const BTree *tree, BTreeNode *node, unsigned index, const unsigned char *key) {
+    btree_destroy_element(tree->key_base, btree_key_slot(tree, node, index));
+    memcpy(btree_key_slot(tree, node, index), key, tree->key_size);
+}
+
+/* Merges `right` and the separator at `index` of `parent` into `left`, and removes `right` from the parent */
+static void btree_internal_merge(BTree *tree, BTreeNode *parent, unsigned index, BTreeNode *left, BTreeNode *right) {
+    memcpy(btree_key_slot(tree, left, left->count), btree_key_slot(tree, parent, index), tree->key_size);
+    btree_internal_move_keys(tree, left, left->count + 1, right, 0, right->count);
+    btree_internal_move_children(tree, left, left->count + 1, right, 0, right->count + 1);
+    left->count += right->count + 1;
+
+    btree_internal_remove(tree, parent, index);
+    btree_node_free(tree, right);
+}
+
+/* Restores the minimum occupancy of the internal nodes on the path, starting at `path[level]` which may have lost a key */
+static void btree_rebalance_internal(BTree *tree, BTreeNode **path, const unsigned *path_index, size_t level) {
+    const unsigned minimum = btree_internal_minimum(tree);
+
+    for (;; --level) {
+        BTreeNode *node = path[level];
+
+        if (level == 0) {
+            /* The tree shrinks by one level when the root runs out of keys */
+            if (node->count == 0) {
+                tree->root = btree_children(tree, node)[0];
+                btree_node_free(tree, node);
+            }
+
+            return;
+        }
+
+        if (node->count >= minimum)
+            return;
+
+        BTreeNode *parent = path[level-1];
+        const unsigned child = path_index[level-1];
+        BTreeNode *left = child > 0? btree_children(tree, parent)[child-1]: NULL;
+        BTreeNode *right = child < parent->count? btree_children(tree, parent)[child+1]: NULL;
+
+        if (left && left->count > minimum) { /* Rotate the last key of the left sibling through the parent */
+            btree_internal_move_keys(tree, node, 1, node, 0, node->count);
+            btree_internal_move_children(tree, node, 1, node, 0, node->count + 1);
+            memcpy(btree_key_slot(tree, node, 0), btree_key_slot(tree, parent, child-1), tree->key_size);
+            btree_children(tree, node)[0] = btree_children(tree, left)[left->count];
+            memcpy(btree_key_slot(tree, parent, child-1), btree_key_slot(tree, left, left->count-1), tree->key_size);
+            left->count -= 1;
+            node->count += 1;
+            return;
+        } else if (right && right->count > minimum) { /* Rotate the first key of the right sibling through the parent */
+            memcpy(btree_key_slot(tree, node, node->count), btree_key_slot(tree, parent, child), tree->key_size);
+            btree_children(tree, node)[node->count + 1] = btree_children(tree, right)[0];
+            memcpy(btree_key_slot(tree, parent, child), btree_key_slot(tree, right, 0), tree->key_size);
+            btree_internal_move_keys(tree, right, 0, right, 1, right->count - 1);
+            btree_internal_move_children(tree, right, 0, right, 1, right->count);
+            right->count -= 1;
+            node->count += 1;
+            return;
+        } else if (left) {
+            btree_internal_merge(tree, parent, child-1, left, node);
+        } else {
+            btree_internal_merge(tree, parent, child, node, right);
+        }
+    }
+}
+
+/* Removes the element at `index` of `leaf`, whose key and value must already have been destroyed, and rebalances the tree.
+ * Returns non-zero if any other elements were moved to a different leaf */
+static int btree_remove_at(BTree *tree, BTreeNode **path, const unsigned *path_index, size_t depth, BTreeNode *leaf, unsigned index) {
+    const unsigned minimum = btree_leaf_minimum(tree);
+
+    btree_leaf_move(tree, leaf, index, leaf, index + 1, leaf->count - index - 1);
+    leaf->count -= 1;
+    tree->size -= 1;
+
+    if (depth == 0) {
+        if (leaf->count == 0) {
+            btree_node_free(tree, leaf);
+            tree->root = NULL;
+        }
+
+        return 0;
+    }
+
+    if (leaf->count >= minimum)
+        return 0;
+
+    BTreeNode *parent = path[depth-1];
+    const unsigned child = path_index[depth-1];
+    BTreeNode *left = child > 0? btree_children(tree, parent)[child-1]: NULL;
+    BTreeNode *right = child < parent->count? btree_children(tree, parent)[child+1]: NULL;
+    unsigned char separator[BTREE_ELEMENT_BUFFER_SIZE];
+
+    /* Borrowing an element changes the first key of a leaf, so the separator must be copied again.
+     * If that fails, the leaf is just left with fewer elements than it should have, which is still a valid tree */
+    if (left && left->count > minimum) {
+        if (btree_store_copy(tree->key_base, separator, btree_key_at(tree, left, left->count - 1)))
+            return 0;
+
+        btree_leaf_move(tree, leaf, 1, leaf, 0, leaf->count);
+        btree_leaf_move(tree, leaf, 0, left, left->count - 1, 1);
+        left->count -= 1;
+        leaf->count += 1;
+        btree_replace_separator(tree, parent, child-1, separator);
+        return 1;
+    } else if (right && right->count > minimum) {
+        if (btree_store_copy(tree->key_base, separator, btree_key_at(tree, right, 1)))
+            return 0;
+
+        btree_leaf_move(tree, leaf, leaf->count, right, 0, 1);
+        btree_leaf_move(tree, right, 0, right, 1, right->count - 1);
+        right->count -= 1;
+        leaf->count += 1;
+        btree_replace_separator(tree, parent, child, separator);
+        return 1;
+    }
+
+    /* Merge with a sibling, and remove the separator between them from the parent */
+    if (left) {
+        btree_leaf_move(tree, left, left->count, leaf, 0, leaf->count);
+        left->count += leaf->count;
+        btree_leaf_unlink(leaf);
+        btree_node_free(tree, leaf);
+
+        btree_destroy_element(tree->key_base, btree_key_slot(tree, parent, child-1));
+        btree_internal_remove(tree, parent, child-1);
+    } else {
+        btree_leaf_move(tree, leaf, leaf->count, right, 0, right->count);
+        leaf->count += right->count;
+        btree_leaf_unlink(right);
+        btree_node_free(tree, right);
+
+        btree_destroy_element(tree->key_base, btree_key_slot(tree, parent, child));
+        btree_internal_remove(tree, parent, child);
+    }
+
+    btree_rebalance_internal(tree, path, path_index, depth-1);
+    return 1;
+}
+
+/* Copies the subtree at `node` of `other` into `tree`, linking copied leaves after `*last_leaf`.
+ * If a copy fails, `*err` is set, but the returned subtree only ever contains fully copied elements so it can still be destroyed */
+static BTreeNode *btree_copy_helper(BTree *tree, const BTree *other, BTreeNode *node, BTreeNode **last_leaf, int *err) {
+    BTreeNode *copy = btree_node_alloc(tree);
+    if (copy == NULL) {
+        *err = CC_ENOMEM;
+        return NULL;
+    }
+
+    copy->leaf = node->leaf;
+
+    if (btree_element_inline(tree->key_base) && (tree->value_size == 0 || btree_element_inline(tree->value_base))) {
+        memcpy(btree_key_slot(tree, copy, 0), btree_key_slot(other, node, 0), BTREE_NODE_SIZE - BTREE_HEADER_SIZE);
+        copy->count = node->count;
+    } else {
+        for (unsigned i = 0; i < node->count; ++i) {
+            if ((*err = btree_store_copy(tree->key_base, btree_key_slot(tree, copy, i), btree_key_at(other, node, i))) != 0)
+                break;
+
+            if (node->leaf && tree->value_size &&
+                    (*err = btree_store_copy(tree->value_base, btree_value_slot(tree, copy, i), btree_element(other->value_base, btree_value_slot(other, node, i)))) != 0) {
+                btree_destroy_element(tree->key_base, btree_key_slot(tree, copy, i));
+                break;
+            }
+
+            copy->count = i + 1;
+        }
+    }
+
+    if (copy->leaf) {
+        copy->prev = *last_leaf;
+        if (*last_leaf)
+            (*last_leaf)->next = copy;
+        *last_leaf = copy;
+    } else {
+        memset(btree_children(tree, copy), 0, (copy->count + 1) * sizeof(BTreeNode *));
+
+        for (unsigned i = 0; i <= copy->count && !*err; ++i)
+            btree_children(tree, copy)[i] = btree_copy_helper(tree, other, btree_children(other, node)[i], last_leaf, err);
+    }
+
+    return copy;
+}
+
+Compare btree_get_key_compare_fn(BTree *tree) {
+    return tree->key_base->compare;
+}
+
+int btree_set_key_compare_fn(BTree *tree, Compare compare) {
+    if (compare == NULL || tree->size)
+        return CC_EINVAL;
+
+    CommonContainerBase *base = container_base_copy_if_static(tree->key_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->compare = compare;
+    tree->key_base = base;
+
+    return 0;
+}
+
+Compare btree_get_value_compare_fn(BTree *tree) {
+    return tree->value_base->compare;
+}
+
+int btree_set_value_compare_fn(BTree *tree, Compare compare) {
+    CommonContainerBase *base = container_base_copy_if_static(tree->value_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->compare = compare;
+    tree->value_base = base;
+
+    return 0;
+}
+
+Copier btree_get_key_copier_fn(BTree *tree) {
+    return tree->key_base->copier;
+}
+
+int btree_set_key_copier_fn(BTree *tree, Copier copier) {
+    CommonContainerBase *base = container_base_copy_if_static(tree->key_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->copier = copier;
+    tree->key_base = base;
+
+    return 0;
+}
+
+Copier btree_get_value_copier_fn(BTree *tree) {
+    return tree->value_base->copier;
+}
+
+int btree_set_value_copier_fn(BTree *tree, Copier copier) {
+    CommonContainerBase *base = container_base_copy_if_static(tree->value_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->copier = copier;
+    tree->value_base = base;
+
+    return 0;
+}
+
+Deleter btree_get_key_deleter_fn(BTree *tree) {
+    return tree->key_base->deleter;
+}
+
+int btree_set_key_deleter_fn(BTree *tree, Deleter deleter) {
+    CommonContainerBase *base = container_base_copy_if_static(tree->key_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->deleter = deleter;
+    tree->key_base = base;
+
+    return 0;
+}
+
+Deleter btree_get_value_deleter_fn(BTree *tree) {
+    return tree->value_base->deleter;
+}
+
+int btree_set_value_deleter_fn(BTree *tree, Deleter deleter) {
+    CommonContainerBase *base = container_base_copy_if_static(tree->value_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->deleter = deleter;
+    tree->value_base = base;
+
+    return 0;
+}
+
+Parser btree_get_key_parser_fn(BTree *tree) {
+    return tree->key_base->parse;
+}
+
+int btree_set_key_parser_fn(BTree *tree, Parser parser) {
+    CommonContainerBase *base = container_base_copy_if_static(tree->key_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->parse = parser;
+    tree->key_base = base;
+
+    return 0;
+}
+
+Parser btree_get_value_parser_fn(BTree *tree) {
+    return tree->value_base->parse;
+}
+
+int btree_set_value_parser_fn(BTree *tree, Parser parser) {
+    CommonContainerBase *base = container_base_copy_if_static(tree->value_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->parse = parser;
+    tree->value_base = base;
+
+    return 0;
+}
+
+Serializer btree_get_key_serializer_fn(BTree *tree) {
+    return tree->key_base->serialize;
+}
+
+int btree_set_key_serializer_fn(BTree *tree, Serializer serializer) {
+    CommonContainerBase *base = container_base_copy_if_static(tree->key_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->serialize = serializer;
+    tree->key_base = base;
+
+    return 0;
+}
+
+Serializer btree_get_value_serializer_fn(BTree *tree) {
+    return tree->value_base->serialize;
+}
+
+int btree_set_value_serializer_fn(BTree *tree, Serializer serializer) {
+    CommonContainerBase *base = container_base_copy_if_static(tree->value_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->serialize = serializer;
+    tree->value_base = base;
+
+    return 0;
+}
+
+
+BTree *btree_create(const CommonContainerBase *key_base, const CommonContainerBase *value_base) {
+    if (key_base == NULL || value_base == NULL || key_base->compare == NULL)
+        return NULL;
+
+    BTree *tree = CALLOC(1, sizeof(*tree));
+    if (tree == NULL)
+        goto cleanup;
+
+    tree->backend = CONTAINER_BACKEND_BTREE;
+
+    tree->key_base = container_base_copy_if_dynamic((CommonContainerBase *) key_base);
+    if (tree->key_base == NULL)
+        goto cleanup;
+
+    tree->value_base = container_base_copy_if_dynamic((CommonContainerBase *) value_base);
+    if (tree->value_base == NULL)
+        goto cleanup;
+
+    /* Sets have no values, so leaves only need room for keys */
+    tree->key_size = btree_element_size(key_base);
+    tree->value_size = generic_types_compatible_compare(value_base, container_base_empty_recipe()) == 0? 0: btree_element_size(value_base);
+
+    const size_t value_alignment = btree_element_alignment(value_base);
+    unsigned capacity = (BTREE_NODE_SIZE - BTREE_HEADER_SIZE) / (tree->key_size + tree->value_size);
+    while (btree_align(BTREE_HEADER_SIZE + capacity * tree->key_size, value_alignment) + capacity * tree->value_size > BTREE_NODE_SIZE)
+        --capacity;
+
+    tree->leaf_capacity = capacity;
+    tree->leaf_value_offset = btree_align(BTREE_HEADER_SIZE + capacity * tree->key_size, value_alignment);
+
+    capacity = (BTREE_NODE_SIZE - BTREE_HEADER_SIZE - sizeof(BTreeNode *)) / (tree->key_size + sizeof(BTreeNode *));
+    while (btree_align(BTREE_HEADER_SIZE + capacity * tree->key_size, sizeof(BTreeNode *)) + (capacity + 1) * sizeof(BTreeNode *) > BTREE_NODE_SIZE)
+        --capacity;
+
+    tree->internal_capacity = capacity;
+    tree->internal_child_offset = btree_align(BTREE_HEADER_SIZE + capacity * tree->key_size, sizeof(BTreeNode *));
+    tree->slab_nodes = BTREE_MIN_SLAB_NODES;
+
+    return tree;
+
+cleanup:
+    if (tree) {
+        container_base_destroy_if_dynamic(tree->key_base);
+        container_base_destroy_if_dynamic(tree->value_base);
+    }
+    FREE(tree);
+
+    return NULL;
+}
+
+void btree_destroy(BTree *tree) {
+    if (tree != NULL) {
+        btree_destroy_nodes(tree);
+
+        container_base_destroy_if_dynamic(tree->key_base);
+        container_base_destroy_if_dynamic(tree->value_base);
+    }
+
+    FREE(tree);
+}
+
+BTree *btree_copy(BTree *other) {
+    if (other == NULL)
+        return NULL;
+
+    BTree *tree = btree_create(other->key_base, other->value_base);
+    if (tree == NULL || other->root == NULL)
+        return tree;
+
+    BTreeNode *last_leaf = NULL;
+    int err = 0;
+
+    tree->root = btree_copy_helper(tree, other, other->root, &last_leaf, &err);
+    tree->size = other->size;
+
+    if (err) {
+        btree_destroy(tree);
+        return NULL;
+    }
+
+    return tree;
+}
+
+/* Returns the smallest key in the subtree at `node` */
+static const void *btree_first_key(const BTree *tree, BTreeNode *node) {
+    while (!node->leaf)
+        node = btree_children(tree, node)[0];
+
+    return btree_key_at(tree, node, 0);
+}
+
+/* Destroys the elements of every node in a level of a partially built tree, linked through `next`. The nodes are not freed */
+static void btree_destroy_level(const BTree *tree, BTreeNode *node) {
+    for (; node; node = node->next) {
+        if (btree_element_needs_delete(tree->key_base))
+            for (size_t i = 0; i < node->count; ++i)
+                btree_destroy_element(tree->key_base, btree_key_slot(tree, node, i));
+
+        if (node->leaf && tree->value_size && btree_element_needs_delete(tree->value_base))
+            for (size_t i = 0; i < node->count; ++i)
+                btree_destroy_element(tree->value_base, btree_value_slot(tree, node, i));
+    }
+}
+
+int btree_build_sorted(BTree *tree, const void **keys, const void **values, size_t count) {
+    if (tree->size)
+        return CC_EINVAL;
+
+    btree_clear(tree);
+    if (count == 0)
+        return 0;
+
+    /* Elements are spread evenly over as few nodes as possible at each level, so no node is less than half full.
+     * Every node is reserved up front, so only copying elements can fail while building */
+    size_t nodes = (count + tree->leaf_capacity - 1) / tree->leaf_capacity, total = nodes;
+    for (size_t level_nodes = nodes; level_nodes > 1; total += level_nodes)
+        level_nodes = (level_nodes + tree->internal_capacity) / (tree->internal_capacity + 1);
+
+    tree->slab_nodes = MAX(MIN(total, BTREE_MAX_SLAB_NODES), BTREE_MIN_SLAB_NODES);
+    if (btree_reserve_nodes(tree, total))
+        return CC_ENOMEM;
+
+    BTreeNode *levels[BTREE_MAX_DEPTH]; /* First node of each level built so far, the nodes of a level are linked through `next` */
+    BTreeNode *prev = NULL;
+    size_t depth = 0, index = 0;
+    int err = 0;
+
+    levels[0] = NULL;
+    for (size_t i = 0; i < nodes && !err; ++i) {
+        BTreeNode *leaf = btree_node_alloc(tree);
+        const size_t leaf_count = count / nodes + (i < count % nodes);
+
+        leaf->leaf = 1;
+        leaf->prev = prev;
+        if (prev)
+            prev->next = leaf;
+        else
+            levels[0] = leaf;
+        prev = leaf;
+
+        for (unsigned j = 0; j < leaf_count; ++j, ++index) {
+            if ((err = btree_store_copy(tree->key_base, btree_key_slot(tree, leaf, j), keys[index])) != 0)
+                break;
+
+            if (tree->value_size &&
+                    (err = btree_store_copy(tree->value_base, btree_value_slot(tree, leaf, j), values? values[index]: NULL)) != 0) {
+                btree_destroy_element(tree->key_base, btree_key_slot(tree, leaf, j));
+                break;
+            }
+
+            leaf->count = j + 1;
+        }
+    }
+
+    while (nodes > 1 && !err) {
+        const size_t children = nodes;
+        BTreeNode *child = levels[depth];
+
+        nodes = (children + tree->internal_capacity) / (tree->internal_capacity + 1);
+        levels[++depth] = prev = NULL;
+
+        for (size_t i = 0; i < nodes && !err; ++i) {
+            BTreeNode *node = btree_node_alloc(tree);
+            const size_t child_count = children / nodes + (i < children % nodes);
+
+            if (prev)
+                prev->next = node;
+            else
+                levels[depth] = node;
+            prev = node;
+
+            for (unsigned j = 0; j < child_count; ++j, child = child->next) {
+                if (j && (err = btree_store_copy(tree->key_base, btree_key_slot(tree, node, j-1), btree_first_key(tree, child))) != 0)
+                    break;
+
+                btree_children(tree, node)[j] = child;
+                node->count = j;
+            }
+        }
+    }
+
+    if (err) {
+        for (size_t level = 0; level <= depth; ++level)
+            btree_destroy_level(tree, levels[level]);
+
+        btree_clear(tree);
+        return err;
+    }
+
+    /* Only leaves stay linked */
+    for (size_t level = 1; level <= depth; ++level) {
+        for (BTreeNode *node = levels[level]; node; ) {
+            BTreeNode *next = node->next;
+            node->next = NULL;
+            node = next;
+        }
+    }
+
+    tree->root = levels[depth];
+    tree->size = count;
+
+    return 0;
+}
+
+Iterator btree_begin(BTree *tree) {
+    BTreeNode *node = tree->root;
+
+    if (node == NULL)
+        return NULL;
+
+    while (!node->leaf)
+        node = btree_children(tree, node)[0];
+
+    return btree_key_slot(tree, node, 0);
+}
+
+Iterator btree_next(BTree *tree, Iterator it) {
+    if (it == NULL)
+        return NULL;
+
+    BTreeNode *leaf = btree_leaf_of(it);
+    const unsigned index = btree_index_of(tree, leaf, it);
+
+    if (index + 1 < leaf->count)
+        return btree_key_slot(tree, leaf, index + 1);
+    else if (leaf->next)
+        return btree_key_slot(tree, leaf->next, 0);
+
+    return NULL;
+}
+
+const void *btree_key_of(BTree *tree, Iterator it) {
+    return btree_element(tree->key_base, it);
+}
+
+void *btree_value_of(BTree *tree, Iterator it) {
+    if (tree->value_size == 0)
+        return NULL;
+
+    BTreeNode *leaf = btree_leaf_of(it);
+
+    return btree_element(tree->value_base, btree_value_slot(tree, leaf, btree_index_of(tree, leaf, it)));
+}
+
+Iterator btree_find(BTree *tree, const void *key) {
+    BTreeNode *node = tree->root;
+    int found;
+
+    if (node == NULL)
+        return NULL;
+
+    while (!node->leaf)
+        node = btree_children(tree, node)[btree_internal_search(tree, node, key)];
+
+    const unsigned index = btree_leaf_search(tree, node, key, &found);
+
+    return found? btree_key_slot(tree, node, index): NULL;
+}
+
+/* Stores the key and value in a new or existing element.
+ * `move_key` specifies whether `key` is moved into the tree or copied, and `copy_value` specifies whether `value` is copied or moved */
+static Iterator btree_insert_helper(BTree *tree, const void *key, void *value, int move_key, int copy_value) {
+    BTreeNode *path[BTREE_MAX_DEPTH], *leaf = NULL;
+    unsigned path_index[BTREE_MAX_DEPTH], index = 0;
+    size_t depth = 0;
+    int found = 0;
+
+    if (tree->root != NULL) {
+        index = btree_find_path(tree, key, path, path_index, &depth, &leaf, &found);
+
+        if (found) { /* Key already exists in tree */
+            unsigned char *slot = btree_key_slot(tree, leaf, index);
+
+            if (move_key)
+                btree_discard_moved(tree->key_base, (void *) key);
+
+            if (copy_value)
+                return btree_replace(tree, slot, value)? NULL: slot;
+
+            btree_replace_move(tree, slot, value);
+            return slot;
+        }
+    }
+
+    /* Prepare the new element before modifying the tree, so the tree is unchanged if anything fails.
+     * This also makes copies of keys and values that point into the tree itself safe, since elements move on insertion */
+    unsigned char key_storage[BTREE_ELEMENT_BUFFER_SIZE], value_storage[BTREE_ELEMENT_BUFFER_SIZE];
+
+    if (move_key)
+        btree_stage_move(tree->key_base, key_storage, (void *) key);
+    else if (btree_store_copy(tree->key_base, key_storage, key))
+        return NULL;
+
+    if (tree->value_size) {
+        if (!copy_value)
+            btree_stage_move(tree->value_base, value_storage, value);
+        else if (btree_store_copy(tree->value_base, value_storage, value)) {
+            if (!move_key)
+                btree_destroy_element(tree->key_base, key_storage);
+
+            return NULL;
+        }
+    }
+
+    if (tree->root == NULL && (leaf = tree->root = btree_node_alloc(tree)) != NULL)
+        leaf->leaf = 1;
+
+    unsigned char *slot = leaf? btree_insert_at(tree, path, path_index, depth, leaf, index, key_storage, value_storage): NULL;
+    if (slot == NULL) {
+        if (!move_key)
+            btree_destroy_element(tree->key_base, key_storage);
+        if (copy_value && tree->value_size)
+            btree_destroy_element(tree->value_base, value_storage);
+
+        return NULL;
+    }
+
+    if (move_key)
+        btree_release_moved(tree->key_base, (void *) key);
+    if (!copy_value && tree->value_size)
+        btree_release_moved(tree->value_base, value);
+
+    return slot;
+}
+
+Iterator btree_insert_move_key(BTree *tree, void *key, void *value) {
+    return btree_insert_helper(tree, key, value, 1, 0);
+}
+
+Iterator btree_insert_copy_key(BTree *tree, const void *key, void *value) {
+    return btree_insert_helper(tree, key, value, 0, 0);
+}
+
+Iterator btree_insert_copy(BTree *tree, const void *key, const void *value) {
+    return btree_insert_helper(tree, key, (void *) value, 0, 1);
+}
+
+int btree_replace_move(BTree *tree, Iterator it, void *value) {
+    if (tree->value_size == 0)
+        return 0;
+
+    BTreeNode *leaf = btree_leaf_of(it);
+    unsigned char *value_storage = btree_value_slot(tree, leaf, btree_index_of(tree, leaf, it));
+
+    btree_destroy_element(tree->value_base, value_storage);
+    btree_stage_move(tree->value_base, value_storage, value);
+    btree_release_moved(tree->value_base, value);
+
+    return 0;
+}
+
+int btree_replace(BTree *tree, Iterator it, const void *value) {
+    if (tree->value_size == 0)
+        return 0;
+
+    BTreeNode *leaf = btree_leaf_of(it);
+    unsigned char *value_storage = btree_value_slot(tree, leaf, btree_index_of(tree, leaf, it));
+
+    if (btree_element_inline(tree->value_base))
+        return btree_store_copy(tree->value_base, value_storage, value);
+
+    /* Copy before destroying the old value, in case `value` refers to it */
+    void *duplicate;
+    int err = btree_store_copy(tree->value_base, &duplicate, value);
+    if (err)
+        return err;
+
+    btree_destroy_element(tree->value_base, value_storage);
+    *((void **) value_storage) = duplicate;
+
+    return 0;
+}
+
+Iterator btree_delete_at(BTree *tree, Iterator it) {
+    if (it == NULL)
+        return NULL;
+
+    BTreeNode *path[BTREE_MAX_DEPTH], *leaf;
+    unsigned path_index[BTREE_MAX_DEPTH];
+    size_t depth;
+    int found;
+
+    /* The path is needed to rebalance the tree, so search for the element from the root */
+    const unsigned index = btree_find_path(tree, btree_key_of(tree, it), path, path_index, &depth, &leaf, &found);
+
+    /* Remember the key of the next element, in case rebalancing moves it to another leaf */
+    unsigned char next_key[BTREE_ELEMENT_BUFFER_SIZE];
+    const void *next = NULL;
+
+    if (index + 1 < leaf->count)
+        memcpy(next_key, btree_key_slot(tree, leaf, index + 1), tree->key_size);
+    else if (leaf->next)
+        memcpy(next_key, btree_key_slot(tree, leaf->next, 0), tree->key_size);
+
+    if (index + 1 < leaf->count || leaf->next)
+        next = btree_element(tree->key_base, next_key);
+
+    btree_destroy_element(tree->key_base, btree_key_slot(tree, leaf, index));
+    if (tree->value_size)
+        btree_destroy_element(tree->value_base, btree_value_slot(tree, leaf, index));
+
+    if (btree_remove_at(tree, path, path_index, depth, leaf, index))
+        return next? btree_find(tree, next): NULL;
+    else if (next == NULL)
+        return NULL;
+
+    return index < leaf->count? btree_key_slot(tree, leaf, index): btree_key_slot(tree, leaf->next, 0);
+}
+
+void btree_delete(BTree *tree, const void *key) {
+    btree_delete_at(tree, btree_find(tree, key));
+}
+
+void btree_clear(BTree *tree) {
+    btree_destroy_nodes(tree);
+}
+
+size_t btree_size(BTree *tree) {
+    return tree->size;
+}
+
+const CommonContainerBase *btree_get_key_container_base(const BTree *tree) {
+    return tree->key_base;
+}
+
+const CommonContainerBase *btree_get_value_container_base(const BTree *tree) {
+    return tree->value_base;
+}
@@ -0,0 +1,66 @@
+/** @file
+ *
+ *  @author Oliver Adams
+ *  @copyright Copyright (C) 2020
+ */
+
+#ifndef BTREE_H
+#define BTREE_H
+
+#include "../common.h"
+#include "backend.h"
+
+struct BTree;
+
+Compare btree_get_key_compare_fn(struct BTree *tree);
+Compare btree_get_value_compare_fn(struct BTree *tree);
+Copier btree_get_key_copier_fn(struct BTree *tree);
+Copier btree_get_value_copier_fn(struct BTree *tree);
+Deleter btree_get_key_deleter_fn(struct BTree *tree);
+Deleter btree_get_value_deleter_fn(struct BTree *tree);
+Parser btree_get_key_parser_fn(struct BTree *tree);
+Parser btree_get_value_parser_fn(struct BTree *tree);
+Serializer btree_get_key_serializer_fn(struct BTree *tree);
+Serializer btree_get_value_serializer_fn(struct BTree *tree);
+int btree_set_key_compare_fn(struct BTree *tree, Compare compare);
+int btree_set_value_compare_fn(struct BTree *tree, Compare compare);
+int btree_set_key_copier_fn(struct BTree *tree, Copier copier);
+int btree_set_value_copier_fn(struct BTree *tree, Copier copier);
+int btree_set_key_deleter_fn(struct BTree *tree, Deleter deleter);
+int btree_set_value_deleter_fn(struct BTree *tree, Deleter deleter);
+int btree_set_key_parser_fn(struct BTree *tree, Parser parser);
+int btree_set_value_parser_fn(struct BTree *tree, Parser parser);
+int btree_set_key_serializer_fn(struct BTree *tree, Serializer serializer);
+int btree_set_value_serializer_fn(struct BTree *tree, Serializer serializer);
+
+/* Small POD keys and values are stored inline in the leaves, all others are stored as pointers.
+ * Iterators point into a leaf, and are invalidated by any insertion that adds a new key or any deletion.
+ * If `value_base` is the empty recipe, no values are stored at all and btree_value_of() always returns NULL */
+struct BTree *btree_create(const CommonContainerBase *key_base, const CommonContainerBase *value_base);
+void btree_destroy(struct BTree *tree);
+struct BTree *btree_copy(struct BTree *other);
+/* Fills an empty tree with `count` keys and values in linear time, without comparing them.
+ * The keys must be sorted in ascending order with no duplicates. All keys and values are copied, and `values` may be NULL */
+int btree_build_sorted(struct BTree *tree, const void **keys, const void **values, size_t count);
+Iterator btree_begin(struct BTree *tree);
+Iterator btree_next(struct BTree *tree, Iterator it);
+const void *btree_key_of(struct BTree *tree, Iterator it);
+void *btree_value_of(struct BTree *tree, Iterator it);
+Iterator btree_find(struct BTree *tree, const void *key);
+/* The key and value are moved into the tree, and the key is destroyed if it already exists in the tree. Returns NULL if out of memory */
+Iterator btree_insert_move_key(struct BTree *tree, void *key, void *value);
+/* The key is copied and the value is moved into the tree. Returns NULL if out of memory or the key cannot be copied */
+Iterator btree_insert_copy_key(struct BTree *tree, const void *key, void *value);
+/* The key and value are both copied into the tree. Returns NULL if out of memory or the key or value cannot be copied */
+Iterator btree_insert_copy(struct BTree *tree, const void *key, const void *value);
+int btree_replace_move(struct BTree *tree, Iterator it, void *value);
+int btree_replace(struct BTree *tree, Iterator it, const void *value);
+/* Returns the element after the deleted element, or NULL if the deleted element was the last one */
+Iterator btree_delete_at(struct BTree *tree, Iterator it);
+void btree_delete(struct BTree *tree, const void *key);
+void btree_clear(struct BTree *tree);
+size_t btree_size(struct BTree *tree);
+const CommonContainerBase *btree_get_key_container_base(const struct BTree *tree);
+const CommonContainerBase *btree_get_value_container_base(const struct BTree *tree);
+
+#endif /* BTREE_H */
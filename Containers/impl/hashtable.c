@@ -0,0 +1,829 @@
+/** @file
+ *
+ *  @author Oliver Adams
+ *  @copyright Copyright (C) 2020
+ */
+
+#include "hashtable.h"
+#include "../../utility.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HASHTABLE_COMPILE_SUPPORTS_SSE2
+#endif
+
+/* Open-addressing hash table with one control byte per slot, in the style of SwissTable.
+ *
+ * Full slots store the low 7 bits of the key's hash in their control byte, all other control states have the high bit set.
+ * Lookups compare a whole group of control bytes against the 7-bit hash at once, and only compare keys on a match.
+ */
+#define HASHTABLE_CTRL_EMPTY ((signed char) -128)
+#define HASHTABLE_CTRL_DELETED ((signed char) -2)
+
+/* Number of control bytes examined at once while probing */
+#define HASHTABLE_GROUP_WIDTH 16
+#define HASHTABLE_GROUP_MASK 0xffffu
+
+#define HASHTABLE_MINIMUM_CAPACITY 16
+
+typedef struct HashTable {
+    enum ContainerBackend backend; /* Always CONTAINER_BACKEND_HASH */
+    CommonContainerBase *key_base, *value_base;
+
+    /* `capacity + HASHTABLE_GROUP_WIDTH` control bytes. The last HASHTABLE_GROUP_WIDTH bytes mirror the first ones, so a group can be loaded at any slot without wrapping */
+    signed char *ctrl;
+
+    /* `capacity` slots of `slot_size` bytes each. Each slot contains the key, followed by the value at `value_offset`.
+     * POD keys and values are stored inline, all others are stored as a pointer */
+    unsigned char *slots;
+
+    size_t capacity; /* Either zero or a power of two not smaller than HASHTABLE_MINIMUM_CAPACITY */
+    size_t size;
+    size_t growth_left; /* Number of empty slots that can still be filled before the table must be rehashed */
+
+    size_t value_offset;
+    size_t slot_size;
+} HashTable;
+
+static unsigned hashtable_lowest_bit(unsigned mask) {
+#if GCC_COMPILER | CLANG_COMPILER
+    return (unsigned) __builtin_ctz(mask);
+#else
+    unsigned index = 0;
+
+    while (!(mask & 1)) {
+        mask >>= 1;
+        ++index;
+    }
+
+    return index;
+#endif
+}
+
+static unsigned hashtable_highest_bit(unsigned mask) {
+#if GCC_COMPILER | CLANG_COMPILER
+    return (unsigned) (sizeof(unsigned) * CHAR_BIT - 1 - __builtin_clz(mask));
+#else
+    unsigned index = 0;
+
+    while (mask >>= 1)
+        ++index;
+
+    return index;
+#endif
+}
+
+/* Returns a mask with one bit set for each control byte in the group starting at `ctrl` that equals `value` */
+static unsigned hashtable_group_match(const signed char *ctrl, signed char value) {
+#ifdef HASHTABLE_COMPILE_SUPPORTS_SSE2
+    __m128i group = _mm_loadu_si128((const __m128i *) ctrl);
+
+    return (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value)));
+#else
+    unsigned mask = 0;
+
+    for (unsigned i = 0; i < HASHTABLE_GROUP_WIDTH; ++i)
+        mask |= (unsigned) (ctrl[i] == value) << i;
+
+    return mask;
+#endif
+}
+
+/* Returns a mask with one bit set for each control byte in the group starting at `ctrl` that is empty or deleted */
+static unsigned hashtable_group_match_not_full(const signed char *ctrl) {
+#ifdef HASHTABLE_COMPILE_SUPPORTS_SSE2
+    return (unsigned) _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) ctrl));
+#else
+    unsigned mask = 0;
+
+    for (unsigned i = 0; i < HASHTABLE_GROUP_WIDTH; ++i)
+        mask |= (unsigned) (ctrl[i] < 0) << i;
+
+    return mask;
+#endif
+}
+
+static size_t hashtable_max_load(size_t capacity) {
+    return capacity - capacity / 8;
+}
+
+static size_t hashtable_element_size(const CommonContainerBase *base) {
+    return base->size? base->size: sizeof(void*);
+}
+
+/* Returns the alignment of an element in a slot, the largest power of two (up to 16) that divides its size */
+static size_t hashtable_element_alignment(const CommonContainerBase *base) {
+    const size_t size = hashtable_element_size(base);
+    size_t alignment = 1;
+
+    while (alignment < 16 && size % (alignment * 2) == 0)
+        alignment *= 2;
+
+    return alignment;
+}
+
+/* Computes the hash of a key, mixed so that both the low 7 bits and the remaining bits are well distributed */
+static size_t hashtable_hash(const HashTable *table, const void *key) {
+    uint64_t hash = table->key_base->hash(key);
+
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xff51afd7ed558ccd);
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xc4ceb9fe1a85ec53);
+    hash ^= hash >> 33;
+
+    return (size_t) hash;
+}
+
+static unsigned char *hashtable_slot(const HashTable *table, size_t index) {
+    return table->slots + index * table->slot_size;
+}
+
+static size_t hashtable_slot_index(const HashTable *table, const unsigned char *slot) {
+    return (size_t) (slot - table->slots) / table->slot_size;
+}
+
+static const void *hashtable_slot_key(const HashTable *table, unsigned char *slot) {
+    return table->key_base->size? slot: *((void **) slot);
+}
+
+static void hashtable_set_ctrl(HashTable *table, size_t index, signed char value) {
+    table->ctrl[index] = value;
+
+    if (index < HASHTABLE_GROUP_WIDTH)
+        table->ctrl[table->capacity + index] = value;
+}
+
+/* Returns whether `item` points into the slot storage of the table, and would therefore be invalidated by a rehash */
+static int hashtable_owns_pointer(const HashTable *table, const void *item) {
+    const unsigned char *p = item;
+
+    return table->slots && p >= table->slots && p < table->slots + table->capacity * table->slot_size;
+}
+
+/* Moves an element into slot storage. POD elements are copied and the original freed, as with GenericList */
+static void hashtable_store_move(const CommonContainerBase *base, void *storage, void *item) {
+    if (base->size) {
+        if (item == NULL)
+            memset(storage, 0, base->size);
+        else {
+            memmove(storage, item, base->size);
+            FREE(item);
+        }
+    } else {
+        *((void **) storage) = item;
+    }
+}
+
+/* Copies an element into slot storage. Returns an error if the element could not be copied */
+static int hashtable_store_copy(const CommonContainerBase *base, void *storage, const void *item) {
+    if (base->size) {
+        if (item == NULL)
+            memset(storage, 0, base->size);
+        else
+            memmove(storage, item, base->size);
+
+        return 0;
+    }
+
+    if (base->copier == NULL)
+        return CC_ENOTSUP;
+
+    void *duplicate = base->copier(item);
+    if (duplicate == NULL && item != NULL)
+        return CC_ENOMEM;
+
+    *((void **) storage) = duplicate;
+    return 0;
+}
+
+static void hashtable_destroy_element(const CommonContainerBase *base, void *storage) {
+    if (!base->size && base->deleter)
+        base->deleter(*((void **) storage));
+}
+
+/* Destroys an element that was going to be moved into the table, but wasn't needed */
+static void hashtable_discard_moved(const CommonContainerBase *base, void *item) {
+    if (base->size)
+        FREE(item);
+    else if (base->deleter)
+        base->deleter(item);
+}
+
+static void hashtable_destroy_elements(HashTable *table) {
+    if (table->size == 0)
+        return;
+
+    for (size_t i = 0; i < table->capacity; ++i) {
+        if (table->ctrl[i] >= 0) {
+            unsigned char *slot = hashtable_slot(table, i);
+
+            hashtable_destroy_element(table->key_base, slot);
+            hashtable_destroy_element(table->value_base, slot + table->value_offset);
+        }
+    }
+}
+
+static unsigned char *hashtable_find_hashed(const HashTable *table, const void *key, size_t hash) {
+    if (table->capacity == 0)
+        return NULL;
+
+    const size_t mask = table->capacity - 1;
+    const signed char h2 = (signed char) (hash & 0x7f);
+    size_t pos = (hash >> 7) & mask;
+
+    /* Triangular probing over groups visits every group exactly once */
+    for (size_t step = HASHTABLE_GROUP_WIDTH; step <= table->capacity; step += HASHTABLE_GROUP_WIDTH) {
+        unsigned match = hashtable_group_match(table->ctrl + pos, h2);
+
+        for (; match; match &= match - 1) {
+            unsigned char *slot = hashtable_slot(table, (pos + hashtable_lowest_bit(match)) & mask);
+
+            if (table->key_base->compare(key, hashtable_slot_key(table, slot)) == 0)
+                return slot;
+        }
+
+        if (hashtable_group_match(table->ctrl + pos, HASHTABLE_CTRL_EMPTY))
+            return NULL;
+
+        pos = (pos + step) & mask;
+    }
+
+    return NULL;
+}
+
+/* Returns the index of the first empty or deleted slot in the probe sequence of `hash`. The table must not be full */
+static size_t hashtable_find_first_not_full(const HashTable *table, size_t hash) {
+    const size_t mask = table->capacity - 1;
+    size_t pos = (hash >> 7) & mask;
+
+    for (size_t step = HASHTABLE_GROUP_WIDTH; ; step += HASHTABLE_GROUP_WIDTH) {
+        unsigned match = hashtable_group_match_not_full(table->ctrl + pos);
+
+        if (match)
+            return (pos + hashtable_lowest_bit(match)) & mask;
+
+        pos = (pos + step) & mask;
+    }
+}
+
+/* Moves all elements into newly allocated storage with the specified capacity, dropping all deleted slots */
+static int hashtable_rehash(HashTable *table, size_t capacity) {
+    const size_t slots_size = safe_multiply(capacity, table->slot_size);
+    if (!slots_size || capacity + HASHTABLE_GROUP_WIDTH < capacity)
+        return CC_ENOMEM;
+
+    signed char *ctrl = MALLOC(capacity + HASHTABLE_GROUP_WIDTH);
+    unsigned char *slots = MALLOC(slots_size);
+    if (ctrl == NULL || slots == NULL) {
+        FREE(ctrl);
+        FREE(slots);
+        return CC_ENOMEM;
+    }
+
+    memset(ctrl, HASHTABLE_CTRL_EMPTY, capacity + HASHTABLE_GROUP_WIDTH);
+
+    signed char *old_ctrl = table->ctrl;
+    unsigned char *old_slots = table->slots;
+    const size_t old_capacity = table->capacity;
+
+    table->ctrl = ctrl;
+    table->slots = slots;
+    table->capacity = capacity;
+    table->growth_left = hashtable_max_load(capacity) - table->size;
+
+    for (size_t i = 0; i < old_capacity; ++i) {
+        if (old_ctrl[i] >= 0) {
+            unsigned char *old_slot = old_slots + i * table->slot_size;
+            const size_t hash = hashtable_hash(table, hashtable_slot_key(table, old_slot));
+            const size_t index = hashtable_find_first_not_full(table, hash);
+
+            hashtable_set_ctrl(table, index, (signed char) (hash & 0x7f));
+            memcpy(hashtable_slot(table, index), old_slot, table->slot_size);
+        }
+    }
+
+    FREE(old_ctrl);
+    FREE(old_slots);
+
+    return 0;
+}
+
+/* Finds the slot for `key`, or claims a new slot for it. `*inserted` is set to 1 if a new slot was claimed, in which case the caller must fill it in.
+ * Returns NULL if the table could not be grown */
+static unsigned char *hashtable_find_or_prepare_insert(HashTable *table, const void *key, int *inserted) {
+    const size_t hash = hashtable_hash(table, key);
+    unsigned char *slot = hashtable_find_hashed(table, key, hash);
+
+    *inserted = 0;
+    if (slot != NULL)
+        return slot;
+
+    size_t index = table->capacity? hashtable_find_first_not_full(table, hash): 0;
+
+    if (table->capacity == 0 || (table->growth_left == 0 && table->ctrl[index] == HASHTABLE_CTRL_EMPTY)) {
+        size_t capacity = HASHTABLE_MINIMUM_CAPACITY;
+
+        if (table->capacity) {
+            /* Rehash in place if most of the load is deleted slots, otherwise grow */
+            capacity = table->size < hashtable_max_load(table->capacity) / 2? table->capacity: table->capacity * 2;
+            if (capacity < table->capacity)
+                return NULL;
+        }
+
+        if (hashtable_rehash(table, capacity))
+            return NULL;
+
+        index = hashtable_find_first_not_full(table, hash);
+    }
+
+    if (table->ctrl[index] == HASHTABLE_CTRL_EMPTY)
+        --table->growth_left;
+
+    hashtable_set_ctrl(table, index, (signed char) (hash & 0x7f));
+    ++table->size;
+    *inserted = 1;
+
+    return hashtable_slot(table, index);
+}
+
+/* Marks a slot as no longer used, without destroying its contents */
+static void hashtable_release_slot(HashTable *table, size_t index) {
+    const size_t mask = table->capacity - 1;
+    const unsigned empty_after = hashtable_group_match(table->ctrl + index, HASHTABLE_CTRL_EMPTY);
+    const unsigned empty_before = hashtable_group_match(table->ctrl + ((index - HASHTABLE_GROUP_WIDTH) & mask), HASHTABLE_CTRL_EMPTY);
+
+    /* If every group containing this slot also contains an empty slot, no probe sequence could have continued past it, so it can become empty again.
+     * Otherwise a tombstone is required to keep later probe sequences intact */
+    const int was_never_full = empty_before && empty_after &&
+            hashtable_lowest_bit(empty_after) + (HASHTABLE_GROUP_WIDTH - 1 - hashtable_highest_bit(empty_before)) < HASHTABLE_GROUP_WIDTH;
+
+    hashtable_set_ctrl(table, index, was_never_full? HASHTABLE_CTRL_EMPTY: HASHTABLE_CTRL_DELETED);
+    table->growth_left += was_never_full;
+    --table->size;
+}
+
+static Iterator hashtable_next_full(HashTable *table, size_t index) {
+    for (; index < table->capacity; index += HASHTABLE_GROUP_WIDTH) {
+        const unsigned full = ~hashtable_group_match_not_full(table->ctrl + index) & HASHTABLE_GROUP_MASK;
+
+        if (full) {
+            index += hashtable_lowest_bit(full);
+
+            /* A match in the mirrored control bytes means there are no more full slots */
+            return index < table->capacity? hashtable_slot(table, index): NULL;
+        }
+    }
+
+    return NULL;
+}
+
+Compare hashtable_get_key_compare_fn(HashTable *table) {
+    return table->key_base->compare;
+}
+
+int hashtable_set_key_compare_fn(HashTable *table, Compare compare) {
+    if (compare == NULL || table->size)
+        return CC_EINVAL;
+
+    CommonContainerBase *base = container_base_copy_if_static(table->key_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->compare = compare;
+    table->key_base = base;
+
+    return 0;
+}
+
+Compare hashtable_get_value_compare_fn(HashTable *table) {
+    return table->value_base->compare;
+}
+
+int hashtable_set_value_compare_fn(HashTable *table, Compare compare) {
+    CommonContainerBase *base = container_base_copy_if_static(table->value_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->compare = compare;
+    table->value_base = base;
+
+    return 0;
+}
+
+Copier hashtable_get_key_copier_fn(HashTable *table) {
+    return table->key_base->copier;
+}
+
+int hashtable_set_key_copier_fn(HashTable *table, Copier copier) {
+    CommonContainerBase *base = container_base_copy_if_static(table->key_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->copier = copier;
+    table->key_base = base;
+
+    return 0;
+}
+
+Copier hashtable_get_value_copier_fn(HashTable *table) {
+    return table->value_base->copier;
+}
+
+int hashtable_set_value_copier_fn(HashTable *table, Copier copier) {
+    CommonContainerBase *base = container_base_copy_if_static(table->value_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->copier = copier;
+    table->value_base = base;
+
+    return 0;
+}
+
+Deleter hashtable_get_key_deleter_fn(HashTable *table) {
+    return table->key_base->deleter;
+}
+
+int hashtable_set_key_deleter_fn(HashTable *table, Deleter deleter) {
+    CommonContainerBase *base = container_base_copy_if_static(table->key_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->deleter = deleter;
+    table->key_base = base;
+
+    return 0;
+}
+
+Deleter hashtable_get_value_deleter_fn(HashTable *table) {
+    return table->value_base->deleter;
+}
+
+int hashtable_set_value_deleter_fn(HashTable *table, Deleter deleter) {
+    CommonContainerBase *base = container_base_copy_if_static(table->value_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->deleter = deleter;
+    table->value_base = base;
+
+    return 0;
+}
+
+Parser hashtable_get_key_parser_fn(HashTable *table) {
+    return table->key_base->parse;
+}
+
+int hashtable_set_key_parser_fn(HashTable *table, Parser parser) {
+    CommonContainerBase *base = container_base_copy_if_static(table->key_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->parse = parser;
+    table->key_base = base;
+
+    return 0;
+}
+
+Parser hashtable_get_value_parser_fn(HashTable *table) {
+    return table->value_base->parse;
+}
+
+int hashtable_set_value_parser_fn(HashTable *table, Parser parser) {
+    CommonContainerBase *base = container_base_copy_if_static(table->value_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->parse = parser;
+    table->value_base = base;
+
+    return 0;
+}
+
+Serializer hashtable_get_key_serializer_fn(HashTable *table) {
+    return table->key_base->serialize;
+}
+
+int hashtable_set_key_serializer_fn(HashTable *table, Serializer serializer) {
+    CommonContainerBase *base = container_base_copy_if_static(table->key_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->serialize = serializer;
+    table->key_base = base;
+
+    return 0;
+}
+
+Serializer hashtable_get_value_serializer_fn(HashTable *table) {
+    return table->value_base->serialize;
+}
+
+int hashtable_set_value_serializer_fn(HashTable *table, Serializer serializer) {
+    CommonContainerBase *base = container_base_copy_if_static(table->value_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->serialize = serializer;
+    table->value_base = base;
+
+    return 0;
+}
+
+Hasher hashtable_get_key_hash_fn(HashTable *table) {
+    return table->key_base->hash;
+}
+
+int hashtable_set_key_hash_fn(HashTable *table, Hasher hash) {
+    if (hash == NULL || table->size)
+        return CC_EINVAL;
+
+    CommonContainerBase *base = container_base_copy_if_static(table->key_base, 1);
+    if (base == NULL)
+        return CC_ENOMEM;
+
+    base->hash = hash;
+    table->key_base = base;
+
+    return 0;
+}
+
+HashTable *hashtable_create(const CommonContainerBase *key_base, const CommonContainerBase *value_base) {
+    if (key_base == NULL || value_base == NULL || key_base->compare == NULL || key_base->hash == NULL)
+        return NULL;
+
+    HashTable *table = CALLOC(1, sizeof(*table));
+    if (table == NULL)
+        goto cleanup;
+
+    table->backend = CONTAINER_BACKEND_HASH;
+
+    table->key_base = container_base_copy_if_dynamic((CommonContainerBase *) key_base);
+    if (table->key_base == NULL)
+        goto cleanup;
+
+    table->value_base = container_base_copy_if_dynamic((CommonContainerBase *) value_base);
+    if (table->value_base == NULL)
+        goto cleanup;
+
+    const size_t value_alignment = hashtable_element_alignment(value_base);
+    const size_t slot_alignment = MAX(hashtable_element_alignment(key_base), value_alignment);
+
+    table->value_offset = (hashtable_element_size(key_base) + value_alignment - 1) / value_alignment * value_alignment;
+    table->slot_size = (table->value_offset + hashtable_element_size(value_base) + slot_alignment - 1) / slot_alignment * slot_alignment;
+
+    return table;
+
+cleanup:
+    if (table) {
+        container_base_destroy_if_dynamic(table->key_base);
+        container_base_destroy_if_dynamic(table->value_base);
+    }
+    FREE(table);
+
+    return NULL;
+}
+
+void hashtable_destroy(HashTable *table) {
+    if (table != NULL) {
+        hashtable_destroy_elements(table);
+
+        FREE(table->ctrl);
+        FREE(table->slots);
+        container_base_destroy_if_dynamic(table->key_base);
+        container_base_destroy_if_dynamic(table->value_base);
+    }
+
+    FREE(table);
+}
+
+HashTable *hashtable_copy(HashTable *other) {
+    if (other == NULL ||
+            (!other->key_base->size && other->key_base->copier == NULL) ||
+            (!other->value_base->size && other->value_base->copier == NULL))
+        return NULL;
+
+    HashTable *table = hashtable_create(other->key_base, other->value_base);
+    if (table == NULL || other->capacity == 0)
+        return table;
+
+    table->ctrl = MALLOC(other->capacity + HASHTABLE_GROUP_WIDTH);
+    table->slots = MALLOC(other->capacity * other->slot_size);
+    if (table->ctrl == NULL || table->slots == NULL) {
+        hashtable_destroy(table);
+        return NULL;
+    }
+
+    /* The same layout is kept, so no keys need to be rehashed */
+    memcpy(table->ctrl, other->ctrl, other->capacity + HASHTABLE_GROUP_WIDTH);
+    table->capacity = other->capacity;
+    table->size = other->size;
+    table->growth_left = other->growth_left;
+
+    for (size_t i = 0; i < other->capacity; ++i) {
+        if (other->ctrl[i] < 0)
+            continue;
+
+        unsigned char *from = hashtable_slot(other, i);
+        unsigned char *to = hashtable_slot(table, i);
+
+        if (hashtable_store_copy(table->key_base, to, hashtable_slot_key(other, from)) == 0) {
+            if (hashtable_store_copy(table->value_base, to + table->value_offset, hashtable_value_of(other, from)) == 0)
+                continue;
+
+            hashtable_destroy_element(table->key_base, to);
+        }
+
+        /* Drop all slots that weren't copied before destroying */
+        for (size_t j = i; j < other->capacity; ++j)
+            hashtable_set_ctrl(table, j, HASHTABLE_CTRL_EMPTY);
+
+        hashtable_destroy(table);
+        return NULL;
+    }
+
+    return table;
+}
+
+Iterator hashtable_begin(HashTable *table) {
+    return hashtable_next_full(table, 0);
+}
+
+Iterator hashtable_next(HashTable *table, Iterator it) {
+    return hashtable_next_full(table, hashtable_slot_index(table, it) + 1);
+}
+
+const void *hashtable_key_of(HashTable *table, Iterator it) {
+    return hashtable_slot_key(table, it);
+}
+
+void *hashtable_value_of(HashTable *table, Iterator it) {
+    unsigned char *value = (unsigned char *) it + table->value_offset;
+
+    return table->value_base->size? value: *((void **) value);
+}
+
+Iterator hashtable_find(HashTable *table, const void *key) {
+    return hashtable_find_hashed(table, key, hashtable_hash(table, key));
+}
+
+Iterator hashtable_insert_move_key(HashTable *table, void *key, void *value) {
+    int inserted;
+    unsigned char *slot = hashtable_find_or_prepare_insert(table, key, &inserted);
+    if (slot == NULL)
+        return NULL;
+
+    if (inserted)
+        hashtable_store_move(table->key_base, slot, key);
+    else {
+        hashtable_discard_moved(table->key_base, key);
+        hashtable_destroy_element(table->value_base, slot + table->value_offset);
+    }
+
+    hashtable_store_move(table->value_base, slot + table->value_offset, value);
+
+    return slot;
+}
+
+/* Copies the key and stores the value in a new or existing slot. `copy_value` specifies whether `value` is copied or moved */
+static Iterator hashtable_insert_helper(HashTable *table, const void *key, void *value, int copy_value) {
+    void *temp_key = NULL, *temp_value = NULL;
+
+    /* POD keys or values from this table would move if the table is rehashed */
+    if (table->key_base->size && hashtable_owns_pointer(table, key)) {
+        key = temp_key = generic_pod_copy_alloc(key, table->key_base->size);
+        if (key == NULL)
+            return NULL;
+    }
+
+    if (copy_value && table->value_base->size && hashtable_owns_pointer(table, value)) {
+        value = temp_value = generic_pod_copy_alloc(value, table->value_base->size);
+        if (value == NULL) {
+            FREE(temp_key);
+            return NULL;
+        }
+    }
+
+    int inserted;
+    unsigned char *slot = hashtable_find_or_prepare_insert(table, key, &inserted);
+    if (slot == NULL)
+        goto cleanup;
+
+    unsigned char *value_storage = slot + table->value_offset;
+
+    if (inserted && hashtable_store_copy(table->key_base, slot, key)) {
+        hashtable_release_slot(table, hashtable_slot_index(table, slot));
+        slot = NULL;
+        goto cleanup;
+    }
+
+    if (copy_value) {
+        void *duplicate = value;
+
+        if (!table->value_base->size) {
+            duplicate = table->value_base->copier? table->value_base->copier(value): NULL;
+            if (duplicate == NULL && value != NULL) {
+                if (inserted) {
+                    hashtable_destroy_element(table->key_base, slot);
+                    hashtable_release_slot(table, hashtable_slot_index(table, slot));
+                }
+
+                slot = NULL;
+                goto cleanup;
+            }
+        }
+
+        if (!inserted)
+            hashtable_destroy_element(table->value_base, value_storage);
+
+        if (table->value_base->size)
+            hashtable_store_copy(table->value_base, value_storage, value);
+        else
+            *((void **) value_storage) = duplicate;
+    } else {
+        if (!inserted)
+            hashtable_destroy_element(table->value_base, value_storage);
+
+        hashtable_store_move(table->value_base, value_storage, value);
+    }
+
+cleanup:
+    FREE(temp_key);
+    FREE(temp_value);
+
+    return slot;
+}
+
+Iterator hashtable_insert_copy_key(HashTable *table, const void *key, void *value) {
+    return hashtable_insert_helper(table, key, value, 0);
+}
+
+Iterator hashtable_insert_copy(HashTable *table, const void *key, const void *value) {
+    return hashtable_insert_helper(table, key, (void *) value, 1);
+}
+
+int hashtable_replace_move(HashTable *table, Iterator it, void *value) {
+    unsigned char *value_storage = (unsigned char *) it + table->value_offset;
+
+    hashtable_destroy_element(table->value_base, value_storage);
+    hashtable_store_move(table->value_base, value_storage, value);
+
+    return 0;
+}
+
+int hashtable_replace(HashTable *table, Iterator it, const void *value) {
+    unsigned char *value_storage = (unsigned char *) it + table->value_offset;
+
+    if (table->value_base->size)
+        return hashtable_store_copy(table->value_base, value_storage, value);
+
+    if (table->value_base->copier == NULL)
+        return CC_ENOTSUP;
+
+    void *duplicate = table->value_base->copier(value);
+    if (duplicate == NULL && value != NULL)
+        return CC_ENOMEM;
+
+    return hashtable_replace_move(table, it, duplicate);
+}
+
+Iterator hashtable_delete_slot(HashTable *table, Iterator it) {
+    if (it == NULL)
+        return NULL;
+
+    unsigned char *slot = it;
+    const size_t index = hashtable_slot_index(table, slot);
+
+    hashtable_destroy_element(table->key_base, slot);
+    hashtable_destroy_element(table->value_base, slot + table->value_offset);
+    hashtable_release_slot(table, index);
+
+    return hashtable_next_full(table, index + 1);
+}
+
+void hashtable_delete(HashTable *table, const void *key) {
+    hashtable_delete_slot(table, hashtable_find(table, key));
+}
+
+void hashtable_clear(HashTable *table) {
+    hashtable_destroy_elements(table);
+
+    if (table->capacity)
+        memset(table->ctrl, HASHTABLE_CTRL_EMPTY, table->capacity + HASHTABLE_GROUP_WIDTH);
+
+    table->size = 0;
+    table->growth_left = hashtable_max_load(table->capacity);
+}
+
+size_t hashtable_size(HashTable *table) {
+    return table->size;
+}
+
+const CommonContainerBase *hashtable_get_key_container_base(const HashTable *table) {
+    return table->key_base;
+}
+
+const CommonContainerBase *hashtable_get_value_container_base(const HashTable *table) {
+    return table->value_base;
+}
@@ -0,0 +1,64 @@
+/** @file
+ *
+ *  @author Oliver Adams
+ *  @copyright Copyright (C) 2020
+ */
+
+#ifndef HASHTABLE_H
+#define HASHTABLE_H
+
+#include "../common.h"
+#include "backend.h"
+
+struct HashTable;
+
+Compare hashtable_get_key_compare_fn(struct HashTable *table);
+Compare hashtable_get_value_compare_fn(struct HashTable *table);
+Copier hashtable_get_key_copier_fn(struct HashTable *table);
+Copier hashtable_get_value_copier_fn(struct HashTable *table);
+Deleter hashtable_get_key_deleter_fn(struct HashTable *table);
+Deleter hashtable_get_value_deleter_fn(struct HashTable *table);
+Parser hashtable_get_key_parser_fn(struct HashTable *table);
+Parser hashtable_get_value_parser_fn(struct HashTable *table);
+Serializer hashtable_get_key_serializer_fn(struct HashTable *table);
+Serializer hashtable_get_value_serializer_fn(struct HashTable *table);
+Hasher hashtable_get_key_hash_fn(struct HashTable *table);
+int hashtable_set_key_compare_fn(struct HashTable *table, Compare compare);
+int hashtable_set_value_compare_fn(struct HashTable *table, Compare compare);
+int hashtable_set_key_copier_fn(struct HashTable *table, Copier copier);
+int hashtable_set_value_copier_fn(struct HashTable *table, Copier copier);
+int hashtable_set_key_deleter_fn(struct HashTable *table, Deleter deleter);
+int hashtable_set_value_deleter_fn(struct HashTable *table, Deleter deleter);
+int hashtable_set_key_parser_fn(struct HashTable *table, Parser parser);
+int hashtable_set_value_parser_fn(struct HashTable *table, Parser parser);
+int hashtable_set_key_serializer_fn(struct HashTable *table, Serializer serializer);
+int hashtable_set_value_serializer_fn(struct HashTable *table, Serializer serializer);
+int hashtable_set_key_hash_fn(struct HashTable *table, Hasher hash);
+
+/* Keys and values with a POD container base are stored inline in the table, all others are stored as pointers.
+ * Iterators point to a slot in the table, and are invalidated by any insertion that adds a new key */
+struct HashTable *hashtable_create(const CommonContainerBase *key_base, const CommonContainerBase *value_base);
+void hashtable_destroy(struct HashTable *table);
+struct HashTable *hashtable_copy(struct HashTable *other);
+Iterator hashtable_begin(struct HashTable *table);
+Iterator hashtable_next(struct HashTable *table, Iterator it);
+const void *hashtable_key_of(struct HashTable *table, Iterator it);
+void *hashtable_value_of(struct HashTable *table, Iterator it);
+Iterator hashtable_find(struct HashTable *table, const void *key);
+/* The key and value are moved into the table, and the key is destroyed if it already exists in the table. Returns NULL if out of memory */
+Iterator hashtable_insert_move_key(struct HashTable *table, void *key, void *value);
+/* The key is copied and the value is moved into the table. Returns NULL if out of memory or the key cannot be copied */
+Iterator hashtable_insert_copy_key(struct HashTable *table, const void *key, void *value);
+/* The key and value are both copied into the table. Returns NULL if out of memory or the key or value cannot be copied */
+Iterator hashtable_insert_copy(struct HashTable *table, const void *key, const void *value);
+int hashtable_replace_move(struct HashTable *table, Iterator it, void *value);
+int hashtable_replace(struct HashTable *table, Iterator it, const void *value);
+/* Returns the next slot after the deleted slot, or NULL if the deleted slot was the last one */
+Iterator hashtable_delete_slot(struct HashTable *table, Iterator it);
+void hashtable_delete(struct HashTable *table, const void *key);
+void hashtable_clear(struct HashTable *table);
+size_t hashtable_size(struct HashTable *table);
+const CommonContainerBase *hashtable_get_key_container_base(const struct HashTable *table);
+const CommonContainerBase *hashtable_get_value_container_base(const struct HashTable *table);
+
+#endif /* HASHTABLE_H */
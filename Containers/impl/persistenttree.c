@@ -0,0 +1,486 @@
+/** @file
+ *
+ *  @author Oliver Adams
+ *  @copyright Copyright (C) 2020
+ */
+
+#include "persistenttree.h"
+#include "../../utility.h"
+
+#include <string.h>
+
+/* POD keys and values up to this size are stored inline in the entry, larger ones are stored as pointers */
+#ifndef PERSISTENTTREE_MAX_INLINE_SIZE
+#define PERSISTENTTREE_MAX_INLINE_SIZE 64
+#endif
+
+/* A key and its value. Entries are shared by every node that refers to the same key-value pair,
+ * so path copying never needs to copy the elements themselves */
+typedef struct PersistentEntry {
+    Atomic refs;
+    /* Followed by key storage at `key_offset` and value storage at `value_offset`, see PersistentTree */
+} PersistentEntry;
+
+typedef struct PersistentNode {
+    Atomic refs; /* Number of parent nodes and versions that refer to this node */
+    int height;
+    struct PersistentNode *left, *right;
+    PersistentEntry *entry;
+} PersistentNode;
+
+typedef struct PersistentTree {
+    CommonContainerBase *key_base, *value_base;
+    PersistentNode *root;
+    size_t size;
+
+    size_t key_offset, value_offset, entry_size; /* Layout of an entry, identical in every version */
+} PersistentTree;
+
+static int persistenttree_element_inline(const CommonContainerBase *base) {
+    return base->size && base->size <= PERSISTENTTREE_MAX_INLINE_SIZE;
+}
+
+static size_t persistenttree_element_size(const CommonContainerBase *base) {
+    return persistenttree_element_inline(base)? base->size: sizeof(void*);
+}
+
+/* Returns the alignment of an element in an entry, the largest power of two (up to 16) that divides its size */
+static size_t persistenttree_element_alignment(const CommonContainerBase *base) {
+    const size_t size = persistenttree_element_size(base);
+    size_t alignment = 1;
+
+    while (alignment < 16 && size % (alignment * 2) == 0)
+        alignment *= 2;
+
+    return alignment;
+}
+
+static size_t persistenttree_align(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+static unsigned char *persistententry_key_storage(const PersistentTree *tree, PersistentEntry *entry) {
+    return (unsigned char *) entry + tree->key_offset;
+}
+
+static unsigned char *persistententry_value_storage(const PersistentTree *tree, PersistentEntry *entry) {
+    return (unsigned char *) entry + tree->value_offset;
+}
+
+static const void *persistententry_key(const PersistentTree *tree, PersistentEntry *entry) {
+    unsigned char *storage = persistententry_key_storage(tree, entry);
+
+    return persistenttree_element_inline(tree->key_base)? storage: *((void **) storage);
+}
+
+static const void *persistententry_value(const PersistentTree *tree, PersistentEntry *entry) {
+    unsigned char *storage = persistententry_value_storage(tree, entry);
+
+    return persistenttree_element_inline(tree->value_base)? storage: *((void **) storage);
+}
+
+/* Moves an element into entry storage. Inline elements are copied and the original freed, as with GenericList */
+static void persistenttree_store_move(const CommonContainerBase *base, void *storage, void *item) {
+    if (persistenttree_element_inline(base)) {
+        if (item == NULL)
+            memset(storage, 0, base->size);
+        else {
+            memcpy(storage, item, base->size);
+            FREE(item);
+        }
+    } else {
+        *((void **) storage) = item;
+    }
+}
+
+/* Copies an element into entry storage. Returns an error if the element could not be copied */
+static int persistenttree_store_copy(const CommonContainerBase *base, void *storage, const void *item) {
+    if (persistenttree_element_inline(base)) {
+        if (item == NULL)
+            memset(storage, 0, base->size);
+        else
+            memcpy(storage, item, base->size);
+
+        return 0;
+    }
+
+    void *duplicate = NULL;
+    if (item != NULL) {
+        if (base->copier == NULL)
+            return CC_ENOTSUP;
+
+        duplicate = base->copier(item);
+        if (duplicate == NULL)
+            return CC_ENOMEM;
+    }
+
+    *((void **) storage) = duplicate;
+    return 0;
+}
+
+static void persistenttree_destroy_element(const CommonContainerBase *base, void *storage) {
+    if (!persistenttree_element_inline(base) && base->deleter)
+        base->deleter(*((void **) storage));
+}
+
+/* Destroys an element that was going to be moved into the tree, but wasn't needed */
+static void persistenttree_discard_moved(const CommonContainerBase *base, void *item) {
+    if (persistenttree_element_inline(base))
+        FREE(item);
+    else if (base->deleter)
+        base->deleter(item);
+}
+
+/* Creates an entry with a copied key, and a value that is either copied or moved */
+static PersistentEntry *persistententry_alloc(const PersistentTree *tree, const void *key, void *value, int copy_value) {
+    PersistentEntry *entry = MALLOC(tree->entry_size);
+    if (entry == NULL)
+        return NULL;
+
+    entry->refs = 1;
+
+    if (persistenttree_store_copy(tree->key_base, persistententry_key_storage(tree, entry), key)) {
+        FREE(entry);
+        return NULL;
+    }
+
+    if (!copy_value)
+        persistenttree_store_move(tree->value_base, persistententry_value_storage(tree, entry), value);
+    else if (persistenttree_store_copy(tree->value_base, persistententry_value_storage(tree, entry), value)) {
+        persistenttree_destroy_element(tree->key_base, persistententry_key_storage(tree, entry));
+        FREE(entry);
+        return NULL;
+    }
+
+    return entry;
+}
+
+static PersistentEntry *persistententry_ref(PersistentEntry *entry) {
+    atomic_add(&entry->refs, 1);
+    return entry;
+}
+
+static void persistententry_release(const PersistentTree *tree, PersistentEntry *entry) {
+    if (atomic_sub(&entry->refs, 1) == 1) {
+        persistenttree_destroy_element(tree->key_base, persistententry_key_storage(tree, entry));
+        persistenttree_destroy_element(tree->value_base, persistententry_value_storage(tree, entry));
+        FREE(entry);
+    }
+}
+
+static PersistentNode *persistentnode_ref(PersistentNode *node) {
+    if (node)
+        atomic_add(&node->refs, 1);
+
+    return node;
+}
+
+/* Releases a reference to the node, and frees the node and any children only it referred to */
+static void persistentnode_release(const PersistentTree *tree, PersistentNode *node) {
+    while (node && atomic_sub(&node->refs, 1) == 1) {
+        PersistentNode *right = node->right;
+
+        persistentnode_release(tree, node->left);
+        persistententry_release(tree, node->entry);
+        FREE(node);
+
+        node = right;
+    }
+}
+
+static int persistentnode_height(const PersistentNode *node) {
+    return node? node->height: 0;
+}
+
+/* Creates a node, taking ownership of the references to `entry`, `left`, and `right`.
+ * If `*err` is already set, or the node cannot be allocated, the references are released, `*err` is set, and NULL is returned.
+ * This allows nested calls, since the callee releases everything on failure */
+static PersistentNode *persistentnode_make(const PersistentTree *tree, PersistentEntry *entry, PersistentNode *left, PersistentNode *right, int *err) {
+    PersistentNode *node = *err? NULL: MALLOC(sizeof(*node));
+    if (node == NULL) {
+        persistententry_release(tree, entry);
+        persistentnode_release(tree, left);
+        persistentnode_release(tree, right);
+        *err = CC_ENOMEM;
+        return NULL;
+    }
+
+    node->refs = 1;
+    node->height = 1 + MAX(persistentnode_height(left), persistentnode_height(right));
+    node->left = left;
+    node->right = right;
+    node->entry = entry;
+
+    return node;
+}
+
+/* Creates a balanced node from subtrees whose heights differ by at most two, taking ownership of all references.
+ * Rotations build new nodes instead of modifying existing ones, since the existing nodes may be shared with other versions */
+static PersistentNode *persistentnode_balance(const PersistentTree *tree, PersistentEntry *entry, PersistentNode *left, PersistentNode *right, int *err) {
+    const int left_height = persistentnode_height(left), right_height = persistentnode_height(right);
+    PersistentNode *result;
+
+    if (*err)
+        return persistentnode_make(tree, entry, left, right, err);
+
+    if (left_height > right_height + 1) {
+        if (persistentnode_height(left->left) >= persistentnode_height(left->right)) { /* Rotate right */
+            result = persistentnode_make(tree, persistententry_ref(left->entry), persistentnode_ref(left->left),
+                                         persistentnode_make(tree, entry, persistentnode_ref(left->right), right, err), err);
+        } else { /* Rotate left-right */
+            PersistentNode *pivot = left->right;
+
+            result = persistentnode_make(tree, persistententry_ref(pivot->entry),
+                                         persistentnode_make(tree, persistententry_ref(left->entry), persistentnode_ref(left->left), persistentnode_ref(pivot->left), err),
+                                         persistentnode_make(tree, entry, persistentnode_ref(pivot->right), right, err), err);
+        }
+
+        persistentnode_release(tree, left);
+    } else if (right_height > left_height + 1) {
+        if (persistentnode_height(right->right) >= persistentnode_height(right->left)) { /* Rotate left */
+            result = persistentnode_make(tree, persistententry_ref(right->entry),
+                                         persistentnode_make(tree, entry, left, persistentnode_ref(right->left), err),
+                                         persistentnode_ref(right->right), err);
+        } else { /* Rotate right-left */
+            PersistentNode *pivot = right->left;
+
+            result = persistentnode_make(tree, persistententry_ref(pivot->entry),
+                                         persistentnode_make(tree, entry, left, persistentnode_ref(pivot->left), err),
+                                         persistentnode_make(tree, persistententry_ref(right->entry), persistentnode_ref(pivot->right), persistentnode_ref(right->right), err), err);
+        }
+
+        persistentnode_release(tree, right);
+    } else
+        result = persistentnode_make(tree, entry, left, right, err);
+
+    return result;
+}
+
+/* Returns a new subtree with `entry` stored under its key, taking ownership of `entry` but not `node` */
+static PersistentNode *persistentnode_insert(const PersistentTree *tree, PersistentNode *node, PersistentEntry *entry, int *added, int *err) {
+    if (node == NULL) {
+        *added = 1;
+        return persistentnode_make(tree, entry, NULL, NULL, err);
+    }
+
+    const int cmp = tree->key_base->compare(persistententry_key(tree, entry), persistententry_key(tree, node->entry));
+
+    if (cmp < 0) {
+        PersistentNode *left = persistentnode_insert(tree, node->left, entry, added, err);
+        return persistentnode_balance(tree, persistententry_ref(node->entry), left, persistentnode_ref(node->right), err);
+    } else if (cmp > 0) {
+        PersistentNode *right = persistentnode_insert(tree, node->right, entry, added, err);
+        return persistentnode_balance(tree, persistententry_ref(node->entry), persistentnode_ref(node->left), right, err);
+    }
+
+    /* Key already exists, replace the entry */
+    return persistentnode_make(tree, entry, persistentnode_ref(node->left), persistentnode_ref(node->right), err);
+}
+
+/* Returns a new subtree without its minimum node, which must exist. Does not take ownership of `node` */
+static PersistentNode *persistentnode_delete_min(const PersistentTree *tree, PersistentNode *node, int *err) {
+    if (node->left == NULL)
+        return persistentnode_ref(node->right);
+
+    PersistentNode *left = persistentnode_delete_min(tree, node->left, err);
+    return persistentnode_balance(tree, persistententry_ref(node->entry), left, persistentnode_ref(node->right), err);
+}
+
+/* Returns a new subtree without `key`, which must exist in the subtree. Does not take ownership of `node` */
+static PersistentNode *persistentnode_delete(const PersistentTree *tree, PersistentNode *node, const void *key, int *err) {
+    const int cmp = tree->key_base->compare(key, persistententry_key(tree, node->entry));
+
+    if (cmp < 0) {
+        PersistentNode *left = persistentnode_delete(tree, node->left, key, err);
+        return persistentnode_balance(tree, persistententry_ref(node->entry), left, persistentnode_ref(node->right), err);
+    } else if (cmp > 0) {
+        PersistentNode *right = persistentnode_delete(tree, node->right, key, err);
+        return persistentnode_balance(tree, persistententry_ref(node->entry), persistentnode_ref(node->left), right, err);
+    }
+
+    if (node->left == NULL)
+        return persistentnode_ref(node->right);
+    else if (node->right == NULL)
+        return persistentnode_ref(node->left);
+
+    /* Replace the node with its successor */
+    PersistentNode *successor = node->right;
+    while (successor->left)
+        successor = successor->left;
+
+    PersistentNode *right = persistentnode_delete_min(tree, node->right, err);
+    return persistentnode_balance(tree, persistententry_ref(successor->entry), persistentnode_ref(node->left), right, err);
+}
+
+/* Creates a new version with the same layout as `other`, taking ownership of `root` */
+static PersistentTree *persistenttree_version(const PersistentTree *other, PersistentNode *root, size_t size) {
+    PersistentTree *tree = CALLOC(1, sizeof(*tree));
+    if (tree == NULL)
+        goto cleanup;
+
+    tree->key_base = container_base_copy_if_dynamic(other->key_base);
+    if (tree->key_base == NULL)
+        goto cleanup;
+
+    tree->value_base = container_base_copy_if_dynamic(other->value_base);
+    if (tree->value_base == NULL)
+        goto cleanup;
+
+    tree->root = root;
+    tree->size = size;
+    tree->key_offset = other->key_offset;
+    tree->value_offset = other->value_offset;
+    tree->entry_size = other->entry_size;
+
+    return tree;
+
+cleanup:
+    if (tree) {
+        container_base_destroy_if_dynamic(tree->key_base);
+        container_base_destroy_if_dynamic(tree->value_base);
+    }
+    FREE(tree);
+
+    persistentnode_release(other, root);
+
+    return NULL;
+}
+
+PersistentTree *persistenttree_create(const CommonContainerBase *key_base, const CommonContainerBase *value_base) {
+    if (key_base == NULL || value_base == NULL || key_base->compare == NULL)
+        return NULL;
+
+    PersistentTree layout = {.key_base = (CommonContainerBase *) key_base, .value_base = (CommonContainerBase *) value_base};
+
+    const size_t key_alignment = persistenttree_element_alignment(key_base);
+    const size_t value_alignment = persistenttree_element_alignment(value_base);
+
+    layout.key_offset = persistenttree_align(sizeof(PersistentEntry), key_alignment);
+    layout.value_offset = persistenttree_align(layout.key_offset + persistenttree_element_size(key_base), value_alignment);
+    layout.entry_size = layout.value_offset + persistenttree_element_size(value_base);
+
+    return persistenttree_version(&layout, NULL, 0);
+}
+
+void persistenttree_destroy(PersistentTree *tree) {
+    if (tree != NULL) {
+        persistentnode_release(tree, tree->root);
+
+        container_base_destroy_if_dynamic(tree->key_base);
+        container_base_destroy_if_dynamic(tree->value_base);
+    }
+
+    FREE(tree);
+}
+
+PersistentTree *persistenttree_copy(PersistentTree *other) {
+    if (other == NULL)
+        return NULL;
+
+    return persistenttree_version(other, persistentnode_ref(other->root), other->size);
+}
+
+Iterator persistenttree_begin(PersistentTree *tree) {
+    PersistentNode *node = tree->root;
+
+    if (node == NULL)
+        return NULL;
+
+    while (node->left)
+        node = node->left;
+
+    return node;
+}
+
+Iterator persistenttree_next(PersistentTree *tree, Iterator it) {
+    if (it == NULL)
+        return NULL;
+
+    const void *key = persistententry_key(tree, ((PersistentNode *) it)->entry);
+    PersistentNode *node = tree->root, *successor = NULL;
+
+    /* Nodes have no parent pointers, since they can have many parents, so search from the root */
+    while (node) {
+        if (tree->key_base->compare(key, persistententry_key(tree, node->entry)) < 0) {
+            successor = node;
+            node = node->left;
+        } else
+            node = node->right;
+    }
+
+    return successor;
+}
+
+const void *persistenttree_key_of(PersistentTree *tree, Iterator it) {
+    return persistententry_key(tree, ((PersistentNode *) it)->entry);
+}
+
+const void *persistenttree_value_of(PersistentTree *tree, Iterator it) {
+    return persistententry_value(tree, ((PersistentNode *) it)->entry);
+}
+
+Iterator persistenttree_find(PersistentTree *tree, const void *key) {
+    PersistentNode *node = tree->root;
+
+    while (node) {
+        const int cmp = tree->key_base->compare(key, persistententry_key(tree, node->entry));
+
+        if (cmp < 0)
+            node = node->left;
+        else if (cmp > 0)
+            node = node->right;
+        else
+            return node;
+    }
+
+    return NULL;
+}
+
+static PersistentTree *persistenttree_insert_helper(PersistentTree *tree, const void *key, void *value, int copy_value) {
+    PersistentEntry *entry = persistententry_alloc(tree, key, value, copy_value);
+    if (entry == NULL) {
+        if (!copy_value)
+            persistenttree_discard_moved(tree->value_base, value);
+
+        return NULL;
+    }
+
+    int added = 0, err = 0;
+    PersistentNode *root = persistentnode_insert(tree, tree->root, entry, &added, &err);
+    if (err)
+        return NULL;
+
+    return persistenttree_version(tree, root, tree->size + added);
+}
+
+PersistentTree *persistenttree_insert_copy_key(PersistentTree *tree, const void *key, void *value) {
+    return persistenttree_insert_helper(tree, key, value, 0);
+}
+
+PersistentTree *persistenttree_insert_copy(PersistentTree *tree, const void *key, const void *value) {
+    return persistenttree_insert_helper(tree, key, (void *) value, 1);
+}
+
+PersistentTree *persistenttree_delete(PersistentTree *tree, const void *key) {
+    if (persistenttree_find(tree, key) == NULL)
+        return persistenttree_copy(tree);
+
+    int err = 0;
+    PersistentNode *root = persistentnode_delete(tree, tree->root, key, &err);
+    if (err)
+        return NULL;
+
+    return persistenttree_version(tree, root, tree->size - 1);
+}
+
+size_t persistenttree_size(PersistentTree *tree) {
+    return tree->size;
+}
+
+const CommonContainerBase *persistenttree_get_key_container_base(const PersistentTree *tree) {
+    return tree->key_base;
+}
+
+const CommonContainerBase *persistenttree_get_value_container_base(const PersistentTree *tree) {
+    return tree->value_base;
+}
@@ -0,0 +1,47 @@
+/** @file
+ *
+ *  @author Oliver Adams
+ *  @copyright Copyright (C) 2020
+ */
+
+#ifndef PERSISTENTTREE_H
+#define PERSISTENTTREE_H
+
+#include "../common.h"
+
+/* Persistent (immutable) ordered map, implemented as a path-copying AVL tree.
+ *
+ * A PersistentTree is one version of the map, and is never modified after it is created.
+ * Inserting or deleting returns a new version that shares every node not on the path to the changed key with the old version,
+ * so updates and snapshots cost O(log n) instead of O(n). Nodes and elements are reference counted atomically,
+ * so each version can be read, copied, and destroyed on any thread without locks, independently of the other versions.
+ *
+ * Keys and values are stored with the same recipe rules as the other containers. Since values may be shared with other versions,
+ * they must not be modified in place; insert a new value instead.
+ */
+struct PersistentTree;
+
+struct PersistentTree *persistenttree_create(const CommonContainerBase *key_base, const CommonContainerBase *value_base);
+void persistenttree_destroy(struct PersistentTree *tree);
+/* Returns another reference to the same version in O(1) time. Both versions must be destroyed */
+struct PersistentTree *persistenttree_copy(struct PersistentTree *other);
+/* Iterators are valid as long as the version they came from.
+ * Advancing an iterator searches from the root, so iterating over the entire map takes O(n log n) time */
+Iterator persistenttree_begin(struct PersistentTree *tree);
+Iterator persistenttree_next(struct PersistentTree *tree, Iterator it);
+const void *persistenttree_key_of(struct PersistentTree *tree, Iterator it);
+const void *persistenttree_value_of(struct PersistentTree *tree, Iterator it);
+Iterator persistenttree_find(struct PersistentTree *tree, const void *key);
+/* Returns a new version with the key copied and the value moved in, replacing any existing value for the key.
+ * Returns NULL if out of memory or the key cannot be copied, in which case the value is destroyed */
+struct PersistentTree *persistenttree_insert_copy_key(struct PersistentTree *tree, const void *key, void *value);
+/* Returns a new version with the key and value copied in, replacing any existing value for the key.
+ * Returns NULL if out of memory or the key or value cannot be copied */
+struct PersistentTree *persistenttree_insert_copy(struct PersistentTree *tree, const void *key, const void *value);
+/* Returns a new version without the key, or NULL if out of memory. If the key is not present, the new version is a copy of @p tree */
+struct PersistentTree *persistenttree_delete(struct PersistentTree *tree, const void *key);
+size_t persistenttree_size(struct PersistentTree *tree);
+const CommonContainerBase *persistenttree_get_key_container_base(const struct PersistentTree *tree);
+const CommonContainerBase *persistenttree_get_value_container_base(const struct PersistentTree *tree);
+
+#endif /* PERSISTENTTREE_H */
@@ -19,6 +19,7 @@ static const CommonContainerBase container_base_empty_recipe_ = {
     .deleter = NULL,
     .parse = NULL,
     .serialize = NULL,
+    .hash = NULL,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -46,12 +47,17 @@ static int container_base_voidptr_compare(const void *a, const void *b) {
     return (ia > ib) - (ia < ib);
 }
 
+static size_t container_base_voidptr_hash(const void *p) {
+    return (size_t) (uintptr_t) p;
+}
+
 static const CommonContainerBase container_base_voidptr_recipe_ = {
     .copier = generic_identitycopy,
     .compare = container_base_voidptr_compare,
     .deleter = NULL,
     .parse = NULL,
     .serialize = NULL,
+    .hash = container_base_voidptr_hash,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -80,12 +86,17 @@ int container_base_compare_boolean(const _Bool *a, const _Bool *b) {
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_boolean(const _Bool *v) {
+    return (size_t) *v;
+}
+
 static const CommonContainerBase container_base_boolean_recipe_ = {
     .copier = (Copier) container_base_copy_boolean,
     .compare = (Compare) container_base_compare_boolean,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_boolean,
+    .hash = (Hasher) container_base_hash_boolean,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -114,12 +125,17 @@ int container_base_compare_char(const signed char *a, const signed char *b) {
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_char(const signed char *v) {
+    return (size_t) *v;
+}
+
 static const CommonContainerBase container_base_char_recipe_ = {
     .copier = (Copier) container_base_copy_char,
     .compare = (Compare) container_base_compare_char,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_char,
+    .hash = (Hasher) container_base_hash_char,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -148,12 +164,17 @@ int container_base_compare_uchar(const unsigned char *a, const unsigned char *b)
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_uchar(const unsigned char *v) {
+    return (size_t) *v;
+}
+
 static const CommonContainerBase container_base_uchar_recipe_ = {
     .copier = (Copier) container_base_copy_uchar,
     .compare = (Compare) container_base_compare_uchar,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_char,
+    .hash = (Hasher) container_base_hash_uchar,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -182,12 +203,17 @@ int container_base_compare_short(const signed short *a, const signed short *b) {
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_short(const signed short *v) {
+    return (size_t) *v;
+}
+
 static const CommonContainerBase container_base_short_recipe_ = {
     .copier = (Copier) container_base_copy_short,
     .compare = (Compare) container_base_compare_short,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_short,
+    .hash = (Hasher) container_base_hash_short,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -216,12 +242,17 @@ int container_base_compare_ushort(const unsigned short *a, const unsigned short
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_ushort(const unsigned short *v) {
+    return (size_t) *v;
+}
+
 static const CommonContainerBase container_base_ushort_recipe_ = {
     .copier = (Copier) container_base_copy_ushort,
     .compare = (Compare) container_base_compare_ushort,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_ushort,
+    .hash = (Hasher) container_base_hash_ushort,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -250,12 +281,17 @@ int container_base_compare_int(const int *a, const int *b) {
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_int(const int *v) {
+    return (size_t) *v;
+}
+
 static const CommonContainerBase container_base_int_recipe_ = {
     .copier = (Copier) container_base_copy_int,
     .compare = (Compare) container_base_compare_int,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_int,
+    .hash = (Hasher) container_base_hash_int,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -284,12 +320,17 @@ int container_base_compare_uint(const unsigned int *a, const unsigned int *b) {
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_uint(const unsigned int *v) {
+    return (size_t) *v;
+}
+
 static const CommonContainerBase container_base_uint_recipe_ = {
     .copier = (Copier) container_base_copy_uint,
     .compare = (Compare) container_base_compare_uint,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_uint,
+    .hash = (Hasher) container_base_hash_uint,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -318,12 +359,17 @@ int container_base_compare_long(const long *a, const long *b) {
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_long(const long *v) {
+    return (size_t) *v;
+}
+
 static const CommonContainerBase container_base_long_recipe_ = {
     .copier = (Copier) container_base_copy_long,
     .compare = (Compare) container_base_compare_long,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_long,
+    .hash = (Hasher) container_base_hash_long,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -352,12 +398,17 @@ int container_base_compare_ulong(const unsigned long *a, const unsigned long *b)
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_ulong(const unsigned long *v) {
+    return (size_t) *v;
+}
+
 static const CommonContainerBase container_base_ulong_recipe_ = {
     .copier = (Copier) container_base_copy_ulong,
     .compare = (Compare) container_base_compare_ulong,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_ulong,
+    .hash = (Hasher) container_base_hash_ulong,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -386,12 +437,19 @@ int container_base_compare_long_long(const long long *a, const long long *b) {
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_long_long(const long long *v) {
+    unsigned long long value = *v;
+
+    return (size_t) (value ^ (value >> 16 >> 16));
+}
+
 static const CommonContainerBase container_base_long_long_recipe_ = {
     .copier = (Copier) container_base_copy_long_long,
     .compare = (Compare) container_base_compare_long_long,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_long_long,
+    .hash = (Hasher) container_base_hash_long_long,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -420,12 +478,19 @@ int container_base_compare_ulong_long(const unsigned long long *a, const unsigne
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_ulong_long(const unsigned long long *v) {
+    unsigned long long value = *v;
+
+    return (size_t) (value ^ (value >> 16 >> 16));
+}
+
 static const CommonContainerBase container_base_ulong_long_recipe_ = {
     .copier = (Copier) container_base_copy_ulong_long,
     .compare = (Compare) container_base_compare_ulong_long,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_ulong_long,
+    .hash = (Hasher) container_base_hash_ulong_long,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -454,12 +519,17 @@ int container_base_compare_size_t(const size_t *a, const size_t *b) {
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_size_t(const size_t *v) {
+    return (size_t) *v;
+}
+
 static const CommonContainerBase container_base_size_t_recipe_ = {
     .copier = (Copier) container_base_copy_size_t,
     .compare = (Compare) container_base_compare_size_t,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_size_t,
+    .hash = (Hasher) container_base_hash_size_t,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -488,12 +558,21 @@ int container_base_compare_float(const float *a, const float *b) {
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_float(const float *v) {
+    float value = *v;
+    if (value == 0) /* Positive and negative zero compare equal */
+        value = 0;
+
+    return generic_hash_bytes(&value, sizeof(value));
+}
+
 static const CommonContainerBase container_base_float_recipe_ = {
     .copier = (Copier) container_base_copy_float,
     .compare = (Compare) container_base_compare_float,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_float,
+    .hash = (Hasher) container_base_hash_float,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -522,12 +601,21 @@ int container_base_compare_double(const double *a, const double *b) {
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_double(const double *v) {
+    double value = *v;
+    if (value == 0) /* Positive and negative zero compare equal */
+        value = 0;
+
+    return generic_hash_bytes(&value, sizeof(value));
+}
+
 static const CommonContainerBase container_base_double_recipe_ = {
     .copier = (Copier) container_base_copy_double,
     .compare = (Compare) container_base_compare_double,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_double,
+    .hash = (Hasher) container_base_hash_double,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -556,12 +644,22 @@ int container_base_compare_long_double(const long double *a, const long double *
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_long_double(const long double *v) {
+    /* Hash as a double, since the padding bytes of a long double are unspecified */
+    double value = (double) *v;
+    if (value == 0) /* Positive and negative zero compare equal */
+        value = 0;
+
+    return generic_hash_bytes(&value, sizeof(value));
+}
+
 static const CommonContainerBase container_base_long_double_recipe_ = {
     .copier = (Copier) container_base_copy_long_double,
     .compare = (Compare) container_base_compare_long_double,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_long_double,
+    .hash = (Hasher) container_base_hash_long_double,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -590,12 +688,17 @@ int container_base_compare_clock_t(const clock_t *a, const clock_t *b) {
     return (*a > *b) - (*a < *b);
 }
 
+size_t container_base_hash_clock_t(const clock_t *v) {
+    return generic_hash_bytes(v, sizeof(*v));
+}
+
 static const CommonContainerBase container_base_clock_t_recipe_ = {
     .copier = (Copier) container_base_copy_clock_t,
     .compare = (Compare) container_base_compare_clock_t,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_clock_t,
+    .hash = (Hasher) container_base_hash_clock_t,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -642,12 +745,20 @@ int container_base_compare_tm(const struct tm *a, const struct tm *b) {
     return 0;
 }
 
+size_t container_base_hash_tm(const struct tm *v) {
+    /* Only the fields used by container_base_compare_tm() are hashed */
+    const int fields[] = {v->tm_year, v->tm_mon, v->tm_mday, v->tm_hour, v->tm_min, v->tm_sec};
+
+    return generic_hash_bytes(fields, sizeof(fields));
+}
+
 static const CommonContainerBase container_base_tm_recipe_ = {
     .copier = (Copier) container_base_copy_tm,
     .compare = (Compare) container_base_compare_tm,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_tm,
+    .hash = (Hasher) container_base_hash_tm,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -668,12 +779,21 @@ const CommonContainerBase *container_base_tm_recipe(void) {
     return &container_base_tm_recipe_;
 }
 
+static size_t container_base_cstring_hash(const char *s) {
+    return generic_hash_bytes(s, strlen(s));
+}
+
+static size_t container_base_binary_hash(const Binary *b) {
+    return generic_hash_bytes(b->data, b->length);
+}
+
 static const CommonContainerBase container_base_cstring_recipe_ = {
     .copier = (Copier) strdup_alloc,
     .compare = (Compare) strcmp,
     .deleter = (Deleter) FREE,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_cstring,
+    .hash = (Hasher) container_base_cstring_hash,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -699,6 +819,7 @@ static const CommonContainerBase container_base_binary_recipe_ = {
     .deleter = (Deleter) binary_destroy,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_binary,
+    .hash = (Hasher) container_base_binary_hash,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -718,12 +839,40 @@ const CommonContainerBase *container_base_binary_recipe(void) {
     return &container_base_binary_recipe_;
 }
 
+/* Slices compare, hash, and serialize like the Binary objects they start with */
+static const CommonContainerBase container_base_binary_slice_recipe_ = {
+    .copier = (Copier) binary_slice_copy,
+    .compare = (Compare) binary_compare,
+    .deleter = (Deleter) binary_slice_destroy,
+    .parse = NULL,
+    .serialize = (Serializer) io_serialize_binary,
+    .hash = (Hasher) container_base_binary_hash,
+    .collection_create = {0},
+    .collection_size = NULL,
+    .collection_begin = NULL,
+    .collection_next = NULL,
+    .collection_get_key = NULL,
+    .collection_get_value = NULL,
+    .collection_find = {0},
+    .collection_insert = {0},
+    .collection_erase = NULL,
+    .collection_replace = NULL,
+    .dynamic = 0,
+    .key_child = NULL,
+    .value_child = NULL
+};
+
+const CommonContainerBase *container_base_binary_slice_recipe(void) {
+    return &container_base_binary_slice_recipe_;
+}
+
 static const CommonContainerBase container_base_variant_recipe_ = {
     .copier = (Copier) variant_copy,
     .compare = (Compare) variant_compare,
     .deleter = (Deleter) variant_destroy,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_variant,
+    .hash = NULL,
     .collection_create = {0},
     .collection_size = NULL,
     .collection_begin = NULL,
@@ -758,6 +907,7 @@ static const CommonContainerBase container_base_genericlist_recipe_ = {
     .deleter = (Deleter) genericlist_destroy,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_utf8,
+    .hash = NULL,
     .collection_create.list = (CollectionCreateList) genericlist_create,
     .collection_size = (CollectionSize) genericlist_size,
     .collection_begin = (CollectionBegin) genericlist_begin,
@@ -793,6 +943,7 @@ static const CommonContainerBase container_base_genericmap_recipe_ = {
     .deleter = (Deleter) genericmap_destroy,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_utf8,
+    .hash = NULL,
     .collection_create.key_value = (CollectionCreateKeyValue) genericmap_create,
     .collection_size = (CollectionSize) genericmap_size,
     .collection_begin = (CollectionBegin) genericmap_begin,
@@ -845,6 +996,7 @@ static const CommonContainerBase container_base_genericset_recipe_ = {
     .deleter = (Deleter) genericset_destroy,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_utf8,
+    .hash = NULL,
     .collection_create.list = (CollectionCreateList) genericset_create,
     .collection_size = (CollectionSize) genericset_size,
     .collection_begin = (CollectionBegin) genericset_begin,
@@ -879,9 +1031,10 @@ static Iterator genericlinkedlist_collection_erase(GenericLinkedList list, Itera
         return NULL;
     }
 
-    Iterator next = genericlinkedlist_next(list, it);
-    genericlinkedlist_remove_after(list, genericlinkedlist_previous(list, it));
-    return next;
+    /* The following element may move when this one is removed from an unrolled list, so find it afterwards */
+    Iterator prior = genericlinkedlist_previous(list, it);
+    genericlinkedlist_remove_after(list, prior);
+    return prior? genericlinkedlist_next(list, prior): genericlinkedlist_begin(list);
 }
 
 static const CommonContainerBase container_base_genericlinkedlist_recipe_ = {
@@ -890,6 +1043,7 @@ static const CommonContainerBase container_base_genericlinkedlist_recipe_ = {
     .deleter = (Deleter) genericlinkedlist_destroy,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_utf8,
+    .hash = NULL,
     .collection_create.list = (CollectionCreateList) genericlinkedlist_create,
     .collection_size = (CollectionSize) genericlinkedlist_size,
     .collection_begin = (CollectionBegin) genericlinkedlist_begin,
@@ -916,6 +1070,7 @@ static const CommonContainerBase container_base_variantlist_recipe_ = {
     .deleter = (Deleter) genericlist_destroy,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_utf8,
+    .hash = NULL,
     .collection_create = {0},
     .collection_size = (CollectionSize) genericlist_size,
     .collection_begin = (CollectionBegin) genericlist_begin,
@@ -942,6 +1097,7 @@ static const CommonContainerBase container_base_variantmap_recipe_ = {
     .deleter = (Deleter) genericmap_destroy,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_utf8,
+    .hash = NULL,
     .collection_create = {0},
     .collection_size = (CollectionSize) genericmap_size,
     .collection_begin = (CollectionBegin) genericmap_begin,
@@ -967,6 +1123,7 @@ static const CommonContainerBase container_base_variantset_recipe_ = {
     .deleter = (Deleter) genericset_destroy,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_utf8,
+    .hash = NULL,
     .collection_create = {0},
     .collection_size = (CollectionSize) genericset_size,
     .collection_begin = (CollectionBegin) genericset_begin,
@@ -993,6 +1150,7 @@ static const CommonContainerBase container_base_stringlist_recipe_ = {
     .deleter = (Deleter) stringlist_destroy,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_utf8,
+    .hash = NULL,
     .collection_create = {0},
     .collection_size = (CollectionSize) stringlist_size,
     .collection_begin = (CollectionBegin) stringlist_begin,
@@ -1019,6 +1177,7 @@ static const CommonContainerBase container_base_stringmap_recipe_ = {
     .deleter = (Deleter) stringmap_destroy,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_utf8,
+    .hash = NULL,
     .collection_create = {0},
     .collection_size = (CollectionSize) stringmap_size,
     .collection_begin = (CollectionBegin) stringmap_begin,
@@ -1044,6 +1203,7 @@ static const CommonContainerBase container_base_stringset_recipe_ = {
     .deleter = (Deleter) stringset_destroy,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_utf8,
+    .hash = NULL,
     .collection_create = {0},
     .collection_size = (CollectionSize) stringset_size,
     .collection_begin = (CollectionBegin) stringset_begin,
@@ -1070,6 +1230,7 @@ static const CommonContainerBase container_base_binarylist_recipe_ = {
     .deleter = (Deleter) genericlist_destroy,
     .parse = NULL,
     .serialize = (Serializer) io_serialize_utf8,
+    .hash = NULL,
     .collection_create = {0},
     .collection_size = (CollectionSize) genericlist_size,
     .collection_begin = (CollectionBegin) genericlist_begin,
@@ -28,6 +28,7 @@ const CommonContainerBase *container_base_double_recipe(void);
 const CommonContainerBase *container_base_long_double_recipe(void);
 const CommonContainerBase *container_base_cstring_recipe(void);
 const CommonContainerBase *container_base_binary_recipe(void);
+const CommonContainerBase *container_base_binary_slice_recipe(void);
 const CommonContainerBase *container_base_variant_recipe(void);
 
 const CommonContainerBase *container_base_clock_t_recipe(void);
@@ -51,6 +51,28 @@ StringList stringlist_create_reserve(size_t reserve, const CommonContainerBase *
                                                             base: container_base_cstring_recipe());
 }
 
+StringList stringlist_create_packed() {
+    return (StringList) genericlist_create_packed(0, container_base_cstring_recipe());
+}
+
+/* Allocates a copy of the first `item_len` characters of `item`, from the list's arena if it is packed */
+static char *stringlist_duplicate_n(StringList list, const char *item, size_t item_len) {
+    char *duplicate = genericlist_is_packed((GenericList) list)? genericlist_packed_alloc((GenericList) list, item_len+1): MALLOC(item_len+1);
+    if (!duplicate)
+        return NULL;
+
+    memcpy(duplicate, item, item_len);
+    duplicate[item_len] = 0;
+
+    return duplicate;
+}
+
+/* Releases a duplicate that could not be added to the list. Arena storage is released with the arena */
+static void stringlist_discard_duplicate(StringList list, char *duplicate) {
+    if (!genericlist_is_packed((GenericList) list))
+        FREE(duplicate);
+}
+
 StringList stringlist_concatenate(StringList left, StringList right) {
     return (StringList) genericlist_concatenate((GenericList) left, (GenericList) right);
 }
@@ -58,7 +80,7 @@ StringList stringlist_concatenate(StringList left, StringList right) {
 StringList stringlist_split(const char *string, const char *separator, int keep_empty) {
     int done = 0;
     size_t separator_len = strlen(separator);
-    StringList list = stringlist_create();
+    StringList list = stringlist_create_packed();
     if (!list)
         return NULL;
 
@@ -104,10 +126,12 @@ StringList stringlist_divide(const char *string, size_t record_size, int keep_pa
 
     size_t records = record_size? len / record_size: 0;
     size_t partial_size = len - records * record_size;
-    StringList list = stringlist_create_reserve(records + !!partial_size, container_base_cstring_recipe());
+    StringList list = stringlist_create_packed();
     if (!list)
         return NULL;
 
+    stringlist_reserve(list, records + !!partial_size);
+
     if (record_size == 0 || record_size >= len) { /* Add entire string as item */
         if (stringlist_append(list, string))
             goto cleanup;
@@ -216,6 +240,9 @@ int stringlist_append_move(StringList list, char *item) {
 }
 
 int stringlist_append(StringList list, const char *item) {
+    if (item != NULL && genericlist_is_packed((GenericList) list))
+        return stringlist_append_n(list, item, strlen(item));
+
     return genericlist_append((GenericList) list, item);
 }
 
@@ -223,19 +250,13 @@ int stringlist_append_n(StringList list, const char *item, size_t item_len) {
     if (memchr(item, 0, item_len) != NULL)
         return CC_EINVAL;
 
-    /* Allocate duplicate */
-    char *duplicate = MALLOC(item_len+1);
+    char *duplicate = stringlist_duplicate_n(list, item, item_len);
     if (!duplicate)
         return CC_ENOMEM;
 
     int err = genericlist_append_move((GenericList) list, duplicate);
     if (err)
-        FREE(duplicate);
-    else {
-        /* Copy string */
-        memcpy(duplicate, item, item_len);
-        duplicate[item_len] = 0;
-    }
+        stringlist_discard_duplicate(list, duplicate);
 
     return err;
 }
@@ -249,6 +270,9 @@ int stringlist_insert_move(StringList list, char *item, size_t before_index) {
 }
 
 int stringlist_insert(StringList list, const char *item, size_t before_index) {
+    if (item != NULL && genericlist_is_packed((GenericList) list))
+        return stringlist_insert_n(list, item, strlen(item), before_index);
+
     return genericlist_insert((GenericList) list, item, before_index);
 }
 
@@ -256,19 +280,13 @@ int stringlist_insert_n(StringList list, const char *item, size_t item_len, size
     if (memchr(item, 0, item_len) != NULL)
         return CC_EINVAL;
 
-    /* Allocate duplicate */
-    char *duplicate = MALLOC(item_len+1);
+    char *duplicate = stringlist_duplicate_n(list, item, item_len);
     if (!duplicate)
         return CC_ENOMEM;
 
     int err = genericlist_insert_move((GenericList) list, duplicate, before_index);
     if (err)
-        FREE(duplicate);
-    else {
-        /* Copy string */
-        memcpy(duplicate, item, item_len);
-        duplicate[item_len] = 0;
-    }
+        stringlist_discard_duplicate(list, duplicate);
 
     return err;
 }
@@ -363,10 +381,22 @@ int stringlist_stable_sort(StringList list, int descending) {
     return genericlist_stable_sort((GenericList) list, descending);
 }
 
+int stringlist_parallel_sort(StringList list, int descending, size_t threads) {
+    return genericlist_parallel_sort((GenericList) list, descending, threads);
+}
+
+int stringlist_parallel_stable_sort(StringList list, int descending, size_t threads) {
+    return genericlist_parallel_stable_sort((GenericList) list, descending, threads);
+}
+
 void stringlist_reserve(StringList list, size_t size) {
     genericlist_reserve((GenericList) list, size);
 }
 
+int stringlist_shrink_to_fit(StringList list) {
+    return genericlist_shrink_to_fit((GenericList) list);
+}
+
 Iterator stringlist_begin(StringList list) {
     return genericlist_begin((GenericList) list);
 }
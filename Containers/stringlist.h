@@ -18,6 +18,13 @@ int variant_set_stringlist_move(Variant var, StringList list);
 StringList stringlist_create();
 StringList stringlist_create_custom(const CommonContainerBase *base);
 StringList stringlist_create_reserve(size_t reserve, const CommonContainerBase *base);
+/** @brief Creates a packed string list.
+ *
+ * Strings appended or inserted by copy are stored back to back in a few large blocks owned by the list, rather than being allocated one by one.
+ * This makes building and destroying large lists, such as the lines of a file, much cheaper.
+ * Replaced strings and strings added with the move functions are allocated separately as usual, and stringlist_array() works the same as with any other list.
+ */
+StringList stringlist_create_packed();
 StringList stringlist_concatenate(StringList left, StringList right);
 StringList stringlist_from_array(const char **strings);
 StringList stringlist_from_array_n(const char **strings, size_t count);
@@ -55,7 +62,10 @@ StringList stringlist_sorted(StringList list, int descending);
 StringList stringlist_stable_sorted(StringList list, int descending);
 int stringlist_sort(StringList list, int descending);
 int stringlist_stable_sort(StringList list, int descending);
+int stringlist_parallel_sort(StringList list, int descending, size_t threads);
+int stringlist_parallel_stable_sort(StringList list, int descending, size_t threads);
 void stringlist_reserve(StringList list, size_t size);
+int stringlist_shrink_to_fit(StringList list);
 Iterator stringlist_begin(StringList list);
 Iterator stringlist_next(StringList list, Iterator it);
 char *stringlist_value_of(StringList list, Iterator it);
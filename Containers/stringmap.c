@@ -44,6 +44,10 @@ StringMap stringmap_create() {
     return stringmap_create_custom(NULL, NULL);
 }
 
+StringMap stringmap_create_hashed() {
+    return (StringMap) genericmap_create_hashed(container_base_cstring_recipe(), container_base_cstring_recipe());
+}
+
 StringMap stringmap_create_custom(const CommonContainerBase *key_base, const CommonContainerBase *value_base) {
     return (StringMap) genericmap_create(key_base && generic_types_compatible_compare(key_base, container_base_cstring_recipe()) == 0?
                                          key_base: container_base_cstring_recipe(),
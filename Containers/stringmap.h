@@ -15,6 +15,8 @@ StringMap variant_get_stringmap(Variant var);
 int variant_set_stringmap(Variant var, const StringMap map);
 int variant_set_stringmap_move(Variant var, StringMap map);
 StringMap stringmap_create();
+/* Iteration order of a hashed StringMap is unspecified, see genericmap_create_hashed() */
+StringMap stringmap_create_hashed();
 StringMap stringmap_create_custom(const CommonContainerBase *key_base, const CommonContainerBase *value_base);
 StringMap stringmap_copy(StringMap other);
 int stringmap_insert_move(StringMap map, const char *key, char *item);
@@ -48,19 +48,10 @@ StringSet stringset_create_custom(const CommonContainerBase *base) {
 }
 
 StringSet stringset_from_stringlist(StringList list, const CommonContainerBase *base) {
-    StringSet set = stringset_create_custom(base);
-
-    if (set) {
-        char **array = stringlist_array(list);
-        for (size_t i = 0; i < stringlist_size(list); ++i) {
-            if (stringset_add(set, array[i])) {
-                stringset_destroy(set);
-                return NULL;
-            }
-        }
-    }
-
-    return set;
+    if (base == NULL || generic_types_compatible_compare(base, container_base_cstring_recipe()) != 0)
+        base = container_base_cstring_recipe();
+
+    return (StringSet) genericset_from_array_n((const void **) stringlist_array(list), stringlist_size(list), base);
 }
 
 StringSet stringset_copy(StringSet other) {
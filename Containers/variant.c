@@ -12,6 +12,10 @@
 #include <math.h>
 #include <limits.h>
 #include <stdio.h>
+#include <stdarg.h>
+
+/* Strings shorter than this (including binary strings and cached string conversions) are stored inside the variant itself */
+#define VARIANT_SMALL_STRING_SIZE 24
 
 struct VariantStructCustomHelper {
     CommonContainerBase *base;
@@ -33,19 +37,178 @@ struct VariantStruct {
         struct VariantStructCustomHelper custom;
         struct VariantStructAtomHelper atom;
     } d;
+    volatile Atomic *shared; /* Reference count of the allocated string or custom data, if shared with copies of this variant */
     enum VariantType type;
+    char pinned; /* A pointer to the allocated string or custom data was handed out, so the data must stay with this variant and is never shared */
+    char small[VARIANT_SMALL_STRING_SIZE]; /* d.atom.string.data points here if the string is stored inline */
 };
 
-static void variant_clear_to(Variant var, enum VariantType type) {
+/* Fails to compile if VariantStorage is too small to hold a variant */
+typedef char variant_storage_size_check[sizeof(struct VariantStruct) <= sizeof(VariantStorage)? 1: -1];
+
+/* Frees the string of a non-custom variant, if it was allocated */
+static void variant_free_string(Variant var) {
+    if (var->d.atom.string.data != var->small)
+        FREE(var->d.atom.string.data);
+}
+
+/* Drops the variant's reference to its shared data, returning nonzero if this was the last reference or the data was not shared */
+static int variant_unshare(Variant var) {
+    if (var->shared == NULL)
+        return 1;
+
+    const int last = atomic_sub(var->shared, 1) == 1;
+    if (last)
+        FREE((Atomic *) var->shared);
+
+    var->shared = NULL;
+    return last;
+}
+
+/* Frees the string or custom data of the variant, unless it is still shared with another variant */
+static void variant_release(Variant var) {
     if (variant_get_type(var) == VariantCustom) {
-        var->d.custom.base->deleter(var->d.custom.data);
+        if (variant_unshare(var) && var->d.custom.base->deleter)
+            var->d.custom.base->deleter(var->d.custom.data);
+
         container_base_destroy_if_dynamic(var->d.custom.base);
-    } else
-        FREE(var->d.atom.string.data);
+    } else if (variant_unshare(var))
+        variant_free_string(var);
+}
+
+/* Marks the allocated data of the variant as shared, so a copy can refer to it */
+static int variant_share(Variant var) {
+    if (var->shared == NULL) {
+        Atomic *shared = MALLOC(sizeof(*shared));
+        if (shared == NULL)
+            return CC_ENOMEM;
+
+        *shared = 1;
+
+        /* Another thread may be copying the same variant */
+        if (atomicp_cmpxchg((volatile AtomicPointer *) &var->shared, shared, NULL) != NULL)
+            FREE(shared);
+    }
+
+    atomic_add(var->shared, 1);
+
+    return 0;
+}
+
+/* Gives the variant its own copy of any data it shares with other variants, so the data can be modified */
+static int variant_detach(Variant var) {
+    if (var->shared == NULL)
+        return 0;
+    else if (atomic_load(var->shared) == 1) { /* All other copies were already destroyed */
+        variant_unshare(var);
+        return 0;
+    }
+
+    if (variant_get_type(var) == VariantCustom) {
+        void *duplicate = var->d.custom.base->copier(var->d.custom.data);
+        if (duplicate == NULL && var->d.custom.data != NULL)
+            return CC_ENOMEM;
+
+        if (variant_unshare(var) && var->d.custom.base->deleter)
+            var->d.custom.base->deleter(var->d.custom.data);
+
+        var->d.custom.data = duplicate;
+    } else {
+        if (var->d.atom.string.length == 0 && variant_get_type(var) == VariantString)
+            var->d.atom.string.length = strlen(var->d.atom.string.data);
+
+        char *duplicate = MALLOC(var->d.atom.string.length+1);
+        if (duplicate == NULL)
+            return CC_ENOMEM;
+
+        memcpy(duplicate, var->d.atom.string.data, var->d.atom.string.length);
+        duplicate[var->d.atom.string.length] = 0;
+
+        if (variant_unshare(var))
+            variant_free_string(var);
+
+        var->d.atom.string.data = duplicate;
+    }
+
+    return 0;
+}
+
+/* Gives the variant its own copy of any shared data and stops it from being shared again,
+ * so a pointer into the data stays valid until the variant itself is modified */
+static int variant_pin(Variant var) {
+    if (variant_detach(var))
+        return CC_ENOMEM;
+
+    var->pinned = 1;
+    return 0;
+}
+
+static void variant_clear_to(Variant var, enum VariantType type) {
+    variant_release(var);
 
     var->d.atom.string.data = NULL;
     var->d.atom.string.length = 0;
     var->type = type;
+    var->pinned = 0;
+}
+
+/* Clears the variant to `type` and stores a copy of the string `value`, inline if it is short enough.
+ * `value` may point into the variant's current string */
+static int variant_store_string(Variant var, const char *value, size_t value_len, enum VariantType type) {
+    if (value_len < VARIANT_SMALL_STRING_SIZE) {
+        char temp[VARIANT_SMALL_STRING_SIZE];
+
+        memcpy(temp, value, value_len);
+        variant_clear_to(var, type);
+        memcpy(var->small, temp, value_len);
+        var->small[value_len] = 0;
+        var->d.atom.string.data = var->small;
+    } else {
+        char *duplicate = MALLOC(value_len+1);
+        if (duplicate == NULL)
+            return CC_ENOMEM;
+
+        memcpy(duplicate, value, value_len);
+        duplicate[value_len] = 0;
+        variant_clear_to(var, type);
+        var->d.atom.string.data = duplicate;
+    }
+
+    var->d.atom.string.length = value_len;
+
+    return 0;
+}
+
+/* Formats a string conversion of the variant, in the inline buffer if it fits */
+static char *variant_format_string(Variant var, const char *fmt, ...) {
+    va_list args, args_copy;
+    char *string = var->small;
+
+    va_start(args, fmt);
+    va_copy(args_copy, args);
+
+    int len = vsnprintf(var->small, sizeof(var->small), fmt, args);
+    if (len < 0)
+        string = NULL;
+    else if ((size_t) len >= sizeof(var->small)) {
+        string = MALLOC(len+1);
+        if (string)
+            vsnprintf(string, len+1, fmt, args_copy);
+    }
+
+    va_end(args_copy);
+    va_end(args);
+
+    return string;
+}
+
+Variant variant_init(VariantStorage *storage) {
+    Variant var = (Variant) storage;
+
+    memset(var, 0, sizeof(*var));
+    var->type = VariantUndefined;
+
+    return var;
 }
 
 Variant variant_create_undefined() {
@@ -121,51 +284,46 @@ Variant variant_create_float(double value) {
 }
 
 Variant variant_create_string_move(char *value) {
-    Variant var = CALLOC(sizeof(*var), 1);
+    Variant var = variant_create_undefined();
     if (var == NULL)
         return NULL;
 
-    var->type = VariantString;
-    var->d.atom.string.data = value;
+    variant_set_string_move(var, value);
 
     return var;
 }
 
 Variant variant_create_string(const char *value) {
-    char *duplicate = strdup_alloc(value);
-    if (duplicate == NULL)
+    Variant var = variant_create_undefined();
+    if (var == NULL)
         return NULL;
 
-    Variant var = variant_create_string_move(duplicate);
-    if (var == NULL)
-        FREE(duplicate);
+    if (variant_set_string(var, value)) {
+        variant_destroy(var);
+        return NULL;
+    }
 
     return var;
 }
 
 Variant variant_create_binary_string_move(char *value, size_t value_len) {
-    Variant var = CALLOC(sizeof(*var), 1);
+    Variant var = variant_create_undefined();
     if (var == NULL)
         return NULL;
 
-    var->type = VariantBinary;
-    var->d.atom.string.data = value;
-    var->d.atom.string.length = value_len;
+    variant_set_binary_string_move(var, value, value_len);
 
     return var;
 }
 
 Variant variant_create_binary_string(const char *value, size_t value_len) {
-    char *duplicate = MALLOC(value_len+1);
-    if (duplicate == NULL)
+    Variant var = variant_create_undefined();
+    if (var == NULL)
         return NULL;
 
-    Variant var = variant_create_binary_string_move(duplicate, value_len);
-    if (var == NULL)
-        FREE(duplicate);
-    else {
-        memcpy(duplicate, value, value_len);
-        duplicate[value_len] = 0;
+    if (variant_set_binary_string(var, value, value_len)) {
+        variant_destroy(var);
+        return NULL;
     }
 
     return var;
@@ -250,6 +408,30 @@ cleanup:
     return NULL;
 }
 
+/* Creates a copy of the variant that shares its allocated string or custom data */
+static Variant variant_copy_shared(Variant other) {
+    CommonContainerBase *base = NULL;
+
+    if (variant_is_custom(other) && (base = container_base_copy_if_dynamic(other->d.custom.base)) == NULL)
+        return NULL;
+
+    Variant var = variant_create_undefined();
+    if (var == NULL || variant_share(other)) {
+        container_base_destroy_if_dynamic(base);
+        FREE(var);
+        return NULL;
+    }
+
+    var->d = other->d;
+    var->shared = other->shared;
+    var->type = other->type;
+
+    if (base)
+        var->d.custom.base = base;
+
+    return var;
+}
+
 Variant variant_copy(Variant other) {
     switch (variant_get_type(other)) {
         default:
@@ -259,9 +441,21 @@ Variant variant_copy(Variant other) {
         case VariantInteger: return variant_create_int64(variant_get_int64(other));
         case VariantUnsignedInteger: return variant_create_uint64(variant_get_uint64(other));
         case VariantFloat: return variant_create_float(variant_get_float(other));
-        case VariantString: return variant_create_string(variant_get_string(other));
-        case VariantBinary: return variant_create_binary_string_binary(variant_get_binary(other));
-        case VariantCustom: return variant_create_custom(variant_get_custom_data(other), variant_get_custom_container_base(other));
+        case VariantString:
+        case VariantBinary:
+            /* Allocated strings are shared, inline strings are cheaper to copy */
+            if (!other->pinned && other->d.atom.string.data != NULL && other->d.atom.string.data != other->small)
+                return variant_copy_shared(other);
+
+            return variant_get_type(other) == VariantString? variant_create_string(other->d.atom.string.data):
+                                                              variant_create_binary_string_binary(other->d.atom.string);
+        case VariantCustom:
+            if (other->d.custom.base->copier == NULL) /* Needed to detach the copy later */
+                return NULL;
+            else if (other->pinned)
+                return variant_create_custom(other->d.custom.data, other->d.custom.base);
+
+            return variant_copy_shared(other);
     }
 }
 
@@ -421,6 +615,14 @@ int variant_set_float(Variant var, double value) {
 }
 
 int variant_set_string_move(Variant var, char *value) {
+    /* Short strings are copied inline so the allocation can be released now */
+    const char *end = value? memchr(value, 0, VARIANT_SMALL_STRING_SIZE): NULL;
+    if (end) {
+        variant_store_string(var, value, end - value, VariantString);
+        FREE(value);
+        return 0;
+    }
+
     variant_clear_to(var, VariantString);
 
     var->d.atom.string.data = value;
@@ -430,18 +632,16 @@ int variant_set_string_move(Variant var, char *value) {
 }
 
 int variant_set_string(Variant var, const char *value) {
-    char *duplicate = strdup_alloc(value);
-    if (duplicate == NULL)
-        return CC_ENOMEM;
-
-    int err = variant_set_string_move(var, duplicate);
-    if (err)
-        FREE(duplicate);
-
-    return err;
+    return variant_store_string(var, value, strlen(value), VariantString);
 }
 
 int variant_set_binary_string_move(Variant var, char *value, size_t value_len) {
+    if (value && value_len < VARIANT_SMALL_STRING_SIZE) {
+        variant_store_string(var, value, value_len, VariantBinary);
+        FREE(value);
+        return 0;
+    }
+
     variant_clear_to(var, VariantBinary);
 
     var->d.atom.string.data = value;
@@ -455,19 +655,7 @@ int variant_set_binary_string_binary_move(Variant var, Binary value) {
 }
 
 int variant_set_binary_string(Variant var, const char *value, size_t value_len) {
-    char *duplicate = MALLOC(value_len+1);
-    if (duplicate == NULL)
-        return CC_ENOMEM;
-
-    int err = variant_set_binary_string_move(var, duplicate, value_len);
-    if (err)
-        FREE(duplicate);
-    else {
-        memcpy(duplicate, value, value_len);
-        duplicate[value_len] = 0;
-    }
-
-    return err;
+    return variant_store_string(var, value, value_len, VariantBinary);
 }
 
 int variant_set_binary_string_binary(Variant var, const Binary value) {
@@ -555,6 +743,12 @@ int variant_set_variant_move(Variant var, Variant other) {
     *var = *other;
     *other = tempstruct;
 
+    /* Inline strings must point into the variant they were moved to */
+    if (var->type != VariantCustom && var->d.atom.string.data == other->small)
+        var->d.atom.string.data = var->small;
+    if (other->type != VariantCustom && other->d.atom.string.data == var->small)
+        other->d.atom.string.data = other->small;
+
     variant_destroy(other);
     return 0;
 }
@@ -602,14 +796,14 @@ double variant_get_float(Variant var) {
 }
 
 char *variant_get_string(Variant var) {
-    if (!variant_is_string(var))
+    if (!variant_is_string(var) || variant_pin(var))
         return NULL;
 
     return var->d.atom.string.data;
 }
 
 Binary variant_get_binary(Variant var) {
-    if (!variant_is_binary(var)) {
+    if (!variant_is_binary(var) || variant_pin(var)) {
         Binary temp = {.data = NULL, .length = 0};
         return temp;
     }
@@ -618,14 +812,21 @@ Binary variant_get_binary(Variant var) {
 }
 
 void *variant_get_custom_data(Variant var) {
-    if (!variant_is_custom(var))
+    if (!variant_is_custom(var) || variant_pin(var))
+        return NULL;
+
+    return var->d.custom.data;
+}
+
+const void *variant_peek_custom_data(Variant var) {
+    if (!variant_is_custom(var) || variant_pin(var))
         return NULL;
 
     return var->d.custom.data;
 }
 
 void *variant_take_custom_data(Variant var) {
-    if (!variant_is_custom(var))
+    if (!variant_is_custom(var) || variant_detach(var))
         return NULL;
 
     void *custom = var->d.custom.data;
@@ -859,6 +1060,10 @@ const char *variant_to_string(Variant var, int *error) {
         if (error)
             *error = CC_ENOTSUP;
         return NULL;
+    } else if (variant_pin(var)) {
+        if (error)
+            *error = CC_ENOMEM;
+        return NULL;
     }
 
     if (var->d.atom.string.data)
@@ -867,41 +1072,27 @@ const char *variant_to_string(Variant var, int *error) {
     char *string = NULL;
     switch (variant_get_type(var)) {
         default:
-        case VariantNull: string = strdup_alloc(""); break;
-        case VariantBoolean: string = strdup_alloc(var->d.atom.d.boolean? "true": "false"); break;
-        case VariantInteger: {
+        case VariantNull: string = variant_format_string(var, ""); break;
+        case VariantBoolean: string = variant_format_string(var, "%s", var->d.atom.d.boolean? "true": "false"); break;
+        case VariantInteger:
             /* Silence some warnings with using the wrong (standard!) format */
 #if WINDOWS_OS && (MSVC_COMPILER | CLANG_COMPILER | GCC_COMPILER)
 # define VARIANT_TO_STRING_FP_FORMAT "%I64d"
 #else
 # define VARIANT_TO_STRING_FP_FORMAT "%lld"
 #endif
-            size_t len = snprintf(NULL, 0, VARIANT_TO_STRING_FP_FORMAT, var->d.atom.d.integer);
-            string = MALLOC(len+1);
-            if (string)
-                snprintf(string, len+1, VARIANT_TO_STRING_FP_FORMAT, var->d.atom.d.integer);
+            string = variant_format_string(var, VARIANT_TO_STRING_FP_FORMAT, var->d.atom.d.integer);
             break;
-        }
-        case VariantUnsignedInteger: {
+        case VariantUnsignedInteger:
             /* Silence some warnings with using the wrong (standard!) format */
 #if WINDOWS_OS && (MSVC_COMPILER | CLANG_COMPILER | GCC_COMPILER)
 # define VARIANT_UNSIGNED_TO_STRING_FP_FORMAT "%I64u"
 #else
 # define VARIANT_UNSIGNED_TO_STRING_FP_FORMAT "%llu"
 #endif
-            size_t len = snprintf(NULL, 0, VARIANT_UNSIGNED_TO_STRING_FP_FORMAT, var->d.atom.d.integer);
-            string = MALLOC(len+1);
-            if (string)
-                snprintf(string, len+1, VARIANT_UNSIGNED_TO_STRING_FP_FORMAT, var->d.atom.d.integer);
+            string = variant_format_string(var, VARIANT_UNSIGNED_TO_STRING_FP_FORMAT, var->d.atom.d.unsigned_integer);
             break;
-        }
-        case VariantFloat: {
-            size_t len = snprintf(NULL, 0, "%.*g", DBL_DIG-1, var->d.atom.d.floating);
-            string = MALLOC(len+1);
-            if (string)
-                snprintf(string, len+1, "%.*g", DBL_DIG-1, var->d.atom.d.floating);
-            break;
-        }
+        case VariantFloat: string = variant_format_string(var, "%.*g", DBL_DIG-1, var->d.atom.d.floating); break;
     }
 
     if (error && string == NULL)
@@ -917,6 +1108,11 @@ Binary variant_to_binary(Variant var, int *error) {
             *error = CC_ENOTSUP;
         Binary temp = {.data = NULL, .length = 0};
         return temp;
+    } else if (variant_pin(var)) {
+        if (error)
+            *error = CC_ENOMEM;
+        Binary temp = {.data = NULL, .length = 0};
+        return temp;
     }
 
     if (variant_is_string(var)) {
@@ -939,15 +1135,7 @@ void variant_clear(Variant var) {
 
 void variant_destroy(Variant var) {
     if (var) {
-        if (variant_get_type(var) == VariantCustom) {
-            if (var->d.custom.base->deleter)
-                var->d.custom.base->deleter(var->d.custom.data);
-
-            container_base_destroy_if_dynamic(var->d.custom.base);
-        } else {
-            FREE(var->d.atom.string.data);
-        }
-
+        variant_release(var);
         FREE(var);
     }
 }
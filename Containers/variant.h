@@ -21,6 +21,26 @@ enum VariantType {
     VariantCustom
 };
 
+/** @brief Storage for a variant that is not allocated by the library
+ *
+ * Variants can be constructed on the stack or in an arena by passing storage of this type to variant_init().
+ * Such variants must be cleared with variant_clear() instead of being destroyed, and must not be passed as the source of variant_set_variant_move().
+ */
+typedef union VariantStorage {
+    unsigned char data[64];
+    long long align_integer;
+    long double align_float;
+    void *align_pointer;
+} VariantStorage;
+
+/** @brief Constructs an undefined variant in caller-provided storage
+ *
+ * Strings shorter than 24 bytes are stored inside the variant, so short string variants need no allocation at all.
+ *
+ * @param storage The storage to construct the variant in. The variant is only valid as long as @p storage is.
+ * @return The new variant, which refers to @p storage.
+ */
+Variant variant_init(VariantStorage *storage);
 Variant variant_create_undefined();
 Variant variant_create_null();
 Variant variant_create_boolean(int b);
@@ -40,6 +60,18 @@ Variant variant_create_custom(const void *item, const CommonContainerBase *base)
 Variant variant_create_custom_move(void *item, const CommonContainerBase *base);
 Variant variant_create_custom_adopt(const void *item, CommonContainerBase *base_to_adopt);
 Variant variant_create_custom_move_adopt(void *item, CommonContainerBase *base_to_adopt);
+/** @brief Copies a variant
+ *
+ * Allocated strings and custom data are not copied, but shared with @p other until either variant is modified or a pointer into the data is needed.
+ * Functions that return a pointer into the data (variant_get_string(), variant_get_binary(), variant_get_custom_data(), variant_peek_custom_data(),
+ * and the `to` conversion functions) first give the variant its own copy if the data is shared, so the pointer stays valid until the variant itself
+ * is modified or destroyed, whatever happens to its copies. From then on the variant is always copied deeply. variant_take_custom_data() also
+ * detaches shared data before removing it from the variant.
+ * Shared data is reference counted atomically, so copies can be passed to and destroyed by other threads.
+ *
+ * @param other The variant to copy.
+ * @return A copy of @p other, or NULL if an allocation failed or @p other holds custom data that cannot be copied.
+ */
 Variant variant_copy(Variant other);
 int variant_compare(Variant lhs, Variant rhs);
 int variant_is_undefined(Variant var);
@@ -84,6 +116,7 @@ double variant_get_float(Variant var);
 char *variant_get_string(Variant var);
 Binary variant_get_binary(Variant var);
 void *variant_get_custom_data(Variant var);
+const void *variant_peek_custom_data(Variant var); /* Like variant_get_custom_data(), but the data must not be modified */
 void *variant_take_custom_data(Variant var);
 int variant_to_boolean(Variant var, int *error);
 int variant_to_int(Variant var, int *error);
@@ -6,6 +6,7 @@
 
 #include "aes.h"
 #include "../utility.h"
+#include "../seaerror.h"
 
 #include <limits.h>
 #include <stdlib.h>
@@ -14,6 +15,12 @@
 #define AES_COMPILE_SUPPORTS_X86_INTRINSICS
 #endif
 
+/* Number of bytes that can be encrypted or decrypted in one span when writing (must be a multiple of 16) */
+#define AES_SPAN_SIZE 4096
+
+/* Number of independent blocks processed in parallel by the hardware-accelerated span functions */
+#define AES_X86_LANES 8
+
 /** @brief Stores all the information needed for encoding or decoding (but not both) one 16-byte block of AES
  *
  * This structure is not designed to be used by the end-user (nor is it accessible as such), but is designed to be used
@@ -51,6 +58,13 @@ struct AES_ctx {
     /** The callback to do the actual encryption or decryption. The function signature for each is identical. The argument `ctx` is a pointer to this struct. */
     void (*cb)(struct AES_ctx *ctx);
 
+    /** The callback to encrypt or decrypt a contiguous span of @p blocks whole blocks in place.
+     *  Modes that are parallel across blocks may process several blocks at once, all other modes run the existing single-block chain through `cb`. */
+    void (*span_cb)(struct AES_ctx *ctx, unsigned char *data, size_t blocks);
+
+    /** Temporary storage for spans of whole blocks written to the device. */
+    unsigned char span[AES_SPAN_SIZE];
+
     /** Specifies the block-cipher mode of operation, one of `AES_ECB`, `AES_CBC`, `AES_PCBC`, `AES_CFB`, `AES_OFB`, or `AES_CTR` */
     enum AES_Mode mode;
 
@@ -64,6 +78,24 @@ struct AES_ctx {
      *  When reading, `pos` contains the number of bytes read from the state (1-16), 0 means fill the state.
      */
     unsigned char pos;
+
+    /** Specifies whether PKCS #7 padding is applied (encryptor) or removed (decryptor) by this device as well. Only used with `AES_CBC`. */
+    unsigned char pkcs7;
+
+    /** When decrypting with padding, whether `held` contains the most recent plaintext block, which is only released once more data is known to follow. */
+    unsigned char hasHeld;
+
+    /** When reading with padding, whether the final block has been processed. */
+    unsigned char done;
+
+    /** When reading with padding, `tail` contains `tailLength` bytes ready to be read, starting at `tail + tailOffset`. */
+    unsigned char tailOffset, tailLength;
+
+    /** When decrypting with padding, the most recent plaintext block. */
+    unsigned char held[16];
+
+    /** When reading with padding, output data that has not yet been read. */
+    unsigned char tail[16];
 };
 
 static const unsigned char sbox[] = {
@@ -529,6 +561,15 @@ static void AESDecode(struct AES_ctx *ctx) {
     }
 }
 
+/* Processes a span of blocks one at a time through the single-block callback, preserving the chaining state in `ctx` */
+static void AESSpan(struct AES_ctx *ctx, unsigned char *data, size_t blocks) {
+    for (; blocks; --blocks, data += 16) {
+        memcpy(ctx->state, data, 16);
+        ctx->cb(ctx);
+        memcpy(data, ctx->buffer, 16);
+    }
+}
+
 #ifdef AES_COMPILE_SUPPORTS_X86_INTRINSICS
 static __m128i AESEncodeInternal_x86(struct AES_ctx *ctx, __m128i state) {
     state = _mm_xor_si128(state, _mm_loadu_si128(((__m128i *) ctx->expandedKey) + 0));
@@ -668,16 +709,188 @@ static void AESDecode_x86(struct AES_ctx *ctx) {
         }
     }
 }
+
+static void AESEncodeLanes_x86(struct AES_ctx *ctx, __m128i state[AES_X86_LANES]) {
+    __m128i key = _mm_loadu_si128(((__m128i *) ctx->expandedKey) + 0);
+
+    for (int j = 0; j < AES_X86_LANES; ++j)
+        state[j] = _mm_xor_si128(state[j], key);
+
+    for (int i = 1; i < ctx->rounds; ++i) {
+        key = _mm_loadu_si128(((__m128i *) ctx->expandedKey) + i);
+
+        for (int j = 0; j < AES_X86_LANES; ++j)
+            state[j] = _mm_aesenc_si128(state[j], key);
+    }
+
+    key = _mm_loadu_si128(((__m128i *) ctx->expandedKey) + ctx->rounds);
+
+    for (int j = 0; j < AES_X86_LANES; ++j)
+        state[j] = _mm_aesenclast_si128(state[j], key);
+}
+
+static void AESDecodeLanes_x86(struct AES_ctx *ctx, __m128i state[AES_X86_LANES]) {
+    __m128i key = _mm_loadu_si128(((__m128i *) ctx->expandedKey) + ctx->rounds);
+
+    for (int j = 0; j < AES_X86_LANES; ++j)
+        state[j] = _mm_xor_si128(state[j], key);
+
+    for (int i = ctx->rounds-1; i > 0; --i) {
+        key = _mm_loadu_si128(((__m128i *) ctx->expandedKey) + i);
+
+        for (int j = 0; j < AES_X86_LANES; ++j)
+            state[j] = _mm_aesdec_si128(state[j], key);
+    }
+
+    key = _mm_loadu_si128(((__m128i *) ctx->expandedKey) + 0);
+
+    for (int j = 0; j < AES_X86_LANES; ++j)
+        state[j] = _mm_aesdeclast_si128(state[j], key);
+}
+
+/* ECB encryption is independent across blocks, so blocks are interleaved to hide the latency of `aesenc`.
+ * The chained modes must run serially and fall back to the single-block implementation */
+static void AESEncodeSpan_x86(struct AES_ctx *ctx, unsigned char *data, size_t blocks) {
+    __m128i state[AES_X86_LANES];
+
+    if (ctx->mode == AES_ECB) {
+        for (; blocks >= AES_X86_LANES; blocks -= AES_X86_LANES, data += 16 * AES_X86_LANES) {
+            for (int j = 0; j < AES_X86_LANES; ++j)
+                state[j] = _mm_loadu_si128(((__m128i *) data) + j);
+
+            AESEncodeLanes_x86(ctx, state);
+
+            for (int j = 0; j < AES_X86_LANES; ++j)
+                _mm_storeu_si128(((__m128i *) data) + j, state[j]);
+        }
+    }
+
+    AESSpan(ctx, data, blocks);
+}
+
+/* ECB, CBC, and CFB decryption only depend on ciphertext that is already available, so blocks are interleaved to hide the latency of `aesdec`/`aesenc`.
+ * The remaining modes must run serially and fall back to the single-block implementation */
+static void AESDecodeSpan_x86(struct AES_ctx *ctx, unsigned char *data, size_t blocks) {
+    __m128i state[AES_X86_LANES];
+    __m128i ciphertext[AES_X86_LANES];
+
+    switch (ctx->mode) {
+        default: break;
+        case AES_ECB: {
+            for (; blocks >= AES_X86_LANES; blocks -= AES_X86_LANES, data += 16 * AES_X86_LANES) {
+                for (int j = 0; j < AES_X86_LANES; ++j)
+                    state[j] = _mm_loadu_si128(((__m128i *) data) + j);
+
+                AESDecodeLanes_x86(ctx, state);
+
+                for (int j = 0; j < AES_X86_LANES; ++j)
+                    _mm_storeu_si128(((__m128i *) data) + j, state[j]);
+            }
+            break;
+        }
+        case AES_CBC: {
+            __m128i previous = _mm_loadu_si128((__m128i *) ctx->previous);
+
+            for (; blocks >= AES_X86_LANES; blocks -= AES_X86_LANES, data += 16 * AES_X86_LANES) {
+                for (int j = 0; j < AES_X86_LANES; ++j)
+                    state[j] = ciphertext[j] = _mm_loadu_si128(((__m128i *) data) + j);
+
+                AESDecodeLanes_x86(ctx, state);
+
+                _mm_storeu_si128((__m128i *) data, _mm_xor_si128(state[0], previous));
+                for (int j = 1; j < AES_X86_LANES; ++j)
+                    _mm_storeu_si128(((__m128i *) data) + j, _mm_xor_si128(state[j], ciphertext[j-1]));
+
+                previous = ciphertext[AES_X86_LANES-1];
+            }
+
+            _mm_storeu_si128((__m128i *) ctx->previous, previous);
+            break;
+        }
+        case AES_CFB: {
+            __m128i previous = _mm_loadu_si128((__m128i *) ctx->previous);
+
+            for (; blocks >= AES_X86_LANES; blocks -= AES_X86_LANES, data += 16 * AES_X86_LANES) {
+                for (int j = 0; j < AES_X86_LANES; ++j)
+                    ciphertext[j] = _mm_loadu_si128(((__m128i *) data) + j);
+
+                state[0] = previous;
+                for (int j = 1; j < AES_X86_LANES; ++j)
+                    state[j] = ciphertext[j-1];
+
+                AESEncodeLanes_x86(ctx, state); /* sic, not decoding */
+
+                for (int j = 0; j < AES_X86_LANES; ++j)
+                    _mm_storeu_si128(((__m128i *) data) + j, _mm_xor_si128(state[j], ciphertext[j]));
+
+                previous = ciphertext[AES_X86_LANES-1];
+            }
+
+            _mm_storeu_si128((__m128i *) ctx->previous, previous);
+            break;
+        }
+    }
+
+    AESSpan(ctx, data, blocks);
+}
 #endif
 
+/* Checks the PKCS #7 padding of a final plaintext block. Returns the number of unpadded bytes in the block, or -1 if the padding is invalid */
+static int aes_pkcs7_unpadded_size(const unsigned char block[16]) {
+    unsigned pad_value = block[15];
+
+    if (pad_value == 0 || pad_value > 16)
+        return -1;
+
+    for (size_t i = 16 - pad_value; i < 16; ++i)
+        if (block[i] != pad_value)
+            return -1;
+
+    return (int) (16 - pad_value);
+}
+
+/* Sends processed blocks to the underlying device. When removing padding, the last plaintext block is held back, since it may be the padded final block */
+static int aes_emit(struct AES_ctx *aes, const unsigned char *data, size_t size) {
+    if (!aes->pkcs7 || !aes->isDecryptor)
+        return io_write(data, 1, size, aes->io) == size? 0: -1;
+
+    if (aes->hasHeld && io_write(aes->held, 1, 16, aes->io) != 16)
+        return -1;
+
+    if (size > 16 && io_write(data, 1, size - 16, aes->io) != size - 16)
+        return -1;
+
+    memcpy(aes->held, data + size - 16, 16);
+    aes->hasHeld = 1;
+
+    return 0;
+}
+
 static size_t aes_write(const void *ptr, size_t size, size_t count, void *userdata, IO io) {
     UNUSED(io)
 
     const unsigned char *cptr = ptr;
     struct AES_ctx *aes = userdata;
-    size_t max = size*count, blocks = 0;
+    size_t max = size*count;
 
     while (max) {
+        if (aes->pos == 0 && max >= 16) {
+            /* Whole blocks are processed as a span and written with a single call */
+            size_t span = MIN(max, AES_SPAN_SIZE) & ~(size_t) 15;
+
+            memcpy(aes->span, cptr, span);
+            aes->span_cb(aes, aes->span, span / 16);
+
+            if (aes_emit(aes, aes->span, span)) {
+                io_set_error(io, io_error(aes->io));
+                return (size * count - max) / size;
+            }
+
+            cptr += span;
+            max -= span;
+            continue;
+        }
+
         size_t add = max;
         if (add > 16 - (size_t) aes->pos)
             add = 16 - aes->pos;
@@ -692,17 +905,175 @@ static size_t aes_write(const void *ptr, size_t size, size_t count, void *userda
 
             aes->pos = 0;
 
-            if (io_write(aes->buffer, 16, 1, aes->io) != 1) {
+            if (aes_emit(aes, aes->buffer, 16)) {
                 io_set_error(io, io_error(aes->io));
                 return (size * count - max) / size;
             }
-            ++blocks;
         }
     }
 
     return count;
 }
 
+/* Completes a padded read. When encrypting, `pos` bytes of plaintext remain in the state to be padded; when decrypting, the held block is unpadded */
+static int aes_pkcs7_finish(struct AES_ctx *aes) {
+    if (aes->isDecryptor) {
+        int unpadded = aes_pkcs7_unpadded_size(aes->held);
+        if (unpadded < 0)
+            return CC_EBADMSG;
+
+        memcpy(aes->tail, aes->held, unpadded);
+        aes->tailLength = (unsigned char) unpadded;
+        aes->hasHeld = 0;
+    } else {
+        memset(aes->state + aes->pos, 16 - aes->pos, 16 - aes->pos);
+        aes->cb(aes);
+
+        memcpy(aes->tail, aes->buffer, 16);
+        aes->tailLength = 16;
+        aes->pos = 0;
+    }
+
+    aes->tailOffset = 0;
+    aes->done = 1;
+
+    return 0;
+}
+
+static size_t aes_pkcs7_read(void *ptr, size_t size, size_t count, struct AES_ctx *aes, IO io) {
+    unsigned char *cptr = ptr;
+    size_t max = size*count;
+    int err;
+
+    /* `aes->pos` bytes of a partial input block are kept in `aes->state` when the underlying device returns a short read before the end of input */
+    while (max) {
+        if (aes->tailLength) {
+            size_t use = MIN(max, aes->tailLength);
+
+            memcpy(cptr, aes->tail + aes->tailOffset, use);
+            aes->tailOffset += (unsigned char) use;
+            aes->tailLength -= (unsigned char) use;
+            cptr += use;
+            max -= use;
+            continue;
+        } else if (aes->done)
+            break;
+
+        if (!aes->isDecryptor && aes->pos == 0 && max >= 16) {
+            /* Whole blocks are read directly into the destination and processed in place, any partial block at the end of input is padded */
+            size_t span = max & ~(size_t) 15;
+            size_t read = io_read(cptr, 1, span, aes->io);
+            size_t blocks = read / 16;
+
+            if (read != span && io_error(aes->io)) {
+                io_set_error(io, io_error(aes->io));
+                return SIZE_MAX;
+            }
+
+            aes->span_cb(aes, cptr, blocks);
+            cptr += blocks * 16;
+            max -= blocks * 16;
+
+            if (read != span) {
+                aes->pos = (unsigned char) (read % 16);
+                memcpy(aes->state, cptr, aes->pos);
+
+                if (!io_eof(aes->io)) /* More input may follow */
+                    break;
+
+                aes_pkcs7_finish(aes);
+            }
+
+            continue;
+        } else if (aes->isDecryptor && aes->pos == 0 && aes->hasHeld && max >= 32) {
+            /* Release the held block, then read whole blocks straight into the destination, holding back the last one again */
+            size_t span = (max - 16) & ~(size_t) 15;
+            size_t read = io_read(cptr + 16, 1, span, aes->io);
+            size_t blocks = read / 16;
+
+            if (read != span && io_error(aes->io)) {
+                io_set_error(io, io_error(aes->io));
+                return SIZE_MAX;
+            }
+
+            /* The span callback uses `aes->state`, so any partial block is saved afterward */
+            aes->span_cb(aes, cptr + 16, blocks);
+            aes->pos = (unsigned char) (read % 16);
+            memcpy(aes->state, cptr + 16 + blocks * 16, aes->pos);
+            memcpy(cptr, aes->held, 16);
+
+            if (blocks) {
+                memcpy(aes->held, cptr + blocks * 16, 16);
+                cptr += blocks * 16;
+                max -= blocks * 16;
+            }
+
+            if (read != span) {
+                if (!io_eof(aes->io)) /* More input may follow */
+                    break;
+                else if (aes->pos) { /* Truncated ciphertext */
+                    io_set_error(io, CC_EBADMSG);
+                    return SIZE_MAX;
+                } else if ((err = aes_pkcs7_finish(aes)) != 0) {
+                    io_set_error(io, err);
+                    return SIZE_MAX;
+                }
+            }
+
+            continue;
+        }
+
+        /* Pump one block from input, completing any partial block */
+        size_t want = 16 - aes->pos;
+        size_t read = io_read(aes->state + aes->pos, 1, want, aes->io);
+
+        if (read != want && io_error(aes->io)) {
+            io_set_error(io, io_error(aes->io));
+            return SIZE_MAX;
+        }
+
+        aes->pos += (unsigned char) read;
+
+        if (aes->pos != 16) {
+            if (!io_eof(aes->io)) /* More input may follow */
+                break;
+            else if (!aes->isDecryptor)
+                aes_pkcs7_finish(aes);
+            else if (aes->pos) { /* Truncated ciphertext */
+                io_set_error(io, CC_EBADMSG);
+                return SIZE_MAX;
+            } else if (!aes->hasHeld) { /* Empty input */
+                aes->done = 1;
+                break;
+            } else if ((err = aes_pkcs7_finish(aes)) != 0) {
+                io_set_error(io, err);
+                return SIZE_MAX;
+            }
+        } else if (!aes->isDecryptor) {
+            aes->pos = 0;
+            aes->cb(aes);
+
+            memcpy(aes->tail, aes->buffer, 16);
+            aes->tailOffset = 0;
+            aes->tailLength = 16;
+        } else {
+            aes->pos = 0;
+            aes->cb(aes);
+
+            if (aes->hasHeld) {
+                memcpy(aes->tail, aes->held, 16);
+                aes->tailOffset = 0;
+                aes->tailLength = 16;
+            }
+
+            memcpy(aes->held, aes->buffer, 16);
+            aes->hasHeld = 1;
+        }
+    }
+
+    return (size*count - max) / size;
+}
+
 static size_t aes_read(void *ptr, size_t size, size_t count, void *userdata, IO io) {
     UNUSED(io)
 
@@ -710,7 +1081,28 @@ static size_t aes_read(void *ptr, size_t size, size_t count, void *userdata, IO
     struct AES_ctx *aes = userdata;
     size_t max = size*count;
 
+    if (aes->pkcs7)
+        return aes_pkcs7_read(ptr, size, count, aes, io);
+
     while (max) {
+        if (aes->pos == 0 && max >= 16) {
+            /* Whole blocks are read directly into the destination and processed in place */
+            size_t span = max & ~(size_t) 15;
+            size_t read = io_read(cptr, 1, span, aes->io);
+            size_t blocks = read / 16;
+
+            aes->span_cb(aes, cptr, blocks);
+            cptr += blocks * 16;
+            max -= blocks * 16;
+
+            if (read != span) {
+                io_set_error(io, io_error(aes->io));
+                return io_error(aes->io)? SIZE_MAX: (size * count - max) / size;
+            }
+
+            continue;
+        }
+
         if (aes->pos == 0) {
             if (io_read(aes->state, 1, 16, aes->io) != 16) {
                 io_set_error(io, io_error(aes->io));
@@ -747,11 +1139,34 @@ static int aes_flush(void *userdata, IO io) {
 static int aes_close(void *userdata, IO io) {
     UNUSED(io)
 
+    struct AES_ctx *aes = userdata;
+    int err = 0;
+
+    /* An encryptor opened for writing always ends with a padded block, even if nothing was written */
+    if (aes->pkcs7 && io_writable(io) && !io_just_read(io)) {
+        if (!aes->isDecryptor) {
+            /* Pad and write the final block */
+            memset(aes->state + aes->pos, 16 - aes->pos, 16 - aes->pos);
+            aes->cb(aes);
+
+            if (io_write(aes->buffer, 1, 16, aes->io) != 16)
+                err = io_error(aes->io);
+        } else if (aes->pos || aes->hasHeld) { /* Empty input decrypts to nothing, as when reading */
+            /* Strip the padding from the held final block */
+            int unpadded = aes->pos == 0 && aes->hasHeld? aes_pkcs7_unpadded_size(aes->held): -1;
+
+            if (unpadded < 0)
+                err = CC_EBADMSG;
+            else if (io_write(aes->held, 1, unpadded, aes->io) != (size_t) unpadded)
+                err = io_error(aes->io);
+        }
+    }
+
     /* Clearing our private encryption data can't hurt :) */
     memset(userdata, 0, sizeof(struct AES_ctx));
 
     FREE(userdata);
-    return 0;
+    return err;
 }
 
 static int aes_state_switch(void *userdata, IO io) {
@@ -759,6 +1174,9 @@ static int aes_state_switch(void *userdata, IO io) {
 
     struct AES_ctx *aes = userdata;
 
+    if (aes->pkcs7)
+        return 0;
+
     return aes->pos = 0;
 }
 
@@ -775,6 +1193,10 @@ static int aes_seek64(void *userdata, long long int offset, int origin, IO io) {
 
     struct AES_ctx *aes = userdata;
 
+    /* Padded devices don't have a fixed mapping between positions in the input and output */
+    if (aes->pkcs7)
+        return -1;
+
     /* Translate all origins to SEEK_SET for ease of computation */
     switch (origin) {
         case SEEK_END: {
@@ -877,6 +1299,9 @@ static long aes_tell(void *userdata, IO io) {
 
     struct AES_ctx *aes = userdata;
 
+    if (aes->pkcs7)
+        return -1;
+
     long result = io_tell(aes->io);
     return result < 0? result: io_just_read(io)? result - aes->pos: result + aes->pos;
 }
@@ -886,6 +1311,9 @@ static long long aes_tell64(void *userdata, IO io) {
 
     struct AES_ctx *aes = userdata;
 
+    if (aes->pkcs7)
+        return -1;
+
     long long result = io_tell64(aes->io);
     return result < 0? result: io_just_read(io)? result - aes->pos: result + aes->pos;
 }
@@ -933,6 +1361,7 @@ IO io_open_aes_encrypt(IO io, enum AES_Type type, enum AES_Mode cipherMode, cons
 
     ctx->io = io;
     ctx->cb = AESEncode;
+    ctx->span_cb = AESSpan;
     ctx->mode = cipherMode;
     ctx->isDecryptor = 0;
 
@@ -948,8 +1377,10 @@ IO io_open_aes_encrypt(IO io, enum AES_Type type, enum AES_Mode cipherMode, cons
 #if X86_CPU | AMD64_CPU
     /* Detect AES extensions support */
     uint32_t cpuid[4];
-    if (strchr(mode, '<') == NULL && 0 == x86_cpuid(1, 0, cpuid) && TESTBIT(cpuid[2], 25))
+    if (strchr(mode, '<') == NULL && 0 == x86_cpuid(1, 0, cpuid) && TESTBIT(cpuid[2], 25)) {
         ctx->cb = AESEncode_x86;
+        ctx->span_cb = AESEncodeSpan_x86;
+    }
 #endif
 #endif
 
@@ -974,6 +1405,7 @@ IO io_open_aes_decrypt(IO io, enum AES_Type type, enum AES_Mode cipherMode, cons
 
     ctx->io = io;
     ctx->cb = AESDecode;
+    ctx->span_cb = AESSpan;
     ctx->mode = cipherMode;
     ctx->isDecryptor = 1;
 
@@ -991,6 +1423,7 @@ IO io_open_aes_decrypt(IO io, enum AES_Type type, enum AES_Mode cipherMode, cons
     uint32_t cpuid[4];
     if (strchr(mode, '<') == NULL && 0 == x86_cpuid(1, 0, cpuid) && TESTBIT(cpuid[2], 25)) {
         ctx->cb = AESDecode_x86;
+        ctx->span_cb = AESDecodeSpan_x86;
 
         if (cipherMode < AES_CFB) {
             /* AESIMC instruction needed for implementation reasons for the central keys in the schedule */
@@ -1003,3 +1436,23 @@ IO io_open_aes_decrypt(IO io, enum AES_Type type, enum AES_Mode cipherMode, cons
 
     return result;
 }
+
+IO io_open_aes_cbc_pkcs7_encrypt(IO io, enum AES_Type type, const unsigned char *key, const unsigned char iv[16], const char *mode) {
+    IO result = io_open_aes_encrypt(io, type, AES_CBC, key, iv, mode);
+    if (result == NULL)
+        return NULL;
+
+    ((struct AES_ctx *) io_userdata(result))->pkcs7 = 1;
+
+    return result;
+}
+
+IO io_open_aes_cbc_pkcs7_decrypt(IO io, enum AES_Type type, const unsigned char *key, const unsigned char iv[16], const char *mode) {
+    IO result = io_open_aes_decrypt(io, type, AES_CBC, key, iv, mode);
+    if (result == NULL)
+        return NULL;
+
+    ((struct AES_ctx *) io_userdata(result))->pkcs7 = 1;
+
+    return result;
+}
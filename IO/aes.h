@@ -76,6 +76,39 @@ IO io_open_aes_decrypt(IO io, enum AES_Type type, enum AES_Mode cipherMode, cons
  */
 IO io_open_aes_encrypt(IO io, enum AES_Type type, enum AES_Mode cipherMode, const unsigned char *key, const unsigned char iv[16], const char *mode);
 
+/** @brief Opens an AES-CBC encryption device that also applies PKCS #7 padding to the plaintext.
+ *
+ *  This is equivalent to opening io_open_aes_encrypt() in `AES_CBC` mode on top of io_open_pkcs7_padding_encode() with a block size of 16,
+ *  but avoids the intermediate device layer. The padding is added when the end of @p io is reached while reading, or when the device is closed after writing.
+ *
+ *  The resulting device is not seekable.
+ *
+ *  @param io is the underlying device to read data from and write data to. Must not be `NULL`.
+ *  @param type is the size of the AES key to be used.
+ *  @param key contains the binary key, size dependent on @p type. Must not be `NULL`.
+ *  @param iv contains the initialization vector to use for encryption. Must not be `NULL`.
+ *  @param mode contains the standard IO device mode specifiers (i.e. "r", "w", "rw"). Must not be `NULL`. See io_open_aes_encrypt() for more info.
+ *  @return A new IO device filter that pads and encrypts data, or `NULL` if a failure occured.
+ */
+IO io_open_aes_cbc_pkcs7_encrypt(IO io, enum AES_Type type, const unsigned char *key, const unsigned char iv[16], const char *mode);
+
+/** @brief Opens an AES-CBC decryption device that also removes PKCS #7 padding from the plaintext.
+ *
+ *  This is equivalent to opening io_open_pkcs7_padding_decode() with a block size of 16 on top of io_open_aes_decrypt() in `AES_CBC` mode,
+ *  but avoids the intermediate device layer. The last plaintext block is held back until the end of the ciphertext is known.
+ *  If the ciphertext is truncated or the padding is invalid, the device error is set to `CC_EBADMSG` when reading, or returned from io_close() when writing.
+ *
+ *  The resulting device is not seekable.
+ *
+ *  @param io is the underlying device to read data from and write data to. Must not be `NULL`.
+ *  @param type is the size of the AES key to be used.
+ *  @param key contains the binary key, size dependent on @p type. Must not be `NULL`.
+ *  @param iv contains the initialization vector to use for decryption. Must not be `NULL`.
+ *  @param mode contains the standard IO device mode specifiers (i.e. "r", "w", "rw"). Must not be `NULL`. See io_open_aes_decrypt() for more info.
+ *  @return A new IO device filter that decrypts and unpads data, or `NULL` if a failure occured.
+ */
+IO io_open_aes_cbc_pkcs7_decrypt(IO io, enum AES_Type type, const unsigned char *key, const unsigned char iv[16], const char *mode);
+
 void test_aes();
 
 #ifdef __cplusplus
@@ -6,27 +6,53 @@
 
 #include "concat.h"
 #include "../seaerror.h"
+#include "../utility.h"
 
 #include <string.h>
 
-/* io_tempdata() guarantees that we'll be able to store at least three pointers, so casting tempdata to this struct is always safe */
 struct ConcatInitializationParams {
     IO lhs, rhs;
     char use_lhs;
+
+    /* Size of `lhs`, measured before the first positional transfer, or -1 if not yet measured.
+     * Positional transfers must not measure `lhs` each time, since measuring moves its position */
+    long long lhs_size;
+    Mutex measure_lock;
 };
 
 static void *concat_open(void *userdata, IO io) {
-    memcpy(io_tempdata(io), userdata, sizeof(struct ConcatInitializationParams));
+    UNUSED(io)
+
+    struct ConcatInitializationParams *params = MALLOC(sizeof(*params));
+    if (params == NULL)
+        return NULL;
+
+    memcpy(params, userdata, sizeof(*params));
 
-    return userdata;
+    params->measure_lock = mutex_create();
+    if (params->measure_lock == NULL) {
+        FREE(params);
+        return NULL;
+    }
+
+    return params;
 }
 
-static size_t concat_read(void *ptr, size_t size, size_t count, void *userdata, IO io) {
-    UNUSED(userdata)
+static int concat_close(void *userdata, IO io) {
+    UNUSED(io)
+
+    struct ConcatInitializationParams *params = userdata;
 
+    mutex_destroy(params->measure_lock);
+    FREE(params);
+
+    return 0;
+}
+
+static size_t concat_read(void *ptr, size_t size, size_t count, void *userdata, IO io) {
     unsigned char *cptr = ptr;
     size_t read = 0, max = size*count;
-    struct ConcatInitializationParams *params = (struct ConcatInitializationParams *) io_tempdata(io);
+    struct ConcatInitializationParams *params = userdata;
 
     if (params->use_lhs) {
         read = io_read(cptr, 1, max, params->lhs);
@@ -49,11 +75,9 @@ static size_t concat_read(void *ptr, size_t size, size_t count, void *userdata,
 }
 
 static size_t concat_write(const void *ptr, size_t size, size_t count, void *userdata, IO io) {
-    UNUSED(userdata)
-
     const unsigned char *cptr = ptr;
     size_t written = 0, max = size*count;
-    struct ConcatInitializationParams *params = (struct ConcatInitializationParams *) io_tempdata(io);
+    struct ConcatInitializationParams *params = userdata;
 
     if (params->use_lhs) {
         written = io_write(ptr, 1, max, params->lhs);
@@ -76,9 +100,7 @@ static size_t concat_write(const void *ptr, size_t size, size_t count, void *use
 }
 
 static int concat_flush(void *userdata, IO io) {
-    UNUSED(userdata)
-
-    struct ConcatInitializationParams *params = (struct ConcatInitializationParams *) io_tempdata(io);
+    struct ConcatInitializationParams *params = userdata;
 
     io_flush(params->lhs);
     io_flush(params->rhs);
@@ -94,18 +116,18 @@ static int concat_flush(void *userdata, IO io) {
 }
 
 static void concat_clearerr(void *userdata, IO io) {
-    UNUSED(userdata)
+    UNUSED(io)
 
-    struct ConcatInitializationParams *params = (struct ConcatInitializationParams *) io_tempdata(io);
+    struct ConcatInitializationParams *params = userdata;
 
     io_clearerr(params->lhs);
     io_clearerr(params->rhs);
 }
 
 static long long concat_tell64(void *userdata, IO io) {
-    UNUSED(userdata)
+    UNUSED(io)
 
-    struct ConcatInitializationParams *params = (struct ConcatInitializationParams *) io_tempdata(io);
+    struct ConcatInitializationParams *params = userdata;
 
     if (params->use_lhs)
         return io_tell64(params->lhs);
@@ -122,9 +144,7 @@ static long long concat_tell64(void *userdata, IO io) {
 }
 
 static int concat_seek64(void *userdata, long long int offset, int origin, IO io) {
-    UNUSED(userdata)
-
-    struct ConcatInitializationParams *params = (struct ConcatInitializationParams *) io_tempdata(io);
+    struct ConcatInitializationParams *params = userdata;
 
     if (offset == 0 && origin == SEEK_SET) {
         if (io_seek(params->lhs, 0, SEEK_SET) < 0 ||
@@ -178,6 +198,60 @@ static int concat_seek64(void *userdata, long long int offset, int origin, IO io
     return 0;
 }
 
+/* Positional transfer shared by concat_pread() and concat_pwrite(). Returns the number of bytes transferred, or SIZE_MAX on error */
+static size_t concat_positional(struct ConcatInitializationParams *params, unsigned char *cptr, size_t size, long long offset, int writing, IO io) {
+    size_t done = 0;
+
+    mutex_lock(params->measure_lock);
+    if (params->lhs_size < 0)
+        params->lhs_size = io_size64(params->lhs);
+
+    long long lhs_size = params->lhs_size;
+    mutex_unlock(params->measure_lock);
+
+    if (lhs_size < 0) {
+        io_set_error(io, io_error(params->lhs)? io_error(params->lhs): CC_ESPIPE);
+        return SIZE_MAX;
+    }
+
+    if (offset < lhs_size) {
+        size_t amount = (unsigned long long) (lhs_size - offset) < size? (size_t) (lhs_size - offset): size;
+
+        done = writing? io_pwrite(params->lhs, cptr, amount, offset): io_pread(params->lhs, cptr, amount, offset);
+        if (done < amount) {
+            if (io_error(params->lhs)) {
+                io_set_error(io, io_error(params->lhs));
+                return SIZE_MAX;
+            }
+
+            return done;
+        }
+    }
+
+    if (done < size) {
+        long long rhs_offset = offset + done - lhs_size;
+        size_t amount = size - done;
+        size_t rhs_done = writing? io_pwrite(params->rhs, cptr + done, amount, rhs_offset): io_pread(params->rhs, cptr + done, amount, rhs_offset);
+
+        if (rhs_done < amount && io_error(params->rhs)) {
+            io_set_error(io, io_error(params->rhs));
+            return SIZE_MAX;
+        }
+
+        done += rhs_done;
+    }
+
+    return done;
+}
+
+static size_t concat_pread(void *ptr, size_t size, long long offset, void *userdata, IO io) {
+    return concat_positional(userdata, ptr, size, offset, 0, io);
+}
+
+static size_t concat_pwrite(const void *ptr, size_t size, long long offset, void *userdata, IO io) {
+    return concat_positional(userdata, (void *) ptr, size, offset, 1, io);
+}
+
 static const char *concat_what(void *userdata, IO io) {
     UNUSED(userdata)
     UNUSED(io)
@@ -187,7 +261,7 @@ static const char *concat_what(void *userdata, IO io) {
 
 static const struct InputOutputDeviceCallbacks concat_callbacks = {
     .open = concat_open,
-    .close = NULL,
+    .close = concat_close,
     .read = concat_read,
     .write = concat_write,
     .flush = concat_flush,
@@ -198,15 +272,485 @@ static const struct InputOutputDeviceCallbacks concat_callbacks = {
     .tell = NULL,
     .tell64 = concat_tell64,
     .flags = NULL,
-    .what = concat_what
+    .what = concat_what,
+    .pread = concat_pread,
+    .pwrite = concat_pwrite
 };
 
 IO io_open_concat(IO lhs, IO rhs, const char *mode) {
     struct ConcatInitializationParams params = {
         .lhs = lhs,
         .rhs = rhs,
-        .use_lhs = 1
+        .use_lhs = 1,
+        .lhs_size = -1
     };
 
     return io_open_custom(&concat_callbacks, &params, mode);
 }
+
+struct ConcatNParams {
+    IO *parts;
+    size_t count;
+    ConcatOpenFn open_part;
+    void *userdata;
+};
+
+struct ConcatNState {
+    /* Opens parts on demand if not NULL, in which case at most one part (`open`) is open at a time */
+    ConcatOpenFn open_part;
+    void *userdata;
+    IO open;
+    size_t open_index;
+
+    size_t count;
+    size_t current; /* Index of the part currently being read from or written to. Equal to `count` once all parts are exhausted */
+
+    /* Prefix sums of the part sizes: ends[i] is the offset one past the last byte of part i. Only the first `known` entries are valid */
+    long long *ends;
+    size_t known;
+
+    /* Parts specified when opening, or NULL if parts are opened on demand */
+    IO *parts;
+
+    /* Number of leading parts that may have been moved from their start, and must be rewound before being read or written from the start again */
+    size_t visited;
+
+    /* Protects `ends` and `known`, which both sequential calls and positional transfers from other threads may fill in.
+     * Once every part is measured they no longer change */
+    Mutex measure_lock;
+};
+
+/* Returns part @p index, opening it (and closing any other part opened on demand) if required. Returns NULL and sets the error of @p io on failure */
+static IO concat_n_part(struct ConcatNState *state, size_t index, IO io) {
+    if (state->parts)
+        return state->parts[index];
+
+    if (state->open != NULL && state->open_index == index)
+        return state->open;
+
+    if (state->open != NULL) {
+        int err = io_close(state->open);
+        state->open = NULL;
+
+        if (err) {
+            io_set_error(io, err);
+            return NULL;
+        }
+    }
+
+    state->open = state->open_part(index, state->userdata);
+    if (state->open == NULL) {
+        io_set_error(io, CC_EIO);
+        return NULL;
+    }
+
+    state->open_index = index;
+    return state->open;
+}
+
+/* Moves to the next part after the current part was read or written to its end. Returns 0 on success, non-zero on failure */
+static int concat_n_advance(struct ConcatNState *state, IO part, IO io) {
+    /* The end of the part is now known without asking the part for its size */
+    mutex_lock(state->measure_lock);
+    if (state->known == state->current) {
+        long long position = io_tell64(part);
+        if (position >= 0)
+            state->ends[state->known++] = (state->current? state->ends[state->current-1]: 0) + position;
+    }
+    mutex_unlock(state->measure_lock);
+
+    ++state->current;
+
+    if (state->current == state->count)
+        return 0;
+
+    if (state->parts && state->current < state->visited && io_seek64(state->parts[state->current], 0, SEEK_SET)) {
+        io_set_error(io, io_error(state->parts[state->current])? io_error(state->parts[state->current]): CC_ESPIPE);
+        return -1;
+    }
+
+    state->visited = MAX(state->visited, state->current + 1);
+    return 0;
+}
+
+/* Ensures the ends of all parts up to and including @p index are known. Returns 0 on success, non-zero on failure.
+ * Must be called with `measure_lock` held. Only sequential calls (@p sequential non-zero) may measure the part open for sequential access,
+ * positional transfers open a private device instead so the sequential position is never touched */
+static int concat_n_measure(struct ConcatNState *state, size_t index, int sequential, IO io) {
+    while (state->known <= index) {
+        size_t i = state->known;
+        IO part;
+        long long size;
+
+        if (state->parts == NULL && (!sequential || state->open == NULL || state->open_index != i)) {
+            /* Measure the part without disturbing the currently open part */
+            part = state->open_part(i, state->userdata);
+            if (part == NULL) {
+                io_set_error(io, CC_EIO);
+                return -1;
+            }
+
+            size = io_size64(part);
+            io_close(part);
+        } else {
+            size = io_size64(state->parts? state->parts[i]: state->open);
+        }
+
+        if (size < 0)
+            return -1;
+
+        state->ends[i] = (i? state->ends[i-1]: 0) + size;
+        state->known = i + 1;
+    }
+
+    return 0;
+}
+
+static size_t concat_n_read(void *ptr, size_t size, size_t count, void *userdata, IO io) {
+    struct ConcatNState *state = userdata;
+    unsigned char *cptr = ptr;
+    size_t read = 0, max = size*count;
+
+    while (read < max && state->current < state->count) {
+        IO part = concat_n_part(state, state->current, io);
+        if (part == NULL)
+            break;
+
+        read += io_read(cptr + read, 1, max - read, part);
+
+        if (read != max) {
+            if (io_error(part)) {
+                io_set_error(io, io_error(part));
+                break;
+            }
+
+            /* Simple EOF, so move to the next part */
+            if (concat_n_advance(state, part, io))
+                break;
+        }
+    }
+
+    return read / size;
+}
+
+static size_t concat_n_write(const void *ptr, size_t size, size_t count, void *userdata, IO io) {
+    struct ConcatNState *state = userdata;
+    const unsigned char *cptr = ptr;
+    size_t written = 0, max = size*count;
+
+    while (written < max) {
+        if (state->current == state->count) {
+            io_set_error(io, CC_ENOBUFS);
+            break;
+        }
+
+        IO part = concat_n_part(state, state->current, io);
+        if (part == NULL)
+            break;
+
+        written += io_write(cptr + written, 1, max - written, part);
+
+        if (written != max) {
+            if (io_error(part) != CC_ENOBUFS) {
+                io_set_error(io, io_error(part));
+                break;
+            }
+
+            /* Part is full, so move to the next part */
+            io_clearerr(part);
+            if (concat_n_advance(state, part, io))
+                break;
+        }
+    }
+
+    return written / size;
+}
+
+static int concat_n_flush(void *userdata, IO io) {
+    struct ConcatNState *state = userdata;
+    size_t first = state->parts? 0: state->current;
+    size_t last = MIN(state->current + 1, state->count);
+
+    /* Parts opened on demand are flushed when closed, so only the open one needs flushing */
+    for (size_t i = first; i < last; ++i) {
+        IO part = state->parts? state->parts[i]: state->open;
+        if (part == NULL)
+            continue;
+
+        if (io_flush(part)) {
+            io_set_error(io, io_error(part));
+            return EOF;
+        }
+    }
+
+    return 0;
+}
+
+static void concat_n_clearerr(void *userdata, IO io) {
+    UNUSED(io)
+
+    struct ConcatNState *state = userdata;
+
+    if (state->parts) {
+        for (size_t i = 0; i < state->count; ++i)
+            io_clearerr(state->parts[i]);
+    } else if (state->open) {
+        io_clearerr(state->open);
+    }
+}
+
+static long long concat_n_tell64(void *userdata, IO io) {
+    struct ConcatNState *state = userdata;
+    long long start = 0;
+
+    if (state->current) {
+        mutex_lock(state->measure_lock);
+        int err = concat_n_measure(state, state->current - 1, 1, io);
+        start = state->ends[state->current - 1];
+        mutex_unlock(state->measure_lock);
+
+        if (err)
+            return -1;
+    }
+
+    if (state->current == state->count)
+        return start;
+
+    IO part = concat_n_part(state, state->current, io);
+    if (part == NULL)
+        return -1;
+
+    long long position = io_tell64(part);
+    if (position < 0)
+        return -1;
+
+    return start + position;
+}
+
+static int concat_n_seek64(void *userdata, long long int offset, int origin, IO io) {
+    struct ConcatNState *state = userdata;
+
+    /* Translate all origins to SEEK_SET for ease of computation */
+    if (origin == SEEK_CUR) {
+        long long current = concat_n_tell64(userdata, io);
+        if (current < 0)
+            return -1;
+
+        offset += current;
+    }
+
+    mutex_lock(state->measure_lock);
+
+    if (origin == SEEK_END) {
+        if (concat_n_measure(state, state->count - 1, 1, io))
+            goto error;
+
+        offset += state->ends[state->count - 1];
+    }
+
+    if (offset < 0)
+        goto error;
+
+    /* Measure parts only until the target is covered, then binary search the cached prefix sums for the first part ending after the target */
+    while (state->known < state->count && (state->known == 0 || state->ends[state->known-1] <= offset))
+        if (concat_n_measure(state, state->known, 1, io))
+            goto error;
+
+    size_t lo = 0, hi = state->known;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (state->ends[mid] <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    /* Seeking to or past the end positions at the end of the last part */
+    if (lo == state->count)
+        lo = state->count - 1;
+
+    const long long start = lo? state->ends[lo-1]: 0;
+    mutex_unlock(state->measure_lock);
+
+    IO part = concat_n_part(state, lo, io);
+    if (part == NULL || io_seek64(part, offset - start, SEEK_SET))
+        return -1;
+
+    state->current = lo;
+    state->visited = MAX(state->visited, lo + 1);
+    return 0;
+
+error:
+    mutex_unlock(state->measure_lock);
+    return -1;
+}
+
+/* Positional transfer shared by concat_n_pread() and concat_n_pwrite(). Returns the number of bytes transferred, or SIZE_MAX on error */
+static size_t concat_n_positional(struct ConcatNState *state, unsigned char *ptr, size_t size, long long offset, int writing, IO io) {
+    mutex_lock(state->measure_lock);
+    int err = concat_n_measure(state, state->count - 1, 0, io);
+    mutex_unlock(state->measure_lock);
+
+    if (err)
+        return SIZE_MAX;
+
+    size_t lo = 0, hi = state->count, done = 0;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (state->ends[mid] <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for (; done < size && lo < state->count; ++lo) {
+        long long start = lo? state->ends[lo-1]: 0;
+        long long position = offset + done;
+        size_t amount = MIN(size - done, (unsigned long long) (state->ends[lo] - position));
+
+        if (amount == 0)
+            continue;
+
+        /* Parts opened on demand get a private device, so transfers from other threads or the current sequential part are undisturbed */
+        IO part = state->parts? state->parts[lo]: state->open_part(lo, state->userdata);
+        if (part == NULL) {
+            io_set_error(io, CC_EIO);
+            return SIZE_MAX;
+        }
+
+        size_t transferred = writing? io_pwrite(part, ptr + done, amount, position - start): io_pread(part, ptr + done, amount, position - start);
+        int part_err = transferred < amount? io_error(part): 0;
+
+        if (state->parts == NULL) {
+            int close_err = io_close(part);
+            if (!part_err)
+                part_err = close_err;
+        }
+
+        done += transferred;
+        if (part_err) {
+            io_set_error(io, part_err);
+            return SIZE_MAX;
+        } else if (transferred < amount)
+            break;
+    }
+
+    if (writing && done < size)
+        io_set_error(io, CC_ENOBUFS);
+
+    return done;
+}
+
+static size_t concat_n_pread(void *ptr, size_t size, long long offset, void *userdata, IO io) {
+    return concat_n_positional(userdata, ptr, size, offset, 0, io);
+}
+
+static size_t concat_n_pwrite(const void *ptr, size_t size, long long offset, void *userdata, IO io) {
+    return concat_n_positional(userdata, (void *) ptr, size, offset, 1, io);
+}
+
+static void *concat_n_open(void *userdata, IO io) {
+    UNUSED(io)
+
+    struct ConcatNParams *params = userdata;
+    struct ConcatNState *state = CALLOC(1, sizeof(*state));
+    if (state == NULL)
+        return NULL;
+
+    state->open_part = params->open_part;
+    state->userdata = params->userdata;
+    state->count = params->count;
+    state->visited = 1;
+
+    state->ends = MALLOC(params->count * sizeof(*state->ends));
+    if (state->ends == NULL)
+        goto cleanup;
+
+    state->measure_lock = mutex_create();
+    if (state->measure_lock == NULL)
+        goto cleanup;
+
+    if (params->parts) {
+        state->parts = MALLOC(params->count * sizeof(*state->parts));
+        if (state->parts == NULL)
+            goto cleanup;
+
+        memcpy(state->parts, params->parts, params->count * sizeof(*state->parts));
+    }
+
+    return state;
+
+cleanup:
+    if (state->measure_lock)
+        mutex_destroy(state->measure_lock);
+
+    FREE(state->ends);
+    FREE(state);
+    return NULL;
+}
+
+static int concat_n_close(void *userdata, IO io) {
+    UNUSED(io)
+
+    struct ConcatNState *state = userdata;
+    int err = io_close(state->open);
+
+    mutex_destroy(state->measure_lock);
+    FREE(state->parts);
+    FREE(state->ends);
+    FREE(state);
+
+    return err;
+}
+
+static const char *concat_n_what(void *userdata, IO io) {
+    UNUSED(userdata)
+    UNUSED(io)
+
+    return "concat_n";
+}
+
+static const struct InputOutputDeviceCallbacks concat_n_callbacks = {
+    .open = concat_n_open,
+    .close = concat_n_close,
+    .read = concat_n_read,
+    .write = concat_n_write,
+    .flush = concat_n_flush,
+    .clearerr = concat_n_clearerr,
+    .state_switch = NULL,
+    .seek = NULL,
+    .seek64 = concat_n_seek64,
+    .tell = NULL,
+    .tell64 = concat_n_tell64,
+    .flags = NULL,
+    .what = concat_n_what,
+    .pread = concat_n_pread,
+    .pwrite = concat_n_pwrite
+};
+
+IO io_open_concat_n(IO parts[], size_t n, const char *mode) {
+    struct ConcatNParams params = {
+        .parts = parts,
+        .count = n
+    };
+
+    if (n == 0)
+        return NULL;
+
+    return io_open_custom(&concat_n_callbacks, &params, mode);
+}
+
+IO io_open_concat_n_lazy(size_t n, ConcatOpenFn open_part, void *userdata, const char *mode) {
+    struct ConcatNParams params = {
+        .count = n,
+        .open_part = open_part,
+        .userdata = userdata
+    };
+
+    if (n == 0 || open_part == NULL)
+        return NULL;
+
+    return io_open_custom(&concat_n_callbacks, &params, mode);
+}
@@ -13,6 +13,9 @@
  *
  * This device is useful to concatenate two data streams into a single stream, without creating an intermediate buffer.
  *
+ * `io_pread()` and `io_pwrite()` are supported if both devices support them. The size of @p lhs is measured once with `io_size64()`, before the first
+ * positional transfer, and must not change afterward. Only that first transfer touches the position of @p lhs, so later positional transfers may run concurrently.
+ *
  * @param lhs The first IO device to start reading from or writing to.
  * @param rhs The second IO device to start reading from or writing to.
  * @param mode Contains the standard IO device mode specifiers (i.e. "r", "w", "rw").
@@ -20,4 +23,44 @@
  */
 IO io_open_concat(IO lhs, IO rhs, const char *mode);
 
+/** @brief Opens a device to concatenate @p n IO streams to a single IO stream.
+ *
+ * Unlike nesting `io_open_concat()` devices, reads, writes, and seeks only touch the part involved. The size of each part is measured at most once
+ * (or recorded when it is read to the end) and cached as a prefix sum, so seeking performs a binary search instead of querying every part.
+ * When writing, the device moves to the next part when a part reports `CC_ENOBUFS`.
+ *
+ * `io_pread()` and `io_pwrite()` are supported if the parts support them. The first positional transfer measures every part that has not been measured yet,
+ * which must not happen concurrently with sequential use of the device. After that, positional transfers from multiple threads are safe. When parts are opened on demand,
+ * each positional transfer opens its own device for the parts it touches, so @p open_part must then be thread-safe.
+ *
+ * @param parts The array of @p n devices to read from or write to, in order. The array is copied, but the devices are not closed by the concatenation device.
+ * @param n The number of parts. Must be greater than 0.
+ * @param mode Contains the standard IO device mode specifiers (i.e. "r", "w", "rw").
+ * @return A new device allowing concatenation of the streams, or NULL if an allocation error occurred.
+ */
+IO io_open_concat_n(IO parts[], size_t n, const char *mode);
+
+/** @brief Opens part @p index of a concatenation device opened with `io_open_concat_n_lazy()`.
+ *
+ * The function may be called more than once for the same part, and must return a device positioned at the start of the part each time.
+ *
+ * @param index The index of the part to open.
+ * @param userdata The userdata passed to `io_open_concat_n_lazy()`.
+ * @return A new device for the part, or NULL if the part could not be opened. The device is closed by the concatenation device.
+ */
+typedef IO (*ConcatOpenFn)(size_t index, void *userdata);
+
+/** @brief Identical to `io_open_concat_n()`, but opens parts on demand with @p open_part.
+ *
+ * At most one part is kept open at a time (and a second one briefly while measuring sizes for a seek), so concatenating thousands of files
+ * does not consume thousands of file descriptors.
+ *
+ * @param n The number of parts. Must be greater than 0.
+ * @param open_part The function used to open each part.
+ * @param userdata The userdata passed to @p open_part.
+ * @param mode Contains the standard IO device mode specifiers (i.e. "r", "w", "rw").
+ * @return A new device allowing concatenation of the streams, or NULL if an allocation error occurred.
+ */
+IO io_open_concat_n_lazy(size_t n, ConcatOpenFn open_part, void *userdata, const char *mode);
+
 #endif // CONCAT_H
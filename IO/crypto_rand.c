@@ -6,8 +6,24 @@
 
 #include "crypto_rand.h"
 #include "../seaerror.h"
+#include "../utility.h"
 
 #include <limits.h>
+#include <string.h>
+
+#if LINUX_OS && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 25))
+#include <sys/random.h>
+#define CRYPTO_RAND_HAS_GETRANDOM
+#endif
+
+#if IS_POSIX_COMPLIANT_OS
+#include <pthread.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CRYPTO_RAND_COMPILE_SUPPORTS_SSE2
+#endif
 
 #if WINDOWS_OS
 #include <windows.h>
@@ -108,3 +124,320 @@ IO io_open_crypto_rand() {
     return io_open("/dev/urandom", "rb");
 }
 #endif
+
+/* Number of 64-byte ChaCha20 blocks generated per refill of the fast generator's keystream buffer. Must be a multiple of 4 */
+#define CRYPTO_RAND_FAST_BLOCKS 64
+
+#if CRYPTO_RAND_FAST_BLOCKS % 4
+# error "CRYPTO_RAND_FAST_BLOCKS must be a multiple of 4"
+#endif
+
+/* Number of bytes the fast generator outputs before it is reseeded from the system generator */
+#define CRYPTO_RAND_FAST_RESEED_INTERVAL (1024 * 1024)
+
+/** @brief Stores the state of the fast generator for one thread
+ *
+ * The generator is a fast-key-erasure ChaCha20 DRBG: each refill generates `CRYPTO_RAND_FAST_BLOCKS` blocks of keystream,
+ * and the first 32 bytes of the result immediately replace the key, so earlier output cannot be recovered from the current state.
+ * Output bytes are erased from the buffer as they are consumed.
+ */
+struct CryptoRandFast {
+    /** The current ChaCha20 key */
+    uint32_t key[8];
+
+    /** Number of unread bytes at the end of `buffer` */
+    size_t available;
+
+    /** Number of bytes output since the last reseed */
+    size_t output;
+
+    /** Value of `crypto_rand_fork_generation` when the generator was last seeded, to detect reseeding is needed in a forked child */
+    unsigned generation;
+
+    /** Whether the generator has been seeded at all */
+    int seeded;
+
+    unsigned char buffer[CRYPTO_RAND_FAST_BLOCKS * 64];
+};
+
+/* THREAD_STATIC falls back to plain `static` before C11, but generators shared between threads would race and could repeat output,
+ * so the fast generator requires real thread-local storage */
+#if C11
+# define CRYPTO_RAND_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+# define CRYPTO_RAND_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+# define CRYPTO_RAND_THREAD_LOCAL __declspec(thread)
+#else
+# error "crypto_rand requires thread-local storage for the fast generator"
+#endif
+
+static CRYPTO_RAND_THREAD_LOCAL struct CryptoRandFast crypto_rand_fast_state;
+
+/* Incremented in the child process after every fork, so that a child never repeats its parent's output */
+static volatile unsigned crypto_rand_fork_generation;
+
+#if IS_POSIX_COMPLIANT_OS
+static pthread_once_t crypto_rand_fork_once = PTHREAD_ONCE_INIT;
+
+static void crypto_rand_fork_child(void) {
+    ++crypto_rand_fork_generation;
+}
+
+static void crypto_rand_fork_register(void) {
+    pthread_atfork(NULL, NULL, crypto_rand_fork_child);
+}
+#endif
+
+/* Fills @p buffer with @p size bytes from the operating system generator. Returns 0 on success, non-zero on failure */
+static int crypto_rand_system(unsigned char *buffer, size_t size) {
+#ifdef CRYPTO_RAND_HAS_GETRANDOM
+    while (size) {
+        ssize_t read = getrandom(buffer, size, 0);
+        if (read < 0) {
+            if (errno == EINTR)
+                continue;
+            else if (errno == ENOSYS)
+                break;
+
+            return -1;
+        }
+
+        buffer += read;
+        size -= read;
+    }
+
+    if (size == 0)
+        return 0;
+#endif
+
+    IO io = io_open_crypto_rand();
+    if (io == NULL)
+        return -1;
+
+    int result = io_read(buffer, 1, size, io) != size;
+    io_close(io);
+
+    return result;
+}
+
+#define CHACHA_ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define CHACHA_QUARTERROUND(a, b, c, d) \
+    a += b; d ^= a; d = CHACHA_ROTL(d, 16); \
+    c += d; b ^= c; b = CHACHA_ROTL(b, 12); \
+    a += b; d ^= a; d = CHACHA_ROTL(d, 8); \
+    c += d; b ^= c; b = CHACHA_ROTL(b, 7);
+
+/* Initializes a ChaCha20 state with a zero nonce, as each key is only ever used for one refill */
+static void chacha20_init(uint32_t state[16], const uint32_t key[8], uint64_t counter) {
+    state[0] = 0x61707865;
+    state[1] = 0x3320646e;
+    state[2] = 0x79622d32;
+    state[3] = 0x6b206574;
+    memcpy(state + 4, key, 32);
+    state[12] = (uint32_t) counter;
+    state[13] = (uint32_t) (counter >> 32);
+    state[14] = 0;
+    state[15] = 0;
+}
+
+#ifndef CRYPTO_RAND_COMPILE_SUPPORTS_SSE2
+/* Generates one 64-byte block of keystream */
+static void chacha20_block(const uint32_t key[8], uint64_t counter, unsigned char *out) {
+    uint32_t input[16], x[16];
+
+    chacha20_init(input, key, counter);
+    memcpy(x, input, sizeof(x));
+
+    for (size_t i = 0; i < 10; ++i) {
+        CHACHA_QUARTERROUND(x[0], x[4], x[ 8], x[12])
+        CHACHA_QUARTERROUND(x[1], x[5], x[ 9], x[13])
+        CHACHA_QUARTERROUND(x[2], x[6], x[10], x[14])
+        CHACHA_QUARTERROUND(x[3], x[7], x[11], x[15])
+        CHACHA_QUARTERROUND(x[0], x[5], x[10], x[15])
+        CHACHA_QUARTERROUND(x[1], x[6], x[11], x[12])
+        CHACHA_QUARTERROUND(x[2], x[7], x[ 8], x[13])
+        CHACHA_QUARTERROUND(x[3], x[4], x[ 9], x[14])
+    }
+
+    for (size_t i = 0; i < 16; ++i)
+        u32cpy_le(out + i*4, x[i] + input[i]);
+
+    memset(x, 0, sizeof(x));
+}
+#else
+#define CHACHA_ROTL_X4(v, n) _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - (n)))
+#define CHACHA_QUARTERROUND_X4(a, b, c, d) \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = CHACHA_ROTL_X4(d, 16); \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = CHACHA_ROTL_X4(b, 12); \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = CHACHA_ROTL_X4(d, 8); \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = CHACHA_ROTL_X4(b, 7);
+
+/* Generates four consecutive 64-byte blocks of keystream, one block per SSE2 lane */
+static void chacha20_block_x4(const uint32_t key[8], uint64_t counter, unsigned char *out) {
+    uint32_t input[16];
+    __m128i x[16], start[16];
+
+    chacha20_init(input, key, counter);
+
+    for (size_t i = 0; i < 16; ++i)
+        start[i] = _mm_set1_epi32((int) input[i]);
+
+    start[12] = _mm_set_epi32((int) (uint32_t) (counter + 3), (int) (uint32_t) (counter + 2), (int) (uint32_t) (counter + 1), (int) (uint32_t) counter);
+    start[13] = _mm_set_epi32((int) (uint32_t) ((counter + 3) >> 32), (int) (uint32_t) ((counter + 2) >> 32), (int) (uint32_t) ((counter + 1) >> 32), (int) (uint32_t) (counter >> 32));
+
+    memcpy(x, start, sizeof(x));
+
+    for (size_t i = 0; i < 10; ++i) {
+        CHACHA_QUARTERROUND_X4(x[0], x[4], x[ 8], x[12])
+        CHACHA_QUARTERROUND_X4(x[1], x[5], x[ 9], x[13])
+        CHACHA_QUARTERROUND_X4(x[2], x[6], x[10], x[14])
+        CHACHA_QUARTERROUND_X4(x[3], x[7], x[11], x[15])
+        CHACHA_QUARTERROUND_X4(x[0], x[5], x[10], x[15])
+        CHACHA_QUARTERROUND_X4(x[1], x[6], x[11], x[12])
+        CHACHA_QUARTERROUND_X4(x[2], x[7], x[ 8], x[13])
+        CHACHA_QUARTERROUND_X4(x[3], x[4], x[ 9], x[14])
+    }
+
+    /* Transpose each group of four words so every lane's block is written contiguously */
+    for (size_t i = 0; i < 16; i += 4) {
+        __m128i a = _mm_add_epi32(x[i], start[i]);
+        __m128i b = _mm_add_epi32(x[i+1], start[i+1]);
+        __m128i c = _mm_add_epi32(x[i+2], start[i+2]);
+        __m128i d = _mm_add_epi32(x[i+3], start[i+3]);
+
+        __m128i ab_lo = _mm_unpacklo_epi32(a, b);
+        __m128i cd_lo = _mm_unpacklo_epi32(c, d);
+        __m128i ab_hi = _mm_unpackhi_epi32(a, b);
+        __m128i cd_hi = _mm_unpackhi_epi32(c, d);
+
+        _mm_storeu_si128((__m128i *) (out + 0*64 + i*4), _mm_unpacklo_epi64(ab_lo, cd_lo));
+        _mm_storeu_si128((__m128i *) (out + 1*64 + i*4), _mm_unpackhi_epi64(ab_lo, cd_lo));
+        _mm_storeu_si128((__m128i *) (out + 2*64 + i*4), _mm_unpacklo_epi64(ab_hi, cd_hi));
+        _mm_storeu_si128((__m128i *) (out + 3*64 + i*4), _mm_unpackhi_epi64(ab_hi, cd_hi));
+    }
+
+    memset(x, 0, sizeof(x));
+}
+#endif
+
+/* Regenerates the keystream buffer and replaces the key with the first 32 bytes of the new keystream */
+static void crypto_rand_fast_refill(struct CryptoRandFast *state) {
+#ifdef CRYPTO_RAND_COMPILE_SUPPORTS_SSE2
+    for (size_t block = 0; block < CRYPTO_RAND_FAST_BLOCKS; block += 4)
+        chacha20_block_x4(state->key, block, state->buffer + block*64);
+#else
+    for (size_t block = 0; block < CRYPTO_RAND_FAST_BLOCKS; ++block)
+        chacha20_block(state->key, block, state->buffer + block*64);
+#endif
+
+    for (size_t i = 0; i < 8; ++i)
+        u32get_le(&state->key[i], state->buffer + i*4);
+
+    memset(state->buffer, 0, sizeof(state->key));
+    state->available = sizeof(state->buffer) - sizeof(state->key);
+}
+
+/* Mixes fresh system entropy into the key and discards any buffered keystream */
+static int crypto_rand_fast_reseed(struct CryptoRandFast *state) {
+    unsigned char seed[32];
+
+#if IS_POSIX_COMPLIANT_OS
+    pthread_once(&crypto_rand_fork_once, crypto_rand_fork_register);
+#endif
+
+    if (crypto_rand_system(seed, sizeof(seed)))
+        return CC_EREAD;
+
+    for (size_t i = 0; i < 8; ++i) {
+        uint32_t word;
+        state->key[i] ^= u32get_le(&word, seed + i*4);
+    }
+
+    memset(seed, 0, sizeof(seed));
+    memset(state->buffer, 0, sizeof(state->buffer));
+
+    state->available = 0;
+    state->output = 0;
+    state->generation = crypto_rand_fork_generation;
+    state->seeded = 1;
+
+    return 0;
+}
+
+int crypto_rand_fast(void *buffer, size_t size) {
+    struct CryptoRandFast *state = &crypto_rand_fast_state;
+    unsigned char *out = buffer;
+
+    if (!state->seeded || state->generation != crypto_rand_fork_generation) {
+        int err = crypto_rand_fast_reseed(state);
+        if (err)
+            return err;
+    }
+
+    while (size) {
+        if (state->output >= CRYPTO_RAND_FAST_RESEED_INTERVAL) {
+            int err = crypto_rand_fast_reseed(state);
+            if (err)
+                return err;
+        }
+
+        if (state->available == 0)
+            crypto_rand_fast_refill(state);
+
+        unsigned char *source = state->buffer + sizeof(state->buffer) - state->available;
+        size_t amount = MIN(size, state->available);
+
+        memcpy(out, source, amount);
+        memset(source, 0, amount);
+
+        out += amount;
+        size -= amount;
+        state->available -= amount;
+        state->output += amount;
+    }
+
+    return 0;
+}
+
+static size_t crypto_rand_fast_read(void *ptr, size_t size, size_t count, void *userdata, IO io) {
+    UNUSED(userdata)
+
+    if (size == 0 || count == 0)
+        return 0;
+
+    int err = crypto_rand_fast(ptr, size*count);
+    if (err) {
+        io_set_error(io, err);
+        return SIZE_MAX;
+    }
+
+    return count;
+}
+
+static const char *crypto_rand_fast_what(void *userdata, IO io) {
+    UNUSED(userdata)
+    UNUSED(io)
+
+    return "crypto_rand_fast";
+}
+
+static const struct InputOutputDeviceCallbacks crypto_rand_fast_callbacks = {
+    .read = crypto_rand_fast_read,
+    .write = NULL,
+    .open = NULL,
+    .close = NULL,
+    .flush = NULL,
+    .clearerr = NULL,
+    .state_switch = NULL,
+    .tell = NULL,
+    .tell64 = NULL,
+    .seek = NULL,
+    .seek64 = NULL,
+    .flags = NULL,
+    .what = crypto_rand_fast_what
+};
+
+IO io_open_crypto_rand_fast() {
+    return io_open_custom(&crypto_rand_fast_callbacks, NULL, "rb");
+}
@@ -21,6 +21,26 @@ extern "C" {
  */
 IO io_open_crypto_rand();
 
+/** @brief Opens a read-only cryptographically-secure RNG that avoids a system call per read
+ *
+ * Reads are served from a per-thread ChaCha20 generator that is seeded from the system RNG (`getrandom` on Linux, falling back to the device opened by `io_open_crypto_rand()`),
+ * reseeded after every 1 MiB of output, and reseeded automatically in a child process after `fork`. The key is replaced after every refill of the generator's buffer,
+ * and output is erased from the buffer once read, so compromise of the generator state does not reveal earlier output.
+ *
+ * Since the generator state belongs to the calling thread, the device may be shared between threads, and never needs seeding.
+ *
+ * @return A new read-only secure RNG device, or `NULL` if an error occured.
+ */
+IO io_open_crypto_rand_fast();
+
+/** @brief Fills @p buffer with @p size bytes from the same per-thread generator as `io_open_crypto_rand_fast()`, without the overhead of an IO device
+ *
+ * @param buffer The location to store the random bytes in.
+ * @param size The number of bytes to generate.
+ * @return 0 on success, or an error code if the generator could not be seeded.
+ */
+int crypto_rand_fast(void *buffer, size_t size);
+
 #ifdef __cplusplus
 }
 #endif
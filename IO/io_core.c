@@ -5391,6 +5391,217 @@ size_t io_write(const void *ptr, size_t size, size_t count, IO io) {
     return io_unlockz(io, result);
 }
 
+#if WINDOWS_OS
+/* ReadFile() and WriteFile() with an offset still move the file pointer of handles not opened for overlapped IO,
+ * so positional transfers save and restore the pointer, and are serialized so they don't restore each other's pointers */
+static Spinlock io_native_positional_lock;
+#endif
+
+/* Positional transfer on a native file handle, without using or moving the file position. Returns the number of bytes transferred, or SIZE_MAX on error */
+static size_t io_native_positional(IONativeFileHandle native, void *ptr, size_t size, long long offset, int writing, IO io) {
+    unsigned char *cptr = ptr;
+    size_t total = 0;
+
+    while (total < size) {
+#if IS_POSIX_COMPLIANT_OS
+        size_t amount = size - total > SSIZE_MAX? SSIZE_MAX: size - total;
+        ssize_t result = writing? pwrite(native, cptr + total, amount, (off_t) (offset + total)):
+                                  pread(native, cptr + total, amount, (off_t) (offset + total));
+
+        if (result < 0) {
+            if (errno == EINTR)
+                continue;
+
+            io_set_error(io, errno);
+            return SIZE_MAX;
+        } else if (result == 0)
+            break;
+#elif WINDOWS_OS
+        DWORD amount = size - total > 0xffffffffu? 0xffffffffu: (DWORD) (size - total);
+        DWORD result = 0;
+        OVERLAPPED overlapped;
+        unsigned long long position = offset + total;
+
+        LARGE_INTEGER zero, saved;
+        DWORD error = 0;
+
+        memset(&overlapped, 0, sizeof(overlapped));
+        overlapped.Offset = (DWORD) position;
+        overlapped.OffsetHigh = (DWORD) (position >> 32);
+        zero.QuadPart = 0;
+
+        spinlock_lock(&io_native_positional_lock);
+
+        const BOOL restore = SetFilePointerEx(native, zero, &saved, FILE_CURRENT);
+        BOOL success = writing? WriteFile(native, cptr + total, amount, &result, &overlapped):
+                                ReadFile(native, cptr + total, amount, &result, &overlapped);
+
+        /* Handles opened for overlapped IO complete asynchronously */
+        if (!success && GetLastError() == ERROR_IO_PENDING)
+            success = GetOverlappedResult(native, &overlapped, &result, TRUE);
+
+        if (!success)
+            error = GetLastError();
+
+        if (restore)
+            SetFilePointerEx(native, saved, NULL, FILE_BEGIN);
+
+        spinlock_unlock(&io_native_positional_lock);
+
+        if (!success) {
+            if (error == ERROR_HANDLE_EOF)
+                break;
+
+            io_set_error(io, error);
+            return SIZE_MAX;
+        } else if (result == 0)
+            break;
+#else
+        UNUSED(native)
+        UNUSED(cptr)
+        UNUSED(offset)
+        UNUSED(writing)
+
+        io_set_error(io, CC_ENOTSUP);
+        return SIZE_MAX;
+#endif
+
+        total += result;
+    }
+
+    return total;
+}
+
+#if IS_POSIX_COMPLIANT_OS
+#define io_file_native_handle(file) fileno(file)
+#elif WINDOWS_OS
+#define io_file_native_handle(file) ((HANDLE) _get_osfhandle(_fileno(file)))
+#else
+#define io_file_native_handle(file) 0
+#endif
+
+size_t io_pread(IO io, void *ptr, size_t size, long long offset) {
+    if (offset < 0) {
+        io_set_error(io, CC_EINVAL);
+        return 0;
+    } else if (!(io->flags & IO_FLAG_READABLE)) {
+        io_set_error(io, CC_EREAD);
+        return 0;
+    } else if (size == 0)
+        return 0;
+
+    size_t result;
+
+    switch (io->type) {
+        default: io_set_error(io, CC_ENOTSUP); return 0;
+        case IO_File:
+        case IO_OwnFile:
+            result = io_native_positional(io_file_native_handle(io->data.file.fptr), ptr, size, offset, 0, io);
+            break;
+        case IO_NativeFile:
+        case IO_OwnNativeFile:
+            result = io_native_positional(io->data.native_file.native, ptr, size, offset, 0, io);
+            break;
+        case IO_SizedBuffer:
+            if ((unsigned long long) offset >= io->data.sized_buffer.buffer_size)
+                return 0;
+
+            result = MIN(size, io->data.sized_buffer.buffer_size - (size_t) offset);
+            memcpy(ptr, io->data.sized_buffer.buffer + offset, result);
+            break;
+        case IO_DynamicBuffer:
+            if ((unsigned long long) offset >= io->data.dynamic_buffer.buffer_size)
+                return 0;
+
+            result = MIN(size, io->data.dynamic_buffer.buffer_size - (size_t) offset);
+            memcpy(ptr, io->data.dynamic_buffer.buffer + offset, result);
+            break;
+        case IO_Custom:
+            if (io->data.custom.callbacks->pread == NULL) {
+                io_set_error(io, CC_ENOTSUP);
+                return 0;
+            }
+
+            result = io->data.custom.callbacks->pread(ptr, size, offset, io->data.custom.ptr, io);
+            if (result == SIZE_MAX && !io_error_internal(io))
+                io_set_error(io, CC_EREAD);
+
+            break;
+    }
+
+    return result == SIZE_MAX? 0: result;
+}
+
+size_t io_pwrite(IO io, const void *ptr, size_t size, long long offset) {
+    if (offset < 0) {
+        io_set_error(io, CC_EINVAL);
+        return 0;
+    } else if (!(io->flags & IO_FLAG_WRITABLE)) {
+        io_set_error(io, CC_EWRITE);
+        return 0;
+    } else if (size == 0)
+        return 0;
+
+    size_t result;
+
+    switch (io->type) {
+        default: io_set_error(io, CC_ENOTSUP); return 0;
+        case IO_File:
+        case IO_OwnFile:
+            result = io_native_positional(io_file_native_handle(io->data.file.fptr), (void *) ptr, size, offset, 1, io);
+            break;
+        case IO_NativeFile:
+        case IO_OwnNativeFile:
+            result = io_native_positional(io->data.native_file.native, (void *) ptr, size, offset, 1, io);
+            break;
+        case IO_SizedBuffer:
+            if ((unsigned long long) offset >= io->data.sized_buffer.buffer_size)
+                result = 0;
+            else {
+                result = MIN(size, io->data.sized_buffer.buffer_size - (size_t) offset);
+                memcpy(io->data.sized_buffer.buffer + offset, ptr, result);
+            }
+
+            if (result < size)
+                io_set_error(io, CC_ENOBUFS);
+            break;
+        case IO_DynamicBuffer: {
+            if ((unsigned long long) offset > SIZE_MAX - size) {
+                io_set_error(io, CC_ENOMEM);
+                return 0;
+            }
+
+            size_t end = (size_t) offset + size;
+            if (io_grow_dynamic(io, end)) {
+                io_set_error(io, CC_ENOMEM);
+                return 0;
+            }
+
+            /* Writing past the end leaves no uninitialized gap */
+            if ((size_t) offset > io->data.dynamic_buffer.buffer_size)
+                memset(io->data.dynamic_buffer.buffer + io->data.dynamic_buffer.buffer_size, 0, (size_t) offset - io->data.dynamic_buffer.buffer_size);
+
+            memcpy(io->data.dynamic_buffer.buffer + offset, ptr, size);
+            io->data.dynamic_buffer.buffer_size = MAX(io->data.dynamic_buffer.buffer_size, end);
+            result = size;
+            break;
+        }
+        case IO_Custom:
+            if (io->data.custom.callbacks->pwrite == NULL) {
+                io_set_error(io, CC_ENOTSUP);
+                return 0;
+            }
+
+            result = io->data.custom.callbacks->pwrite(ptr, size, offset, io->data.custom.ptr, io);
+            if (result == SIZE_MAX && !io_error_internal(io))
+                io_set_error(io, CC_EWRITE);
+
+            break;
+    }
+
+    return result == SIZE_MAX? 0: result;
+}
+
 void io_rewind(IO io) {
     io_lock(io);
 
@@ -270,6 +270,33 @@ struct InputOutputDeviceCallbacks {
      * @return A machine-friendly string identifying the type of the IO device.
      */
     const char *(*what)(void *userdata, IO io);
+
+    /** @brief Reads data at a specific position without using or changing the current position of the device.
+     *
+     * This callback may be called from multiple threads at once, and concurrently with other callbacks, so must not modify any shared state.
+     * The callback may set the `io` parameter's error code with `io_set_error()`.
+     *
+     * @param ptr The buffer to read into.
+     * @param size The number of bytes to read.
+     * @param offset The position of the device to start reading from.
+     * @param userdata The userdata stored in @p io.
+     * @param io The IO device being read from.
+     * @return The number of bytes read, which is only less than @p size if the end of the device was reached, or `SIZE_MAX` if an error occurred.
+     */
+    size_t (*pread)(void *ptr, size_t size, long long offset, void *userdata, IO io);
+
+    /** @brief Writes data at a specific position without using or changing the current position of the device.
+     *
+     * The same restrictions as for `pread` apply.
+     *
+     * @param ptr The buffer to write from.
+     * @param size The number of bytes to write.
+     * @param offset The position of the device to start writing at.
+     * @param userdata The userdata stored in @p io.
+     * @param io The IO device being written to.
+     * @return The number of bytes written, or `SIZE_MAX` if an error occurred. If fewer than @p size bytes are written, the callback must set an error.
+     */
+    size_t (*pwrite)(const void *ptr, size_t size, long long offset, void *userdata, IO io);
 };
 
 /* Whether IO device is readable or not */
@@ -912,6 +939,40 @@ long int io_size(IO io);
 long long int io_size64(IO io);
 size_t io_write(const void *ptr, size_t size, size_t count, IO io);
 void io_rewind(IO io);
+
+/** @brief Reads a block of data from a specific position of an IO device, without using or changing the current position.
+ *
+ * Positional reads on the same device may be performed from multiple threads at once, and do not discard any read buffer of the device.
+ * The data is read directly from the underlying file or memory, so text-mode translation, the unget buffer, and data buffered but not yet flushed
+ * by `io_write()` are ignored. Native files map to `pread()` (or `ReadFile()` with an offset on Windows), sized and dynamic buffers copy from memory,
+ * and custom devices use their `pread` callback.
+ *
+ * On Windows, files not opened for overlapped IO move their file pointer during the transfer, and it is restored afterward,
+ * so positional transfers on such files must not run concurrently with sequential IO on the same file.
+ *
+ * Unlike `io_read()`, the EOF flag is never set. A failure sets the error of the device, which is the only state shared between positional operations.
+ *
+ * @param io The IO device that is being read from.
+ * @param ptr The destination buffer to write to.
+ * @param size The number of bytes to read.
+ * @param offset The position in @p io to start reading from.
+ * @return The number of bytes read. If less than @p size, either the end of the device was reached or an error occurred.
+ */
+size_t io_pread(IO io, void *ptr, size_t size, long long offset);
+
+/** @brief Writes a block of data to a specific position of an IO device, without using or changing the current position.
+ *
+ * The same rules as for `io_pread()` apply. Writing to a dynamic buffer may grow the buffer, and is therefore not thread-safe unless the buffer is
+ * already large enough. Writing past the end of a sized buffer fails with `CC_ENOBUFS`.
+ *
+ * @param io The IO device that is being written to.
+ * @param ptr The source buffer to write from.
+ * @param size The number of bytes to write.
+ * @param offset The position in @p io to start writing at.
+ * @return The number of bytes written. If less than @p size, an error occurred.
+ */
+size_t io_pwrite(IO io, const void *ptr, size_t size, long long offset);
+
 void io_setbuf(IO io, char *buf);
 int io_setvbuf(IO io, char *buf, int mode, size_t size);
 enum IO_Type io_type(IO io);
@@ -1081,6 +1142,10 @@ public:
     size_t read(char *buffer, size_t max) {
         return m_io? io_read(buffer, 1, max, m_io): 0;
     }
+    /* Attempts to read `max` characters at `offset` into `buffer`, without using or changing the current position. Returns the number of characters read */
+    size_t readAt(char *buffer, size_t max, long long offset) {
+        return m_io? io_pread(m_io, buffer, max, offset): 0;
+    }
     /* Reads until EOF or newline, whichever comes first */
     /* NUL-terminates the buffer, so max must be greater than 0. Returns the number of characters read, including the newline
      * The newline character is included in the output
@@ -1207,6 +1272,10 @@ public:
     bool write(const std::string &str) {
         return putString(str);
     }
+    /* Writes a string at `offset`, without using or changing the current position. Returns true on success, false on failure */
+    bool writeAt(const char *str, size_t len, long long offset) {
+        return m_io? io_pwrite(m_io, str, len, offset) == len: false;
+    }
 
     bool putInt(signed char i) {
         return printf("%hhd", i) >= 0;
@@ -57,6 +57,43 @@ static size_t limiter_write(const void *buf, size_t size, size_t count, void *us
     return written;
 }
 
+static size_t limiter_pread(void *buf, size_t size, long long offset, void *userdata, IO io) {
+    struct Limiter *limiter = userdata;
+
+    if (offset >= limiter->length)
+        return 0;
+
+    if ((unsigned long long) (limiter->length - offset) < size)
+        size = (size_t) (limiter->length - offset);
+
+    size_t read = io_pread(limiter->io, buf, size, limiter->offset + offset);
+    if (read < size && io_error(limiter->io)) {
+        io_set_error(io, io_error(limiter->io));
+        return SIZE_MAX;
+    }
+
+    return read;
+}
+
+static size_t limiter_pwrite(const void *buf, size_t size, long long offset, void *userdata, IO io) {
+    struct Limiter *limiter = userdata;
+    size_t max = size;
+
+    if (offset >= limiter->length)
+        max = 0;
+    else if ((unsigned long long) (limiter->length - offset) < size)
+        max = (size_t) (limiter->length - offset);
+
+    size_t written = max? io_pwrite(limiter->io, buf, max, limiter->offset + offset): 0;
+    if (written < max) {
+        io_set_error(io, io_error(limiter->io));
+        return SIZE_MAX;
+    } else if (written < size)
+        io_set_error(io, CC_ENOBUFS);
+
+    return written;
+}
+
 static int limiter_close(void *userdata, IO io) {
     UNUSED(io)
 
@@ -145,7 +182,9 @@ static const struct InputOutputDeviceCallbacks limiter_callbacks = {
     .seek = NULL,
     .seek64 = limiter_seek64,
     .flags = NULL,
-    .what = limiter_what
+    .what = limiter_what,
+    .pread = limiter_pread,
+    .pwrite = limiter_pwrite
 };
 
 IO io_open_limiter(IO io, long long offset, long long length, const char *mode) {
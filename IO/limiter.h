@@ -12,6 +12,7 @@
 /** @brief Opens a device to limit IO to a specific subset of another device.
  *
  * This device is useful to limit the amount of data read from the middle of another stream.
+ * `io_pread()` and `io_pwrite()` are supported if @p io supports them, and are clamped to the limited region.
  *
  * @param io The IO device to read from or write to.
  * @param offset The offset of @p io to start reading from or writing to.
@@ -14,27 +14,48 @@ struct BitPadding {
     IO io;
     size_t block_size;
     uint64_t written;
-    int wrote_80;
+
+    /* Total padding length (including the 0x80 marker), or 0 if padding has not started yet, and the amount of padding already read */
+    uint64_t pad_length;
+    uint64_t pad_done;
 };
 
+/* Fills `ptr` with `size` bytes of bit padding, starting at offset `offset` into a padding run */
+static void bit_padding_fill(unsigned char *ptr, size_t size, uint64_t offset) {
+    if (size == 0)
+        return;
+
+    if (offset == 0) {
+        *ptr++ = 0x80;
+        --size;
+    }
+
+    memset(ptr, 0, size);
+}
+
 int bit_padding_encode_close(void *userdata, IO io) {
     UNUSED(io)
 
     struct BitPadding *padding = userdata;
     int err = 0;
 
-    if (io_just_wrote(io) && padding->written % padding->block_size != 0) {
-        if (io_putc(0x80, padding->io) == EOF)
-            err = io_error(padding->io);
+    /* A device opened for writing always ends with padding, even if nothing was written */
+    if (io_writable(io) && !io_just_read(io)) {
+        unsigned char pad[256];
+        uint64_t rest = padding->block_size - padding->written % padding->block_size;
 
-        padding->written += 1;
-        size_t rest = padding->written % padding->block_size;
+        /* Write the padding in as few pieces as possible */
+        for (uint64_t done = 0; done < rest; ) {
+            size_t amount = (size_t) MIN(rest - done, sizeof(pad));
 
-        for (size_t i = 0; i < rest; ++i)
-            if (io_putc(0, padding->io) == EOF) {
+            bit_padding_fill(pad, amount, done);
+            if (io_write(pad, 1, amount, padding->io) != amount) {
                 err = io_error(padding->io);
                 break;
             }
+
+            done += amount;
+        }
     }
 
     FREE(userdata);
@@ -46,38 +67,22 @@ size_t bit_padding_encode_read(void *ptr, size_t size, size_t count, void *userd
     struct BitPadding *padding = userdata;
 
     size_t max = size*count;
-    size_t read = io_read(ptr, 1, max, padding->io);
+    size_t read = padding->pad_length? 0: io_read(ptr, 1, max, padding->io);
 
     padding->written += read;
 
     if (io_error(padding->io)) {
         io_set_error(io, io_error(padding->io));
         return read;
-    } else if (read == max) /* Read everything */
-        ;
-    else if (io_eof(padding->io)) { /* Ran out of data while reading */
-        unsigned char *cptr = ptr;
-
-        cptr += read;
-        max -= read;
-
-        if (!padding->wrote_80) {
-            padding->wrote_80 = 1;
+    } else if (padding->pad_length || io_eof(padding->io)) { /* Ran out of data while reading, so pad with the rest */
+        if (padding->pad_length == 0)
+            padding->pad_length = padding->block_size - padding->written % padding->block_size;
 
-            *cptr++ = 0x80; /* Pad 0x80 since we know there needs to be at least one pad char */
-            padding->written += 1;
-            read += 1;
-            max -= 1;
-        }
-
-        size_t more = padding->written % padding->block_size;
-        more = more > max? max: more;
+        size_t more = (size_t) MIN(max - read, padding->pad_length - padding->pad_done);
 
-        if (more) { /* Pad any remaining zeros necessary */
-            memset(cptr, 0, more);
-            padding->written += more;
-            read += more;
-        }
+        bit_padding_fill((unsigned char *) ptr + read, more, padding->pad_done);
+        padding->pad_done += more;
+        read += more;
     }
 
     return read / size;
@@ -88,8 +93,8 @@ size_t bit_padding_encode_write(const void *ptr, size_t size, size_t count, void
 
     size_t written = io_write(ptr, size, count, padding->io);
 
-    if (written == size*count)
-        padding->written += written;
+    if (written == count)
+        padding->written += size*count;
     else
         io_set_error(io, io_error(padding->io));
 
@@ -4,7 +4,7 @@
  *  @copyright Copyright (C) 2019
  */
 
-#include "bit.h"
+#include "pkcs7.h"
 #include "../../seaerror.h"
 
 #include <string.h>
@@ -15,32 +15,60 @@
 struct Pkcs7Padding {
     IO io;
     size_t block_size;
-    int pad_value;
     uint64_t written;
+
+    /* Total padding length, or 0 if padding has not started yet, and the amount of padding already read */
+    size_t pad_length;
+    size_t pad_done;
 };
 
 struct Pkcs7PaddingDecode {
     IO io;
     size_t block_size;
 
-    unsigned char buffer[256];
-    size_t buffer_avail; /* Number of bytes left available to read from buffer */
+    /* When writing, the last block written (`block_avail` bytes), which is only forwarded once more data arrives since it may be the padded final block.
+     * When reading, the last full block read (if `block_avail` is non-zero), which is only released once more data is known to follow */
+    unsigned char block[255];
+    size_t block_avail;
+
+    /* Unpadded bytes ready to be read, starting at `buffer + buffer_pos` */
+    unsigned char buffer[255];
+    size_t buffer_pos;
+    size_t buffer_avail;
+
+    /* Whether the final block has been read */
+    int finished;
 };
 
+/* Checks the PKCS #7 padding of the final block. Returns the number of unpadded bytes in the block, or SIZE_MAX if the padding is invalid */
+static size_t pkcs7_padding_unpadded_size(const unsigned char *block, size_t block_size) {
+    unsigned pad_value = block[block_size - 1];
+
+    if (pad_value == 0 || pad_value > block_size) /* Bad padding, specifies value greater than block size */
+        return SIZE_MAX;
+
+    /* Ensure that all padding actually is set to the correct value */
+    for (size_t i = block_size - pad_value; i < block_size; ++i)
+        if (block[i] != pad_value)
+            return SIZE_MAX;
+
+    return block_size - pad_value;
+}
+
 int pkcs7_padding_encode_close(void *userdata, IO io) {
     UNUSED(io)
 
     struct Pkcs7Padding *padding = userdata;
     int err = 0;
 
-    if (io_just_wrote(io) && padding->written % padding->block_size != 0) {
+    /* A device opened for writing always ends with padding, even if nothing was written */
+    if (io_writable(io) && !io_just_read(io)) {
+        unsigned char pad[255];
         size_t rest = padding->block_size - padding->written % padding->block_size;
 
-        for (size_t i = 0; i < rest; ++i)
-            if (io_putc((int) rest, padding->io) == EOF) {
-                err = io_error(padding->io);
-                break;
-            }
+        memset(pad, (int) rest, rest);
+        if (io_write(pad, 1, rest, padding->io) != rest)
+            err = io_error(padding->io);
     }
 
     FREE(userdata);
@@ -54,27 +82,13 @@ int pkcs7_padding_decode_close(void *userdata, IO io) {
     struct Pkcs7PaddingDecode *padding = userdata;
     int err = 0;
 
-    if (io_just_wrote(io) && padding->buffer_avail) {
-        unsigned padding_char = padding->buffer[padding->buffer_avail - 1];
+    if (io_writable(io) && !io_just_read(io) && padding->block_avail) {
+        size_t unpadded = padding->block_avail == padding->block_size? pkcs7_padding_unpadded_size(padding->block, padding->block_size): SIZE_MAX;
 
-        if (padding_char > padding->buffer_avail ||
-                padding->buffer_avail != padding->block_size) /* Bad padding, specifies value greater than block size */
+        if (unpadded == SIZE_MAX)
             err = CC_EBADMSG;
-
-        if (!err) {
-            /* Ensure that all padding actually is set to the correct value */
-            for (size_t i = padding->buffer_avail - padding_char; i < padding->buffer_avail; ++i)
-                if (padding->buffer[i] != padding_char) {
-                    err = CC_EBADMSG;
-                    break;
-                }
-
-            padding->buffer_avail -= padding_char;
-
-            if (io_write(padding->buffer, 1, padding->buffer_avail, padding->io) != padding->buffer_avail) {
-                err = io_error(padding->io);
-            }
-        }
+        else if (io_write(padding->block, 1, unpadded, padding->io) != unpadded)
+            err = io_error(padding->io);
     }
 
     FREE(userdata);
@@ -86,102 +100,129 @@ size_t pkcs7_padding_encode_read(void *ptr, size_t size, size_t count, void *use
     struct Pkcs7Padding *padding = userdata;
 
     size_t max = size*count;
-    size_t read = io_read(ptr, 1, max, padding->io);
+    size_t read = padding->pad_length? 0: io_read(ptr, 1, max, padding->io);
 
     padding->written += read;
 
     if (io_error(padding->io)) {
         io_set_error(io, io_error(padding->io));
         return read;
-    } else if (read == max) /* Read everything */
-        ;
-    else if (io_eof(padding->io)) { /* Ran out of data while reading */
-        unsigned char *cptr = ptr;
-
-        cptr += read;
-        max -= read;
-
-        size_t more = padding->written % padding->block_size;
-        if (padding->pad_value < 0) {
-            more = padding->block_size - padding->written % padding->block_size;
-            padding->pad_value = (int) more;
-        }
+    } else if (padding->pad_length || io_eof(padding->io)) { /* Ran out of data while reading, so pad with the rest */
+        if (padding->pad_length == 0)
+            padding->pad_length = padding->block_size - padding->written % padding->block_size;
 
-        more = more > max? max: more;
+        size_t more = MIN(max - read, padding->pad_length - padding->pad_done);
 
-        if (more) { /* Pad any remaining values necessary */
-            memset(cptr, padding->pad_value, more);
-            padding->written += more;
-            read += more;
-        }
+        memset((unsigned char *) ptr + read, (int) padding->pad_length, more);
+        padding->pad_done += more;
+        read += more;
     }
 
     return read / size;
 }
 
-size_t pkcs7_padding_decode_read(void *ptr, size_t size, size_t count, void *userdata, IO io) {
-    UNUSED(io)
+/* Validates the held final block and makes its unpadded contents available to read */
+static int pkcs7_padding_decode_finish(struct Pkcs7PaddingDecode *padding) {
+    size_t unpadded = pkcs7_padding_unpadded_size(padding->block, padding->block_size);
+    if (unpadded == SIZE_MAX)
+        return CC_EBADMSG;
 
+    memcpy(padding->buffer, padding->block, unpadded);
+    padding->buffer_pos = 0;
+    padding->buffer_avail = unpadded;
+    padding->block_avail = 0;
+    padding->finished = 1;
+
+    return 0;
+}
+
+size_t pkcs7_padding_decode_read(void *ptr, size_t size, size_t count, void *userdata, IO io) {
     struct Pkcs7PaddingDecode *padding = userdata;
 
+    const size_t block_size = padding->block_size;
     size_t max = size*count;
     unsigned char *cptr = ptr;
 
-    do {
+    while (max) {
         /* Read from existing internal buffer to specified external buffer */
-        if (padding->buffer_avail >= max) {
-            memcpy(cptr, padding->buffer + padding->block_size - padding->buffer_avail, max);
-            padding->buffer_avail -= max;
-            return count;
-        } else if (padding->buffer_avail) {
-            memcpy(cptr, padding->buffer + padding->block_size - padding->buffer_avail, padding->buffer_avail);
-            max -= padding->buffer_avail;
-            cptr += padding->buffer_avail;
-            padding->buffer_avail = 0;
-        }
+        if (padding->buffer_avail) {
+            size_t amount = MIN(max, padding->buffer_avail);
+
+            memcpy(cptr, padding->buffer + padding->buffer_pos, amount);
+            padding->buffer_pos += amount;
+            padding->buffer_avail -= amount;
+            cptr += amount;
+            max -= amount;
+            continue;
+        } else if (padding->finished)
+            break;
+
+        if (padding->block_avail && max >= 2*block_size) {
+            /* Release the held block, then read whole blocks straight into the destination, holding back the last one again */
+            size_t span = (max - block_size) / block_size * block_size;
+            size_t read = io_read(cptr + block_size, 1, span, padding->io);
+
+            if (read != span && io_error(padding->io)) {
+                io_set_error(io, io_error(padding->io));
+                return SIZE_MAX;
+            } else if (read % block_size) { /* Truncated input */
+                io_set_error(io, CC_EBADMSG);
+                return SIZE_MAX;
+            }
 
-        /* Pump data from input to internal buffer */
-        size_t read = io_read(padding->buffer, 1, padding->block_size + 1, padding->io);
+            memcpy(cptr, padding->block, block_size);
 
-        if (read == padding->block_size + 1) {
-            if (io_ungetc(padding->buffer[padding->block_size], padding->io) == EOF) {
-                io_set_error(io, CC_EREAD);
-                return SIZE_MAX;
+            if (read) {
+                memcpy(padding->block, cptr + read, block_size);
+                cptr += read;
+                max -= read;
+            }
+
+            if (read != span) {
+                int err = pkcs7_padding_decode_finish(padding);
+                if (err) {
+                    io_set_error(io, err);
+                    return SIZE_MAX;
+                }
             }
 
-            padding->buffer_avail = padding->block_size;
-        } else if (io_error(padding->io)) {
+            continue;
+        }
+
+        /* Pump one block from input, to determine whether the held block (if any) is the final one */
+        unsigned char next[255];
+        size_t read = io_read(next, 1, block_size, padding->io);
+
+        if (read != block_size && io_error(padding->io)) {
             io_set_error(io, io_error(padding->io));
-            return read;
-        } else if (read < padding->block_size) {
-            if (read == 0)
+            return SIZE_MAX;
+        } else if (read == 0) {
+            if (padding->block_avail == 0) { /* Empty input */
+                padding->finished = 1;
                 break;
+            }
 
-            io_set_error(io, CC_EREAD);
+            int err = pkcs7_padding_decode_finish(padding);
+            if (err) {
+                io_set_error(io, err);
+                return SIZE_MAX;
+            }
+        } else if (read != block_size) { /* Truncated input */
+            io_set_error(io, CC_EBADMSG);
             return SIZE_MAX;
-        } else /* read == padding->block_size, no error */ {
-            unsigned char pad_value = padding->buffer[padding->block_size - 1];
-            int i = 0, pos;
-
-            if (pad_value > padding->block_size) /* Bad padding, specifies value greater than block size */
-                goto cleanup;
-
-            /* Ensure that all padding actually is set to the correct value */
-            for (pos = (int) padding->block_size - 1; i < pad_value; ++i, --pos) {
-                if (padding->buffer[pos] != pad_value)
-                    goto cleanup;
+        } else {
+            if (padding->block_avail) {
+                memcpy(padding->buffer, padding->block, block_size);
+                padding->buffer_pos = 0;
+                padding->buffer_avail = block_size;
             }
 
-            memmove(padding->buffer + pad_value, padding->buffer, padding->block_size - pad_value);
-            padding->buffer_avail = padding->block_size - pad_value;
+            memcpy(padding->block, next, block_size);
+            padding->block_avail = block_size;
         }
-    } while (max);
+    }
 
     return (size*count - max) / size;
-
-cleanup:
-    io_set_error(io, CC_EREAD);
-    return SIZE_MAX;
 }
 
 size_t pkcs7_padding_encode_write(const void *ptr, size_t size, size_t count, void *userdata, IO io) {
@@ -189,8 +230,8 @@ size_t pkcs7_padding_encode_write(const void *ptr, size_t size, size_t count, vo
 
     size_t written = io_write(ptr, size, count, padding->io);
 
-    if (written == size*count)
-        padding->written += written;
+    if (written == count)
+        padding->written += size*count;
     else
         io_set_error(io, io_error(padding->io));
 
@@ -200,28 +241,31 @@ size_t pkcs7_padding_encode_write(const void *ptr, size_t size, size_t count, vo
 size_t pkcs7_padding_decode_write(const void *ptr, size_t size, size_t count, void *userdata, IO io) {
     struct Pkcs7PaddingDecode *padding = userdata;
 
-    size_t max = size*count, written = 0;
+    const size_t block_size = padding->block_size;
+    size_t max = size*count;
     const unsigned char *cptr = ptr;
 
-    while (max) {
-        if (padding->buffer_avail == padding->block_size) { /* Only flush block if there is guaranteed to be more data coming */
-            size_t wrote = io_write(padding->buffer, 1, padding->block_size, padding->io);
-            written += wrote;
-            if (wrote != padding->block_size) {
-                io_set_error(io, io_error(padding->io));
-                return written / size;
-            }
-            padding->buffer_avail = 0;
-        }
+    /* Everything except the last (possibly partial) block of the combined held and new data is guaranteed not to be the final block */
+    size_t total = padding->block_avail + max;
+    size_t forward = total? (total - 1) / block_size * block_size: 0;
+
+    if (forward) {
+        size_t direct = forward - padding->block_avail;
 
-        size_t amount_added = MIN(max, padding->block_size - padding->buffer_avail);
-        memcpy(padding->buffer + padding->buffer_avail, cptr, amount_added);
+        if ((padding->block_avail && io_write(padding->block, 1, padding->block_avail, padding->io) != padding->block_avail) ||
+                io_write(cptr, 1, direct, padding->io) != direct) {
+            io_set_error(io, io_error(padding->io));
+            return 0;
+        }
 
-        padding->buffer_avail += amount_added;
-        cptr += amount_added;
-        max -= amount_added;
+        padding->block_avail = 0;
+        cptr += direct;
+        max -= direct;
     }
 
+    memcpy(padding->block + padding->block_avail, cptr, max);
+    padding->block_avail += max;
+
     return count;
 }
 
@@ -321,7 +365,6 @@ IO io_open_pkcs7_padding_encode(IO io, size_t block_size, const char *mode) {
 
     padding->io = io;
     padding->block_size = block_size? block_size: 1;
-    padding->pad_value = -1;
 
     return result;
 }
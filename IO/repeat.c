@@ -6,27 +6,122 @@
 
 #include "repeat.h"
 #include "../seaerror.h"
+#include "../utility.h"
 
 #include <string.h>
 
+/* Minimum size of the cached block the pattern is expanded into, so short patterns are copied in large runs */
+#define REPEAT_BLOCK_SIZE 4096
+
+struct Repeat {
+    IO io;
+
+    /* The pattern expanded to a whole number of repetitions of at least REPEAT_BLOCK_SIZE bytes, or NULL if the pattern is streamed from `io` */
+    unsigned char *block;
+    size_t block_size;
+
+    /* Length of one repetition of the pattern, or 0 if unknown (when streaming) */
+    size_t length;
+
+    /* Offset of the next byte in the current repetition of the pattern */
+    size_t pos;
+
+    /* Number of bytes read from the device */
+    long long position;
+
+    /* Offset in the pattern that position 0 of the device corresponds to */
+    long long origin;
+};
+
+/* Reads the entire underlying device into memory if it is no longer than REPEAT_CACHE_LIMIT, and positions the device at the same point in the pattern */
+static int repeat_cache(struct Repeat *repeat) {
+    long long start = repeat->origin;
+    if (io_seek64(repeat->io, 0, SEEK_SET))
+        return -1;
+
+    unsigned char *pattern = MALLOC(REPEAT_CACHE_LIMIT + 1);
+    if (pattern == NULL)
+        goto restore;
+
+    size_t length = io_read(pattern, 1, REPEAT_CACHE_LIMIT + 1, repeat->io);
+    if (length > REPEAT_CACHE_LIMIT || io_error(repeat->io) || length == 0 || (unsigned long long) start > length) {
+        FREE(pattern);
+        goto restore;
+    }
+
+    /* Expand to a whole number of repetitions so any rotation of the pattern can be copied from a single contiguous run */
+    size_t repetitions = length >= REPEAT_BLOCK_SIZE? 1: (REPEAT_BLOCK_SIZE + length - 1) / length;
+
+    repeat->block_size = length * repetitions;
+    repeat->block = MALLOC(repeat->block_size + length);
+    if (repeat->block == NULL) {
+        FREE(pattern);
+        goto restore;
+    }
+
+    /* One extra repetition after the block allows copying `block_size` bytes starting from any offset in the first repetition */
+    for (size_t i = 0; i <= repetitions; ++i)
+        memcpy(repeat->block + i*length, pattern, length);
+
+    FREE(pattern);
+
+    repeat->length = length;
+    repeat->pos = (size_t) start % length;
+    return 0;
+
+restore:
+    io_clearerr(repeat->io);
+    io_seek64(repeat->io, start, SEEK_SET);
+    return -1;
+}
+
+/* Fills `ptr` from the cached pattern, by copying one block and then doubling the periodic data already written */
+static void repeat_fill(struct Repeat *repeat, unsigned char *ptr, size_t max) {
+    size_t filled = MIN(max, repeat->block_size);
+
+    if (repeat->length == 1)
+        memset(ptr, repeat->block[0], max);
+    else {
+        memcpy(ptr, repeat->block + repeat->pos, filled);
+
+        while (filled < max) {
+            /* The output is periodic from its start, so any whole number of periods can be copied forward without overlap */
+            size_t period = filled - filled % repeat->length;
+            size_t amount = MIN(period, max - filled);
+
+            memcpy(ptr + filled, ptr + filled - period, amount);
+            filled += amount;
+        }
+    }
+
+    repeat->pos = (size_t) ((repeat->pos + max % repeat->length) % repeat->length);
+}
+
 static size_t repeat_read(void *ptr, size_t size, size_t count, void *userdata, IO io) {
-    IO underlyingIO = userdata;
+    struct Repeat *repeat = userdata;
     char *cptr = ptr;
     size_t max = size*count;
     size_t read;
     int at_end = 0;
 
+    if (repeat->block) {
+        repeat_fill(repeat, ptr, max);
+        repeat->position += max;
+        return count;
+    }
+
     while (1) {
-        read = io_read(cptr, 1, max, underlyingIO);
-        io_set_error(io, io_error(underlyingIO));
+        read = io_read(cptr, 1, max, repeat->io);
+        io_set_error(io, io_error(repeat->io));
 
         cptr += read;
         max -= read;
+        repeat->position += read;
 
         if (max == 0 || io_error(io) || (at_end && read == 0)) /* Everything was read, an error occurred, or the stream is empty */
             return (size*count - max) / size;
 
-        if (io_seek(underlyingIO, 0, SEEK_SET)) {
+        if (io_seek(repeat->io, 0, SEEK_SET)) {
             io_set_error(io, CC_ESPIPE);
             return (size*count - max) / size;
         }
@@ -35,6 +130,51 @@ static size_t repeat_read(void *ptr, size_t size, size_t count, void *userdata,
     }
 }
 
+static long long repeat_tell64(void *userdata, IO io) {
+    UNUSED(io)
+
+    struct Repeat *repeat = userdata;
+
+    return repeat->position;
+}
+
+static int repeat_seek64(void *userdata, long long int offset, int origin, IO io) {
+    UNUSED(io)
+
+    struct Repeat *repeat = userdata;
+
+    /* The stream is infinite, so it has no end to seek relative to */
+    switch (origin) {
+        case SEEK_END: return -1;
+        case SEEK_CUR: offset += repeat->position; break;
+    }
+
+    if (offset < 0)
+        return -1;
+
+    if (repeat->block) {
+        repeat->pos = (size_t) ((repeat->origin + offset) % (long long) repeat->length);
+    } else {
+        long long length = io_size64(repeat->io);
+        if (length <= 0 || io_seek64(repeat->io, (repeat->origin + offset) % length, SEEK_SET))
+            return -1;
+    }
+
+    repeat->position = offset;
+    return 0;
+}
+
+static int repeat_close(void *userdata, IO io) {
+    UNUSED(io)
+
+    struct Repeat *repeat = userdata;
+
+    FREE(repeat->block);
+    FREE(repeat);
+
+    return 0;
+}
+
 static const char *repeat_what(void *userdata, IO io) {
     UNUSED(userdata)
     UNUSED(io)
@@ -44,20 +184,37 @@ static const char *repeat_what(void *userdata, IO io) {
 
 static const struct InputOutputDeviceCallbacks repeat_callbacks = {
     .open = NULL,
-    .close = NULL,
+    .close = repeat_close,
     .read = repeat_read,
     .write = NULL,
     .flush = NULL,
     .clearerr = NULL,
     .state_switch = NULL,
     .seek = NULL,
-    .seek64 = NULL,
+    .seek64 = repeat_seek64,
     .tell = NULL,
-    .tell64 = NULL,
+    .tell64 = repeat_tell64,
     .flags = NULL,
     .what = repeat_what
 };
 
 IO io_open_repeat(IO io, const char *mode) {
-    return io_open_custom(&repeat_callbacks, io, mode);
+    struct Repeat *repeat = CALLOC(1, sizeof(*repeat));
+    if (repeat == NULL)
+        return NULL;
+
+    repeat->io = io;
+    repeat->origin = MAX(io_tell64(io), 0);
+
+    /* Streaming from the device remains the fallback if the pattern can't be cached */
+    repeat_cache(repeat);
+
+    IO result = io_open_custom(&repeat_callbacks, repeat, mode);
+    if (result == NULL) {
+        FREE(repeat->block);
+        FREE(repeat);
+        return NULL;
+    }
+
+    return result;
 }
@@ -9,10 +9,18 @@
 
 #include "io_core.h"
 
+/* Maximum length of a pattern that is cached in memory by `io_open_repeat()` */
+#define REPEAT_CACHE_LIMIT (1024 * 1024)
+
 /** @brief Opens a device to repeat an IO stream as an infinite stream.
  *
  * This device repeats an input IO stream endlessly, creating a never-ending stream.
  *
+ * If @p io is seekable and no longer than `REPEAT_CACHE_LIMIT` bytes, its entire contents are read into memory when the device is opened,
+ * and @p io is not used afterward. Reads are then served from memory, and seeking positions the device modulo the pattern length.
+ * Otherwise, @p io is read from and rewound as the pattern repeats, and seeking requires @p io to report its size.
+ * In both cases, reading starts at the current position of @p io.
+ *
  * @param io The IO device to read from.
  * @param mode Contains the standard IO device mode specifiers (i.e. "r", "w", "rw").
  * @return A new device allowing repeating of the IO stream, or NULL if an allocation error occurred.
@@ -5,6 +5,9 @@
  */
 
 #include "tee.h"
+#include "../seaerror.h"
+#include "../utility.h"
+
 #include <string.h>
 
 /* io_tempdata() guarantees that we'll be able to store at least two pointers, so casting tempdata to this struct is always safe */
@@ -94,3 +97,345 @@ IO io_open_tee(IO out1, IO out2, const char *mode) {
 
     return io_open_custom(&tee_callbacks, &params, mode);
 }
+
+struct TeeNParams {
+    IO *outs;
+    size_t count;
+    enum TeeMode mode;
+    size_t ring_size;
+};
+
+struct TeeBranch {
+    IO io;
+    struct TeeState *tee;
+
+    /* Worker thread, ring buffer, and synchronization objects, only present if the tee is asynchronous */
+    Thread thread;
+    Mutex mutex;
+    ConditionVariable data_ready; /* Signalled when data is added to the ring or the branch should quit */
+    ConditionVariable space_ready; /* Signalled when data is removed from the ring */
+
+    unsigned char *ring;
+    size_t head; /* Offset of the first unwritten byte in the ring */
+    size_t size; /* Number of unwritten bytes in the ring */
+    int busy; /* Whether the worker is currently writing data taken from the ring */
+    int quit;
+
+    /* First error reported by the branch, sticky until cleared with io_clearerr() on the tee */
+    int err;
+
+    /* Number of bytes discarded because the ring was full */
+    unsigned long long dropped;
+};
+
+struct TeeState {
+    enum TeeMode mode;
+    size_t ring_size;
+    size_t count;
+    struct TeeBranch branches[];
+};
+
+static int tee_worker(void *arg) {
+    struct TeeBranch *branch = arg;
+    size_t ring_size = branch->tee->ring_size;
+
+    mutex_lock(branch->mutex);
+
+    while (1) {
+        while (branch->size == 0 && !branch->quit)
+            condition_variable_sleep(&branch->data_ready, branch->mutex);
+
+        if (branch->size == 0)
+            break;
+
+        /* Write the contiguous run at the head of the ring without holding the lock, so the writer can keep filling the rest */
+        unsigned char *data = branch->ring + branch->head;
+        size_t amount = MIN(branch->size, ring_size - branch->head);
+        int err = branch->err;
+
+        branch->busy = 1;
+        mutex_unlock(branch->mutex);
+
+        if (!err && io_write(data, 1, amount, branch->io) != amount)
+            err = io_error(branch->io)? io_error(branch->io): CC_EWRITE;
+
+        mutex_lock(branch->mutex);
+        branch->busy = 0;
+        branch->err = err;
+        branch->head = (branch->head + amount) % ring_size;
+        branch->size -= amount;
+        condition_variable_wakeall(&branch->space_ready);
+    }
+
+    mutex_unlock(branch->mutex);
+
+    return 0;
+}
+
+/* Waits until the worker has written everything in the ring. Must be called with the branch's mutex held */
+static void tee_branch_drain(struct TeeBranch *branch) {
+    while (branch->size || branch->busy)
+        condition_variable_sleep(&branch->space_ready, branch->mutex);
+}
+
+static void tee_branch_push(struct TeeBranch *branch, const unsigned char *data, size_t length) {
+    size_t ring_size = branch->tee->ring_size;
+
+    mutex_lock(branch->mutex);
+
+    if (branch->tee->mode == TEE_ASYNC_DROP && !branch->err && ring_size - branch->size < length) {
+        /* Drop the whole write rather than part of it, so the branch never receives a torn record */
+        branch->dropped += length;
+        mutex_unlock(branch->mutex);
+        return;
+    }
+
+    while (length && !branch->err) {
+        while (branch->size == ring_size && !branch->err)
+            condition_variable_sleep(&branch->space_ready, branch->mutex);
+
+        size_t tail = (branch->head + branch->size) % ring_size;
+        size_t amount = MIN(length, MIN(ring_size - branch->size, ring_size - tail));
+
+        memcpy(branch->ring + tail, data, amount);
+        branch->size += amount;
+        data += amount;
+        length -= amount;
+
+        condition_variable_wake(&branch->data_ready);
+    }
+
+    mutex_unlock(branch->mutex);
+}
+
+/* Returns the first error reported by any branch, or 0 if none failed */
+static int tee_n_error(struct TeeState *state) {
+    int err = 0;
+
+    for (size_t i = 0; i < state->count && !err; ++i) {
+        struct TeeBranch *branch = &state->branches[i];
+
+        if (state->mode == TEE_SYNC) {
+            err = io_error(branch->io);
+        } else {
+            mutex_lock(branch->mutex);
+            err = branch->err;
+            mutex_unlock(branch->mutex);
+        }
+    }
+
+    return err;
+}
+
+static size_t tee_n_write(const void *ptr, size_t size, size_t count, void *userdata, IO io) {
+    struct TeeState *state = userdata;
+
+    for (size_t i = 0; i < state->count; ++i) {
+        if (state->mode == TEE_SYNC)
+            io_write(ptr, size, count, state->branches[i].io);
+        else
+            tee_branch_push(&state->branches[i], ptr, size*count);
+    }
+
+    int err = tee_n_error(state);
+    if (err) {
+        io_set_error(io, err);
+        return 0;
+    }
+
+    return count;
+}
+
+static int tee_n_flush(void *userdata, IO io) {
+    struct TeeState *state = userdata;
+
+    for (size_t i = 0; i < state->count; ++i) {
+        struct TeeBranch *branch = &state->branches[i];
+
+        if (state->mode != TEE_SYNC) {
+            mutex_lock(branch->mutex);
+            tee_branch_drain(branch);
+            mutex_unlock(branch->mutex);
+        }
+
+        /* The worker is idle until more data is written, so the branch can be flushed from this thread */
+        if (io_flush(branch->io) && state->mode != TEE_SYNC) {
+            mutex_lock(branch->mutex);
+            if (!branch->err)
+                branch->err = io_error(branch->io)? io_error(branch->io): CC_EWRITE;
+            mutex_unlock(branch->mutex);
+        }
+    }
+
+    int err = tee_n_error(state);
+    if (err) {
+        io_set_error(io, err);
+        return EOF;
+    }
+
+    return 0;
+}
+
+static void tee_n_clearerr(void *userdata, IO io) {
+    UNUSED(io)
+
+    struct TeeState *state = userdata;
+
+    for (size_t i = 0; i < state->count; ++i) {
+        struct TeeBranch *branch = &state->branches[i];
+
+        if (state->mode == TEE_SYNC) {
+            io_clearerr(branch->io);
+        } else {
+            mutex_lock(branch->mutex);
+            tee_branch_drain(branch);
+            io_clearerr(branch->io);
+            branch->err = 0;
+            mutex_unlock(branch->mutex);
+        }
+    }
+}
+
+/* Stops all workers once their rings are empty and frees the tee. Returns the first error reported by any branch, or 0 if none failed */
+static int tee_n_destroy(struct TeeState *state) {
+    int err = 0;
+
+    for (size_t i = 0; i < state->count; ++i) {
+        struct TeeBranch *branch = &state->branches[i];
+
+        if (branch->thread) {
+            mutex_lock(branch->mutex);
+            branch->quit = 1;
+            condition_variable_wake(&branch->data_ready);
+            mutex_unlock(branch->mutex);
+
+            thread_join(branch->thread, NULL);
+        }
+
+        if (!err)
+            err = branch->err;
+
+        if (branch->mutex) {
+            mutex_destroy(branch->mutex);
+            condition_variable_destroy(&branch->data_ready);
+            condition_variable_destroy(&branch->space_ready);
+        }
+
+        FREE(branch->ring);
+    }
+
+    FREE(state);
+    return err;
+}
+
+static void *tee_n_open(void *userdata, IO io) {
+    UNUSED(io)
+
+    struct TeeNParams *params = userdata;
+
+    struct TeeState *state = CALLOC(1, sizeof(*state) + params->count * sizeof(*state->branches));
+    if (state == NULL)
+        return NULL;
+
+    state->mode = params->mode;
+    state->ring_size = params->ring_size? params->ring_size: TEE_DEFAULT_RING_SIZE;
+
+    for (size_t i = 0; i < params->count; ++i) {
+        struct TeeBranch *branch = &state->branches[i];
+
+        branch->io = params->outs[i];
+        branch->tee = state;
+        state->count = i + 1;
+
+        if (state->mode == TEE_SYNC)
+            continue;
+
+        branch->ring = MALLOC(state->ring_size);
+        if (branch->ring == NULL)
+            goto cleanup;
+
+        branch->mutex = mutex_create();
+        if (branch->mutex == NULL)
+            goto cleanup;
+
+        condition_variable_init(&branch->data_ready);
+        condition_variable_init(&branch->space_ready);
+
+        branch->thread = thread_create(tee_worker, branch);
+        if (branch->thread == NULL)
+            goto cleanup;
+    }
+
+    return state;
+
+cleanup:
+    tee_n_destroy(state);
+    return NULL;
+}
+
+static int tee_n_close(void *userdata, IO io) {
+    UNUSED(io)
+
+    struct TeeState *state = userdata;
+
+    /* Workers write everything remaining in their rings before exiting */
+    return tee_n_destroy(state);
+}
+
+static const char *tee_n_what(void *userdata, IO io) {
+    UNUSED(userdata)
+    UNUSED(io)
+
+    return "tee_n";
+}
+
+static const struct InputOutputDeviceCallbacks tee_n_callbacks = {
+    .open = tee_n_open,
+    .close = tee_n_close,
+    .read = NULL,
+    .write = tee_n_write,
+    .flush = tee_n_flush,
+    .clearerr = tee_n_clearerr,
+    .state_switch = NULL,
+    .seek = NULL,
+    .seek64 = NULL,
+    .tell = NULL,
+    .tell64 = NULL,
+    .flags = NULL,
+    .what = tee_n_what
+};
+
+IO io_open_tee_n(IO outs[], size_t n, const char *mode, int async) {
+    return io_open_tee_n2(outs, n, mode, async, 0);
+}
+
+IO io_open_tee_n2(IO outs[], size_t n, const char *mode, int async, size_t ring_size) {
+    struct TeeNParams params = {
+        .outs = outs,
+        .count = n,
+        .mode = (enum TeeMode) async,
+        .ring_size = ring_size
+    };
+
+    if (n == 0 || async < TEE_SYNC || async > TEE_ASYNC_DROP || strchr(mode, 'r') || strchr(mode, '+'))
+        return NULL;
+
+    return io_open_custom(&tee_n_callbacks, &params, mode);
+}
+
+unsigned long long io_tee_dropped(IO tee, size_t branch) {
+    if (strcmp(io_description(tee), "tee_n"))
+        return 0;
+
+    struct TeeState *state = io_userdata(tee);
+    unsigned long long dropped = 0;
+
+    if (branch >= state->count || state->mode == TEE_SYNC)
+        return 0;
+
+    mutex_lock(state->branches[branch].mutex);
+    dropped = state->branches[branch].dropped;
+    mutex_unlock(state->branches[branch].mutex);
+
+    return dropped;
+}
@@ -21,6 +21,43 @@ extern "C" {
  */
 IO io_open_tee(IO out1, IO out2, const char *mode);
 
+/* Default size of the ring buffer each asynchronous tee branch is fed through */
+#define TEE_DEFAULT_RING_SIZE (1024 * 1024)
+
+/** @brief Specifies how an n-way tee device delivers data to its outputs. */
+enum TeeMode {
+    /** Each write is written to every output in turn before returning. */
+    TEE_SYNC = 0,
+    /** Each output is written by its own thread through a bounded ring. Writes block while any output's ring is full. */
+    TEE_ASYNC_BLOCK = 1,
+    /** Each output is written by its own thread through a bounded ring. Writes that don't fit in an output's ring are dropped for that output and counted. */
+    TEE_ASYNC_DROP = 2
+};
+
+/** @brief Opens a device that duplicates the data pushed to it to @p n outputs.
+ *
+ * In asynchronous modes, a slow output only delays the other outputs once its ring fills (`TEE_ASYNC_BLOCK`), or never (`TEE_ASYNC_DROP`).
+ * A write to an output in `TEE_ASYNC_DROP` mode is either queued entirely or dropped entirely. Once an output reports an error, no further data is sent to it.
+ *
+ * Errors from asynchronous outputs are reported by the next write, and always by `io_flush()` and `io_close()`, which wait until every ring is empty.
+ * `io_clearerr()` clears the errors of the tee and all outputs. The outputs must not be used directly while the tee is open, and are not closed by the tee.
+ *
+ * This device cannot be opened for reading.
+ *
+ * @param outs The array of @p n output devices.
+ * @param n The number of outputs. Must be greater than 0.
+ * @param mode The mode of the device.
+ * @param async One of the `TeeMode` values.
+ * @return A new write-only tee device, or `NULL` if an error occured.
+ */
+IO io_open_tee_n(IO outs[], size_t n, const char *mode, int async);
+
+/* Identical to `io_open_tee_n()`, but specifies the size of each output's ring buffer in bytes. If @p ring_size is 0, `TEE_DEFAULT_RING_SIZE` is used */
+IO io_open_tee_n2(IO outs[], size_t n, const char *mode, int async, size_t ring_size);
+
+/** @brief Returns the number of bytes dropped for output @p branch of an n-way tee in `TEE_ASYNC_DROP` mode, or 0 if @p tee is not an asynchronous n-way tee. */
+unsigned long long io_tee_dropped(IO tee, size_t branch);
+
 #ifdef __cplusplus
 class TeeIO : public IODevice {
     IODevice *out1, *out2;
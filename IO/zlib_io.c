@@ -6,10 +6,49 @@
 
 #include "zlib_io.h"
 #include "../seaerror.h"
+#include "../utility.h"
 
+#include <limits.h>
 #include <stdint.h>
+#include <string.h>
 
 #ifdef CC_INCLUDE_ZLIB
+/* Size of the intermediate buffer between zlib and the underlying device if none is specified */
+#define ZLIB_DEFAULT_BUFFER_SIZE 16384
+
+/* Size of the window stored with each index checkpoint (the maximum deflate window) */
+#define ZLIB_INDEX_WINDOW_SIZE 32768
+
+/* Version of the serialized index format written by zlib_index_save() */
+#define ZLIB_INDEX_VERSION 1
+
+struct ZlibIndexPoint {
+    /* Offset of this checkpoint in the uncompressed data */
+    long long out;
+
+    /* Offset of the first complete byte of the next deflate block in the compressed data, relative to the start of the stream */
+    long long in;
+
+    /* Number of bits (1-7) of the byte before `in` that belong to the next deflate block, or 0 if the block starts on a byte boundary */
+    int bits;
+
+    /* Uncompressed data preceding this checkpoint, up to 32 KiB */
+    unsigned char *window;
+    size_t window_size;
+};
+
+struct ZlibIndexStruct {
+    /* Minimum distance between checkpoints in the uncompressed data */
+    long long span;
+
+    /* Total length of the uncompressed data, or -1 if the end of the stream has not been indexed yet */
+    long long length;
+
+    struct ZlibIndexPoint *points;
+    size_t count;
+    size_t capacity;
+};
+
 struct ZlibParameters {
     IO io;
     int windowBits;
@@ -17,14 +56,32 @@ struct ZlibParameters {
     int memLevel;
     int strategy;
     int deflating;
+    size_t bufferSize;
+    ZlibIndex index;
     int *err;
 };
 
 struct ZlibState {
     IO io;
     z_stream zlib;
-    unsigned char buffer[4096];
     int deflating;
+    int windowBits;
+
+    /* Whether data was written that has not been finished with Z_FINISH yet */
+    int pending;
+
+    /* Checkpoint index used for seeking, and updated while inflating. May be NULL */
+    ZlibIndex index;
+
+    /* Offset of the start of the compressed stream in the underlying device */
+    long long start;
+
+    /* Compressed and uncompressed offsets at which `zlib` was last started, since resuming from a checkpoint resets its counters */
+    long long in_base;
+    long long out_base;
+
+    size_t buffer_size;
+    unsigned char buffer[];
 };
 
 static void *zalloc(void *unused, uInt size, uInt count) {
@@ -42,15 +99,21 @@ static void zfree(void *unused, void *ptr) {
 static void *zlib_open(void *userdata, IO io) {
     UNUSED(io)
 
-    struct ZlibState *state = CALLOC(1, sizeof(*state));
+    struct ZlibParameters *params = userdata;
+
+    size_t bufferSize = params->bufferSize? params->bufferSize: ZLIB_DEFAULT_BUFFER_SIZE;
+
+    struct ZlibState *state = CALLOC(1, sizeof(*state) + bufferSize);
     if (state == NULL)
         return NULL;
 
-    struct ZlibParameters *params = userdata;
-
     int windowBits = params->windowBits;
 
     state->deflating = params->deflating;
+    state->windowBits = windowBits;
+    state->index = params->index;
+    state->start = MAX(io_tell64(params->io), 0);
+    state->buffer_size = bufferSize;
     state->io = params->io;
     state->zlib.zalloc = zalloc;
     state->zlib.zfree = zfree;
@@ -86,6 +149,103 @@ cleanup:
     return NULL;
 }
 
+/* Returns the current offset in the uncompressed data */
+static long long zlib_out_position(struct ZlibState *state) {
+    return state->out_base + state->zlib.total_out;
+}
+
+static int zlib_index_add(ZlibIndex index, long long out, long long in, int bits, z_stream *zlib) {
+    if (index->count == index->capacity) {
+        size_t capacity = MAX(index->capacity + (index->capacity >> 1), 8);
+        struct ZlibIndexPoint *points = REALLOC(index->points, capacity * sizeof(*points));
+        if (points == NULL)
+            return CC_ENOMEM;
+
+        index->points = points;
+        index->capacity = capacity;
+    }
+
+    struct ZlibIndexPoint *point = &index->points[index->count];
+    uInt window_size = ZLIB_INDEX_WINDOW_SIZE;
+
+    point->window = MALLOC(ZLIB_INDEX_WINDOW_SIZE);
+    if (point->window == NULL)
+        return CC_ENOMEM;
+
+    if (inflateGetDictionary(zlib, point->window, &window_size) != Z_OK) {
+        FREE(point->window);
+        return CC_EIO;
+    }
+
+    point->out = out;
+    point->in = in;
+    point->bits = bits;
+    point->window_size = window_size;
+
+    ++index->count;
+    return 0;
+}
+
+/* Records a checkpoint if inflate stopped at a block boundary far enough from the last one, and notes the total length when the stream ends */
+static int zlib_index_update(struct ZlibState *state, int result) {
+    ZlibIndex index = state->index;
+    long long out = zlib_out_position(state);
+
+    if (result == Z_STREAM_END) {
+        index->length = out;
+        return 0;
+    }
+
+    /* Bit 7 specifies a block boundary, bit 6 specifies that the last block is being decoded (so no blocks follow) */
+    if ((state->zlib.data_type & 128) == 0 || (state->zlib.data_type & 64) != 0)
+        return 0;
+
+    if (index->count && (out <= index->points[index->count-1].out || out - index->points[index->count-1].out < index->span))
+        return 0;
+
+    return zlib_index_add(index, out, state->in_base + state->zlib.total_in, state->zlib.data_type & 7, &state->zlib);
+}
+
+/* Returns the last checkpoint at or before `offset` in the uncompressed data, or NULL if none exists */
+static const struct ZlibIndexPoint *zlib_index_find(ZlibIndex index, long long offset) {
+    size_t lo = 0, hi = index->count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (index->points[mid].out <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo? &index->points[lo-1]: NULL;
+}
+
+/* Returns the unread contents of a memory-backed underlying device, so they can be handed to zlib without copying through the intermediate buffer.
+ * Returns NULL if the underlying device does not support direct access */
+static unsigned char *zlib_direct_input(struct ZlibState *state, size_t *avail) {
+    switch (io_type(state->io)) {
+        default: return NULL;
+        case IO_SizedBuffer:
+        case IO_DynamicBuffer: {
+#if WINDOWS_OS
+            if (!io_binary(state->io))
+                return NULL;
+#endif
+
+            long long pos = io_tell64(state->io);
+            size_t size = io_underlying_buffer_size(state->io);
+
+            if (pos < 0 || (unsigned long long) pos > size)
+                return NULL;
+
+            *avail = size - (size_t) pos;
+            return (unsigned char *) io_underlying_buffer(state->io) + pos;
+        }
+    }
+}
+
 static size_t zlib_read(void *buf, size_t size, size_t count, void *userdata, IO io) {
     struct ZlibState *state = userdata;
 
@@ -94,29 +254,60 @@ static size_t zlib_read(void *buf, size_t size, size_t count, void *userdata, IO
     state->zlib.avail_out = max;
     state->zlib.next_out = buf;
 
-    int flush = io_eof(state->io)? Z_FINISH: Z_NO_FLUSH;
+    int finishing = io_eof(state->io);
     int result;
 
     do {
+        size_t direct = 0;
+
         if (state->zlib.avail_in == 0) {
-            state->zlib.avail_in = io_read(state->buffer, 1, sizeof(state->buffer), state->io);
+            size_t available = 0;
+            unsigned char *input = zlib_direct_input(state, &available);
 
-            if (flush == Z_FINISH && state->zlib.avail_in == 0 && io_error(state->io)) {
-                io_set_error(io, io_error(state->io));
-                break;
-            }
+            if (input != NULL) {
+                direct = MIN(available, UINT_MAX);
+                state->zlib.next_in = input;
+                state->zlib.avail_in = (uInt) direct;
 
-            if (state->zlib.avail_in != sizeof(state->buffer)) {
-                flush = Z_FINISH;
-            }
+                /* All remaining input is available at once, so no further input will follow */
+                finishing = direct == available;
+            } else {
+                state->zlib.avail_in = io_read(state->buffer, 1, state->buffer_size, state->io);
+
+                if (finishing && state->zlib.avail_in == 0 && io_error(state->io)) {
+                    io_set_error(io, io_error(state->io));
+                    break;
+                }
+
+                if (state->zlib.avail_in != state->buffer_size) {
+                    finishing = 1;
+                }
 
-            state->zlib.next_in = state->buffer;
+                state->zlib.next_in = state->buffer;
+            }
         }
 
         if (state->deflating)
-            result = deflate(&state->zlib, flush);
+            result = deflate(&state->zlib, finishing? Z_FINISH: Z_NO_FLUSH);
+        else if (state->index)
+            result = inflate(&state->zlib, Z_BLOCK); /* Stop at every block boundary so checkpoints can be recorded */
         else
-            result = inflate(&state->zlib, flush);
+            result = inflate(&state->zlib, finishing? Z_FINISH: Z_NO_FLUSH);
+
+        if (state->index && !state->deflating && zlib_index_update(state, result)) {
+            io_set_error(io, CC_ENOMEM);
+            return SIZE_MAX;
+        }
+
+        if (direct) {
+            /* Consume what zlib used from the underlying device, and fetch a fresh view of it next time in case it was reallocated */
+            if (io_seek64(state->io, (long long) (direct - state->zlib.avail_in), SEEK_CUR)) {
+                io_set_error(io, io_error(state->io)? io_error(state->io): CC_EIO);
+                return SIZE_MAX;
+            }
+
+            state->zlib.avail_in = 0;
+        }
 
         switch (result) {
             case Z_STREAM_ERROR:
@@ -124,6 +315,7 @@ static size_t zlib_read(void *buf, size_t size, size_t count, void *userdata, IO
             case Z_DATA_ERROR: io_set_error(io, io_error(state->io)? io_error(state->io): CC_EBADMSG); return SIZE_MAX;
             case Z_MEM_ERROR: io_set_error(io, io_error(state->io)? io_error(state->io): CC_ENOMEM); return SIZE_MAX;
             case Z_STREAM_END: goto done;
+            case Z_BUF_ERROR: if (finishing && state->zlib.avail_in == 0) goto done; break; /* No more input is available */
         }
     } while (state->zlib.avail_out != 0);
 
@@ -136,12 +328,13 @@ static size_t zlib_write(const void *buf, size_t size, size_t count, void *userd
 
     state->zlib.avail_in = size*count;
     state->zlib.next_in = (Bytef *) buf;
+    state->pending = state->zlib.avail_in != 0;
 
     int flush = state->zlib.avail_in == 0? Z_FINISH: Z_NO_FLUSH;
     int result;
 
     do {
-        state->zlib.avail_out = sizeof(state->buffer);
+        state->zlib.avail_out = state->buffer_size;
         state->zlib.next_out = state->buffer;
 
         if (state->deflating)
@@ -156,7 +349,7 @@ static size_t zlib_write(const void *buf, size_t size, size_t count, void *userd
             case Z_MEM_ERROR: io_set_error(io, CC_ENOMEM); return 0;
         }
 
-        size_t used = sizeof(state->buffer) - state->zlib.avail_out;
+        size_t used = state->buffer_size - state->zlib.avail_out;
         if (io_write(state->buffer, 1, used, state->io) != used) {
             io_set_error(io, io_error(state->io));
             return 0;
@@ -166,13 +359,105 @@ static size_t zlib_write(const void *buf, size_t size, size_t count, void *userd
     return count;
 }
 
+/* Positions the underlying device and inflate state at a checkpoint. The checkpoint is decoded as raw deflate data, since any header precedes it */
+static int zlib_resume(struct ZlibState *state, const struct ZlibIndexPoint *point) {
+    if (io_seek64(state->io, state->start + point->in - (point->bits? 1: 0), SEEK_SET) ||
+            inflateReset2(&state->zlib, -15) != Z_OK)
+        return -1;
+
+    if (point->bits) {
+        int ch = io_getc(state->io);
+        if (ch == EOF || inflatePrime(&state->zlib, point->bits, ch >> (8 - point->bits)) != Z_OK)
+            return -1;
+    }
+
+    if (inflateSetDictionary(&state->zlib, point->window, (uInt) point->window_size) != Z_OK)
+        return -1;
+
+    state->zlib.next_in = NULL;
+    state->zlib.avail_in = 0;
+    state->in_base = point->in;
+    state->out_base = point->out;
+
+    return 0;
+}
+
+/* Positions the underlying device and inflate state at the start of the stream */
+static int zlib_restart(struct ZlibState *state) {
+    if (io_seek64(state->io, state->start, SEEK_SET) ||
+            inflateReset2(&state->zlib, state->windowBits) != Z_OK)
+        return -1;
+
+    state->zlib.next_in = NULL;
+    state->zlib.avail_in = 0;
+    state->in_base = 0;
+    state->out_base = 0;
+
+    return 0;
+}
+
+static int zlib_seek64(void *userdata, long long int offset, int origin, IO io) {
+    struct ZlibState *state = userdata;
+
+    /* Only inflating while reading supports seeking */
+    if (state->deflating || !io_readable(io) || io_writable(io))
+        return -1;
+
+    long long current = zlib_out_position(state);
+
+    switch (origin) {
+        case SEEK_CUR: offset += current; break;
+        case SEEK_END:
+            if (state->index == NULL || state->index->length < 0)
+                return -1;
+
+            offset += state->index->length;
+            break;
+    }
+
+    if (offset < 0)
+        return -1;
+
+    const struct ZlibIndexPoint *point = state->index? zlib_index_find(state->index, offset): NULL;
+
+    /* Resume from the nearest checkpoint if it's closer than the current position, otherwise restart from the beginning if seeking backward */
+    if (point != NULL && (point->out > current || offset < current)) {
+        if (zlib_resume(state, point))
+            return -1;
+    } else if (offset < current) {
+        if (zlib_restart(state))
+            return -1;
+    }
+
+    /* Inflate and discard data up to the requested offset */
+    for (current = zlib_out_position(state); current < offset; current = zlib_out_position(state)) {
+        unsigned char discard[4096];
+        size_t amount = (size_t) MIN(offset - current, (long long) sizeof(discard));
+        size_t read = zlib_read(discard, 1, amount, userdata, io);
+
+        if (read == SIZE_MAX || read < amount)
+            return -1;
+    }
+
+    return 0;
+}
+
+static long long zlib_tell64(void *userdata, IO io) {
+    struct ZlibState *state = userdata;
+
+    if (io_just_wrote(io))
+        return state->zlib.total_in;
+
+    return zlib_out_position(state);
+}
+
 static int zlib_close(void *userdata, IO io) {
     UNUSED(io)
 
     struct ZlibState *state = userdata;
     int result = 0;
 
-    if (io_just_wrote(io)) {
+    if (state->pending) {
         zlib_write("", 0, 0, userdata, io);
         result = io_error(io);
     }
@@ -220,9 +505,9 @@ static const struct InputOutputDeviceCallbacks zlib_callbacks = {
     .clearerr = zlib_clearerr,
     .state_switch = NULL,
     .seek = NULL,
-    .seek64 = NULL,
+    .seek64 = zlib_seek64,
     .tell = NULL,
-    .tell64 = NULL,
+    .tell64 = zlib_tell64,
     .flags = NULL,
     .what = zlib_what
 };
@@ -232,13 +517,18 @@ IO io_open_zlib_deflate(IO io, int level, int windowBits, const char *mode) {
 }
 
 IO io_open_zlib_deflate2(IO io, int level, int windowBits, int memLevel, int strategy, const char *mode) {
+    return io_open_zlib_deflate3(io, level, windowBits, memLevel, strategy, 0, mode);
+}
+
+IO io_open_zlib_deflate3(IO io, int level, int windowBits, int memLevel, int strategy, size_t bufferSize, const char *mode) {
     struct ZlibParameters params = {
         .io = io,
         .deflateLevel = level,
         .windowBits = windowBits,
         .memLevel = memLevel,
         .strategy = strategy,
-        .deflating = 1
+        .deflating = 1,
+        .bufferSize = bufferSize
     };
 
     return io_open_custom(&zlib_callbacks, &params, mode);
@@ -254,13 +544,18 @@ IO io_open_zlib_deflate_easy(IO io, enum ZlibType type, const char *mode) {
 }
 
 IO io_open_zlib_inflate(IO io, int windowBits, const char *mode) {
+    return io_open_zlib_inflate2(io, windowBits, 0, mode);
+}
+
+IO io_open_zlib_inflate2(IO io, int windowBits, size_t bufferSize, const char *mode) {
     struct ZlibParameters params = {
         .io = io,
         .deflateLevel = Z_DEFAULT_COMPRESSION,
         .windowBits = windowBits,
         .memLevel = 8,
         .strategy = Z_DEFAULT_STRATEGY,
-        .deflating = 0
+        .deflating = 0,
+        .bufferSize = bufferSize
     };
 
     return io_open_custom(&zlib_callbacks, &params, mode);
@@ -276,4 +571,594 @@ IO io_open_zlib_inflate_easy(IO io, enum ZlibType type, const char *mode) {
     }
 }
 
+int io_zlib_reset(IO zlib, IO io) {
+    if (io_type(zlib) != IO_Custom || io_userdata(zlib) == NULL ||
+            (strcmp(io_description(zlib), "zlib_deflate") && strcmp(io_description(zlib), "zlib_inflate")))
+        return CC_EINVAL;
+
+    struct ZlibState *state = io_userdata(zlib);
+    int result = 0;
+
+    /* Finish the stream currently being written before starting a new one */
+    if (state->pending) {
+        zlib_write("", 0, 0, state, zlib);
+        result = io_error(zlib);
+    }
+
+    if ((state->deflating? deflateReset(&state->zlib): inflateReset(&state->zlib)) != Z_OK && !result)
+        result = CC_EIO;
+
+    /* Input already buffered from the same underlying device belongs to the next stream, so only discard it if the device changes */
+    if (io != NULL && io != state->io) {
+        state->zlib.next_in = NULL;
+        state->zlib.avail_in = 0;
+        state->io = io;
+    }
+
+    state->start = MAX(io_tell64(state->io) - (long long) state->zlib.avail_in, 0);
+    state->in_base = 0;
+    state->out_base = 0;
+    state->pending = 0;
+
+    io_clearerr(zlib);
+
+    return result;
+}
+
+IO io_open_zlib_inflate_indexed(IO io, int windowBits, ZlibIndex index, const char *mode) {
+    struct ZlibParameters params = {
+        .io = io,
+        .deflateLevel = Z_DEFAULT_COMPRESSION,
+        .windowBits = windowBits,
+        .memLevel = 8,
+        .strategy = Z_DEFAULT_STRATEGY,
+        .deflating = 0,
+        .index = index
+    };
+
+    if (index == NULL)
+        return NULL;
+
+    return io_open_custom(&zlib_callbacks, &params, mode);
+}
+
+ZlibIndex zlib_index_create(long long span) {
+    ZlibIndex index = CALLOC(1, sizeof(*index));
+    if (index == NULL)
+        return NULL;
+
+    index->span = span > 0? span: ZLIB_INDEX_DEFAULT_SPAN;
+    index->length = -1;
+
+    return index;
+}
+
+void zlib_index_destroy(ZlibIndex index) {
+    if (index == NULL)
+        return;
+
+    for (size_t i = 0; i < index->count; ++i)
+        FREE(index->points[i].window);
+
+    FREE(index->points);
+    FREE(index);
+}
+
+size_t zlib_index_size(ZlibIndex index) {
+    return index->count;
+}
+
+long long zlib_index_length(ZlibIndex index) {
+    return index->length;
+}
+
+int zlib_index_save(ZlibIndex index, IO out) {
+    if (io_write("ZIDX", 1, 4, out) != 4 ||
+            io_put_uint32_le(out, ZLIB_INDEX_VERSION) != 1 ||
+            io_put_uint64_le(out, index->span) != 1 ||
+            io_put_uint64_le(out, index->length) != 1 ||
+            io_put_uint64_le(out, index->count) != 1)
+        return io_error(out)? io_error(out): CC_EWRITE;
+
+    for (size_t i = 0; i < index->count; ++i) {
+        const struct ZlibIndexPoint *point = &index->points[i];
+
+        if (io_put_uint64_le(out, point->out) != 1 ||
+                io_put_uint64_le(out, point->in) != 1 ||
+                io_putc(point->bits, out) == EOF ||
+                io_put_uint32_le(out, (unsigned long) point->window_size) != 1 ||
+                io_write(point->window, 1, point->window_size, out) != point->window_size)
+            return io_error(out)? io_error(out): CC_EWRITE;
+    }
+
+    return 0;
+}
+
+static int zlib_index_get_uint64(IO in, uint64_t *value) {
+    unsigned char buf[8];
+
+    if (io_read(buf, 1, sizeof(buf), in) != sizeof(buf))
+        return -1;
+
+    u64get_le(value, buf);
+    return 0;
+}
+
+ZlibIndex zlib_index_load(IO in) {
+    unsigned char header[8];
+    uint32_t version;
+    uint64_t span, length, count;
+
+    if (io_read(header, 1, sizeof(header), in) != sizeof(header) ||
+            memcmp(header, "ZIDX", 4) ||
+            u32get_le(&version, header + 4) != ZLIB_INDEX_VERSION ||
+            zlib_index_get_uint64(in, &span) ||
+            zlib_index_get_uint64(in, &length) ||
+            zlib_index_get_uint64(in, &count))
+        return NULL;
+
+    ZlibIndex index = zlib_index_create((long long) span);
+    if (index == NULL)
+        return NULL;
+
+    index->length = (long long) length;
+
+    for (uint64_t i = 0; i < count; ++i) {
+        struct ZlibIndexPoint point;
+        uint64_t out, pos;
+        unsigned char info[5];
+        uint32_t window_size;
+
+        if (zlib_index_get_uint64(in, &out) ||
+                zlib_index_get_uint64(in, &pos) ||
+                io_read(info, 1, sizeof(info), in) != sizeof(info) ||
+                info[0] > 7 ||
+                u32get_le(&window_size, info + 1) > ZLIB_INDEX_WINDOW_SIZE)
+            goto cleanup;
+
+        point.out = (long long) out;
+        point.in = (long long) pos;
+        point.bits = info[0];
+        point.window_size = window_size;
+        point.window = MALLOC(ZLIB_INDEX_WINDOW_SIZE);
+
+        if (point.window == NULL)
+            goto cleanup;
+
+        if (io_read(point.window, 1, window_size, in) != window_size ||
+                (index->count && point.out <= index->points[index->count-1].out)) {
+            FREE(point.window);
+            goto cleanup;
+        }
+
+        if (index->count == index->capacity) {
+            size_t capacity = MAX(index->capacity + (index->capacity >> 1), 8);
+            struct ZlibIndexPoint *points = REALLOC(index->points, capacity * sizeof(*points));
+            if (points == NULL) {
+                FREE(point.window);
+                goto cleanup;
+            }
+
+            index->points = points;
+            index->capacity = capacity;
+        }
+
+        index->points[index->count++] = point;
+    }
+
+    return index;
+
+cleanup:
+    zlib_index_destroy(index);
+    return NULL;
+}
+
+/* Size of the dictionary each parallel block is primed with (the maximum deflate window) */
+#define ZLIB_PARALLEL_DICT_SIZE 32768
+
+/* Default size of the input block compressed by each worker if none is specified */
+#define ZLIB_PARALLEL_DEFAULT_BLOCK_SIZE (128 * 1024)
+
+enum ZlibParallelJobStatus {
+    ZlibJobIdle,
+    ZlibJobQueued,
+    ZlibJobDone
+};
+
+struct ZlibParallelJob {
+    unsigned char *in;
+    size_t in_size;
+
+    /* Last bytes of the previous block, used as the deflate dictionary for this block */
+    unsigned char dict[ZLIB_PARALLEL_DICT_SIZE];
+    size_t dict_size;
+
+    unsigned char *out;
+    size_t out_size;
+    size_t out_capacity;
+
+    /* CRC-32 or Adler-32 of the input data, depending on the stream type */
+    uLong check;
+
+    /* Whether this is the final block of the stream */
+    int last;
+
+    int err;
+    enum ZlibParallelJobStatus status;
+};
+
+struct ZlibParallelState {
+    IO io;
+    enum ZlibType type;
+    int level;
+
+    Mutex mutex;
+    ConditionVariable job_queued; /* Signalled when a job is available or the workers should quit */
+    ConditionVariable job_done; /* Signalled when a worker finished a job */
+
+    Thread *threads;
+    size_t thread_count;
+
+    /* Ring of jobs, indexed by sequence number modulo `slots` */
+    struct ZlibParallelJob *jobs;
+    size_t slots;
+    size_t block_size;
+
+    /* Sequence numbers of the next job to hand to a worker, the next job to write out, and the next job to fill, respectively */
+    size_t next_job;
+    size_t next_output;
+    size_t next_input;
+
+    /* Combined check value and total length of all the input written out so far */
+    uLong check;
+    unsigned long long total_in;
+
+    int quit;
+};
+
+static int zlib_parallel_compress(struct ZlibParallelState *state, z_stream *zlib, struct ZlibParallelJob *job) {
+    if (deflateReset(zlib) != Z_OK)
+        return CC_EIO;
+
+    if (job->dict_size && deflateSetDictionary(zlib, job->dict, (uInt) job->dict_size) != Z_OK)
+        return CC_EIO;
+
+    /* Non-final blocks end with a sync flush so the next block starts on a byte boundary */
+    size_t required = deflateBound(zlib, (uLong) job->in_size) + 16;
+    if (job->out_capacity < required) {
+        unsigned char *out = REALLOC(job->out, required);
+        if (out == NULL)
+            return CC_ENOMEM;
+
+        job->out = out;
+        job->out_capacity = required;
+    }
+
+    zlib->next_in = job->in;
+    zlib->avail_in = (uInt) job->in_size;
+    zlib->next_out = job->out;
+    zlib->avail_out = (uInt) job->out_capacity;
+
+    int result = deflate(zlib, job->last? Z_FINISH: Z_SYNC_FLUSH);
+    if (result == Z_STREAM_ERROR || zlib->avail_in != 0 || (job->last && result != Z_STREAM_END))
+        return CC_EIO;
+
+    job->out_size = job->out_capacity - zlib->avail_out;
+
+    if (state->type == GzipDeflate)
+        job->check = crc32(crc32(0, Z_NULL, 0), job->in, (uInt) job->in_size);
+    else
+        job->check = adler32(adler32(0, Z_NULL, 0), job->in, (uInt) job->in_size);
+
+    return 0;
+}
+
+static int zlib_parallel_worker(void *userdata) {
+    struct ZlibParallelState *state = userdata;
+    z_stream zlib;
+
+    zlib.zalloc = zalloc;
+    zlib.zfree = zfree;
+    zlib.opaque = NULL;
+
+    int init = deflateInit2(&zlib, state->level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+
+    mutex_lock(state->mutex);
+
+    while (1) {
+        while (!state->quit && state->next_job == state->next_input)
+            condition_variable_sleep(&state->job_queued, state->mutex);
+
+        if (state->next_job == state->next_input)
+            break;
+
+        struct ZlibParallelJob *job = &state->jobs[state->next_job++ % state->slots];
+
+        mutex_unlock(state->mutex);
+
+        int err = init != Z_OK? CC_ENOMEM: zlib_parallel_compress(state, &zlib, job);
+
+        mutex_lock(state->mutex);
+
+        job->err = err;
+        job->status = ZlibJobDone;
+        condition_variable_wakeall(&state->job_done);
+    }
+
+    mutex_unlock(state->mutex);
+
+    if (init == Z_OK)
+        deflateEnd(&zlib);
+
+    return 0;
+}
+
+static int zlib_parallel_write_header(struct ZlibParallelState *state) {
+    switch (state->type) {
+        default: return 0;
+        case GzipDeflate: {
+            const unsigned char header[10] = {0x1f, 0x8b, Z_DEFLATED, 0, 0, 0, 0, 0, state->level == 9? 2: state->level == 1? 4: 0, 0xff};
+
+            return io_write(header, 1, sizeof(header), state->io) == sizeof(header)? 0: io_error(state->io);
+        }
+        case ZlibDeflate: {
+            unsigned char header[2] = {0x78, 0};
+            int level = state->level == Z_DEFAULT_COMPRESSION? 6: state->level;
+
+            header[1] = (level < 2? 0: level < 6? 1: level == 6? 2: 3) << 6;
+            header[1] += 31 - ((header[0] << 8) + header[1]) % 31;
+
+            return io_write(header, 1, sizeof(header), state->io) == sizeof(header)? 0: io_error(state->io);
+        }
+    }
+}
+
+static int zlib_parallel_write_trailer(struct ZlibParallelState *state) {
+    switch (state->type) {
+        default: return 0;
+        case GzipDeflate:
+            return io_put_uint32_le(state->io, state->check) == 1 && io_put_uint32_le(state->io, (unsigned long) (state->total_in & 0xffffffffu)) == 1? 0: io_error(state->io);
+        case ZlibDeflate:
+            return io_put_uint32_be(state->io, state->check) == 1? 0: io_error(state->io);
+    }
+}
+
+/* Waits for the oldest outstanding job to complete and writes its output to the underlying device. The mutex must not be locked */
+static int zlib_parallel_output_next(struct ZlibParallelState *state) {
+    struct ZlibParallelJob *job = &state->jobs[state->next_output % state->slots];
+
+    mutex_lock(state->mutex);
+    while (job->status != ZlibJobDone)
+        condition_variable_sleep(&state->job_done, state->mutex);
+    mutex_unlock(state->mutex);
+
+    ++state->next_output;
+    job->status = ZlibJobIdle;
+
+    if (job->err)
+        return job->err;
+
+    if (io_write(job->out, 1, job->out_size, state->io) != job->out_size)
+        return io_error(state->io);
+
+    if (state->type == GzipDeflate)
+        state->check = crc32_combine(state->check, job->check, (z_off_t) job->in_size);
+    else
+        state->check = adler32_combine(state->check, job->check, (z_off_t) job->in_size);
+
+    state->total_in += job->in_size;
+
+    return 0;
+}
+
+/* Hands the block currently being filled to the worker threads and prepares the next one */
+static int zlib_parallel_submit(struct ZlibParallelState *state, int last) {
+    struct ZlibParallelJob *job = &state->jobs[state->next_input % state->slots];
+    struct ZlibParallelJob *next = &state->jobs[(state->next_input + 1) % state->slots];
+
+    job->last = last;
+
+    mutex_lock(state->mutex);
+    job->status = ZlibJobQueued;
+    ++state->next_input;
+    condition_variable_wake(&state->job_queued);
+    mutex_unlock(state->mutex);
+
+    if (last)
+        return 0;
+
+    /* Recycle the next slot, writing out its previous contents if they are still pending */
+    if (state->next_input - state->next_output == state->slots) {
+        int err = zlib_parallel_output_next(state);
+        if (err)
+            return err;
+    }
+
+    next->dict_size = MIN(job->in_size, ZLIB_PARALLEL_DICT_SIZE);
+    memcpy(next->dict, job->in + job->in_size - next->dict_size, next->dict_size);
+    next->in_size = 0;
+
+    return 0;
+}
+
+static size_t zlib_parallel_write(const void *buf, size_t size, size_t count, void *userdata, IO io) {
+    struct ZlibParallelState *state = userdata;
+    const unsigned char *cbuf = buf;
+    size_t max = size*count;
+
+    while (max) {
+        struct ZlibParallelJob *job = &state->jobs[state->next_input % state->slots];
+        size_t add = MIN(max, state->block_size - job->in_size);
+
+        memcpy(job->in + job->in_size, cbuf, add);
+        job->in_size += add;
+        cbuf += add;
+        max -= add;
+
+        if (job->in_size == state->block_size) {
+            int err = zlib_parallel_submit(state, 0);
+            if (err) {
+                io_set_error(io, err);
+                return (size*count - max) / size;
+            }
+        }
+    }
+
+    return count;
+}
+
+static int zlib_parallel_destroy(struct ZlibParallelState *state) {
+    if (state->threads) {
+        mutex_lock(state->mutex);
+        state->quit = 1;
+        condition_variable_wakeall(&state->job_queued);
+        mutex_unlock(state->mutex);
+
+        for (size_t i = 0; i < state->thread_count; ++i)
+            thread_join(state->threads[i], NULL);
+
+        FREE(state->threads);
+    }
+
+    if (state->jobs) {
+        for (size_t i = 0; i < state->slots; ++i) {
+            FREE(state->jobs[i].in);
+            FREE(state->jobs[i].out);
+        }
+
+        FREE(state->jobs);
+    }
+
+    if (state->mutex) {
+        condition_variable_destroy(&state->job_queued);
+        condition_variable_destroy(&state->job_done);
+        mutex_destroy(state->mutex);
+    }
+
+    FREE(state);
+    return 0;
+}
+
+static int zlib_parallel_close(void *userdata, IO io) {
+    UNUSED(io)
+
+    struct ZlibParallelState *state = userdata;
+    int result = zlib_parallel_submit(state, 1);
+
+    while (state->next_output != state->next_input) {
+        int err = zlib_parallel_output_next(state);
+        if (!result)
+            result = err;
+    }
+
+    if (!result)
+        result = zlib_parallel_write_trailer(state);
+
+    zlib_parallel_destroy(state);
+    return result;
+}
+
+static int zlib_parallel_flush(void *userdata, IO io) {
+    struct ZlibParallelState *state = userdata;
+
+    int result = io_flush(state->io);
+    io_set_error(io, io_error(state->io));
+
+    return result;
+}
+
+static void zlib_parallel_clearerr(void *userdata, IO io) {
+    UNUSED(io)
+
+    struct ZlibParallelState *state = userdata;
+
+    io_clearerr(state->io);
+}
+
+static const char *zlib_parallel_what(void *userdata, IO io) {
+    UNUSED(userdata)
+    UNUSED(io)
+
+    return "zlib_deflate_parallel";
+}
+
+static const struct InputOutputDeviceCallbacks zlib_parallel_callbacks = {
+    .open = NULL,
+    .close = zlib_parallel_close,
+    .read = NULL,
+    .write = zlib_parallel_write,
+    .flush = zlib_parallel_flush,
+    .clearerr = zlib_parallel_clearerr,
+    .state_switch = NULL,
+    .seek = NULL,
+    .seek64 = NULL,
+    .tell = NULL,
+    .tell64 = NULL,
+    .flags = NULL,
+    .what = zlib_parallel_what
+};
+
+IO io_open_zlib_deflate_parallel(IO io, int level, int threads, size_t block_size) {
+    return io_open_zlib_deflate_parallel2(io, GzipDeflate, level, threads, block_size, "wb");
+}
+
+IO io_open_zlib_deflate_parallel2(IO io, enum ZlibType type, int level, int threads, size_t block_size, const char *mode) {
+    if (type != GzipDeflate && type != ZlibDeflate && type != RawDeflate)
+        return NULL;
+
+    struct ZlibParallelState *state = CALLOC(1, sizeof(*state));
+    if (state == NULL)
+        return NULL;
+
+    state->io = io;
+    state->type = type;
+    state->level = level;
+    state->check = type == GzipDeflate? crc32(0, Z_NULL, 0): adler32(0, Z_NULL, 0);
+    state->thread_count = threads < 1? 1: threads;
+    state->slots = state->thread_count * 2;
+    state->block_size = block_size? MAX(block_size, ZLIB_PARALLEL_DICT_SIZE): ZLIB_PARALLEL_DEFAULT_BLOCK_SIZE;
+
+    state->mutex = mutex_create();
+    if (state->mutex == NULL)
+        goto cleanup;
+
+    condition_variable_init(&state->job_queued);
+    condition_variable_init(&state->job_done);
+
+    state->jobs = CALLOC(state->slots, sizeof(*state->jobs));
+    if (state->jobs == NULL)
+        goto cleanup;
+
+    for (size_t i = 0; i < state->slots; ++i) {
+        state->jobs[i].in = MALLOC(state->block_size);
+        if (state->jobs[i].in == NULL)
+            goto cleanup;
+    }
+
+    state->threads = CALLOC(state->thread_count, sizeof(*state->threads));
+    if (state->threads == NULL)
+        goto cleanup;
+
+    for (size_t i = 0; i < state->thread_count; ++i) {
+        state->threads[i] = thread_create(zlib_parallel_worker, state);
+        if (state->threads[i] == NULL) {
+            state->thread_count = i;
+            goto cleanup;
+        }
+    }
+
+    if (zlib_parallel_write_header(state))
+        goto cleanup;
+
+    IO result = io_open_custom(&zlib_parallel_callbacks, state, mode);
+    if (result == NULL)
+        goto cleanup;
+
+    return result;
+
+cleanup:
+    zlib_parallel_destroy(state);
+    return NULL;
+}
+
 #endif
@@ -16,6 +16,16 @@
 extern "C" {
 #endif
 
+/** @brief An index of checkpoints into a deflate stream, allowing random access when inflating.
+ *
+ *  The index is filled in by a device opened with `io_open_zlib_inflate_indexed()` as data is inflated,
+ *  and is used by `io_seek64()` on any device opened with the same index to resume inflating near the target offset.
+ */
+typedef struct ZlibIndexStruct *ZlibIndex;
+
+/* Default distance between index checkpoints in the uncompressed data */
+#define ZLIB_INDEX_DEFAULT_SPAN (1024LL * 1024)
+
 enum ZlibType {
     GzipDeflate,
     ZlibDeflate,
@@ -30,9 +40,74 @@ IO io_open_zlib_deflate(IO io, int level, int windowBits, const char *mode);
 IO io_open_zlib_deflate2(IO io, int level, int windowBits, int memLevel, int strategy, const char *mode);
 IO io_open_zlib_inflate(IO io, int windowBits, const char *mode);
 
+/** @brief Opens an inflate device that records and uses checkpoints in @p index.
+ *
+ *  While inflating, a checkpoint (the compressed bit offset plus the preceding 32 KiB of output) is added to @p index at the first block boundary
+ *  at least @p span bytes (as specified in `zlib_index_create()`) after the last checkpoint. Seeking the device resumes from the nearest checkpoint
+ *  before the target instead of inflating from the start. Seeking relative to `SEEK_END` is only possible once the whole stream has been indexed.
+ *
+ *  Only a single compressed stream, starting at the current position of @p io, is indexed. @p io must be seekable for seeking to succeed.
+ *  Data is not verified against the stream checksum after resuming from a checkpoint.
+ *
+ *  @param io The underlying device to read compressed data from.
+ *  @param windowBits The zlib window bits, as for `io_open_zlib_inflate()`.
+ *  @param index The index to record checkpoints in and seek with. The index must outlive the device. Must not be `NULL`.
+ *  @param mode The mode of the device. Seeking is only supported if the device is read-only.
+ *  @return A new inflate device, or `NULL` if a failure occurred.
+ */
+IO io_open_zlib_inflate_indexed(IO io, int windowBits, ZlibIndex index, const char *mode);
+
+/** @brief Creates an empty index with checkpoints at least @p span bytes apart in the uncompressed data, or `ZLIB_INDEX_DEFAULT_SPAN` apart if @p span is not positive. */
+ZlibIndex zlib_index_create(long long span);
+void zlib_index_destroy(ZlibIndex index);
+
+/** @brief Returns the number of checkpoints in @p index. */
+size_t zlib_index_size(ZlibIndex index);
+
+/** @brief Returns the total uncompressed length of the indexed stream, or -1 if the end of the stream has not been reached yet. */
+long long zlib_index_length(ZlibIndex index);
+
+/** @brief Serializes @p index to @p out. Returns 0 on success, or an error code on failure. */
+int zlib_index_save(ZlibIndex index, IO out);
+
+/** @brief Deserializes an index previously written with `zlib_index_save()`. Returns `NULL` on failure. */
+ZlibIndex zlib_index_load(IO in);
+
+/* Identical to the above functions, but the size of the buffer between zlib and @p io may be specified. A @p bufferSize of 0 uses the default size.
+ * If @p io is a memory buffer, inflating reads directly from its storage without using the buffer. */
+IO io_open_zlib_deflate3(IO io, int level, int windowBits, int memLevel, int strategy, size_t bufferSize, const char *mode);
+IO io_open_zlib_inflate2(IO io, int windowBits, size_t bufferSize, const char *mode);
+
 IO io_open_zlib_deflate_easy(IO io, enum ZlibType type, const char *mode);
 IO io_open_zlib_inflate_easy(IO io, enum ZlibType type, const char *mode);
 
+/** @brief Resets a zlib device to begin a new stream, reusing its allocated zlib state.
+ *
+ *  If data was written to @p zlib that has not been finished yet, the stream is finished before resetting.
+ *  Error and EOF flags on @p zlib are cleared.
+ *
+ *  @param zlib A device opened with `io_open_zlib_deflate()` or `io_open_zlib_inflate()` (or any of their variants, except the parallel device).
+ *  @param io The new underlying device to use, or `NULL` to continue using the current underlying device.
+ *  @return 0 on success, or an error code if finishing the previous stream or resetting failed.
+ */
+int io_zlib_reset(IO zlib, IO io);
+
+/** @brief Opens a write-only deflate device that compresses independent blocks on worker threads.
+ *
+ *  Input is split into blocks of @p block_size bytes, each primed with the previous 32 KiB of input as its dictionary.
+ *  The output is a single standard gzip stream with a combined checksum, readable by `io_open_zlib_inflate()`.
+ *
+ *  @param io The underlying device to write the compressed stream to.
+ *  @param level The zlib compression level.
+ *  @param threads The number of worker threads to compress with. If less than 1, one worker thread is used.
+ *  @param block_size The number of input bytes per block, or 0 to use the default of 128 KiB.
+ *  @return A new deflate device, or `NULL` if a failure occurred.
+ */
+IO io_open_zlib_deflate_parallel(IO io, int level, int threads, size_t block_size);
+
+/** @brief Identical to `io_open_zlib_deflate_parallel()`, but allows @p type to be one of `GzipDeflate`, `ZlibDeflate`, or `RawDeflate`. */
+IO io_open_zlib_deflate_parallel2(IO io, enum ZlibType type, int level, int threads, size_t block_size, const char *mode);
+
 #ifdef __cplusplus
 }
 #endif
@@ -66,7 +66,7 @@ int io_parser_nested_parse_and_list_insert(void *input, void *container, const C
 StringList io_split_to_stringlist(IO input, const char *separator, int keep_empty) {
     Buffer data_buffer;
     size_t separator_matched = 0, separator_len = strlen(separator); /* If non-zero, contains number of separator characters matched */
-    StringList list = stringlist_create();
+    StringList list = stringlist_create_packed();
     if (list == NULL) {
         stringlist_destroy(list);
         return NULL;
@@ -254,6 +254,78 @@ cleanup:
     return NULL;
 }
 
+/* Appends a slice of `buffer` to the list, taking ownership of the new slice */
+static int io_append_binary_slice(GenericList list, BinaryBuffer buffer, size_t offset, size_t length) {
+    BinarySlice *slice = binary_slice_alloc(buffer, offset, length);
+    if (slice == NULL)
+        return CC_ENOMEM;
+
+    int err = genericlist_append_move(list, slice);
+    if (err)
+        binary_slice_destroy(slice);
+
+    return err;
+}
+
+GenericList io_split_buffer_to_binarylist(BinaryBuffer buffer, const char *separator, size_t separator_len, int keep_empty) {
+    if (separator_len == 0)
+        return NULL;
+
+    GenericList list = genericlist_create(container_base_binary_slice_recipe());
+    if (list == NULL)
+        return NULL;
+
+    const char *data = binary_buffer_data(buffer);
+    const size_t size = binary_buffer_size(buffer);
+    size_t offset = 0, search = 0;
+
+    while (1) {
+        /* Find candidates for the separator by its first byte */
+        const char *found = size - search >= separator_len? memchr(data + search, separator[0], size - search - separator_len + 1): NULL;
+        if (found && memcmp(found, separator, separator_len) != 0) {
+            search = found - data + 1;
+            continue;
+        }
+
+        const size_t length = found? (size_t) (found - data) - offset: size - offset;
+
+        if ((keep_empty || length) && io_append_binary_slice(list, buffer, offset, length))
+            goto cleanup;
+
+        if (found == NULL)
+            break;
+
+        search = offset += length + separator_len;
+    }
+
+    return list;
+
+cleanup:
+    genericlist_destroy(list);
+    return NULL;
+}
+
+GenericList io_divide_buffer_to_binarylist(BinaryBuffer buffer, size_t record_size, int keep_partial) {
+    if (record_size == 0)
+        return NULL;
+
+    const size_t size = binary_buffer_size(buffer);
+    GenericList list = genericlist_create_reserve(size / record_size + 1, container_base_binary_slice_recipe());
+    if (list == NULL)
+        return NULL;
+
+    for (size_t offset = 0; offset < size; offset += record_size) {
+        if ((size - offset >= record_size || keep_partial) && io_append_binary_slice(list, buffer, offset, record_size))
+            goto cleanup;
+    }
+
+    return list;
+
+cleanup:
+    genericlist_destroy(list);
+    return NULL;
+}
+
 int io_join_stringlist(IO output, StringList list, const char *separator) {
     Iterator it = stringlist_begin(list);
 
@@ -289,7 +361,8 @@ int io_join_genericlist_n(IO output, GenericList list, const char *separator, si
         }
 
         return 0;
-    } else if (generic_types_compatible_compare(genericlist_get_container_base(list), container_base_binary_recipe()) == 0) {
+    } else if (generic_types_compatible_compare(genericlist_get_container_base(list), container_base_binary_recipe()) == 0 ||
+               generic_types_compatible_compare(genericlist_get_container_base(list), container_base_binary_slice_recipe()) == 0) {
         Iterator it = genericlist_begin(list);
 
         while (it) {
@@ -576,7 +649,8 @@ int io_serialize_cstring(IO output, const void *data, const CommonContainerBase
 int io_serialize_binary(IO output, const void *data, const CommonContainerBase *base, struct SerializerIdentity *type) {
     SERIALIZER_DECLARE("UTF-8", io_serialize_binary, 1);
 
-    if (generic_types_compatible_compare(base, container_base_binary_recipe()) != 0)
+    if (generic_types_compatible_compare(base, container_base_binary_recipe()) != 0 &&
+        generic_types_compatible_compare(base, container_base_binary_slice_recipe()) != 0)
         return CC_ENOTSUP;
 
     const Binary *binary = data;
@@ -611,7 +685,7 @@ int io_serialize_variant(IO output, const void *data, const CommonContainerBase
 
         switch (variant_get_type(v)) {
             case VariantCustom:
-                data = variant_get_custom_data(v);
+                data = variant_peek_custom_data(v);
                 base = variant_get_custom_container_base(v);
                 continue;
             case VariantUndefined:
@@ -641,11 +715,11 @@ int io_serialize_variant(IO output, const void *data, const CommonContainerBase
                 return io_serialize_double(output, &d, container_base_double_recipe(), type);
             }
             case VariantString: {
-                const char *s = variant_get_string(v);
+                const char *s = variant_to_string(v, NULL);
                 return io_serialize_double(output, s, container_base_cstring_recipe(), type);
             }
             case VariantBinary: {
-                Binary b = variant_get_binary(v);
+                Binary b = variant_to_binary(v, NULL);
                 return io_serialize_binary(output, &b, container_base_binary_recipe(), type);
             }
             default:
@@ -1645,7 +1719,7 @@ int io_serialize_json(IO output, const void *data, const CommonContainerBase *ba
 
             if (variant_is_custom(v)) {
                 /* Variant is custom, just move down a level (to the child value) and restart the serializer */
-                data = variant_get_custom_data(v);
+                data = variant_peek_custom_data(v);
                 base = variant_get_custom_container_base(v);
                 continue;
             } else {
@@ -1757,7 +1831,8 @@ int io_serialize_json(IO output, const void *data, const CommonContainerBase *ba
                 Binary b = {.data = (char *) data, .length = strlen(data)};
                 type->written = serialize_json_string_internal(ascii_only, output, b);
                 return io_error(output);
-            } else if (generic_types_compatible_compare(base, container_base_binary_recipe()) == 0) {
+            } else if (generic_types_compatible_compare(base, container_base_binary_recipe()) == 0 ||
+                       generic_types_compatible_compare(base, container_base_binary_slice_recipe()) == 0) {
                 type->written = serialize_json_string_internal(ascii_only, output, *((Binary *) data));
                 return io_error(output);
             } else if (generic_types_compatible_compare(base, container_base_boolean_recipe()) == 0) {
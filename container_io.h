@@ -54,6 +54,9 @@ StringList io_split_to_stringlist(IO input, const char *separator, int keep_empt
 GenericList io_split_to_binarylist(IO input, const char *separator, size_t separator_len, int keep_empty);
 StringList io_divide_to_stringlist(IO input, size_t record_size, int keep_partial);
 GenericList io_divide_to_binarylist(IO input, size_t record_size, int keep_partial);
+/** Like io_split_to_binarylist() and io_divide_to_binarylist(), but the returned list holds BinarySlice objects that refer to @p buffer instead of copies of the data */
+GenericList io_split_buffer_to_binarylist(BinaryBuffer buffer, const char *separator, size_t separator_len, int keep_empty);
+GenericList io_divide_buffer_to_binarylist(BinaryBuffer buffer, size_t record_size, int keep_partial);
 int io_join_stringlist(IO output, StringList list, const char *separator);
 int io_join_genericlist(IO output, GenericList list, const char *separator);
 int io_join_genericlist_n(IO output, GenericList list, const char *separator, size_t separator_len);
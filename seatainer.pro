@@ -26,12 +26,16 @@ unix: !win32 {
 
 SOURCES += \
     Containers/common.c \
+    Containers/concurrentmap.c \
     Containers/genericlinkedlist.c \
     Containers/genericlist.c \
     Containers/genericmap.c \
     Containers/genericset.c \
     Containers/generictree.c \
     Containers/impl/avl.c \
+    Containers/impl/btree.c \
+    Containers/impl/hashtable.c \
+    Containers/impl/persistenttree.c \
     Containers/recipes.c \
     Containers/sbuffer.c \
     Containers/stringlist.c \
@@ -64,12 +68,17 @@ SOURCES += \
 
 HEADERS += \
     Containers/common.h \
+    Containers/concurrentmap.h \
     Containers/genericlinkedlist.h \
     Containers/genericlist.h \
     Containers/genericmap.h \
     Containers/genericset.h \
     Containers/generictree.h \
     Containers/impl/avl.h \
+    Containers/impl/backend.h \
+    Containers/impl/btree.h \
+    Containers/impl/hashtable.h \
+    Containers/impl/persistenttree.h \
     Containers/recipes.h \
     Containers/sbuffer.h \
     Containers/stringlist.h \